@@ -0,0 +1,1104 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+// Benchmark of scalar and batch operations for each integer type
+// and each set of inputs, which prints results as CSV or JSON.
+//
+// Usage: libsatop_bench [--format=csv|json] [--filter=<substring of name>]
+//                       [--simd-level=scalar|sse2|avx2|avx512bw]
+//
+// Each result has 2 numbers in nanoseconds.
+// - scalar throughput: per element of independent calls in a loop
+// - scalar latency: per element of calls chained by their results,
+//   including 2 instructions to chain them
+// - batch throughput: per element of a batch call for 4096 elements
+// - batch latency: per batch call for 64 elements
+// - frame throughput: per pixel of an image operation for a 4K RGBA frame
+// - frame latency: per call for the frame
+// - stream throughput: per element of arrays larger than caches
+// - stream latency: per call for the arrays
+// - gemm throughput: per multiply-accumulate of a 256 x 256 x 256 GEMM
+// - gemm latency: per call of the GEMM
+// - contention throughput: per addition of threads adding to a counter
+// - contention latency: per run of 64K additions on each thread
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "satop.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr std::size_t kThroughputElements = 4096;
+constexpr std::size_t kLatencyElements = 64;
+constexpr int kTrials = 5;
+constexpr std::chrono::milliseconds kMinTrialTime(2);
+
+// Size of 4K frames, which are larger than caches.
+constexpr std::size_t kFrameWidth = 3840;
+constexpr std::size_t kFrameHeight = 2160;
+
+// Compilers can not assume that it is 0, so results chained by it
+// are not optimized away.
+volatile int g_zero = 0;
+volatile uint64_t g_sink = 0;
+
+// Force compilers to assume that any memory is read and written here.
+inline void ClobberMemory() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  _ReadWriteBarrier();
+#else
+  __asm__ __volatile__("" : : : "memory");  // NOLINT(readability/casting)
+#endif
+}
+
+enum class InputSet {
+  kNeverOverflow,
+  kAlwaysOverflow,
+  kRandom,
+};
+
+const char* GetName(InputSet input) {
+  switch (input) {
+    case InputSet::kNeverOverflow:
+      return "never_overflow";
+    case InputSet::kAlwaysOverflow:
+      return "always_overflow";
+    case InputSet::kRandom:
+      return "random";
+    default:
+      return "";
+  }
+}
+
+const char* GetName(saturated::simd_level level) {
+  switch (level) {
+    case saturated::simd_level::scalar:
+      return "scalar";
+    case saturated::simd_level::sse2:
+      return "sse2";
+    case saturated::simd_level::avx2:
+      return "avx2";
+    case saturated::simd_level::avx512bw:
+      return "avx512bw";
+    default:
+      return "";
+  }
+}
+
+template <typename T>
+const char* GetTypeName() {
+  return std::is_signed<T>::value
+      ? ((sizeof(T) == 1) ? "int8_t"
+         : (sizeof(T) == 2) ? "int16_t"
+         : (sizeof(T) == 4) ? "int32_t"
+         : "int64_t")
+      : ((sizeof(T) == 1) ? "uint8_t"
+         : (sizeof(T) == 2) ? "uint16_t"
+         : (sizeof(T) == 4) ? "uint32_t"
+         : "uint64_t");
+}
+
+// Random values of T in [lowest, max] for each generator.
+template <typename T>
+class RandomValue {
+ public:
+  explicit RandomValue(std::mt19937_64* engine)
+      : engine_(engine) {
+  }
+
+  T operator()(T lowest, T max) {
+    using wide_t = typename std::conditional<std::is_signed<T>::value,
+                                             int64_t,
+                                             uint64_t>::type;
+    std::uniform_int_distribution<wide_t> distribution(lowest, max);
+    return static_cast<T>(distribution(*engine_));
+  }
+
+  bool Coin() {
+    return ((*engine_)() & 1) != 0;
+  }
+
+ private:
+  std::mt19937_64* engine_;
+};
+
+// Largest value whose square does not exceed max of T.
+template <typename T>
+T GetRootOfMax() {
+  T root = static_cast<T>(
+      std::sqrt(static_cast<double>(std::numeric_limits<T>::max())));
+  while (static_cast<double>(root) * static_cast<double>(root)
+         > static_cast<double>(std::numeric_limits<T>::max())) {
+    --root;
+  }
+  return root;
+}
+
+template <typename T>
+struct Operands {
+  T x;
+  T y;
+  T z;
+};
+
+// Each operation generates operands which overflow or not,
+// and calls scalar and batch functions.
+struct AddOp {
+  static const char* GetName() {
+    return "add";
+  }
+
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    using Limits = std::numeric_limits<T>;
+    constexpr T kHalfMax = Limits::max() / 2;
+    constexpr T kHalfLowest = Limits::lowest() / 2;
+    if (!overflow) {
+      return {(*random)(kHalfLowest, kHalfMax),
+              (*random)(kHalfLowest, kHalfMax), T(0)};
+    }
+    if (std::is_signed<T>::value && random->Coin()) {
+      return {(*random)(Limits::lowest(), static_cast<T>(kHalfLowest - 1)),
+              (*random)(Limits::lowest(), static_cast<T>(kHalfLowest - 1)),
+              T(0)};
+    }
+    return {(*random)(static_cast<T>(kHalfMax + 1), Limits::max()),
+            (*random)(static_cast<T>(kHalfMax + 1), Limits::max()), T(0)};
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::add<Policy>(x, y);
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::add<Policy>(x, y, out, n);
+  }
+};
+
+struct SubOp {
+  static const char* GetName() {
+    return "sub";
+  }
+
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    using Limits = std::numeric_limits<T>;
+    constexpr T kHalfMax = Limits::max() / 2;
+    constexpr T kHalfLowest = Limits::lowest() / 2;
+    if (!std::is_signed<T>::value) {
+      const T small = (*random)(T(0), static_cast<T>(kHalfMax - 1));
+      const T large = (*random)(kHalfMax, Limits::max());
+      return overflow ? Operands<T>{small, large, T(0)}
+                      : Operands<T>{large, small, T(0)};
+    }
+    if (!overflow) {
+      return {(*random)(kHalfLowest, kHalfMax),
+              (*random)(kHalfLowest, kHalfMax), T(0)};
+    }
+    const T positive = (*random)(static_cast<T>(kHalfMax + 1), Limits::max());
+    const T negative =
+        (*random)(Limits::lowest(), static_cast<T>(kHalfLowest - 1));
+    return random->Coin() ? Operands<T>{positive, negative, T(0)}
+                          : Operands<T>{negative, positive, T(0)};
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::sub<Policy>(x, y);
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::sub<Policy>(x, y, out, n);
+  }
+};
+
+// Values whose magnitudes are in [lower, upper] with random signs.
+template <typename T>
+T GenerateSigned(RandomValue<T>* random, T lower, T upper) {
+  const T magnitude = (*random)(lower, upper);
+  return (std::is_signed<T>::value && random->Coin())
+      ? static_cast<T>(T(0) - magnitude)
+      : magnitude;
+}
+
+struct MulOp {
+  static const char* GetName() {
+    return "mul";
+  }
+
+  // Magnitudes of products exceed max of T
+  // if magnitudes of both operands exceed its square root.
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    const T root = GetRootOfMax<T>();
+    if (!overflow) {
+      return {GenerateSigned(random, T(0), root),
+              GenerateSigned(random, T(0), root), T(0)};
+    }
+    return {
+      GenerateSigned(random, static_cast<T>(root + 1),
+                     std::numeric_limits<T>::max()),
+      GenerateSigned(random, static_cast<T>(root + 1),
+                     std::numeric_limits<T>::max()),
+      T(0)};
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::mul<Policy>(x, y);
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::mul<Policy>(x, y, out, n);
+  }
+};
+
+// Batch division divides all elements by y[0],
+// because batch division supports only one divisor for an array.
+struct DivOp {
+  static const char* GetName() {
+    return "div";
+  }
+
+  // Division overflows only if dividing lowest by -1 or dividing by 0.
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    using Limits = std::numeric_limits<T>;
+    if (overflow) {
+      return (std::is_signed<T>::value && random->Coin())
+          ? Operands<T>{Limits::lowest(), static_cast<T>(T(0) - T(1)), T(0)}
+          : Operands<T>{(*random)(Limits::lowest(), Limits::max()), T(0),
+                        T(0)};
+    }
+    return {(*random)(Limits::lowest(), Limits::max()),
+            GenerateSigned(random, T(2), Limits::max()), T(0)};
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::div<Policy>(x, y);
+  }
+
+  template <typename Policy = saturated::saturate, typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::div<Policy>(x, y[0], out, n);
+  }
+};
+
+struct MulAddOp {
+  static const char* GetName() {
+    return "mul_add";
+  }
+
+  // Addends have the same signs as products to overflow.
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    using Limits = std::numeric_limits<T>;
+    const Operands<T> product = MulOp::Generate(random, overflow);
+    if (!overflow) {
+      return {static_cast<T>(product.x / 2), static_cast<T>(product.y / 2),
+              GenerateSigned(random, T(0), static_cast<T>(Limits::max() / 2))};
+    }
+    const T addend = (*random)(T(0), static_cast<T>(Limits::max() / 2));
+    const bool is_negative = (product.x < T(0)) != (product.y < T(0));
+    return {product.x, product.y,
+            is_negative ? static_cast<T>(T(0) - addend) : addend};
+  }
+
+  template <typename T>
+  static T Scalar(T x, T y, T z) {
+    return saturated::mul_add(x, y, z);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* y, const T* z, T* out,
+                    std::size_t n) {
+    saturated::mul_add(x, y, z, out, n);
+  }
+};
+
+// Only lowest of signed types and any values except 0
+// of unsigned types overflow by negation.
+struct NegOp {
+  static const char* GetName() {
+    return "neg";
+  }
+
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    using Limits = std::numeric_limits<T>;
+    if (!std::is_signed<T>::value) {
+      return {overflow ? (*random)(T(1), Limits::max()) : T(0), T(0), T(0)};
+    }
+    return {overflow
+            ? Limits::lowest()
+            : (*random)(static_cast<T>(Limits::lowest() + 1), Limits::max()),
+            T(0), T(0)};
+  }
+
+  template <typename T>
+  static T Scalar(T x, T /* y */, T /* z */) {
+    return saturated::neg(x);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* /* y */, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::neg(x, out, n);
+  }
+};
+
+// Absolute values of unsigned types never overflow.
+struct AbsOp {
+  static const char* GetName() {
+    return "abs";
+  }
+
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    using Limits = std::numeric_limits<T>;
+    return {(overflow && std::is_signed<T>::value)
+            ? Limits::lowest()
+            : (*random)(static_cast<T>(Limits::lowest() + 1), Limits::max()),
+            T(0), T(0)};
+  }
+
+  template <typename T>
+  static T Scalar(T x, T /* y */, T /* z */) {
+    return saturated::abs(x);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* /* y */, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::abs(x, out, n);
+  }
+};
+
+// Values are shifted by a constant number of bits.
+struct ShlOp {
+  static constexpr int kShift = 3;
+
+  static const char* GetName() {
+    return "shl";
+  }
+
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    constexpr T kLimit = std::numeric_limits<T>::max() >> kShift;
+    return {overflow
+            ? GenerateSigned(random, static_cast<T>(kLimit + 1),
+                             std::numeric_limits<T>::max())
+            : GenerateSigned(random, T(0), kLimit),
+            T(0), T(0)};
+  }
+
+  template <typename T>
+  static T Scalar(T x, T /* y */, T /* z */) {
+    return saturated::shl(x, kShift);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* /* y */, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::shl(x, kShift, out, n);
+  }
+};
+
+// Values are multiplied by a constant, compared with mul of arrays.
+struct MulConstOp {
+  static constexpr std::intmax_t kFactor = 3;
+
+  static const char* GetName() {
+    return "mul_c3";
+  }
+
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    constexpr T kLimit = static_cast<T>(std::numeric_limits<T>::max()
+                                        / kFactor);
+    return {overflow
+            ? GenerateSigned(random, static_cast<T>(kLimit + 1),
+                             std::numeric_limits<T>::max())
+            : GenerateSigned(random, T(0), kLimit),
+            T(0), T(0)};
+  }
+
+  template <typename T>
+  static T Scalar(T x, T /* y */, T /* z */) {
+    return saturated::mul<kFactor>(x);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* /* y */, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::mul(x, static_cast<T>(kFactor), out, n);
+  }
+};
+
+// Batch division is available only for types up to 32 bits.
+template <typename Op, typename T>
+struct HasBatch : public std::true_type {
+};
+
+template <typename T>
+struct HasBatch<DivOp, T>
+    : public std::integral_constant<bool, (sizeof(T) <= sizeof(int32_t))> {
+};
+
+const char* GetName(saturated::wrap) {
+  return "wrap";
+}
+
+const char* GetName(saturated::trap) {
+  return "trap";
+}
+
+const char* GetName(saturated::report<>) {
+  return "report";
+}
+
+// Operation Op with overflow policy Policy, named like "add_wrap".
+template <typename Op, typename Policy>
+struct PolicyOp {
+  static std::string GetName() {
+    return std::string(Op::GetName()) + "_" + ::GetName(Policy());
+  }
+
+  template <typename T>
+  static Operands<T> Generate(RandomValue<T>* random, bool overflow) {
+    return Op::template Generate<T>(random, overflow);
+  }
+
+  template <typename T>
+  static T Scalar(T x, T y, T z) {
+    return Op::template Scalar<Policy>(x, y, z);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* y, const T* z, T* out,
+                    std::size_t n) {
+    Op::template Batch<Policy>(x, y, z, out, n);
+  }
+};
+
+template <typename Op, typename Policy, typename T>
+struct HasBatch<PolicyOp<Op, Policy>, T> : public HasBatch<Op, T> {
+};
+
+// Operations which throw for inputs overflowing,
+// so they are measured only with never_overflow.
+template <typename Op>
+struct IsThrowing : public std::false_type {
+};
+
+template <typename Op>
+struct IsThrowing<PolicyOp<Op, saturated::trap>> : public std::true_type {
+};
+
+template <typename T>
+struct Arrays {
+  std::vector<T> x;
+  std::vector<T> y;
+  std::vector<T> z;
+  std::vector<T> out;
+};
+
+template <typename Op, typename T>
+Arrays<T> GenerateArrays(InputSet input, std::size_t n) {
+  std::mt19937_64 engine(n);
+  RandomValue<T> random(&engine);
+  Arrays<T> arrays{std::vector<T>(n), std::vector<T>(n),
+                   std::vector<T>(n), std::vector<T>(n)};
+  for (std::size_t i = 0; i < n; ++i) {
+    const bool overflow = (input == InputSet::kRandom)
+        ? random.Coin()
+        : (input == InputSet::kAlwaysOverflow);
+    const Operands<T> operands = Op::template Generate<T>(&random, overflow);
+    arrays.x[i] = operands.x;
+    arrays.y[i] = operands.y;
+    arrays.z[i] = operands.z;
+  }
+  return arrays;
+}
+
+// Best nanoseconds per unit of body over trials,
+// where body processes units per call.
+// Each trial repeats body for kMinTrialTime at least.
+template <typename Body>
+double Measure(Body body, std::size_t units) {
+  using clock = std::chrono::steady_clock;
+  std::size_t repeats = 1;
+  for (;;) {
+    const auto start = clock::now();
+    for (std::size_t i = 0; i < repeats; ++i) {
+      body();
+      ClobberMemory();
+    }
+    if (clock::now() - start >= kMinTrialTime) {
+      break;
+    }
+    repeats *= 2;
+  }
+  double best = std::numeric_limits<double>::infinity();
+  for (int trial = 0; trial < kTrials; ++trial) {
+    const auto start = clock::now();
+    for (std::size_t i = 0; i < repeats; ++i) {
+      body();
+      ClobberMemory();
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        clock::now() - start;
+    best = std::min(best,
+                    elapsed.count() / static_cast<double>(repeats * units));
+  }
+  return best;
+}
+
+struct Result {
+  std::string op;
+  std::string type;
+  std::string input;
+  std::string mode;
+  double throughput_ns;
+  double latency_ns;
+};
+
+template <typename Op, typename T>
+Result MeasureScalar(InputSet input) {
+  Arrays<T> arrays = GenerateArrays<Op, T>(input, kThroughputElements);
+  const T* x = arrays.x.data();
+  const T* y = arrays.y.data();
+  const T* z = arrays.z.data();
+  T* out = arrays.out.data();
+  const double throughput_ns = Measure(
+      [=]() {
+        for (std::size_t i = 0; i < kThroughputElements; ++i) {
+          out[i] = Op::Scalar(x[i], y[i], z[i]);
+        }
+      },
+      kThroughputElements);
+  // Each x is chained with the previous result, which is masked by 0.
+  const T zero = static_cast<T>(g_zero);
+  T chain = T(0);
+  const double latency_ns = Measure(
+      [=, &chain]() {
+        T result = chain;
+        for (std::size_t i = 0; i < kThroughputElements; ++i) {
+          result = Op::Scalar(static_cast<T>(x[i] ^ (result & zero)),
+                              y[i], z[i]);
+        }
+        chain = result;
+      },
+      kThroughputElements);
+  g_sink = g_sink + static_cast<uint64_t>(chain)
+      + static_cast<uint64_t>(out[0]);
+  return {Op::GetName(), GetTypeName<T>(), GetName(input), "scalar",
+          throughput_ns, latency_ns};
+}
+
+template <typename Op, typename T>
+Result MeasureBatch(InputSet input) {
+  Arrays<T> arrays = GenerateArrays<Op, T>(input, kThroughputElements);
+  const T* x = arrays.x.data();
+  const T* y = arrays.y.data();
+  const T* z = arrays.z.data();
+  T* out = arrays.out.data();
+  const double throughput_ns = Measure(
+      [=]() {
+        Op::Batch(x, y, z, out, kThroughputElements);
+      },
+      kThroughputElements);
+  const double latency_ns = Measure(
+      [=]() {
+        Op::Batch(x, y, z, out, kLatencyElements);
+      },
+      1);
+  g_sink = g_sink + static_cast<uint64_t>(out[0]);
+  return {Op::GetName(), GetTypeName<T>(), GetName(input), "batch",
+          throughput_ns, latency_ns};
+}
+
+struct Options {
+  bool json;
+  std::string filter;
+};
+
+void Print(const Options& options, const std::vector<Result>& results) {
+  const char* const level = GetName(saturated::current_simd_level());
+  if (options.json) {
+    std::printf("{\n  \"simd_level\": \"%s\",\n  \"results\": [", level);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      const Result& r = results[i];
+      std::printf("%s\n    {\"op\": \"%s\", \"type\": \"%s\", "
+                  "\"input\": \"%s\", \"mode\": \"%s\", "
+                  "\"throughput_ns\": %.4f, \"latency_ns\": %.4f}",
+                  (i == 0) ? "" : ",",
+                  r.op.c_str(), r.type.c_str(), r.input.c_str(),
+                  r.mode.c_str(), r.throughput_ns, r.latency_ns);
+    }
+    std::printf("\n  ]\n}\n");
+    return;
+  }
+  std::printf("simd_level,op,type,input,mode,throughput_ns,latency_ns\n");
+  for (const Result& r : results) {
+    std::printf("%s,%s,%s,%s,%s,%.4f,%.4f\n",
+                level, r.op.c_str(), r.type.c_str(), r.input.c_str(),
+                r.mode.c_str(), r.throughput_ns, r.latency_ns);
+  }
+}
+
+template <typename Op, typename T>
+void MeasureBatchIfAvailable(InputSet input, std::vector<Result>* results,
+                             std::true_type /* has_batch */) {
+  results->push_back(MeasureBatch<Op, T>(input));
+}
+
+template <typename Op, typename T>
+void MeasureBatchIfAvailable(InputSet /* input */,
+                             std::vector<Result>* /* results */,
+                             std::false_type /* has_batch */) {
+}
+
+template <typename Op, typename T>
+void Run(const Options& options, std::vector<Result>* results) {
+  const std::string name = std::string(Op::GetName()) + "/" + GetTypeName<T>();
+  if (name.find(options.filter) == std::string::npos) {
+    return;
+  }
+  for (const auto input : {InputSet::kNeverOverflow,
+                           InputSet::kAlwaysOverflow,
+                           InputSet::kRandom}) {
+    if (IsThrowing<Op>::value && (input != InputSet::kNeverOverflow)) {
+      continue;
+    }
+    results->push_back(MeasureScalar<Op, T>(input));
+    MeasureBatchIfAvailable<Op, T>(input, results, HasBatch<Op, T>());
+  }
+}
+
+template <typename Op>
+void RunForTypes(const Options& options, std::vector<Result>* results) {
+  Run<Op, int8_t>(options, results);
+  Run<Op, int16_t>(options, results);
+  Run<Op, int32_t>(options, results);
+  Run<Op, int64_t>(options, results);
+  Run<Op, uint8_t>(options, results);
+  Run<Op, uint16_t>(options, results);
+  Run<Op, uint32_t>(options, results);
+  Run<Op, uint64_t>(options, results);
+}
+
+template <typename Op>
+void RunForPolicies(const Options& options, std::vector<Result>* results) {
+  RunForTypes<Op>(options, results);
+  RunForTypes<PolicyOp<Op, saturated::wrap>>(options, results);
+  RunForTypes<PolicyOp<Op, saturated::trap>>(options, results);
+  RunForTypes<PolicyOp<Op, saturated::report<>>>(options, results);
+}
+
+// Image operations are measured with random RGBA pixels,
+// which pass through memory rather than caches.
+template <typename Body>
+void MeasureFrame(const Options& options, const char* op, Body body,
+                  std::vector<Result>* results) {
+  const std::string name = std::string(op) + "/uint8_t";
+  if (name.find(options.filter) == std::string::npos) {
+    return;
+  }
+  const double frame_ns = Measure(body, 1);
+  results->push_back(
+      {op, "uint8_t", GetName(InputSet::kRandom), "frame",
+       frame_ns / static_cast<double>(kFrameWidth * kFrameHeight), frame_ns});
+}
+
+void RunImages(const Options& options, std::vector<Result>* results) {
+  constexpr std::size_t kStride = kFrameWidth * 4;
+  std::mt19937_64 engine(0);
+  RandomValue<uint8_t> random(&engine);
+  std::vector<uint8_t> x(kStride * kFrameHeight);
+  std::vector<uint8_t> y(x.size());
+  std::vector<uint8_t> out(x.size());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    x[i] = random(0, UINT8_MAX);
+    y[i] = random(0, UINT8_MAX);
+  }
+  using saturated::image_view;
+  const image_view<const uint8_t> vx{
+    x.data(), kFrameWidth, kFrameHeight, kStride, 4};
+  const image_view<const uint8_t> vy{
+    y.data(), kFrameWidth, kFrameHeight, kStride, 4};
+  const image_view<uint8_t> vout{
+    out.data(), kFrameWidth, kFrameHeight, kStride, 4};
+  MeasureFrame(options, "add_images",
+               [=]() { saturated::add_images(vx, vy, vout); }, results);
+  MeasureFrame(options, "scale_image",
+               [=]() {
+                 saturated::scale_image(vx, saturated::image_gain(1.25), 16,
+                                        vout);
+               },
+               results);
+  MeasureFrame(options, "blend_images",
+               [=]() { saturated::blend_images(vx, vy, 96, vout); }, results);
+  MeasureFrame(options, "composite_images",
+               [=]() { saturated::composite_images(vx, vy, vout); }, results);
+  g_sink = g_sink + out[0];
+}
+
+// Mixing is measured with random streams, whose sums saturate often,
+// for each number of streams.
+void RunMixer(const Options& options, std::vector<Result>* results) {
+  for (const std::size_t streams : {2, 8, 64}) {
+    for (const auto mode : {saturated::reduction_mode::clamp_at_end,
+                            saturated::reduction_mode::clamp_each_step}) {
+      const std::string op =
+          std::string((mode == saturated::reduction_mode::clamp_at_end)
+                      ? "mix_at_end_x" : "mix_each_step_x")
+          + std::to_string(streams);
+      if ((op + "/int16_t").find(options.filter) == std::string::npos) {
+        continue;
+      }
+      std::mt19937_64 engine(0);
+      RandomValue<int16_t> random(&engine);
+      std::vector<std::vector<int16_t>> x(
+          streams, std::vector<int16_t>(kThroughputElements));
+      std::vector<const int16_t*> pointers;
+      for (auto& stream : x) {
+        for (auto& sample : stream) {
+          sample = random(INT16_MIN, INT16_MAX);
+        }
+        pointers.push_back(stream.data());
+      }
+      const std::vector<saturated::mix_gain> gains(
+          streams, saturated::mix_gain(0.5));
+      std::vector<int16_t> out(kThroughputElements);
+      const int16_t* const* p = pointers.data();
+      const saturated::mix_gain* g = gains.data();
+      int16_t* o = out.data();
+      const double throughput_ns = Measure(
+          [=]() {
+            saturated::mix(p, g, streams, o, kThroughputElements, mode);
+          },
+          kThroughputElements);
+      const double latency_ns = Measure(
+          [=]() {
+            saturated::mix(p, g, streams, o, kLatencyElements, mode);
+          },
+          1);
+      g_sink = g_sink + static_cast<uint64_t>(out[0]);
+      results->push_back({op, "int16_t", GetName(InputSet::kRandom),
+                          "batch", throughput_ns, latency_ns});
+    }
+  }
+}
+
+// Expression a * 3 + b - c is measured on arrays larger than caches,
+// evaluated by array_expr in one pass and by batch operations in 3 passes
+// with a temporary array.
+void RunExpressions(const Options& options, std::vector<Result>* results) {
+  constexpr std::size_t kSize = std::size_t{1} << 22;
+  std::mt19937_64 engine(0);
+  RandomValue<int16_t> random(&engine);
+  std::vector<int16_t> a(kSize);
+  std::vector<int16_t> b(kSize);
+  std::vector<int16_t> c(kSize);
+  for (std::size_t i = 0; i < kSize; ++i) {
+    a[i] = random(INT16_MIN, INT16_MAX);
+    b[i] = random(INT16_MIN, INT16_MAX);
+    c[i] = random(INT16_MIN, INT16_MAX);
+  }
+  std::vector<int16_t> tmp(kSize);
+  std::vector<int16_t> out(kSize);
+  const int16_t* pa = a.data();
+  const int16_t* pb = b.data();
+  const int16_t* pc = c.data();
+  int16_t* pt = tmp.data();
+  int16_t* po = out.data();
+  if (std::string("expr/int16_t").find(options.filter) != std::string::npos) {
+    const double expr_ns = Measure(
+        [=]() {
+          saturated::evaluate(saturated::lazy(pa) * int16_t{3}
+                              + saturated::lazy(pb) - saturated::lazy(pc),
+                              po, kSize);
+        },
+        1);
+    results->push_back({"expr", "int16_t", GetName(InputSet::kRandom),
+                        "stream", expr_ns / static_cast<double>(kSize),
+                        expr_ns});
+  }
+  if (std::string("expr_unfused/int16_t").find(options.filter)
+      != std::string::npos) {
+    const double unfused_ns = Measure(
+        [=]() {
+          saturated::mul(pa, int16_t{3}, pt, kSize);
+          saturated::add(pt, pb, pt, kSize);
+          saturated::sub(pt, pc, po, kSize);
+        },
+        1);
+    results->push_back({"expr_unfused", "int16_t",
+                        GetName(InputSet::kRandom), "stream",
+                        unfused_ns / static_cast<double>(kSize),
+                        unfused_ns});
+  }
+  g_sink = g_sink + static_cast<uint64_t>(out[0]);
+}
+
+// Scaling of parallel batch operations is measured on arrays larger
+// than caches with pools of 1, 2, 4, ... threads up to hardware threads.
+void RunParallel(const Options& options, std::vector<Result>* results) {
+  constexpr std::size_t kSize = std::size_t{1} << 22;
+  std::mt19937_64 engine(0);
+  RandomValue<int16_t> random(&engine);
+  std::vector<int16_t> x(kSize);
+  std::vector<int16_t> y(kSize);
+  for (std::size_t i = 0; i < kSize; ++i) {
+    x[i] = random(INT16_MIN, INT16_MAX);
+    y[i] = random(INT16_MIN, INT16_MAX);
+  }
+  std::vector<int16_t> out(kSize);
+  const int16_t* px = x.data();
+  const int16_t* py = y.data();
+  int16_t* po = out.data();
+  const std::size_t max_threads =
+      std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  for (std::size_t threads = 1; ; threads = std::min(threads * 2,
+                                                     max_threads)) {
+    saturated::thread_pool pool(threads);
+    const saturated::parallel_policy policy = saturated::par.on(&pool);
+    const std::string suffix = "_par_x" + std::to_string(threads);
+    if (("add" + suffix + "/int16_t").find(options.filter)
+        != std::string::npos) {
+      const double add_ns = Measure(
+          [=]() { saturated::add(policy, px, py, po, kSize); }, 1);
+      results->push_back({"add" + suffix, "int16_t",
+                          GetName(InputSet::kRandom), "stream",
+                          add_ns / static_cast<double>(kSize), add_ns});
+    }
+    if (("sum" + suffix + "/int16_t").find(options.filter)
+        != std::string::npos) {
+      const double sum_ns = Measure(
+          [=]() {
+            g_sink = g_sink + static_cast<uint64_t>(
+                saturated::sum(policy, px, kSize));
+          },
+          1);
+      results->push_back({"sum" + suffix, "int16_t",
+                          GetName(InputSet::kRandom), "stream",
+                          sum_ns / static_cast<double>(kSize), sum_ns});
+    }
+    if (threads == max_threads) {
+      break;
+    }
+  }
+  g_sink = g_sink + static_cast<uint64_t>(out[0]);
+}
+
+// Counters are measured with 1, 2, 4, ... threads up to hardware threads
+// adding +1 and -1 alternately, which never saturate, to a shared counter.
+template <typename Counter, typename Add>
+double MeasureContention(std::size_t threads, std::size_t adds, Add add) {
+  return Measure(
+      [=]() {
+        Counter counter;
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < threads; ++i) {
+          workers.emplace_back([=, &counter]() {
+            for (std::size_t j = 0; j < adds; ++j) {
+              add(&counter, (j & 1) ? int32_t{-1} : int32_t{1});
+            }
+          });
+        }
+        for (auto& worker : workers) {
+          worker.join();
+        }
+      },
+      1);
+}
+
+void RunAtomics(const Options& options, std::vector<Result>* results) {
+  constexpr std::size_t kAdds = std::size_t{1} << 16;
+  const std::size_t max_threads =
+      std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  for (std::size_t threads = 1; ; threads = std::min(threads * 2,
+                                                     max_threads)) {
+    const std::string suffix = "_add_x" + std::to_string(threads);
+    const double adds = static_cast<double>(threads * kAdds);
+    if (("atomic" + suffix + "/int32_t").find(options.filter)
+        != std::string::npos) {
+      const double atomic_ns =
+          MeasureContention<saturated::atomic<int32_t>>(
+              threads, kAdds,
+              [](saturated::atomic<int32_t>* counter, int32_t y) {
+                counter->fetch_add(y, std::memory_order_relaxed);
+              });
+      results->push_back({"atomic" + suffix, "int32_t",
+                          GetName(InputSet::kNeverOverflow), "contention",
+                          atomic_ns / adds, atomic_ns});
+    }
+    if (("sharded" + suffix + "/int32_t").find(options.filter)
+        != std::string::npos) {
+      const double sharded_ns =
+          MeasureContention<saturated::sharded_counter<int32_t>>(
+              threads, kAdds,
+              [](saturated::sharded_counter<int32_t>* counter, int32_t y) {
+                counter->add(y);
+              });
+      results->push_back({"sharded" + suffix, "int32_t",
+                          GetName(InputSet::kNeverOverflow), "contention",
+                          sharded_ns / adds, sharded_ns});
+    }
+    if (threads == max_threads) {
+      break;
+    }
+  }
+}
+
+// GEMM is measured with random matrices, compared with a naive loop
+// of saturated::mul() and saturated::add() in int32_t.
+template <typename T>
+void RunGemm(const Options& options, std::vector<Result>* results) {
+  constexpr std::size_t kSize = 256;
+  constexpr std::size_t kMacs = kSize * kSize * kSize;
+  std::mt19937_64 engine(0);
+  RandomValue<T> random(&engine);
+  std::vector<T> a(kSize * kSize);
+  std::vector<T> b(a.size());
+  std::vector<int32_t> c(a.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    a[i] = random(std::numeric_limits<T>::lowest(),
+                  std::numeric_limits<T>::max());
+    b[i] = random(std::numeric_limits<T>::lowest(),
+                  std::numeric_limits<T>::max());
+  }
+  const T* pa = a.data();
+  const T* pb = b.data();
+  int32_t* pc = c.data();
+  const saturated::matrix_view<const T> va{pa, kSize, kSize, kSize, 1};
+  const saturated::matrix_view<const T> vb{pb, kSize, kSize, kSize, 1};
+  const saturated::matrix_view<int32_t> vc{pc, kSize, kSize, kSize, 1};
+  const std::string type = GetTypeName<T>();
+  if (("gemm/" + type).find(options.filter) != std::string::npos) {
+    const double gemm_ns = Measure([=]() { saturated::gemm(va, vb, vc); }, 1);
+    results->push_back({"gemm", type, GetName(InputSet::kRandom), "gemm",
+                        gemm_ns / static_cast<double>(kMacs), gemm_ns});
+  }
+  if (("gemm_naive/" + type).find(options.filter) != std::string::npos) {
+    const double naive_ns = Measure(
+        [=]() {
+          for (std::size_t i = 0; i < kSize; ++i) {
+            for (std::size_t j = 0; j < kSize; ++j) {
+              int32_t acc = 0;
+              for (std::size_t k = 0; k < kSize; ++k) {
+                acc = saturated::add(
+                    acc, saturated::mul(int32_t{pa[i * kSize + k]},
+                                        int32_t{pb[k * kSize + j]}));
+              }
+              pc[i * kSize + j] = acc;
+            }
+          }
+        },
+        1);
+    results->push_back({"gemm_naive", type, GetName(InputSet::kRandom),
+                        "gemm", naive_ns / static_cast<double>(kMacs),
+                        naive_ns});
+  }
+  g_sink = g_sink + static_cast<uint64_t>(c[0]);
+}
+
+bool ParseSimdLevel(const std::string& name) {
+  for (const auto level : {saturated::simd_level::scalar,
+                           saturated::simd_level::sse2,
+                           saturated::simd_level::avx2,
+                           saturated::simd_level::avx512bw}) {
+    if (name == GetName(level)) {
+      return saturated::force_simd_level(level);
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options{false, ""};
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "--format=csv") {
+      options.json = false;
+    } else if (arg == "--format=json") {
+      options.json = true;
+    } else if (arg.compare(0, 9, "--filter=") == 0) {
+      options.filter = arg.substr(9);
+    } else if (arg.compare(0, 13, "--simd-level=") == 0) {
+      if (!ParseSimdLevel(arg.substr(13))) {
+        std::fprintf(stderr, "Unsupported SIMD level: %s\n", argv[i]);
+        return 1;
+      }
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [--format=csv|json] [--filter=<name>]"
+                   " [--simd-level=scalar|sse2|avx2|avx512bw]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<Result> results;
+  RunForPolicies<AddOp>(options, &results);
+  RunForPolicies<SubOp>(options, &results);
+  RunForPolicies<MulOp>(options, &results);
+  RunForPolicies<DivOp>(options, &results);
+  RunForTypes<MulAddOp>(options, &results);
+  RunForTypes<NegOp>(options, &results);
+  RunForTypes<AbsOp>(options, &results);
+  RunForTypes<ShlOp>(options, &results);
+  RunForTypes<MulConstOp>(options, &results);
+  RunMixer(options, &results);
+  RunImages(options, &results);
+  RunExpressions(options, &results);
+  RunParallel(options, &results);
+  RunAtomics(options, &results);
+  RunGemm<int8_t>(options, &results);
+  RunGemm<int16_t>(options, &results);
+  Print(options, results);
+  return 0;
+}
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Check that each function fused_<name> in a source file is compiled
+# into code as short as manual_<name>, without calls and extra branches.
+# Register allocation and operand order may differ between them,
+# so instructions are counted instead of compared one by one.
+#
+# Usage: check_codegen.sh <C++ compiler> <source file> <object file> [flags]
+
+set -e
+
+CXX=$1
+SRC=$2
+OBJ=$3
+shift 3
+
+mkdir -p "$(dirname "${OBJ}")"
+"${CXX}" "$@" -c -o "${OBJ}" "${SRC}"
+
+# Print instructions of a function except padding after it.
+disassemble() {
+  objdump -d --no-show-raw-insn "${OBJ}" \
+    | awk -v name="<$1>:" '
+        $2 == name { found = 1; next }
+        found && NF == 0 { exit }
+        found { sub(/^[ \t]*[0-9a-f]+:[ \t]*/, ""); print }' \
+    | grep -v -E '^(nop|xchg +%ax,%ax|data16|cs nop|int3)'
+}
+
+count() {
+  disassemble "$1" | grep -c -E "$2" || true
+}
+
+status=0
+for fused in $(nm "${OBJ}" | awk '$2 == "T" && $3 ~ /^_?fused_/ { print $3 }'); do
+  manual=$(echo "${fused}" | sed 's/fused_/manual_/')
+  fused_size=$(count "${fused}" '.')
+  manual_size=$(count "${manual}" '.')
+  fused_jumps=$(count "${fused}" '^j')
+  manual_jumps=$(count "${manual}" '^j')
+  fused_calls=$(count "${fused}" '^call')
+  if [ "${manual_size}" -gt 0 ] \
+       && [ "${fused_size}" -le "${manual_size}" ] \
+       && [ "${fused_jumps}" -le "${manual_jumps}" ] \
+       && [ "${fused_calls}" -eq 0 ]; then
+    echo "OK: ${fused} (${fused_size} instructions," \
+         "${manual_size} in ${manual})"
+  else
+    echo "NG: ${fused} (${fused_size} instructions, ${fused_jumps} jumps," \
+         "${fused_calls} calls) is worse than ${manual}" \
+         "(${manual_size} instructions, ${manual_jumps} jumps)"
+    disassemble "${fused}"
+    echo "---"
+    disassemble "${manual}"
+    status=1
+  fi
+done
+exit ${status}
@@ -24,10 +24,30 @@
 
 #define SATOP_INTERNAL
 
+#include "satop_abs-priv.h"
 #include "satop_add-priv.h"
+#include "satop_atomic-priv.h"
+#include "satop_batch-priv.h"
+#include "satop_cast-priv.h"
+#include "satop_dispatch-priv.h"
 #include "satop_div-priv.h"
+#include "satop_expr-priv.h"
+#include "satop_fixed-priv.h"
+#include "satop_gemm-priv.h"
+#include "satop_image-priv.h"
+#include "satop_integer-priv.h"
+#include "satop_mixer-priv.h"
 #include "satop_mul-priv.h"
+#include "satop_mul_add-priv.h"
+#include "satop_mul_div-priv.h"
+#include "satop_neg-priv.h"
+#include "satop_parallel-priv.h"
+#include "satop_policy-priv.h"
+#include "satop_reduce-priv.h"
+#include "satop_shl-priv.h"
 #include "satop_sub-priv.h"
+#include "satop_telemetry-priv.h"
+#include "satop_view-priv.h"
 
 #undef SATOP_INTERNAL
 
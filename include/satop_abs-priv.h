@@ -0,0 +1,97 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_ABS_PRIV_H_
+#define INCLUDE_SATOP_ABS_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <limits>
+#include <type_traits>
+
+#include "satop_sign_util-priv.h"
+#include "satop_telemetry-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Only absolute value of lowest overflows, into max.
+template <typename T>
+constexpr T abs(T x, signed_integer_tag) {
+  return ((x == std::numeric_limits<T>::lowest())
+          ? std::numeric_limits<T>::max()
+          : ((x < 0) ? static_cast<T>(-x) : x));
+}
+
+template <typename T>
+constexpr T abs(T x, unsigned_integer_tag) {
+  return x;
+}
+
+// Kind of saturation of abs(x).
+template <typename T>
+constexpr saturation_kind abs_saturation(T x, signed_integer_tag) {
+  return ((x == std::numeric_limits<T>::lowest())
+          ? saturation_kind::overflow
+          : saturation_kind::none);
+}
+
+template <typename T>
+constexpr saturation_kind abs_saturation(T /* x */, unsigned_integer_tag) {
+  return saturation_kind::none;
+}
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_abs(T result, T x) {
+  return observe(saturation_op::abs, result,
+                 abs_saturation(x, arithmetic_category<T>()));
+}
+#endif  // SATOP_TELEMETRY
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Absolute value with saturation.
+///
+/// @tparam T Type of the argument and the return value, integral type
+///
+/// @param x A value
+///
+/// @return |x| saturated into the range of T,
+///         so max of T for lowest of T.
+///
+/// @see saturation_snapshot() to count saturations
+template <typename T>
+constexpr T abs(T x) {
+  static_assert(std::is_integral<T>::value,
+                "abs supports only integral types");
+  return SATOP_OBSERVE(abs, impl::abs(x, impl::arithmetic_category<T>()), x);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_ABS_PRIV_H_
@@ -23,7 +23,12 @@
 #error Do not include this file directly, libsatop.h instead.
 #endif
 
+#include <cstdint>
 #include <limits>
+#include <type_traits>
+
+#include "satop_sign_util-priv.h"
+#include "satop_telemetry-priv.h"
 
 namespace saturated {
 
@@ -44,6 +49,109 @@ constexpr bool is_add_underflow(T x, T y) {
               || (y < std::numeric_limits<T>::lowest() - x)));
 }
 
+// Portable implementation, used for floating point types.
+template <typename T>
+constexpr T add_by_compare(T x, T y) {
+  using limits = std::numeric_limits<T>;
+  return (is_add_overflow(x, y)
+          ? limits::max()
+          : (is_add_underflow(x, y)
+             ? limits::lowest()
+             : static_cast<T>(x + y)));
+}
+
+// Wrapped sum of unsigned values is less than x only if carried.
+template <typename T>
+constexpr T add_select_by_carry(T x, T sum) {
+  return ((sum < x) ? std::numeric_limits<T>::max() : sum);
+}
+
+// Signed addition overflows only if sign of the wrapped sum differs
+// from signs of both of operands.
+template <typename T, typename U>
+constexpr T add_select_by_sign_bit(U x, U y, U sum) {
+  return static_cast<T>(
+      ((((x ^ sum) & (y ^ sum)) >> std::numeric_limits<T>::digits) != 0)
+      ? saturated_by_sign_bit<T>(x)
+      : sum);
+}
+
+template <typename T>
+constexpr T add(T x, T y, unsigned_integer_tag) {
+  return add_select_by_carry(x, static_cast<T>(x + y));
+}
+
+template <typename T>
+constexpr T add(T x, T y, signed_integer_tag) {
+  using U = typename std::make_unsigned<T>::type;
+  return add_select_by_sign_bit<T>(
+      static_cast<U>(x),
+      static_cast<U>(y),
+      static_cast<U>(static_cast<U>(x) + static_cast<U>(y)));
+}
+
+template <typename T>
+constexpr T add(T x, T y, floating_point_tag) {
+  return add_by_compare(x, y);
+}
+
+// Kind of saturation of add(x, y) which returned result.
+// Integral results are saturated only if they differ from wrapped sums.
+template <typename T>
+constexpr saturation_kind add_saturation(T x, T y, T /* result */,
+                                         floating_point_tag) {
+  return (is_add_overflow(x, y)
+          ? saturation_kind::overflow
+          : (is_add_underflow(x, y)
+             ? saturation_kind::underflow
+             : saturation_kind::none));
+}
+
+template <typename T, typename Category>
+constexpr saturation_kind add_saturation(T x, T y, T result, Category) {
+  using U = typename std::make_unsigned<T>::type;
+  return saturation_if(static_cast<U>(static_cast<U>(x) + static_cast<U>(y))
+                       != static_cast<U>(result),
+                       result);
+}
+
+// add(x, y) of integral types for y known before x.
+// Sums saturate just when x is out of the range [lowest - y, max - y],
+// so x is clamped into it and added without overflow.
+template <typename T>
+class add_bounds {
+ public:
+  constexpr explicit add_bounds(T y)
+      : y_(y),
+        lowest_x_(csignbit(y)
+                  ? static_cast<T>(std::numeric_limits<T>::lowest() - y)
+                  : std::numeric_limits<T>::lowest()),
+        max_x_(csignbit(y)
+               ? std::numeric_limits<T>::max()
+               : static_cast<T>(std::numeric_limits<T>::max() - y)) {
+  }
+
+  constexpr T operator()(T x) const {
+    return static_cast<T>(((x < lowest_x_)
+                           ? lowest_x_
+                           : ((x > max_x_) ? max_x_ : x))
+                          + y_);
+  }
+
+ private:
+  T y_;
+  T lowest_x_;
+  T max_x_;
+};
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_add(T result, T x, T y) {
+  return observe(saturation_op::add, result,
+                 add_saturation(x, y, result, arithmetic_category<T>()));
+}
+#endif  // SATOP_TELEMETRY
+
 }  // namespace impl
 
 /// @addtogroup libsatop
@@ -60,14 +168,35 @@ constexpr bool is_add_underflow(T x, T y) {
 /// @return If addition results causes overflow, returns max of T.
 ///         If underflow, returns min(lowest) of T.
 ///         If no overflow and no underflow, returns x + y.
+///
+/// @see saturation_snapshot() to count saturations
 template <typename T>
 constexpr T add(T x, T y) {
-  using limits = std::numeric_limits<T>;
-  return (impl::is_add_overflow(x, y)
-          ? limits::max()
-          : (impl::is_add_underflow(x, y)
-             ? limits::lowest()
-             : static_cast<T>(x + y)));
+  return SATOP_OBSERVE(add,
+                       impl::add(x, y, impl::arithmetic_category<T>()),
+                       x, y);
+}
+
+/// Add a constant to a value with saturation.
+///
+/// The range of x whose sums do not saturate is a constant,
+/// so it is compiled into a comparison and an addition.
+///
+/// @tparam C A constant to add, in the range of T
+/// @tparam T Type of the argument and the return value, integral type
+///
+/// @param x A value to add
+///
+/// @return x + C saturated into the range of T.
+///
+/// @see saturation_snapshot() to count saturations
+template <std::intmax_t C, typename T>
+constexpr T add(T x) {
+  static_assert(std::is_integral<T>::value,
+                "add<C> supports only integral types");
+  static_assert(impl::is_in_range<T>(C), "C must be in the range of T");
+  return SATOP_OBSERVE(add, impl::add_bounds<T>(static_cast<T>(C))(x),
+                       x, static_cast<T>(C));
 }
 
 /// @}
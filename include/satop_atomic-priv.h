@@ -0,0 +1,288 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_ATOMIC_PRIV_H_
+#define INCLUDE_SATOP_ATOMIC_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include "satop_op-priv.h"
+#include "satop_reduce-priv.h"
+#include "satop_telemetry-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Order of loads in read-modify-write operations of order.
+constexpr std::memory_order load_order(std::memory_order order) {
+  return ((order == std::memory_order_release)
+          ? std::memory_order_relaxed
+          : ((order == std::memory_order_acq_rel)
+             ? std::memory_order_acquire
+             : order));
+}
+
+// Shard of sharded_counter, padded to a cache line
+// so that threads adding to different shards never share lines.
+struct counter_shard {
+  counter_shard()
+      : value(0), padding() {
+  }
+
+  std::atomic<int64_t> value;
+  char padding[64 - sizeof(std::atomic<int64_t>)];
+};
+
+// Index of shards for the calling thread, assigned in order of first use
+// so that threads spread over shards evenly.
+inline std::size_t thread_shard_index() {
+  static std::atomic<std::size_t> next_index(0);
+  static thread_local const std::size_t index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Atomic integer whose additions and subtractions saturate.
+///
+/// No instruction adds to memory atomically with saturation,
+/// so additions are compare-and-swap loops of add().
+/// Additions which leave the value unchanged, such as ones to max,
+/// only load the value without writing the cache line,
+/// so counters staying saturated do not contend.
+/// Use sharded_counter for counters updated by many threads.
+///
+/// @tparam T Type of the value, integral type
+template <typename T>
+class atomic {
+ public:
+  static_assert(std::is_integral<T>::value,
+                "atomic supports only integral types");
+
+  /// Construct with a value, which is not atomic.
+  ///
+  /// @param value The initial value
+  constexpr explicit atomic(T value = T(0))
+      : value_(value) {
+  }
+
+  atomic(const atomic&) = delete;
+  atomic& operator=(const atomic&) = delete;
+
+  /// @return true if operations never use locks
+  bool is_lock_free() const {
+    return value_.is_lock_free();
+  }
+
+  /// Load the value.
+  ///
+  /// @param order Memory order
+  ///
+  /// @return The value
+  T load(std::memory_order order = std::memory_order_seq_cst) const {
+    return value_.load(order);
+  }
+
+  /// Store a value.
+  ///
+  /// @param value A value to store
+  /// @param order Memory order
+  void store(T value, std::memory_order order = std::memory_order_seq_cst) {
+    value_.store(value, order);
+  }
+
+  /// Replace the value.
+  ///
+  /// @param value A value to store
+  /// @param order Memory order
+  ///
+  /// @return The value before replacement
+  T exchange(T value, std::memory_order order = std::memory_order_seq_cst) {
+    return value_.exchange(value, order);
+  }
+
+  /// Replace the value if it is expected one.
+  ///
+  /// @param expected The expected value, replaced with the current value
+  ///                 if they differ
+  /// @param desired  A value to store
+  /// @param order    Memory order
+  ///
+  /// @return true if the value is replaced
+  bool compare_exchange_strong(
+      T& expected, T desired,  // NOLINT(runtime/references)
+      std::memory_order order = std::memory_order_seq_cst) {
+    return value_.compare_exchange_strong(expected, desired, order,
+                                          impl::load_order(order));
+  }
+
+  /// Add a value with saturation atomically.
+  ///
+  /// @param y     A value to add
+  /// @param order Memory order
+  ///
+  /// @return The value before addition
+  ///
+  /// @see saturation_snapshot() to count saturations
+  T fetch_add(T y, std::memory_order order = std::memory_order_seq_cst) {
+    return update(impl::add_op(), y, order);
+  }
+
+  /// Subtract a value with saturation atomically.
+  ///
+  /// @param y     A value to subtract
+  /// @param order Memory order
+  ///
+  /// @return The value before subtraction
+  ///
+  /// @see saturation_snapshot() to count saturations
+  T fetch_sub(T y, std::memory_order order = std::memory_order_seq_cst) {
+    return update(impl::sub_op(), y, order);
+  }
+
+ private:
+  template <typename Op>
+  T update(Op, T y, std::memory_order order) {
+    T x = value_.load(impl::load_order(order));
+    for (;;) {
+      const T result = impl::apply(Op(), x, y);
+      if ((result == x)
+          || value_.compare_exchange_weak(x, result, order,
+                                          impl::load_order(order))) {
+#ifdef SATOP_TELEMETRY
+        observe(Op(), result, x, y);
+#endif
+        return x;
+      }
+    }
+  }
+
+#ifdef SATOP_TELEMETRY
+  static void observe(impl::add_op, T result, T x, T y) {
+    static_cast<void>(SATOP_OBSERVE(add, result, x, y));
+  }
+
+  static void observe(impl::sub_op, T result, T x, T y) {
+    static_cast<void>(SATOP_OBSERVE(sub, result, x, y));
+  }
+#endif
+
+  std::atomic<T> value_;
+};
+
+/// Counter updated by many threads, whose value saturates when it is read.
+///
+/// Each thread adds to one of shards in its own cache line
+/// by an atomic addition without compare-and-swap,
+/// and value() sums the shards exactly and saturates the sum,
+/// as sum() with reduction_mode::clamp_at_end.
+/// Shards hold 64 bits sums, which never overflow
+/// before 2^31 additions of extreme values to each shard.
+///
+/// @tparam T Type of the value, integral type up to 32 bits
+template <typename T>
+class sharded_counter {
+ public:
+  static_assert(std::is_integral<T>::value && (sizeof(T) <= sizeof(int32_t)),
+                "sharded_counter supports only integral types up to 32 bits");
+
+  /// Construct a counter of 0.
+  ///
+  /// @param shards Number of shards, the number of hardware threads
+  ///               by default
+  explicit sharded_counter(
+      std::size_t shards = std::max<std::size_t>(
+          std::thread::hardware_concurrency(), 1))
+      : size_(std::max<std::size_t>(shards, 1)),
+        shards_(new impl::counter_shard[size_]) {
+  }
+
+  sharded_counter(const sharded_counter&) = delete;
+  sharded_counter& operator=(const sharded_counter&) = delete;
+
+  /// @return Number of shards
+  std::size_t shards() const {
+    return size_;
+  }
+
+  /// Add a value to the shard of the calling thread.
+  ///
+  /// @param y A value to add
+  void add(T y) {
+    shard().fetch_add(y, std::memory_order_relaxed);
+  }
+
+  /// Subtract a value from the shard of the calling thread.
+  ///
+  /// @param y A value to subtract
+  void sub(T y) {
+    shard().fetch_sub(y, std::memory_order_relaxed);
+  }
+
+  /// Sum shards with saturation.
+  ///
+  /// Additions running concurrently may or may not be included.
+  ///
+  /// @return The sum of all additions and subtractions,
+  ///         saturated into the range of T
+  T value() const {
+    impl::wide_accumulator acc;
+    for (std::size_t i = 0; i < size_; ++i) {
+      acc.add(shards_[i].value.load(std::memory_order_relaxed));
+    }
+    return acc.clamp<T>();
+  }
+
+  /// Reset the counter into 0,
+  /// which must not run concurrently with other operations.
+  void reset() {
+    for (std::size_t i = 0; i < size_; ++i) {
+      shards_[i].value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  std::atomic<int64_t>& shard() {
+    return shards_[impl::thread_shard_index() % size_].value;
+  }
+
+  std::size_t size_;
+  std::unique_ptr<impl::counter_shard[]> shards_;
+};
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_ATOMIC_PRIV_H_
@@ -0,0 +1,1705 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_BATCH_PRIV_H_
+#define INCLUDE_SATOP_BATCH_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "satop_add-priv.h"
+#include "satop_cast-priv.h"
+#include "satop_dispatch-priv.h"
+#include "satop_div-priv.h"
+#include "satop_fixed-priv.h"
+#include "satop_mul-priv.h"
+#include "satop_mul_add-priv.h"
+#include "satop_op-priv.h"
+#include "satop_policy-priv.h"
+#include "satop_simd-priv.h"
+#include "satop_sub-priv.h"
+#include "satop_telemetry-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Division by divider is binary operation
+// whose right hand side is divider instead of vector.
+template <typename Isa, typename T>
+struct has_vector_binary<
+  Isa, div_op, T,
+  decltype(static_cast<void>(Isa::apply(div_op(),
+                                        Isa::load(nullptr),
+                                        std::declval<const divider<T>&>())))>
+    : public std::true_type {
+};
+
+// Multiply-add is binary operation with an additional vector to add.
+template <typename Isa, typename T>
+struct has_vector_binary<
+  Isa, mul_add_op, T,
+  decltype(static_cast<void>(Isa::apply(mul_add_op(),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        type_tag<T>())))>
+    : public std::true_type {
+};
+
+// Number of lanes of From converted into each lane of To.
+template <typename From, typename To>
+using narrowing_ratio =
+    std::integral_constant<std::size_t, sizeof(From) / sizeof(To)>;
+
+// Half width type of 32 bits From, to narrow 32 bits lanes
+// into 8 bits lanes in 2 steps.  Both steps saturate in the same
+// direction, so the result is the same as narrowing at once.
+template <typename From>
+using half_type = typename std::conditional<std::is_signed<From>::value,
+                                            int16_t,
+                                            uint16_t>::type;
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+// Convert lanes of From at x into a vector of To, and store it to out.
+// They are declared only for conversions which Isa supports.
+template <typename Isa, typename From, typename To>
+SATOP_ALWAYS_INLINE auto cast_vector(Isa, const From* x, To* out,
+                                     std::integral_constant<std::size_t, 1>)
+    -> decltype(static_cast<void>(Isa::apply(cast_op<From>(),
+                                             Isa::load(x),
+                                             type_tag<To>()))) {
+  Isa::store(out, Isa::apply(cast_op<From>(), Isa::load(x), type_tag<To>()));
+}
+
+template <typename Isa, typename From, typename To>
+SATOP_ALWAYS_INLINE auto cast_vector(Isa, const From* x, To* out,
+                                     std::integral_constant<std::size_t, 2>)
+    -> decltype(static_cast<void>(Isa::narrow(Isa::load(x), Isa::load(x),
+                                              type_tag<From>(),
+                                              type_tag<To>()))) {
+  constexpr std::size_t kLanes =
+      sizeof(typename Isa::vector_type) / sizeof(From);
+  Isa::store(out, Isa::narrow(Isa::load(x), Isa::load(x + kLanes),
+                              type_tag<From>(), type_tag<To>()));
+}
+
+template <typename Isa, typename From, typename To>
+SATOP_ALWAYS_INLINE auto cast_vector(Isa, const From* x, To* out,
+                                     std::integral_constant<std::size_t, 4>)
+    -> decltype(static_cast<void>(Isa::narrow(
+        Isa::narrow(Isa::load(x), Isa::load(x),
+                    type_tag<From>(), type_tag<half_type<From>>()),
+        Isa::load(x),
+        type_tag<half_type<From>>(), type_tag<To>()))) {
+  using half_t = half_type<From>;
+  constexpr std::size_t kLanes =
+      sizeof(typename Isa::vector_type) / sizeof(From);
+  Isa::store(out, Isa::narrow(
+      Isa::narrow(Isa::load(x), Isa::load(x + kLanes),
+                  type_tag<From>(), type_tag<half_t>()),
+      Isa::narrow(Isa::load(x + kLanes * 2), Isa::load(x + kLanes * 3),
+                  type_tag<From>(), type_tag<half_t>()),
+      type_tag<half_t>(), type_tag<To>()));
+}
+
+SATOP_GENERIC_SIMD_END()
+
+// Conversion from From is unary operation whose operand is not To.
+template <typename Isa, typename From, typename To>
+struct has_vector_binary<
+  Isa, cast_op<From>, To,
+  decltype(cast_vector(Isa(),
+                       std::declval<const From*>(),
+                       std::declval<To*>(),
+                       narrowing_ratio<From, To>()))>
+    : public std::true_type {
+};
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+// Convert lanes of From at x multiplied by scale into a vector of To
+// through vectors of int32_t, and store it to out.
+// Narrowing int32_t saturates in the same direction,
+// so the result is the same as converting into To at once.
+template <typename Isa, typename From, rounding Mode>
+SATOP_ALWAYS_INLINE auto convert_vector(Isa, const From* x, From scale,
+                                        int32_t* out, rounding_tag<Mode> mode)
+    -> decltype(static_cast<void>(Isa::to_int32(x, scale, mode))) {
+  Isa::store(out, Isa::to_int32(x, scale, mode));
+}
+
+template <typename Isa, typename From, typename To, rounding Mode>
+SATOP_ALWAYS_INLINE auto convert_vector(Isa, const From* x, From scale,
+                                        To* out, rounding_tag<Mode> mode)
+    -> typename std::enable_if<
+      (sizeof(To) == sizeof(int16_t)),
+      decltype(static_cast<void>(Isa::narrow(Isa::to_int32(x, scale, mode),
+                                             Isa::to_int32(x, scale, mode),
+                                             type_tag<int32_t>(),
+                                             type_tag<To>())))>::type {
+  constexpr std::size_t kLanes =
+      sizeof(typename Isa::vector_type) / sizeof(int32_t);
+  Isa::store(out, Isa::narrow(Isa::to_int32(x, scale, mode),
+                              Isa::to_int32(x + kLanes, scale, mode),
+                              type_tag<int32_t>(), type_tag<To>()));
+}
+
+template <typename Isa, typename From, typename To, rounding Mode>
+SATOP_ALWAYS_INLINE auto convert_vector(Isa, const From* x, From scale,
+                                        To* out, rounding_tag<Mode> mode)
+    -> typename std::enable_if<
+      (sizeof(To) == sizeof(int8_t)),
+      decltype(static_cast<void>(Isa::narrow(
+          Isa::narrow(Isa::to_int32(x, scale, mode),
+                      Isa::to_int32(x, scale, mode),
+                      type_tag<int32_t>(), type_tag<int16_t>()),
+          Isa::to_int32(x, scale, mode),
+          type_tag<int16_t>(), type_tag<To>())))>::type {
+  constexpr std::size_t kLanes =
+      sizeof(typename Isa::vector_type) / sizeof(int32_t);
+  Isa::store(out, Isa::narrow(
+      Isa::narrow(Isa::to_int32(x, scale, mode),
+                  Isa::to_int32(x + kLanes, scale, mode),
+                  type_tag<int32_t>(), type_tag<int16_t>()),
+      Isa::narrow(Isa::to_int32(x + kLanes * 2, scale, mode),
+                  Isa::to_int32(x + kLanes * 3, scale, mode),
+                  type_tag<int32_t>(), type_tag<int16_t>()),
+      type_tag<int16_t>(), type_tag<To>()));
+}
+
+SATOP_GENERIC_SIMD_END()
+
+// Conversion from floating point type is unary operation
+// with a scale, whose operand is not To.
+template <typename Isa, typename From, rounding Mode, typename To>
+struct has_vector_binary<
+  Isa, convert_op<From, Mode>, To,
+  decltype(convert_vector(Isa(),
+                          std::declval<const From*>(),
+                          std::declval<From>(),
+                          std::declval<To*>(),
+                          rounding_tag<Mode>()))>
+    : public std::true_type {
+};
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+// Apply unary operations to lanes of T in x, and set them to result.
+// Negation is subtraction from 0, which all instruction sets saturate.
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE auto unary_vector(Isa, neg_op,
+                                      typename Isa::vector_type x,
+                                      typename Isa::vector_type* result,
+                                      type_tag<T>)
+    -> decltype(static_cast<void>(Isa::apply(sub_op(), x, x,
+                                             type_tag<T>()))) {
+  *result = Isa::apply(sub_op(), Isa::zero(), x, type_tag<T>());
+}
+
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE auto unary_vector(Isa, abs_op,
+                                      typename Isa::vector_type x,
+                                      typename Isa::vector_type* result,
+                                      type_tag<T>)
+    -> decltype(static_cast<void>(Isa::apply(abs_op(), x, type_tag<T>()))) {
+  *result = Isa::apply(abs_op(), x, type_tag<T>());
+}
+
+SATOP_GENERIC_SIMD_END()
+
+// Unary operation is binary operation without the 2nd operand.
+template <typename Isa, typename Op, typename T>
+struct has_vector_binary<
+  Isa, Op, T,
+  decltype(unary_vector(Isa(), Op(),
+                        Isa::load(nullptr),
+                        std::declval<typename Isa::vector_type*>(),
+                        type_tag<T>()))>
+    : public std::true_type {
+};
+
+// Outputs of kernels, given as their last arguments.
+// Kernels counting saturations get masks of saturated lanes
+// of each vector, and count them by popcount in the same pass
+// as computing results.
+
+// Store results without counting saturations.
+struct store_output {
+};
+
+// Store results and count saturations into tally.
+struct count_output {
+  saturation_tally* tally;
+};
+
+// Count saturations into tally without storing results,
+// for policies which throw before storing any result.
+struct check_output {
+  saturation_tally* tally;
+};
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+// Factors of shift left of lanes of T.  Shift left with saturation
+// is multiplication by 2^shift with saturation.  Shifts by digits of T
+// or more saturate the same as by digits,
+// multiplication by 2^(digits - 1) and then by 2.
+// Shifts beyond digits saturate all but 0, even -1 whose products
+// by 2^(digits - 1) and by 2 are lowest without saturation.
+template <typename Isa, typename T>
+struct shift_factors {
+  SATOP_ALWAYS_INLINE explicit shift_factors(int shift)
+      : factor(Isa::broadcast(static_cast<T>(
+            T(1) << std::min(shift, std::numeric_limits<T>::digits - 1)))),
+        two(Isa::broadcast(T(2))),
+        is_beyond_digits(shift >= std::numeric_limits<T>::digits),
+        saturates_nonzero(shift > std::numeric_limits<T>::digits) {
+  }
+
+  typename Isa::vector_type factor;
+  typename Isa::vector_type two;
+  bool is_beyond_digits;
+  bool saturates_nonzero;
+};
+
+// Lanes of result of Op on vectors which saturated,
+// as masks of equal_mask().  Bits out of lanes may be set,
+// they are cleared by masks of equal_mask() to count lanes.
+// Saturated sums and differences always differ from wrapped ones.
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(Isa, add_op,
+                                             typename Isa::vector_type result,
+                                             typename Isa::vector_type x,
+                                             typename Isa::vector_type y,
+                                             type_tag<T>) {
+  return ~Isa::equal_mask(result,
+                          Isa::apply(wrap_op<add_op>(), x, y, type_tag<T>()),
+                          lane_width<sizeof(T)>());
+}
+
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(Isa, sub_op,
+                                             typename Isa::vector_type result,
+                                             typename Isa::vector_type x,
+                                             typename Isa::vector_type y,
+                                             type_tag<T>) {
+  return ~Isa::equal_mask(result,
+                          Isa::apply(wrap_op<sub_op>(), x, y, type_tag<T>()),
+                          lane_width<sizeof(T)>());
+}
+
+// Saturated products may be the same as wrapped ones,
+// so instruction sets find them in wider lanes.
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(Isa, mul_op,
+                                             typename Isa::vector_type,
+                                             typename Isa::vector_type x,
+                                             typename Isa::vector_type y,
+                                             type_tag<T>) {
+  return Isa::saturated_mask(mul_op(), x, y, type_tag<T>());
+}
+
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(Isa, mul_add_op,
+                                             typename Isa::vector_type,
+                                             typename Isa::vector_type x,
+                                             typename Isa::vector_type y,
+                                             typename Isa::vector_type z,
+                                             type_tag<T>) {
+  return Isa::saturated_mask(mul_add_op(), x, y, z, type_tag<T>());
+}
+
+// Only lowest saturates by negation and absolute value of signed values,
+// and all but 0 saturate by negation of unsigned values.
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(Isa, neg_op,
+                                             typename Isa::vector_type,
+                                             typename Isa::vector_type x,
+                                             type_tag<T>) {
+  return std::is_signed<T>::value
+      ? Isa::equal_mask(x, Isa::broadcast(std::numeric_limits<T>::lowest()),
+                        lane_width<sizeof(T)>())
+      : ~Isa::equal_mask(x, Isa::zero(), lane_width<sizeof(T)>());
+}
+
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(Isa, abs_op,
+                                             typename Isa::vector_type,
+                                             typename Isa::vector_type x,
+                                             type_tag<T>) {
+  return std::is_signed<T>::value
+      ? Isa::equal_mask(x, Isa::broadcast(std::numeric_limits<T>::lowest()),
+                        lane_width<sizeof(T)>())
+      : 0;
+}
+
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(
+    Isa, shl_op, typename Isa::vector_type,
+    typename Isa::vector_type x, const shift_factors<Isa, T>& factors,
+    type_tag<T>) {
+  if (factors.saturates_nonzero) {
+    return ~Isa::equal_mask(x, Isa::zero(), lane_width<sizeof(T)>());
+  }
+  const uint64_t saturated =
+      Isa::saturated_mask(mul_op(), x, factors.factor, type_tag<T>());
+  return factors.is_beyond_digits
+      ? (saturated
+         | Isa::saturated_mask(mul_op(),
+                               Isa::apply(mul_op(), x, factors.factor,
+                                          type_tag<T>()),
+                               factors.two,
+                               type_tag<T>()))
+      : saturated;
+}
+
+// Vector division runs only for divisors other than 0,
+// where only lowest / -1 saturates.
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE uint64_t saturated_lanes(Isa, div_op,
+                                             typename Isa::vector_type,
+                                             typename Isa::vector_type x,
+                                             const divider<T>& y,
+                                             type_tag<T>) {
+  return (std::is_signed<T>::value && (y.divisor() == static_cast<T>(-1)))
+      ? Isa::equal_mask(x, Isa::broadcast(std::numeric_limits<T>::lowest()),
+                        lane_width<sizeof(T)>())
+      : 0;
+}
+
+// Counts of saturations of Op on T in a loop, which are kept
+// in registers and added to tally when the loop ends.
+template <typename Op, typename T>
+class saturation_counter {
+ public:
+  SATOP_ALWAYS_INLINE explicit saturation_counter(saturation_tally* tally)
+      : tally_(tally), counts_{0, 0} {
+  }
+
+  saturation_counter(const saturation_counter&) = delete;
+  saturation_counter& operator=(const saturation_counter&) = delete;
+
+  SATOP_ALWAYS_INLINE ~saturation_counter() {
+    tally_->overflow += counts_.overflow;
+    tally_->underflow += counts_.underflow;
+  }
+
+  // Saturated lanes are max or lowest, which tell their directions.
+  template <typename Isa, typename... Operands>
+  SATOP_ALWAYS_INLINE void count_vector(Isa,
+                                        typename Isa::vector_type result,
+                                        const Operands&... operands) {
+    using width = lane_width<sizeof(T)>;
+    const uint64_t saturated =
+        saturated_lanes(Isa(), Op(), result, operands..., type_tag<T>());
+    counts_.overflow += static_cast<uint64_t>(
+        popcount(saturated
+                 & Isa::equal_mask(result,
+                                   Isa::broadcast(
+                                       std::numeric_limits<T>::max()),
+                                   width()))
+        / Isa::bits_per_lane(width()));
+    counts_.underflow += static_cast<uint64_t>(
+        popcount(saturated
+                 & Isa::equal_mask(result,
+                                   Isa::broadcast(
+                                       std::numeric_limits<T>::lowest()),
+                                   width()))
+        / Isa::bits_per_lane(width()));
+  }
+
+  template <typename... Operands>
+  SATOP_ALWAYS_INLINE void count(T result, Operands... operands) {
+    counts_.add(saturation_of(Op(), operands..., result));
+  }
+
+ private:
+  saturation_tally* tally_;
+  saturation_tally counts_;
+};
+
+// Writer of results of Op on T into Output in a loop,
+// which takes operands of each result to count saturations.
+template <typename Op, typename T, typename Output>
+class batch_writer;
+
+template <typename Op, typename T>
+class batch_writer<Op, T, store_output> {
+ public:
+  SATOP_ALWAYS_INLINE explicit batch_writer(store_output) {
+  }
+
+  template <typename Isa, typename... Operands>
+  SATOP_ALWAYS_INLINE void put_vector(Isa, T* out,
+                                      typename Isa::vector_type result,
+                                      const Operands&...) {
+    Isa::store(out, result);
+  }
+
+  template <typename... Operands>
+  SATOP_ALWAYS_INLINE void put(T* out, T result, Operands...) {
+    *out = result;
+  }
+};
+
+template <typename Op, typename T>
+class batch_writer<Op, T, count_output>
+    : private saturation_counter<Op, T> {
+ public:
+  SATOP_ALWAYS_INLINE explicit batch_writer(count_output output)
+      : saturation_counter<Op, T>(output.tally) {
+  }
+
+  // Inlined even into unlikely paths, where counts are discarded.
+  SATOP_ALWAYS_INLINE ~batch_writer() {
+  }
+
+  template <typename Isa, typename... Operands>
+  SATOP_ALWAYS_INLINE void put_vector(Isa, T* out,
+                                      typename Isa::vector_type result,
+                                      const Operands&... operands) {
+    this->count_vector(Isa(), result, operands...);
+    Isa::store(out, result);
+  }
+
+  template <typename... Operands>
+  SATOP_ALWAYS_INLINE void put(T* out, T result, Operands... operands) {
+    this->count(result, operands...);
+    *out = result;
+  }
+};
+
+template <typename Op, typename T>
+class batch_writer<Op, T, check_output>
+    : private saturation_counter<Op, T> {
+ public:
+  SATOP_ALWAYS_INLINE explicit batch_writer(check_output output)
+      : saturation_counter<Op, T>(output.tally) {
+  }
+
+  SATOP_ALWAYS_INLINE ~batch_writer() {
+  }
+
+  template <typename Isa, typename... Operands>
+  SATOP_ALWAYS_INLINE void put_vector(Isa, T* /* out */,
+                                      typename Isa::vector_type result,
+                                      const Operands&... operands) {
+    this->count_vector(Isa(), result, operands...);
+  }
+
+  template <typename... Operands>
+  SATOP_ALWAYS_INLINE void put(T* /* out */, T result,
+                               Operands... operands) {
+    this->count(result, operands...);
+  }
+};
+
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void binary_loop(scalar_isa,
+                                     const T* x, const T* y, T* out,
+                                     std::size_t n, Output output) {
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, apply(Op(), x[i], y[i]), x[i], y[i]);
+  }
+}
+
+template <typename Op, typename Isa, typename T, typename Output>
+SATOP_ALWAYS_INLINE void binary_loop(Isa,
+                                     const T* x, const T* y, T* out,
+                                     std::size_t n, Output output) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(T);
+  batch_writer<Op, T, Output> writer(output);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const vector_type vx = Isa::load(x + i);
+    const vector_type vy = Isa::load(y + i);
+    writer.put_vector(Isa(), out + i,
+                      Isa::apply(Op(), vx, vy, type_tag<T>()), vx, vy);
+  }
+  binary_loop<Op>(scalar_isa(), x + i, y + i, out + i, n - i, output);
+}
+
+// Op by a value y for each element, which computes what depends
+// only on y once, such as the range of x without saturation.
+template <typename Op, typename T, typename Enable = void>
+class scalar_operand {
+ public:
+  explicit scalar_operand(T y)
+      : y_(y) {
+  }
+
+  T operator()(T x) const {
+    return apply(Op(), x, y_);
+  }
+
+ private:
+  T y_;
+};
+
+template <typename T>
+class scalar_operand<
+  add_op, T, typename std::enable_if<std::is_integral<T>::value>::type>
+    : public add_bounds<T> {
+ public:
+  using add_bounds<T>::add_bounds;
+};
+
+template <typename T>
+class scalar_operand<
+  sub_op, T, typename std::enable_if<std::is_integral<T>::value>::type>
+    : public sub_bounds<T> {
+ public:
+  using sub_bounds<T>::sub_bounds;
+};
+
+template <typename T>
+class scalar_operand<
+  mul_op, T, typename std::enable_if<std::is_integral<T>::value>::type>
+    : public mul_bounds<T> {
+ public:
+  using mul_bounds<T>::mul_bounds;
+};
+
+// Remainders of vector loops are too short
+// to compute what scalar_operand computes once.
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void binary_remainder_loop(const T* x, T y, T* out,
+                                               std::size_t n,
+                                               Output output) {
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, apply(Op(), x[i], y), x[i], y);
+  }
+}
+
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void binary_scalar_loop(scalar_isa,
+                                            const T* x, T y, T* out,
+                                            std::size_t n, Output output) {
+  const scalar_operand<Op, T> op(y);
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, op(x[i]), x[i], y);
+  }
+}
+
+template <typename Op, typename Isa, typename T, typename Output>
+SATOP_ALWAYS_INLINE void binary_scalar_loop(Isa,
+                                            const T* x, T y, T* out,
+                                            std::size_t n, Output output) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(T);
+  const vector_type vy = Isa::broadcast(y);
+  batch_writer<Op, T, Output> writer(output);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const vector_type vx = Isa::load(x + i);
+    writer.put_vector(Isa(), out + i,
+                      Isa::apply(Op(), vx, vy, type_tag<T>()), vx, vy);
+  }
+  binary_remainder_loop<Op>(x + i, y, out + i, n - i, output);
+}
+
+// Kernel of binary batch operations for dispatch(),
+// which uses the widest instruction set in Isas having Op for T.
+template <typename Op, typename T>
+struct binary_kernel {
+  template <typename Isas, typename Output>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, const T* y, T* out,
+                                      std::size_t n, Output output) {
+    binary_loop<Op>(typename select_isa<Op, T, Isas>::type(),
+                    x, y, out, n, output);
+  }
+
+  template <typename Isas, typename Output>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, T y, T* out,
+                                      std::size_t n, Output output) {
+    binary_scalar_loop<Op>(typename select_isa<Op, T, Isas>::type(),
+                           x, y, out, n, output);
+  }
+};
+
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void ternary_loop(scalar_isa,
+                                      const T* x, const T* y, const T* z,
+                                      T* out, std::size_t n, Output output) {
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, apply(Op(), x[i], y[i], z[i]), x[i], y[i], z[i]);
+  }
+}
+
+template <typename Op, typename Isa, typename T, typename Output>
+SATOP_ALWAYS_INLINE void ternary_loop(Isa,
+                                      const T* x, const T* y, const T* z,
+                                      T* out, std::size_t n, Output output) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(T);
+  batch_writer<Op, T, Output> writer(output);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const vector_type vx = Isa::load(x + i);
+    const vector_type vy = Isa::load(y + i);
+    const vector_type vz = Isa::load(z + i);
+    writer.put_vector(Isa(), out + i,
+                      Isa::apply(Op(), vx, vy, vz, type_tag<T>()),
+                      vx, vy, vz);
+  }
+  ternary_loop<Op>(scalar_isa(), x + i, y + i, z + i, out + i, n - i,
+                   output);
+}
+
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void ternary_scalar_loop(scalar_isa,
+                                             const T* x, T y, const T* z,
+                                             T* out, std::size_t n,
+                                             Output output) {
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, apply(Op(), x[i], y, z[i]), x[i], y, z[i]);
+  }
+}
+
+template <typename Op, typename Isa, typename T, typename Output>
+SATOP_ALWAYS_INLINE void ternary_scalar_loop(Isa,
+                                             const T* x, T y, const T* z,
+                                             T* out, std::size_t n,
+                                             Output output) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(T);
+  const vector_type vy = Isa::broadcast(y);
+  batch_writer<Op, T, Output> writer(output);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const vector_type vx = Isa::load(x + i);
+    const vector_type vz = Isa::load(z + i);
+    writer.put_vector(Isa(), out + i,
+                      Isa::apply(Op(), vx, vy, vz, type_tag<T>()),
+                      vx, vy, vz);
+  }
+  ternary_scalar_loop<Op>(scalar_isa(), x + i, y, z + i, out + i, n - i,
+                          output);
+}
+
+// Kernel of ternary batch operations for dispatch(),
+// whose 2nd operand is an array or a value.
+template <typename Op, typename T>
+struct ternary_kernel {
+  template <typename Isas, typename Output>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, const T* y, const T* z,
+                                      T* out, std::size_t n, Output output) {
+    ternary_loop<Op>(typename select_isa<Op, T, Isas>::type(),
+                     x, y, z, out, n, output);
+  }
+
+  template <typename Isas, typename Output>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, T y, const T* z,
+                                      T* out, std::size_t n, Output output) {
+    ternary_scalar_loop<Op>(typename select_isa<Op, T, Isas>::type(),
+                            x, y, z, out, n, output);
+  }
+};
+template <typename From, typename To>
+SATOP_ALWAYS_INLINE void cast_loop(scalar_isa,
+                                   const From* x, To* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = saturated::saturate_cast<To>(x[i]);
+  }
+}
+
+template <typename Isa, typename From, typename To>
+SATOP_ALWAYS_INLINE void cast_loop(Isa,
+                                   const From* x, To* out, std::size_t n) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type) / sizeof(To);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    cast_vector(Isa(), x + i, out + i, narrowing_ratio<From, To>());
+  }
+  cast_loop(scalar_isa(), x + i, out + i, n - i);
+}
+
+template <typename From, typename To>
+struct cast_kernel {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const From* x, To* out, std::size_t n) {
+    cast_loop(typename select_isa<cast_op<From>, To, Isas>::type(),
+              x, out, n);
+  }
+};
+
+template <typename From, typename To, rounding Mode>
+SATOP_ALWAYS_INLINE void convert_loop(scalar_isa,
+                                      const From* x, From scale, To* out,
+                                      std::size_t n, rounding_tag<Mode> mode) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = convert<To>(static_cast<From>(x[i] * scale), mode);
+  }
+}
+
+template <typename Isa, typename From, typename To, rounding Mode>
+SATOP_ALWAYS_INLINE void convert_loop(Isa,
+                                      const From* x, From scale, To* out,
+                                      std::size_t n, rounding_tag<Mode> mode) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type) / sizeof(To);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    convert_vector(Isa(), x + i, scale, out + i, mode);
+  }
+  convert_loop(scalar_isa(), x + i, scale, out + i, n - i, mode);
+}
+
+template <typename From, typename To, rounding Mode>
+struct convert_kernel {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const From* x, From scale, To* out,
+                                      std::size_t n) {
+    convert_loop(typename select_isa<convert_op<From, Mode>, To, Isas>::type(),
+                 x, scale, out, n, rounding_tag<Mode>());
+  }
+};
+
+// Division by divider wraps around only for divisor -1,
+// which is left to the scalar loop.
+template <typename T>
+SATOP_ALWAYS_INLINE T divide_element(div_op, const divider<T>& y, T x) {
+  return y.divide(x);
+}
+
+template <typename T>
+SATOP_ALWAYS_INLINE T divide_element(wrap_op<div_op>, const divider<T>& y,
+                                     T x) {
+  return (std::is_signed<T>::value && (y.divisor() == static_cast<T>(-1)))
+      ? apply(wrap_op<div_op>(), x, y.divisor())
+      : y.divide(x);
+}
+
+// Vector division does not support divisor 0,
+// it is rare enough to leave to the scalar loop.
+template <typename T>
+SATOP_ALWAYS_INLINE bool is_vector_divisor(div_op, const divider<T>& y) {
+  return y.divisor() != 0;
+}
+
+template <typename T>
+SATOP_ALWAYS_INLINE bool is_vector_divisor(wrap_op<div_op>,
+                                           const divider<T>& y) {
+  return (y.divisor() != 0)
+      && !(std::is_signed<T>::value && (y.divisor() == static_cast<T>(-1)));
+}
+
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void divide_loop(scalar_isa,
+                                     const T* x, const divider<T>& y, T* out,
+                                     std::size_t n, Output output) {
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, divide_element(Op(), y, x[i]), x[i], y.divisor());
+  }
+}
+
+template <typename Op, typename Isa, typename T, typename Output>
+SATOP_ALWAYS_INLINE void divide_loop(Isa,
+                                     const T* x, const divider<T>& y, T* out,
+                                     std::size_t n, Output output) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(T);
+  std::size_t i = 0;
+  if (is_vector_divisor(Op(), y)) {
+    batch_writer<Op, T, Output> writer(output);
+    for (; i + kLanes <= n; i += kLanes) {
+      const vector_type vx = Isa::load(x + i);
+      writer.put_vector(Isa(), out + i, Isa::apply(div_op(), vx, y), vx, y);
+    }
+  }
+  divide_loop<Op>(scalar_isa(), x + i, y, out + i, n - i, output);
+}
+
+template <typename Op, typename T>
+struct divide_kernel {
+  template <typename Isas, typename Output>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, divider<T> y, T* out,
+                                      std::size_t n, Output output) {
+    divide_loop<Op>(typename select_isa<div_op, T, Isas>::type(),
+                    x, y, out, n, output);
+  }
+};
+
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void unary_loop(scalar_isa,
+                                    const T* x, T* out, std::size_t n,
+                                    Output output) {
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, apply(Op(), x[i]), x[i]);
+  }
+}
+
+template <typename Op, typename Isa, typename T, typename Output>
+SATOP_ALWAYS_INLINE void unary_loop(Isa,
+                                    const T* x, T* out, std::size_t n,
+                                    Output output) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(T);
+  batch_writer<Op, T, Output> writer(output);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const vector_type vx = Isa::load(x + i);
+    vector_type v;
+    unary_vector(Isa(), Op(), vx, &v, type_tag<T>());
+    writer.put_vector(Isa(), out + i, v, vx);
+  }
+  unary_loop<Op>(scalar_isa(), x + i, out + i, n - i, output);
+}
+
+template <typename Op, typename T>
+struct unary_kernel {
+  template <typename Isas, typename Output>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, T* out, std::size_t n,
+                                      Output output) {
+    unary_loop<Op>(typename select_isa<Op, T, Isas>::type(),
+                   x, out, n, output);
+  }
+};
+
+template <typename Op, typename T, typename Output>
+SATOP_ALWAYS_INLINE void shift_loop(scalar_isa,
+                                    const T* x, int shift, T* out,
+                                    std::size_t n, Output output) {
+  batch_writer<Op, T, Output> writer(output);
+  for (std::size_t i = 0; i < n; ++i) {
+    writer.put(out + i, apply(Op(), x[i], shift), x[i], shift);
+  }
+}
+
+template <typename Op, typename Isa, typename T, typename Output>
+SATOP_ALWAYS_INLINE void shift_loop(Isa,
+                                    const T* x, int shift, T* out,
+                                    std::size_t n, Output output) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(T);
+  const shift_factors<Isa, T> factors(shift);
+  batch_writer<Op, T, Output> writer(output);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const vector_type vx = Isa::load(x + i);
+    vector_type v = Isa::apply(mul_op(), vx, factors.factor, type_tag<T>());
+    if (factors.is_beyond_digits) {
+      v = Isa::apply(mul_op(), v, factors.two, type_tag<T>());
+    }
+    writer.put_vector(Isa(), out + i, v, vx, factors);
+  }
+  shift_loop<Op>(scalar_isa(), x + i, shift, out + i, n - i, output);
+}
+
+// Kernel of shift left, whose Op is always shl_op
+// to be given in the same way as the other kernels.
+template <typename Op, typename T>
+struct shift_kernel {
+  template <typename Isas, typename Output>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, int shift, T* out,
+                                      std::size_t n, Output output) {
+    shift_loop<Op>(typename select_isa<mul_op, T, Isas>::type(),
+                   x, shift, out, n, output);
+  }
+};
+
+SATOP_GENERIC_SIMD_END()
+
+// Kernels count saturations in the same pass as storing results.
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void count_batch(Op, Args... args) {
+  saturation_tally tally = {0, 0};
+  dispatch<Kernel<Op, T>>(args..., count_output{&tally});
+  record_saturations(saturation_op_of(Op()), tally);
+}
+
+// Rounding multiplication of fixed-point values is not counted
+// as well as operator*() of fixed.
+template <template <typename, typename> class Kernel, typename T,
+          int FracBits, typename... Args>
+void count_batch(fixed_mul_op<FracBits>, Args... args) {
+  dispatch<Kernel<fixed_mul_op<FracBits>, T>>(args..., store_output());
+}
+
+// Saturations which Op on T would make without storing any result.
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+saturation_tally check_batch(Op, Args... args) {
+  saturation_tally tally = {0, 0};
+  dispatch<Kernel<Op, T>>(args..., check_output{&tally});
+  return tally;
+}
+
+// Run Kernel of Op on T by Policy.  Args are the operands of Kernel
+// except its output.
+#ifdef SATOP_TELEMETRY
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void run_batch(saturate, Op, Args... args) {
+  count_batch<Kernel, T>(Op(), args...);
+}
+#else
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void run_batch(saturate, Op, Args... args) {
+  dispatch<Kernel<Op, T>>(args..., store_output());
+}
+#endif  // SATOP_TELEMETRY
+
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void run_batch(wrap, Op, Args... args) {
+  dispatch<Kernel<wrap_op<Op>, T>>(args..., store_output());
+}
+
+// Results may overwrite operands, so they are stored
+// only after checking all of them.
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void run_batch(trap, Op, Args... args) {
+  const saturation_tally tally = check_batch<Kernel, T>(Op(), args...);
+  if ((tally.overflow != 0) || (tally.underflow != 0)) {
+    throw saturation_error_of(saturation_op_of(Op()),
+                              ((tally.overflow != 0)
+                               ? saturation_kind::overflow
+                               : saturation_kind::underflow));
+  }
+  dispatch<Kernel<Op, T>>(args..., store_output());
+}
+
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void run_batch(report<saturate>, Op, Args... args) {
+  count_batch<Kernel, T>(Op(), args...);
+}
+
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void run_batch(report<wrap>, Op, Args... args) {
+  record_saturations(saturation_op_of(Op()),
+                     check_batch<Kernel, T>(Op(), args...));
+  run_batch<Kernel, T>(wrap(), Op(), args...);
+}
+
+template <typename Op, typename Policy, typename T, typename Y>
+void batch_with(Policy, const T* x, Y y, T* out, std::size_t n) {
+  run_batch<binary_kernel, T>(Policy(), Op(), x, y, out, n);
+}
+
+template <typename Op, typename T>
+void batch(const T* x, const T* y, T* out, std::size_t n) {
+  batch_with<Op>(saturate(), x, y, out, n);
+}
+
+template <typename Op, typename T>
+void batch(const T* x, T y, T* out, std::size_t n) {
+  batch_with<Op>(saturate(), x, y, out, n);
+}
+
+template <typename Op, typename T>
+void unary_batch(const T* x, T* out, std::size_t n) {
+  run_batch<unary_kernel, T>(saturate(), Op(), x, out, n);
+}
+
+template <typename T>
+void shift_batch(const T* x, int shift, T* out, std::size_t n) {
+  run_batch<shift_kernel, T>(saturate(), shl_op(), x, shift, out, n);
+}
+
+template <typename Op, typename T>
+void batch(const T* x, const T* y, const T* z, T* out, std::size_t n) {
+  run_batch<ternary_kernel, T>(saturate(), Op(), x, y, z, out, n);
+}
+
+template <typename Op, typename T>
+void batch(const T* x, T y, const T* z, T* out, std::size_t n) {
+  run_batch<ternary_kernel, T>(saturate(), Op(), x, y, z, out, n);
+}
+
+template <typename Policy, typename T>
+void divide_with(Policy, const T* x, const divider<T>& y, T* out,
+                 std::size_t n) {
+  run_batch<divide_kernel, T>(Policy(), div_op(), x, y, out, n);
+}
+
+// Operation on raw values of fixed-point values with FracBits fraction bits
+// which is the same as Op on fixed-point values.
+template <typename Op, int FracBits>
+struct fixed_raw_op {
+};
+
+template <int FracBits>
+struct fixed_raw_op<add_op, FracBits> {
+  using type = add_op;
+};
+
+template <int FracBits>
+struct fixed_raw_op<sub_op, FracBits> {
+  using type = sub_op;
+};
+
+template <int FracBits>
+struct fixed_raw_op<mul_op, FracBits> {
+  using type = fixed_mul_op<FracBits>;
+};
+
+// Arrays of fixed are processed as arrays of their raw values,
+// which are the only members of standard layout fixed.
+template <int IntBits, int FracBits, typename Storage>
+const Storage* raw_array(const fixed<IntBits, FracBits, Storage>* x) {
+  static_assert(std::is_standard_layout<
+                  fixed<IntBits, FracBits, Storage>>::value
+                && (sizeof(fixed<IntBits, FracBits, Storage>)
+                    == sizeof(Storage)),
+                "fixed must have the same layout as Storage");
+  return reinterpret_cast<const Storage*>(x);
+}
+
+template <int IntBits, int FracBits, typename Storage>
+Storage* raw_array(fixed<IntBits, FracBits, Storage>* x) {
+  return const_cast<Storage*>(
+      raw_array(static_cast<const fixed<IntBits, FracBits, Storage>*>(x)));
+}
+
+template <typename Op, int IntBits, int FracBits, typename Storage>
+void batch(const fixed<IntBits, FracBits, Storage>* x,
+           const fixed<IntBits, FracBits, Storage>* y,
+           fixed<IntBits, FracBits, Storage>* out,
+           std::size_t n) {
+  batch<typename fixed_raw_op<Op, FracBits>::type>(
+      raw_array(x), raw_array(y), raw_array(out), n);
+}
+
+template <typename Op, int IntBits, int FracBits, typename Storage>
+void batch(const fixed<IntBits, FracBits, Storage>* x,
+           fixed<IntBits, FracBits, Storage> y,
+           fixed<IntBits, FracBits, Storage>* out,
+           std::size_t n) {
+  batch<typename fixed_raw_op<Op, FracBits>::type>(
+      raw_array(x), y.raw(), raw_array(out), n);
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Add 2 arrays element by element with saturation.
+///
+/// out may be the same array as x or y,
+/// but it must not overlap them partially.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to add
+/// @param y   Array of values to add
+/// @param out Array to store add(x[i], y[i]) into
+/// @param n   Number of elements of each array
+template <typename T>
+void add(const T* x, const T* y, T* out, std::size_t n) {
+  impl::batch<impl::add_op>(x, y, out, n);
+}
+
+/// Add an array and a value element by element with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to add
+/// @param y   A value to add to each element of x
+/// @param out Array to store add(x[i], y) into, it may be the same as x
+/// @param n   Number of elements of each array
+template <typename T>
+void add(const T* x, T y, T* out, std::size_t n) {
+  impl::batch<impl::add_op>(x, y, out, n);
+}
+
+/// Add an array to another one in place with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x Array to be replaced with add(x[i], y[i])
+/// @param y Array of values to add
+/// @param n Number of elements of each array
+template <typename T>
+void add(T* x, const T* y, std::size_t n) {
+  impl::batch<impl::add_op>(static_cast<const T*>(x), y, x, n);
+}
+
+/// Add a value to each element of an array in place with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x Array to be replaced with add(x[i], y)
+/// @param y A value to add to each element of x
+/// @param n Number of elements of x
+template <typename T>
+void add(T* x, T y, std::size_t n) {
+  impl::batch<impl::add_op>(static_cast<const T*>(x), y, x, n);
+}
+
+/// Subtract 2 arrays element by element with saturation.
+///
+/// out may be the same array as x or y,
+/// but it must not overlap them partially.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to subtract from
+/// @param y   Array of values to subtract
+/// @param out Array to store sub(x[i], y[i]) into
+/// @param n   Number of elements of each array
+template <typename T>
+void sub(const T* x, const T* y, T* out, std::size_t n) {
+  impl::batch<impl::sub_op>(x, y, out, n);
+}
+
+/// Subtract a value from each element of an array with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to subtract from
+/// @param y   A value to subtract from each element of x
+/// @param out Array to store sub(x[i], y) into, it may be the same as x
+/// @param n   Number of elements of each array
+template <typename T>
+void sub(const T* x, T y, T* out, std::size_t n) {
+  impl::batch<impl::sub_op>(x, y, out, n);
+}
+
+/// Subtract an array from another one in place with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x Array to be replaced with sub(x[i], y[i])
+/// @param y Array of values to subtract
+/// @param n Number of elements of each array
+template <typename T>
+void sub(T* x, const T* y, std::size_t n) {
+  impl::batch<impl::sub_op>(static_cast<const T*>(x), y, x, n);
+}
+
+/// Subtract a value from each element of an array in place with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x Array to be replaced with sub(x[i], y)
+/// @param y A value to subtract from each element of x
+/// @param n Number of elements of x
+template <typename T>
+void sub(T* x, T y, std::size_t n) {
+  impl::batch<impl::sub_op>(static_cast<const T*>(x), y, x, n);
+}
+
+/// Multiply 2 arrays element by element with saturation.
+///
+/// out may be the same array as x or y,
+/// but it must not overlap them partially.
+/// Products of arrays of fixed are rounded as operator*() of fixed,
+/// by pmulhrsw for Q15 if it is available.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   Array of values to multiply
+/// @param out Array to store mul(x[i], y[i]) into
+/// @param n   Number of elements of each array
+template <typename T>
+void mul(const T* x, const T* y, T* out, std::size_t n) {
+  impl::batch<impl::mul_op>(x, y, out, n);
+}
+
+/// Multiply each element of an array by a value with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   A value to multiply each element of x by
+/// @param out Array to store mul(x[i], y) into, it may be the same as x
+/// @param n   Number of elements of each array
+template <typename T>
+void mul(const T* x, T y, T* out, std::size_t n) {
+  impl::batch<impl::mul_op>(x, y, out, n);
+}
+
+/// Multiply an array by another one in place with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x Array to be replaced with mul(x[i], y[i])
+/// @param y Array of values to multiply
+/// @param n Number of elements of each array
+template <typename T>
+void mul(T* x, const T* y, std::size_t n) {
+  impl::batch<impl::mul_op>(static_cast<const T*>(x), y, x, n);
+}
+
+/// Multiply each element of an array by a value in place with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x Array to be replaced with mul(x[i], y)
+/// @param y A value to multiply each element of x by
+/// @param n Number of elements of x
+template <typename T>
+void mul(T* x, T y, std::size_t n) {
+  impl::batch<impl::mul_op>(static_cast<const T*>(x), y, x, n);
+}
+
+/// Divide each element of an array by a prepared divisor with saturation.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x   Array of values to be divided
+/// @param y   Divisor to divide each element of x by
+/// @param out Array to store div(x[i], y.divisor()) into,
+///            it may be the same as x
+/// @param n   Number of elements of each array
+template <typename T>
+void div(const T* x, const divider<T>& y, T* out, std::size_t n) {
+  impl::divide_with(saturate(), x, y, out, n);
+}
+
+/// Divide each element of an array by a value with saturation.
+///
+/// The divisor is prepared as divider at each call,
+/// so use divider for repeated calls with the same divisor.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x   Array of values to be divided
+/// @param y   A value to divide each element of x by
+/// @param out Array to store div(x[i], y) into, it may be the same as x
+/// @param n   Number of elements of each array
+template <typename T>
+void div(const T* x, T y, T* out, std::size_t n) {
+  div(x, divider<T>(y), out, n);
+}
+
+/// Divide each element of an array by a prepared divisor in place
+/// with saturation.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x Array to be replaced with div(x[i], y.divisor())
+/// @param y Divisor to divide each element of x by
+/// @param n Number of elements of x
+template <typename T>
+void div(T* x, const divider<T>& y, std::size_t n) {
+  div(static_cast<const T*>(x), y, x, n);
+}
+
+/// Divide each element of an array by a value in place with saturation.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x Array to be replaced with div(x[i], y)
+/// @param y A value to divide each element of x by
+/// @param n Number of elements of x
+template <typename T>
+void div(T* x, T y, std::size_t n) {
+  div(static_cast<const T*>(x), divider<T>(y), x, n);
+}
+
+/// Negate each element of an array with saturation.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param x   Array of values to negate
+/// @param out Array to store neg(x[i]) into, it may be the same as x
+/// @param n   Number of elements of each array
+template <typename T>
+void neg(const T* x, T* out, std::size_t n) {
+  static_assert(std::is_integral<T>::value,
+                "neg supports only integral types");
+  impl::unary_batch<impl::neg_op>(x, out, n);
+}
+
+/// Negate each element of an array in place with saturation.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param x Array to be replaced with neg(x[i])
+/// @param n Number of elements of x
+template <typename T>
+void neg(T* x, std::size_t n) {
+  neg(static_cast<const T*>(x), x, n);
+}
+
+/// Absolute value of each element of an array with saturation.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param x   Array of values
+/// @param out Array to store abs(x[i]) into, it may be the same as x
+/// @param n   Number of elements of each array
+template <typename T>
+void abs(const T* x, T* out, std::size_t n) {
+  static_assert(std::is_integral<T>::value,
+                "abs supports only integral types");
+  impl::unary_batch<impl::abs_op>(x, out, n);
+}
+
+/// Replace each element of an array with its absolute value
+/// with saturation.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param x Array to be replaced with abs(x[i])
+/// @param n Number of elements of x
+template <typename T>
+void abs(T* x, std::size_t n) {
+  abs(static_cast<const T*>(x), x, n);
+}
+
+/// Shift each element of an array left with saturation.
+///
+/// Vectors are multiplied by 2^shift with saturation,
+/// which is the same as shifts with saturation.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param x     Array of values to shift
+/// @param shift Number of bits to shift each element of x by, 0 or more
+/// @param out   Array to store shl(x[i], shift) into,
+///              it may be the same as x
+/// @param n     Number of elements of each array
+template <typename T>
+void shl(const T* x, int shift, T* out, std::size_t n) {
+  static_assert(std::is_integral<T>::value,
+                "shl supports only integral types");
+  impl::shift_batch(x, shift, out, n);
+}
+
+/// Shift each element of an array left in place with saturation.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param x     Array to be replaced with shl(x[i], shift)
+/// @param shift Number of bits to shift each element of x by, 0 or more
+/// @param n     Number of elements of x
+template <typename T>
+void shl(T* x, int shift, std::size_t n) {
+  shl(static_cast<const T*>(x), shift, x, n);
+}
+
+/// Add 2 arrays element by element with an overflow policy.
+///
+/// out may be the same array as x or y,
+/// but it must not overlap them partially.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements
+///
+/// @param x   Array of values to add
+/// @param y   Array of values to add
+/// @param out Array to store add<Policy>(x[i], y[i]) into
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+add(const T* x, const T* y, T* out, std::size_t n) {
+  impl::batch_with<impl::add_op>(Policy(), x, y, out, n);
+}
+
+/// Add an array and a value element by element with an overflow policy.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements
+///
+/// @param x   Array of values to add
+/// @param y   A value to add to each element of x
+/// @param out Array to store add<Policy>(x[i], y) into,
+///            it may be the same as x
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+add(const T* x, T y, T* out, std::size_t n) {
+  impl::batch_with<impl::add_op>(Policy(), x, y, out, n);
+}
+
+/// Subtract 2 arrays element by element with an overflow policy.
+///
+/// out may be the same array as x or y,
+/// but it must not overlap them partially.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements
+///
+/// @param x   Array of values to subtract from
+/// @param y   Array of values to subtract
+/// @param out Array to store sub<Policy>(x[i], y[i]) into
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+sub(const T* x, const T* y, T* out, std::size_t n) {
+  impl::batch_with<impl::sub_op>(Policy(), x, y, out, n);
+}
+
+/// Subtract a value from each element of an array with an overflow policy.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements
+///
+/// @param x   Array of values to subtract from
+/// @param y   A value to subtract from each element of x
+/// @param out Array to store sub<Policy>(x[i], y) into,
+///            it may be the same as x
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+sub(const T* x, T y, T* out, std::size_t n) {
+  impl::batch_with<impl::sub_op>(Policy(), x, y, out, n);
+}
+
+/// Multiply 2 arrays element by element with an overflow policy.
+///
+/// out may be the same array as x or y,
+/// but it must not overlap them partially.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   Array of values to multiply
+/// @param out Array to store mul<Policy>(x[i], y[i]) into
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+mul(const T* x, const T* y, T* out, std::size_t n) {
+  impl::batch_with<impl::mul_op>(Policy(), x, y, out, n);
+}
+
+/// Multiply each element of an array by a value with an overflow policy.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   A value to multiply each element of x by
+/// @param out Array to store mul<Policy>(x[i], y) into,
+///            it may be the same as x
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+mul(const T* x, T y, T* out, std::size_t n) {
+  impl::batch_with<impl::mul_op>(Policy(), x, y, out, n);
+}
+
+/// Divide each element of an array by a prepared divisor
+/// with an overflow policy.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x   Array of values to be divided
+/// @param y   Divisor to divide each element of x by
+/// @param out Array to store div<Policy>(x[i], y.divisor()) into,
+///            it may be the same as x
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+div(const T* x, const divider<T>& y, T* out, std::size_t n) {
+  impl::divide_with(Policy(), x, y, out, n);
+}
+
+/// Divide each element of an array by a value with an overflow policy.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x   Array of values to be divided
+/// @param y   A value to divide each element of x by
+/// @param out Array to store div<Policy>(x[i], y) into,
+///            it may be the same as x
+/// @param n   Number of elements of each array
+template <typename Policy, typename T>
+typename std::enable_if<is_overflow_policy<Policy>::value>::type
+div(const T* x, T y, T* out, std::size_t n) {
+  impl::divide_with(Policy(), x, divider<T>(y), out, n);
+}
+
+/// Multiply 2 arrays and add another one element by element
+/// with saturation.
+///
+/// out may be the same array as x, y or z,
+/// but it must not overlap them partially.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   Array of values to multiply
+/// @param z   Array of values to add to the products
+/// @param out Array to store mul_add(x[i], y[i], z[i]) into
+/// @param n   Number of elements of each array
+template <typename T>
+void mul_add(const T* x, const T* y, const T* z, T* out, std::size_t n) {
+  impl::batch<impl::mul_add_op>(x, y, z, out, n);
+}
+
+/// Multiply each element of an array by a value and add another array
+/// with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   A value to multiply each element of x by
+/// @param z   Array of values to add to the products
+/// @param out Array to store mul_add(x[i], y, z[i]) into,
+///            it may be the same as x or z
+/// @param n   Number of elements of each array
+template <typename T>
+void mul_add(const T* x, T y, const T* z, T* out, std::size_t n) {
+  impl::batch<impl::mul_add_op>(x, y, z, out, n);
+}
+
+/// Accumulate products of 2 arrays element by element with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   Array of values to multiply
+/// @param acc Array to be replaced with mul_add(x[i], y[i], acc[i])
+/// @param n   Number of elements of each array
+template <typename T>
+void mul_add(const T* x, const T* y, T* acc, std::size_t n) {
+  impl::batch<impl::mul_add_op>(x, y, static_cast<const T*>(acc), acc, n);
+}
+
+/// Accumulate products of an array and a value element by element
+/// with saturation.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Array of values to multiply
+/// @param y   A value to multiply each element of x by
+/// @param acc Array to be replaced with mul_add(x[i], y, acc[i])
+/// @param n   Number of elements of each array
+template <typename T>
+void mul_add(const T* x, T y, T* acc, std::size_t n) {
+  impl::batch<impl::mul_add_op>(x, y, static_cast<const T*>(acc), acc, n);
+}
+
+/// Convert elements of an array into another type with saturation.
+///
+/// Narrowing conversions between integral types are vectorized
+/// by packing instructions.
+///
+/// @tparam To   Type of elements to convert into
+/// @tparam From Type of elements of x
+///
+/// @param x   Array of values to convert
+/// @param out Array to store saturate_cast<To>(x[i]) into,
+///            which must not overlap x
+/// @param n   Number of elements of each array
+template <typename To, typename From>
+void saturate_cast(const From* x, To* out, std::size_t n) {
+  impl::dispatch<impl::cast_kernel<From, To>>(x, out, n);
+}
+
+/// Convert elements of a floating point array into integral type
+/// with saturation, after multiplying them by a scale.
+///
+/// Results are the same as convert<To>(x[i] * scale, mode) bit by bit,
+/// except for NaN and infinities when compiled with -ffinite-math-only
+/// such as by -Ofast.
+/// Conversions into int8_t, uint8_t, int16_t, uint16_t and int32_t
+/// are vectorized, where rounding modes other than rounding::toward_zero
+/// need AVX2 at least.
+///
+/// @tparam From Floating point type of elements of x
+/// @tparam To   Integral type of elements to convert into, except bool
+///
+/// @param x     Array of values to convert
+/// @param out   Array to store results into, which must not overlap x
+/// @param n     Number of elements of each array
+/// @param scale A value to multiply elements of x by, such as 32768
+///              to convert audio samples in [-1, 1) into int16_t
+/// @param mode  Rounding mode
+template <typename From, typename To>
+void convert(const From* x, To* out, std::size_t n, From scale,
+             rounding mode = rounding::toward_zero) {
+  static_assert(std::is_floating_point<From>::value
+                && std::is_integral<To>::value
+                && !std::is_same<To, bool>::value,
+                "convert supports only floating point types"
+                " into integral types except bool");
+  switch (mode) {
+    case rounding::to_nearest:
+      impl::dispatch<impl::convert_kernel<From, To, rounding::to_nearest>>(
+          x, scale, out, n);
+      break;
+    case rounding::downward:
+      impl::dispatch<impl::convert_kernel<From, To, rounding::downward>>(
+          x, scale, out, n);
+      break;
+    case rounding::upward:
+      impl::dispatch<impl::convert_kernel<From, To, rounding::upward>>(
+          x, scale, out, n);
+      break;
+    case rounding::toward_zero:
+    default:
+      impl::dispatch<impl::convert_kernel<From, To, rounding::toward_zero>>(
+          x, scale, out, n);
+      break;
+  }
+}
+
+/// Convert elements of a floating point array into integral type
+/// with saturation.
+///
+/// @tparam From Floating point type of elements of x
+/// @tparam To   Integral type of elements to convert into, except bool
+///
+/// @param x    Array of values to convert
+/// @param out  Array to store convert<To>(x[i], mode) into,
+///             which must not overlap x
+/// @param n    Number of elements of each array
+/// @param mode Rounding mode
+template <typename From, typename To>
+void convert(const From* x, To* out, std::size_t n,
+             rounding mode = rounding::toward_zero) {
+  convert(x, out, n, static_cast<From>(1), mode);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_BATCH_PRIV_H_
@@ -0,0 +1,115 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_C_H_
+#define INCLUDE_SATOP_C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// C interface of batch operations for C programs and other languages.
+// Functions are exported from libsatop.so and libsatop.a
+// built by "make build-lib", with symbol version LIBSATOP_1.
+#if defined(SATOP_C_BUILD) && defined(__GNUC__)
+#define SATOP_C_API __attribute__((visibility("default")))
+#else
+#define SATOP_C_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @addtogroup libsatop_c
+///
+/// @{
+
+/// Instruction set levels of batch operations,
+/// same as saturated::simd_level.
+typedef enum satop_simd_level {
+  SATOP_SIMD_SCALAR,    ///< Portable C++ only
+  SATOP_SIMD_SSE2,      ///< SSE2
+  SATOP_SIMD_AVX2,      ///< AVX2
+  SATOP_SIMD_AVX512BW,  ///< AVX-512F and AVX-512BW
+} satop_simd_level;
+
+/// Same as saturated::supported_simd_level().
+SATOP_C_API satop_simd_level satop_supported_simd_level(void);
+
+/// Same as saturated::current_simd_level().
+SATOP_C_API satop_simd_level satop_current_simd_level(void);
+
+/// Same as saturated::force_simd_level().
+///
+/// @return Non-zero if level is supported and it is applied, otherwise 0
+SATOP_C_API int satop_force_simd_level(satop_simd_level level);
+
+/// Same as saturated::reset_simd_level().
+SATOP_C_API void satop_reset_simd_level(void);
+
+/// Declare functions for integer type "type" with suffix "name",
+/// such as satop_add_i16() and satop_add_i16_batch() for int16_t.
+///
+/// - satop_<op>_<name>(x, y) is saturated::<op>(x, y)
+///   for add, sub, mul and div, and satop_mul_add_<name>(x, y, z)
+///   is saturated::mul_add(x, y, z)
+/// - satop_<op>_<name>_batch(x, y, out, n) is batch version
+///   saturated::<op>(x, y, out, n) for add, sub and mul,
+///   and y of satop_div_<name>_batch() is a divisor for all elements
+/// - satop_mul_add_<name>_batch(x, y, z, out, n) is
+///   saturated::mul_add(x, y, z, out, n)
+#define SATOP_C_DECLARE(name, type)                                     \
+  SATOP_C_API type satop_add_##name(type x, type y);                    \
+  SATOP_C_API type satop_sub_##name(type x, type y);                    \
+  SATOP_C_API type satop_mul_##name(type x, type y);                    \
+  SATOP_C_API type satop_div_##name(type x, type y);                    \
+  SATOP_C_API type satop_mul_add_##name(type x, type y, type z);        \
+  SATOP_C_API void satop_add_##name##_batch(const type* x,              \
+                                            const type* y,              \
+                                            type* out, size_t n);       \
+  SATOP_C_API void satop_sub_##name##_batch(const type* x,              \
+                                            const type* y,              \
+                                            type* out, size_t n);       \
+  SATOP_C_API void satop_mul_##name##_batch(const type* x,              \
+                                            const type* y,              \
+                                            type* out, size_t n);       \
+  SATOP_C_API void satop_div_##name##_batch(const type* x, type y,      \
+                                            type* out, size_t n);       \
+  SATOP_C_API void satop_mul_add_##name##_batch(const type* x,          \
+                                                const type* y,          \
+                                                const type* z,          \
+                                                type* out, size_t n)
+
+SATOP_C_DECLARE(i8, int8_t);
+SATOP_C_DECLARE(u8, uint8_t);
+SATOP_C_DECLARE(i16, int16_t);
+SATOP_C_DECLARE(u16, uint16_t);
+SATOP_C_DECLARE(i32, int32_t);
+SATOP_C_DECLARE(u32, uint32_t);
+SATOP_C_DECLARE(i64, int64_t);
+SATOP_C_DECLARE(u64, uint64_t);
+
+#undef SATOP_C_DECLARE
+
+/// @}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // INCLUDE_SATOP_C_H_
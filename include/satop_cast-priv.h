@@ -0,0 +1,245 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_CAST_PRIV_H_
+#define INCLUDE_SATOP_CAST_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "satop_sign_util-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Rounding modes of convert() from floating point types.
+enum class rounding : int {
+  toward_zero,  ///< Truncated toward 0, same as saturate_cast()
+  to_nearest,   ///< Rounded to nearest, ties to even
+  downward,     ///< Rounded toward -inf
+  upward,       ///< Rounded toward +inf
+};
+
+/// @}
+
+namespace impl {
+
+// Negative values are compared as intmax_t and others as uintmax_t,
+// so any pair of integral types is compared without conversion.
+template <typename To, typename From>
+constexpr To saturate_cast(From value, std::true_type /* is_integral */,
+                           std::true_type /* is_integral */) {
+  using limits = std::numeric_limits<To>;
+  return csignbit(value)
+      ? ((static_cast<intmax_t>(value)
+          < static_cast<intmax_t>(limits::lowest()))
+         ? limits::lowest()
+         : static_cast<To>(value))
+      : ((static_cast<uintmax_t>(value)
+          > static_cast<uintmax_t>(limits::max()))
+         ? limits::max()
+         : static_cast<To>(value));
+}
+
+// 2 to the power of digits of To, which is exact in floating point types.
+template <typename From, typename To>
+constexpr From max_plus_one_as() {
+  return static_cast<From>(std::numeric_limits<To>::max() / 2 + 1)
+      * static_cast<From>(2);
+}
+
+// Values are truncated toward 0 as static_cast.
+// NaN fails all of comparisons, so it is 0.
+template <typename To, typename From>
+constexpr To saturate_cast(From value, std::false_type /* is_integral */,
+                           std::true_type /* is_integral */) {
+  using limits = std::numeric_limits<To>;
+  return (value >= max_plus_one_as<From, To>())
+      ? limits::max()
+      : ((value > static_cast<From>(limits::lowest()))
+         ? static_cast<To>(value)
+         : ((value <= static_cast<From>(limits::lowest()))
+            ? limits::lowest()
+            : static_cast<To>(0)));
+}
+
+// Any integral value is in range of floating point types.
+template <typename To, typename From>
+constexpr To saturate_cast(From value, std::true_type /* is_integral */,
+                           std::false_type /* is_integral */) {
+  return static_cast<To>(value);
+}
+
+template <typename To, typename From>
+constexpr To narrow_floating_point(From value, std::true_type /* is_wider */) {
+  return static_cast<To>(value);
+}
+
+// Infinities are saturated as results of arithmetic operations,
+// and NaN is kept.
+template <typename To, typename From>
+constexpr To narrow_floating_point(From value,
+                                   std::false_type /* is_wider */) {
+  using limits = std::numeric_limits<To>;
+  return (value > static_cast<From>(limits::max()))
+      ? limits::max()
+      : ((value < static_cast<From>(limits::lowest()))
+         ? limits::lowest()
+         : static_cast<To>(value));
+}
+
+template <typename To, typename From>
+constexpr To saturate_cast(From value, std::false_type /* is_integral */,
+                           std::false_type /* is_integral */) {
+  return narrow_floating_point<To>(
+      value,
+      std::integral_constant<bool,
+                             (std::numeric_limits<To>::max_exponent
+                              > std::numeric_limits<From>::max_exponent)>());
+}
+
+// Tag to choose implementations by rounding mode at compile time.
+template <rounding Mode>
+using rounding_tag = std::integral_constant<rounding, Mode>;
+
+// Ties are rounded to even regardless of floating point environment.
+// Differences from floor are exact, and values whose magnitudes
+// are not less than 2^digits are integers whose differences are 0.
+// NaN fails all of comparisons, so it is kept.
+template <typename F>
+F round_to_nearest_even(F value) {
+  const F lower = std::floor(value);
+  const F fraction = value - lower;
+  const F remainder = std::fmod(lower, static_cast<F>(2));
+  return ((fraction > static_cast<F>(0.5))
+          || (!(fraction < static_cast<F>(0.5))
+              && ((remainder < 0) || (remainder > 0))))
+      ? lower + static_cast<F>(1)
+      : lower;
+}
+
+template <typename F>
+F round_by(F value, rounding_tag<rounding::toward_zero>) {
+  return value;
+}
+
+template <typename F>
+F round_by(F value, rounding_tag<rounding::to_nearest>) {
+  return round_to_nearest_even(value);
+}
+
+template <typename F>
+F round_by(F value, rounding_tag<rounding::downward>) {
+  return std::floor(value);
+}
+
+template <typename F>
+F round_by(F value, rounding_tag<rounding::upward>) {
+  return std::ceil(value);
+}
+
+// Integral values after rounding are not changed by truncation
+// of saturate_cast().
+template <typename To, rounding Mode, typename From>
+To convert(From value, rounding_tag<Mode> mode) {
+  return saturate_cast<To>(round_by(value, mode),
+                           std::false_type(), std::true_type());
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Convert a value into another arithmetic type with saturation.
+///
+/// Integral values out of range of To are saturated to max or lowest of To.
+/// Floating point values are truncated toward 0 into integral types,
+/// where NaN is 0, and +inf and -inf are max and lowest of To.
+/// Floating point values out of range of narrower floating point type,
+/// including infinities, are max or lowest of it, and NaN is kept.
+///
+/// @tparam To   Type to convert into, arithmetic type except bool
+/// @tparam From Type of the value, arithmetic type except bool
+///
+/// @param value A value to convert
+///
+/// @return value saturated into the range of To.
+template <typename To, typename From>
+constexpr To saturate_cast(From value) {
+  static_assert(std::is_arithmetic<To>::value
+                && std::is_arithmetic<From>::value
+                && !std::is_same<To, bool>::value
+                && !std::is_same<From, bool>::value,
+                "saturate_cast supports only arithmetic types except bool");
+  return impl::saturate_cast<To>(value,
+                                 std::is_integral<From>(),
+                                 std::is_integral<To>());
+}
+
+/// Convert a floating point value into integral type with saturation,
+/// rounding it by a rounding mode.
+///
+/// It is the scalar version of batch convert().
+/// Results are saturate_cast<To>() of rounded values,
+/// so NaN is 0, and +inf and -inf are max and lowest of To.
+///
+/// @tparam To   Integral type to convert into, except bool
+/// @tparam From Floating point type of the value
+///
+/// @param value A value to convert
+/// @param mode  Rounding mode
+///
+/// @return value rounded by mode and saturated into the range of To.
+template <typename To, typename From>
+To convert(From value, rounding mode = rounding::toward_zero) {
+  static_assert(std::is_floating_point<From>::value
+                && std::is_integral<To>::value
+                && !std::is_same<To, bool>::value,
+                "convert supports only floating point types"
+                " into integral types except bool");
+  switch (mode) {
+    case rounding::to_nearest:
+      return impl::convert<To>(value,
+                               impl::rounding_tag<rounding::to_nearest>());
+    case rounding::downward:
+      return impl::convert<To>(value, impl::rounding_tag<rounding::downward>());
+    case rounding::upward:
+      return impl::convert<To>(value, impl::rounding_tag<rounding::upward>());
+    case rounding::toward_zero:
+    default:
+      return impl::convert<To>(value,
+                               impl::rounding_tag<rounding::toward_zero>());
+  }
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_CAST_PRIV_H_
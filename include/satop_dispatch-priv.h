@@ -0,0 +1,286 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_DISPATCH_PRIV_H_
+#define INCLUDE_SATOP_DISPATCH_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <atomic>
+
+#include "satop_simd-priv.h"
+#include "satop_simd_avx2-priv.h"
+#include "satop_simd_avx512bw-priv.h"
+#include "satop_simd_avx512vnni-priv.h"
+#include "satop_simd_sse2-priv.h"
+
+#if defined(SATOP_SIMD_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Instruction set levels of batch operations, narrower one first.
+enum class simd_level : int {
+  scalar,    ///< Portable C++ only
+  sse2,      ///< SSE2
+  avx2,      ///< AVX2
+  avx512bw,  ///< AVX-512F and AVX-512BW
+};
+
+/// @}
+
+namespace impl {
+
+#if !defined(SATOP_SIMD_X86)
+
+inline simd_level detect_simd_level() {
+  return simd_level::scalar;
+}
+
+#elif defined(_MSC_VER) && !defined(__clang__)
+
+// Instructions are usable only if both CPU and OS support them,
+// OS support is checked by XCR0 which tells saved register states.
+inline simd_level detect_simd_level() {
+  int regs[4] = {};
+  __cpuid(regs, 0);
+  const int max_leaf = regs[0];
+  __cpuid(regs, 1);
+  if ((regs[3] & (1 << 26)) == 0) {
+    return simd_level::scalar;
+  }
+  const bool has_osxsave = (regs[2] & (1 << 27)) != 0;
+  if (!has_osxsave || (max_leaf < 7)) {
+    return simd_level::sse2;
+  }
+  const unsigned __int64 xcr0 = _xgetbv(0);
+  __cpuidex(regs, 7, 0);
+  const bool has_avx_state = (xcr0 & 0x06) == 0x06;
+  const bool has_avx512_state = (xcr0 & 0xe6) == 0xe6;
+  if (has_avx512_state
+      && ((regs[1] & (1 << 16)) != 0) && ((regs[1] & (1 << 30)) != 0)) {
+    return simd_level::avx512bw;
+  }
+  if (has_avx_state && ((regs[1] & (1 << 5)) != 0)) {
+    return simd_level::avx2;
+  }
+  return simd_level::sse2;
+}
+
+// AVX512-VNNI is used only if the level is simd_level::avx512bw,
+// so register states are already checked.
+inline bool detect_avx512vnni() {
+  int regs[4] = {};
+  __cpuid(regs, 0);
+  if (regs[0] < 7) {
+    return false;
+  }
+  __cpuidex(regs, 7, 0);
+  return (regs[2] & (1 << 11)) != 0;
+}
+
+#else
+
+// __builtin_cpu_supports() checks OS support of register states too.
+inline simd_level detect_simd_level() {
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("avx512f")
+          && __builtin_cpu_supports("avx512bw"))
+      ? simd_level::avx512bw
+      : __builtin_cpu_supports("avx2")
+      ? simd_level::avx2
+      : __builtin_cpu_supports("sse2")
+      ? simd_level::sse2
+      : simd_level::scalar;
+}
+
+inline bool detect_avx512vnni() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512vnni");
+}
+
+#endif
+
+inline simd_level supported_simd_level() {
+  static const simd_level level = detect_simd_level();
+  return level;
+}
+
+#ifdef SATOP_SIMD_X86
+
+inline bool supports_avx512vnni() {
+  static const bool is_supported = detect_avx512vnni();
+  return is_supported;
+}
+
+#endif  // SATOP_SIMD_X86
+
+// Level used by batch operations, shared by all translation units.
+SATOP_NOINLINE std::atomic<simd_level>& active_simd_level() {
+  static std::atomic<simd_level> level(supported_simd_level());
+  return level;
+}
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+// Entry functions of each instruction set level.
+// Kernel::run(isa_list<...>, ...) must be inlined into them
+// so that it is compiled for their instruction sets.
+template <typename Kernel, typename... Args>
+void run_scalar(Args... args) {
+  Kernel::run(isa_list<>(), args...);
+}
+
+#ifdef SATOP_SIMD_X86
+
+SATOP_TARGET_REGION_BEGIN("sse2")
+
+template <typename Kernel, typename... Args>
+void run_sse2(Args... args) {
+  Kernel::run(isa_list<sse2>(), args...);
+}
+
+SATOP_TARGET_REGION_END()
+
+SATOP_TARGET_REGION_BEGIN("avx2")
+
+template <typename Kernel, typename... Args>
+void run_avx2(Args... args) {
+  Kernel::run(isa_list<avx2, sse2>(), args...);
+}
+
+SATOP_TARGET_REGION_END()
+
+SATOP_TARGET_REGION_BEGIN("avx512f,avx512bw")
+
+template <typename Kernel, typename... Args>
+void run_avx512bw(Args... args) {
+  Kernel::run(isa_list<avx512bw, avx2, sse2>(), args...);
+}
+
+SATOP_TARGET_REGION_END()
+
+SATOP_TARGET_REGION_BEGIN("avx512f,avx512bw,avx512vnni")
+
+template <typename Kernel, typename... Args>
+void run_avx512vnni(Args... args) {
+  Kernel::run(isa_list<avx512vnni, avx512bw, avx2, sse2>(), args...);
+}
+
+SATOP_TARGET_REGION_END()
+
+#endif  // SATOP_SIMD_X86
+
+SATOP_GENERIC_SIMD_END()
+
+// Run Kernel with the widest instruction set of the active level.
+template <typename Kernel, typename... Args>
+void dispatch(Args... args) {
+  switch (active_simd_level().load(std::memory_order_relaxed)) {
+#ifdef SATOP_SIMD_X86
+    case simd_level::avx512bw:
+      run_avx512bw<Kernel>(args...);
+      break;
+    case simd_level::avx2:
+      run_avx2<Kernel>(args...);
+      break;
+    case simd_level::sse2:
+      run_sse2<Kernel>(args...);
+      break;
+#endif  // SATOP_SIMD_X86
+    case simd_level::scalar:
+    default:
+      run_scalar<Kernel>(args...);
+      break;
+  }
+}
+
+// Run Kernel as dispatch(), but with avx512vnni in place of avx512bw
+// if the CPU supports it, for kernels using dot products of pairs.
+template <typename Kernel, typename... Args>
+void dispatch_vnni(Args... args) {
+#ifdef SATOP_SIMD_X86
+  if ((active_simd_level().load(std::memory_order_relaxed)
+       == simd_level::avx512bw)
+      && supports_avx512vnni()) {
+    run_avx512vnni<Kernel>(args...);
+    return;
+  }
+#endif  // SATOP_SIMD_X86
+  dispatch<Kernel>(args...);
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Get the widest instruction set level which this CPU supports.
+///
+/// It is detected once per process.
+///
+/// @return The widest supported level,
+///         simd_level::scalar if SATOP_NO_SIMD is defined
+inline simd_level supported_simd_level() {
+  return impl::supported_simd_level();
+}
+
+/// Get the instruction set level which batch operations use now.
+///
+/// @return supported_simd_level() unless it is changed
+///         by force_simd_level()
+inline simd_level current_simd_level() {
+  return impl::active_simd_level().load(std::memory_order_relaxed);
+}
+
+/// Force batch operations to use an instruction set level.
+///
+/// It affects all threads, and it is intended to test
+/// and to compare each level on one machine.
+///
+/// @param level Instruction set level to use
+///
+/// @return true if level is supported and it is applied, otherwise false
+SATOP_NOINLINE bool force_simd_level(simd_level level) {
+  const bool is_supported =
+      static_cast<int>(level) <= static_cast<int>(supported_simd_level());
+  if (is_supported) {
+    impl::active_simd_level().store(level, std::memory_order_relaxed);
+  }
+  return is_supported;
+}
+
+/// Let batch operations use supported_simd_level() again.
+inline void reset_simd_level() {
+  impl::active_simd_level().store(supported_simd_level(),
+                                  std::memory_order_relaxed);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_DISPATCH_PRIV_H_
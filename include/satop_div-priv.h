@@ -23,12 +23,135 @@
 #error Do not include this file directly, libsatop.h instead.
 #endif
 
+#include <cstdint>
 #include <limits>
+#include <type_traits>
 
 #include "satop_sign_util-priv.h"
+#include "satop_telemetry-priv.h"
+#include "satop_wider_type-priv.h"
 
 namespace saturated {
 
+namespace impl {
+
+// Result of division by 0, saturated in the direction of sign of x.
+template <typename T>
+constexpr T div_by_zero(T x) {
+  return ((x > 0)
+          ? std::numeric_limits<T>::max()
+          : (csignbit(x) ? std::numeric_limits<T>::lowest() : T(0)));
+}
+
+// Quotients of floating point values can exceed max only by infinity.
+template <typename T>
+constexpr T clamp_quotient(T quotient) {
+  return ((quotient > std::numeric_limits<T>::max())
+          ? std::numeric_limits<T>::max()
+          : ((quotient < std::numeric_limits<T>::lowest())
+             ? std::numeric_limits<T>::lowest()
+             : quotient));
+}
+
+template <typename T>
+constexpr T div(T x, T y, unsigned_integer_tag) {
+  return ((y == 0) ? div_by_zero(x) : static_cast<T>(x / y));
+}
+
+// Only lowest / -1 overflows, its quotient is max + 1.
+template <typename T>
+constexpr T div(T x, T y, signed_integer_tag) {
+  return ((y == 0)
+          ? div_by_zero(x)
+          : (((y == -1) && (x == std::numeric_limits<T>::lowest()))
+             ? std::numeric_limits<T>::max()
+             : static_cast<T>(x / y)));
+}
+
+// y is compared without operator== to avoid floating point equality.
+template <typename T>
+constexpr T div(T x, T y, floating_point_tag) {
+  return (((y < 0) || (y > 0))
+          ? clamp_quotient(x / y)
+          : div_by_zero(x));
+}
+
+// Kind of saturation of div(x, 0).
+template <typename T>
+constexpr saturation_kind div_by_zero_saturation(T x) {
+  return ((x > 0)
+          ? saturation_kind::overflow
+          : (csignbit(x) ? saturation_kind::underflow : saturation_kind::none));
+}
+
+// Kind of saturation of div(x, y).
+template <typename T>
+constexpr saturation_kind div_saturation(T x, T y, unsigned_integer_tag) {
+  return ((y == 0) ? div_by_zero_saturation(x) : saturation_kind::none);
+}
+
+template <typename T>
+constexpr saturation_kind div_saturation(T x, T y, signed_integer_tag) {
+  return ((y == 0)
+          ? div_by_zero_saturation(x)
+          : (((y == -1) && (x == std::numeric_limits<T>::lowest()))
+             ? saturation_kind::overflow
+             : saturation_kind::none));
+}
+
+template <typename T>
+constexpr saturation_kind div_saturation(T x, T y, floating_point_tag) {
+  return (((y < 0) || (y > 0))
+          ? (((x / y) > std::numeric_limits<T>::max())
+             ? saturation_kind::overflow
+             : (((x / y) < std::numeric_limits<T>::lowest())
+                ? saturation_kind::underflow
+                : saturation_kind::none))
+          : div_by_zero_saturation(x));
+}
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_div(T result, T x, T y) {
+  return observe(saturation_op::div, result,
+                 div_saturation(x, y, arithmetic_category<T>()));
+}
+#endif  // SATOP_TELEMETRY
+
+// Upper half of the product of 2 unsigned values.
+template <typename U>
+constexpr U mulhi(U x, U y) {
+  using wider_t = typename wider_type<U>::type;
+  return static_cast<U>((static_cast<wider_t>(x) * static_cast<wider_t>(y))
+                        >> std::numeric_limits<U>::digits);
+}
+
+// Recursion of the portable version is too deep to be inlined
+// into constructors of divider, so GCC and Clang count leading zeros.
+template <typename U>
+constexpr int floor_log2(U x) {
+#if defined(__GNUC__)
+  return ((x > 1) ? (63 - __builtin_clzll(static_cast<uint64_t>(x))) : 0);
+#else
+  return ((x > 1) ? (1 + floor_log2(static_cast<U>(x >> 1))) : 0);
+#endif
+}
+
+template <typename U>
+constexpr bool is_power_of_2(U x) {
+  return ((x & (x - 1)) == 0);
+}
+
+template <typename T>
+constexpr typename std::make_unsigned<T>::type magnitude(T x) {
+  using U = typename std::make_unsigned<T>::type;
+  return (csignbit(x)
+          ? static_cast<U>(static_cast<U>(0) - static_cast<U>(x))
+          : static_cast<U>(x));
+}
+
+}  // namespace impl
+
 /// @addtogroup libsatop
 ///
 /// @{
@@ -37,17 +160,137 @@ namespace saturated {
 ///
 /// @tparam T Type of arguments and the return value
 ///
-/// @param x A value to divtiply
-/// @param y A value to divtiply
+/// @param x A value to be divided
+/// @param y A value to divide by
 ///
-/// @return If divtiply results causes overflow, returns max of T.
+/// @return If y is 0, returns max of T for positive x,
+///         min(lowest) of T for negative x, or 0 for x of 0.
+///         If division results causes overflow, returns max of T.
 ///         If underflow, returns min(lowest) of T.
-///         If no overflow and no underflow, returns x + y.
+///         Otherwise, returns x / y.
+///
+/// @see saturation_snapshot() to count saturations
 template <typename T>
 constexpr T div(T x, T y) {
-  return static_cast<T>(x / y);
+  return SATOP_OBSERVE(div,
+                       impl::div(x, y, impl::arithmetic_category<T>()),
+                       x, y);
 }
 
+/// Divisor prepared to divide many values by it quickly.
+///
+/// Division is replaced with multiplication by magic number and shifts,
+/// which batch operations can also run with SIMD instructions.
+/// Quotient of unsigned magnitudes is calculated as
+/// (t + ((n - t) >> shift1())) >> shift2(), where t is mulhi(n, magic()),
+/// and then sign is applied.
+///
+/// @tparam T Type of dividends and the divisor,
+///           integral type whose width is up to 32 bits
+template <typename T>
+class divider {
+  static_assert(std::is_integral<T>::value
+                && (sizeof(T) <= sizeof(int32_t)),
+                "divider supports only integral types up to 32 bits");
+
+ public:
+  /// Type of magic number and magnitude of values.
+  using unsigned_type = typename std::make_unsigned<T>::type;
+
+  /// Prepare to divide by a divisor.
+  ///
+  /// @param divisor A value to divide by, it may be 0
+  explicit divider(T divisor)
+      : divisor_(divisor),
+        magic_(magic_of(impl::magnitude(divisor))),
+        shift1_(shift1_of(impl::magnitude(divisor))),
+        shift2_(shift2_of(impl::magnitude(divisor))) {
+  }
+
+  /// @return The divisor
+  T divisor() const {
+    return divisor_;
+  }
+
+  /// @return Magic number to multiply magnitude of dividends by
+  unsigned_type magic() const {
+    return magic_;
+  }
+
+  /// @return Shift count of the difference of dividend and product
+  int shift1() const {
+    return shift1_;
+  }
+
+  /// @return Shift count of the quotient
+  int shift2() const {
+    return shift2_;
+  }
+
+  /// @return true if the divisor is negative
+  bool is_negative() const {
+    return impl::csignbit(divisor_);
+  }
+
+  /// Divide a value by the divisor with saturation.
+  ///
+  /// @param x A value to be divided
+  ///
+  /// @return The same value as div(x, divisor())
+  T divide(T x) const {
+    return ((divisor_ == 0)
+            ? impl::div_by_zero(x)
+            : apply_sign(divide_magnitude(impl::magnitude(x)),
+                         impl::csignbit(x) != is_negative()));
+  }
+
+ private:
+  static constexpr int kDigits = std::numeric_limits<unsigned_type>::digits;
+
+  // Magic number is 2^N * (2^l - d) / d + 1 for l = ceil(log2(d)),
+  // or 0 for powers of 2 which need only shifts.
+  static unsigned_type magic_of(unsigned_type d) {
+    return (impl::is_power_of_2(d)
+            ? static_cast<unsigned_type>(0)
+            : static_cast<unsigned_type>(
+                ((uint64_t(1) << kDigits)
+                 * ((uint64_t(1) << (impl::floor_log2(d) + 1)) - d)) / d
+                + 1));
+  }
+
+  static int shift1_of(unsigned_type d) {
+    return ((d > 1) ? 1 : 0);
+  }
+
+  static int shift2_of(unsigned_type d) {
+    return ((d <= 1)
+            ? 0
+            : (impl::is_power_of_2(d)
+               ? (impl::floor_log2(d) - 1)
+               : impl::floor_log2(d)));
+  }
+
+  unsigned_type divide_magnitude(unsigned_type n) const {
+    const unsigned_type t = impl::mulhi(n, magic_);
+    return static_cast<unsigned_type>(
+        (t + static_cast<unsigned_type>((n - t) >> shift1_)) >> shift2_);
+  }
+
+  // Only magnitude of lowest / -1 exceeds max of T.
+  static T apply_sign(unsigned_type q, bool is_negative_quotient) {
+    return (is_negative_quotient
+            ? static_cast<T>(static_cast<unsigned_type>(0 - q))
+            : ((q > static_cast<unsigned_type>(std::numeric_limits<T>::max()))
+               ? std::numeric_limits<T>::max()
+               : static_cast<T>(q)));
+  }
+
+  T divisor_;
+  unsigned_type magic_;
+  int shift1_;
+  int shift2_;
+};
+
 /// @}
 
 }  // namespace saturated
@@ -0,0 +1,325 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_EXPR_PRIV_H_
+#define INCLUDE_SATOP_EXPR_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "satop_batch-priv.h"
+#include "satop_op-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Lazy expression of arrays, which is evaluated by evaluate().
+///
+/// It is made by lazy(), operators +, - and *, clamp()
+/// and saturate_cast(), and it keeps only pointers to arrays
+/// and values of operands.
+///
+/// @tparam Node Implementation of the expression
+template <typename Node>
+class array_expr {
+ public:
+  /// Type of elements of the expression.
+  using value_type = typename Node::value_type;
+
+  /// Construct from an implementation.
+  ///
+  /// @param node Implementation of the expression
+  explicit array_expr(const Node& node)
+      : node_(node) {
+  }
+
+  /// Get the implementation of the expression.
+  ///
+  /// @return The implementation
+  const Node& node() const {
+    return node_;
+  }
+
+ private:
+  Node node_;
+};
+
+/// @}
+
+namespace impl {
+
+// Elements of expressions are evaluated chunk by chunk,
+// where each node stores a chunk of its results into a buffer on stack
+// by a batch operation, so that buffers stay in L1 cache
+// and arrays are read only once.
+constexpr std::size_t kExprChunk = 1024;
+
+// Implementations of array_expr, whose eval() returns elements
+// from offset to offset + n, either in place or in buffer.
+template <typename T>
+struct expr_array {
+  using value_type = T;
+
+  const T* eval(std::size_t offset, std::size_t /* n */,
+                T* /* buffer */) const {
+    return data + offset;
+  }
+
+  const T* data;
+};
+
+template <typename T>
+struct expr_value {
+  using value_type = T;
+
+  const T* eval(std::size_t /* offset */, std::size_t n, T* buffer) const {
+    std::fill(buffer, buffer + n, value);
+    return buffer;
+  }
+
+  T value;
+};
+
+template <typename Op, typename X, typename Y>
+struct expr_binary {
+  using value_type = typename X::value_type;
+  static_assert(std::is_same<value_type, typename Y::value_type>::value,
+                "Operands of array_expr must have the same type.");
+
+  const value_type* eval(std::size_t offset, std::size_t n,
+                         value_type* buffer) const {
+    value_type x_buffer[kExprChunk];
+    value_type y_buffer[kExprChunk];
+    batch<Op>(x.eval(offset, n, x_buffer), y.eval(offset, n, y_buffer),
+              buffer, n);
+    return buffer;
+  }
+
+  X x;
+  Y y;
+};
+
+// A value as the right operand is not expanded into a buffer.
+template <typename Op, typename X>
+struct expr_binary<Op, X, expr_value<typename X::value_type>> {
+  using value_type = typename X::value_type;
+
+  const value_type* eval(std::size_t offset, std::size_t n,
+                         value_type* buffer) const {
+    value_type x_buffer[kExprChunk];
+    batch<Op>(x.eval(offset, n, x_buffer), y.value, buffer, n);
+    return buffer;
+  }
+
+  X x;
+  expr_value<value_type> y;
+};
+
+template <typename X>
+struct expr_clamp {
+  using value_type = typename X::value_type;
+
+  const value_type* eval(std::size_t offset, std::size_t n,
+                         value_type* buffer) const {
+    value_type x_buffer[kExprChunk];
+    const value_type* values = x.eval(offset, n, x_buffer);
+    for (std::size_t i = 0; i < n; ++i) {
+      buffer[i] = std::min(std::max(values[i], lowest), max);
+    }
+    return buffer;
+  }
+
+  X x;
+  value_type lowest;
+  value_type max;
+};
+
+template <typename To, typename X>
+struct expr_cast {
+  using value_type = To;
+
+  const To* eval(std::size_t offset, std::size_t n, To* buffer) const {
+    typename X::value_type x_buffer[kExprChunk];
+    saturated::saturate_cast(x.eval(offset, n, x_buffer), buffer, n);
+    return buffer;
+  }
+
+  X x;
+};
+
+template <typename Op, typename X, typename Y>
+array_expr<expr_binary<Op, X, Y>> make_expr(Op, const X& x, const Y& y) {
+  return array_expr<expr_binary<Op, X, Y>>(expr_binary<Op, X, Y>{x, y});
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Make an array_expr of an array.
+///
+/// @tparam T Type of elements
+///
+/// @param x Array, which must be alive until evaluate()
+///
+/// @return array_expr whose elements are x[i]
+template <typename T>
+array_expr<impl::expr_array<T>> lazy(const T* x) {
+  return array_expr<impl::expr_array<T>>(impl::expr_array<T>{x});
+}
+
+/// Add elements of 2 array_expr with saturation.
+template <typename X, typename Y>
+array_expr<impl::expr_binary<impl::add_op, X, Y>>
+operator+(const array_expr<X>& x, const array_expr<Y>& y) {
+  return impl::make_expr(impl::add_op(), x.node(), y.node());
+}
+
+/// Add a value to elements of array_expr with saturation.
+template <typename X>
+array_expr<impl::expr_binary<impl::add_op, X,
+                             impl::expr_value<typename X::value_type>>>
+operator+(const array_expr<X>& x, typename X::value_type y) {
+  return impl::make_expr(impl::add_op(), x.node(),
+                         impl::expr_value<typename X::value_type>{y});
+}
+
+/// Add elements of array_expr to a value with saturation.
+template <typename Y>
+array_expr<impl::expr_binary<impl::add_op, Y,
+                             impl::expr_value<typename Y::value_type>>>
+operator+(typename Y::value_type x, const array_expr<Y>& y) {
+  return y + x;
+}
+
+/// Subtract elements of an array_expr from another one with saturation.
+template <typename X, typename Y>
+array_expr<impl::expr_binary<impl::sub_op, X, Y>>
+operator-(const array_expr<X>& x, const array_expr<Y>& y) {
+  return impl::make_expr(impl::sub_op(), x.node(), y.node());
+}
+
+/// Subtract a value from elements of array_expr with saturation.
+template <typename X>
+array_expr<impl::expr_binary<impl::sub_op, X,
+                             impl::expr_value<typename X::value_type>>>
+operator-(const array_expr<X>& x, typename X::value_type y) {
+  return impl::make_expr(impl::sub_op(), x.node(),
+                         impl::expr_value<typename X::value_type>{y});
+}
+
+/// Subtract elements of array_expr from a value with saturation.
+template <typename Y>
+array_expr<impl::expr_binary<impl::sub_op,
+                             impl::expr_value<typename Y::value_type>, Y>>
+operator-(typename Y::value_type x, const array_expr<Y>& y) {
+  return impl::make_expr(impl::sub_op(),
+                         impl::expr_value<typename Y::value_type>{x},
+                         y.node());
+}
+
+/// Multiply elements of 2 array_expr with saturation.
+template <typename X, typename Y>
+array_expr<impl::expr_binary<impl::mul_op, X, Y>>
+operator*(const array_expr<X>& x, const array_expr<Y>& y) {
+  return impl::make_expr(impl::mul_op(), x.node(), y.node());
+}
+
+/// Multiply elements of array_expr by a value with saturation.
+template <typename X>
+array_expr<impl::expr_binary<impl::mul_op, X,
+                             impl::expr_value<typename X::value_type>>>
+operator*(const array_expr<X>& x, typename X::value_type y) {
+  return impl::make_expr(impl::mul_op(), x.node(),
+                         impl::expr_value<typename X::value_type>{y});
+}
+
+/// Multiply a value by elements of array_expr with saturation.
+template <typename Y>
+array_expr<impl::expr_binary<impl::mul_op, Y,
+                             impl::expr_value<typename Y::value_type>>>
+operator*(typename Y::value_type x, const array_expr<Y>& y) {
+  return y * x;
+}
+
+/// Clamp elements of array_expr into a range.
+///
+/// @param x      Elements to clamp
+/// @param lowest The lower bound
+/// @param max    The upper bound, which must not be less than lowest
+///
+/// @return array_expr whose elements are in [lowest, max]
+template <typename X>
+array_expr<impl::expr_clamp<X>> clamp(const array_expr<X>& x,
+                                      typename X::value_type lowest,
+                                      typename X::value_type max) {
+  return array_expr<impl::expr_clamp<X>>(
+      impl::expr_clamp<X>{x.node(), lowest, max});
+}
+
+/// Convert elements of array_expr into another type with saturation,
+/// as saturate_cast() of each element.
+///
+/// @tparam To Type to convert into
+///
+/// @param x Elements to convert
+///
+/// @return array_expr whose elements are saturate_cast<To>() of x
+template <typename To, typename X>
+array_expr<impl::expr_cast<To, X>> saturate_cast(const array_expr<X>& x) {
+  return array_expr<impl::expr_cast<To, X>>(impl::expr_cast<To, X>{x.node()});
+}
+
+/// Evaluate array_expr into an array in one pass.
+///
+/// Results are the same as batch operations applied in order
+/// with temporary arrays, such as add(mul(a, b), c)
+/// for lazy(a) * lazy(b) + lazy(c), but arrays are read only once
+/// and no memory is allocated.
+///
+/// @param expr Expression to evaluate
+/// @param out  Array to store results into, which may be the same
+///             as arrays of expr, but must not overlap them otherwise
+/// @param n    Number of elements of out and arrays of expr
+template <typename X>
+void evaluate(const array_expr<X>& expr, typename X::value_type* out,
+              std::size_t n) {
+  for (std::size_t offset = 0; offset < n; offset += impl::kExprChunk) {
+    const std::size_t chunk = std::min(impl::kExprChunk, n - offset);
+    const auto* values = expr.node().eval(offset, chunk, out + offset);
+    if (values != out + offset) {
+      std::copy(values, values + chunk, out + offset);
+    }
+  }
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_EXPR_PRIV_H_
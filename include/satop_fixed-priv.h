@@ -0,0 +1,337 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_FIXED_PRIV_H_
+#define INCLUDE_SATOP_FIXED_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "satop_add-priv.h"
+#include "satop_cast-priv.h"
+#include "satop_sub-priv.h"
+#include "satop_wider_type-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Multiply fixed-point values with FracBits fraction bits,
+// rounding the product to nearest (ties toward +inf) and saturating it,
+// as vqrdmulh and pmulhrsw do for FracBits == digits of T.
+// Right shift of negative values is arithmetic on supported compilers.
+template <int FracBits, typename T>
+constexpr T rounding_mul(T x, T y) {
+  using wider_t = typename wider_type<T>::type;
+  return clamp_cast<T>(static_cast<wider_t>(
+      (static_cast<wider_t>(x) * static_cast<wider_t>(y)
+       + ((static_cast<wider_t>(1) << FracBits) >> 1)) >> FracBits));
+}
+
+// Floating point type to convert fixed-point values through,
+// which has enough precision for raw values of 32 bits.
+template <typename F>
+using fixed_conversion_type = typename std::common_type<F, double>::type;
+
+// Raw value nearest to value * 2^FracBits with saturation,
+// ties away from 0.
+template <int FracBits, typename Storage, typename F>
+constexpr Storage fixed_raw_from(F value) {
+  using conversion_t = fixed_conversion_type<F>;
+  return saturated::saturate_cast<Storage>(
+      static_cast<conversion_t>(value)
+      * static_cast<conversion_t>(static_cast<uintmax_t>(1) << FracBits)
+      + ((value < 0)
+         ? static_cast<conversion_t>(-0.5)
+         : static_cast<conversion_t>(0.5)));
+}
+
+// Tag to construct fixed from a raw value.
+struct raw_tag {};
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Signed fixed-point value in Q format whose arithmetic saturates.
+///
+/// fixed<0, 15, int16_t> is Q15 and fixed<0, 31, int32_t> is Q31.
+/// Multiplication rounds the product to nearest, ties toward +inf,
+/// which is the same as vqrdmulh of ARM and pmulhrsw of x86 for Q15,
+/// and it never divides.
+/// Arrays of fixed are available for batch add(), sub() and mul().
+///
+/// @tparam IntBits  Number of integer bits except the sign bit
+/// @tparam FracBits Number of fraction bits
+/// @tparam Storage  Type of raw values, signed integral type whose width
+///                  is up to 32 bits and is IntBits + FracBits + 1
+template <int IntBits, int FracBits, typename Storage>
+class fixed {
+  static_assert(std::is_integral<Storage>::value
+                && std::is_signed<Storage>::value
+                && (sizeof(Storage) <= sizeof(int32_t)),
+                "fixed supports only signed integral types up to 32 bits");
+  static_assert((IntBits >= 0) && (FracBits >= 0)
+                && (IntBits + FracBits
+                    == std::numeric_limits<Storage>::digits),
+                "IntBits + FracBits + 1 must be width of Storage");
+
+ public:
+  /// Type of raw values.
+  using storage_type = Storage;
+
+  /// Number of integer bits except the sign bit.
+  static constexpr int kIntBits = IntBits;
+
+  /// Number of fraction bits.
+  static constexpr int kFracBits = FracBits;
+
+  /// Construct fixed of 0.
+  constexpr fixed()
+      : raw_(0) {
+  }
+
+  /// Construct fixed nearest to a floating point value with saturation.
+  ///
+  /// Ties are rounded away from 0, NaN is 0.
+  ///
+  /// @tparam F Floating point type
+  ///
+  /// @param value A value to convert
+  template <typename F,
+            typename std::enable_if<std::is_floating_point<F>::value,
+                                    bool>::type = true>
+  constexpr explicit fixed(F value)
+      : raw_(impl::fixed_raw_from<FracBits, Storage>(value)) {
+  }
+
+  /// Construct fixed from a raw value.
+  ///
+  /// @param raw A raw value, which is value * 2^FracBits
+  ///
+  /// @return fixed whose raw value is raw
+  static constexpr fixed from_raw(Storage raw) {
+    return fixed(impl::raw_tag(), raw);
+  }
+
+  /// @return The raw value, which is value * 2^FracBits
+  constexpr Storage raw() const {
+    return raw_;
+  }
+
+  /// Convert into a floating point value.
+  ///
+  /// It multiplies by 2^-FracBits instead of dividing by 2^FracBits.
+  ///
+  /// @tparam F Floating point type
+  ///
+  /// @return The value
+  template <typename F,
+            typename std::enable_if<std::is_floating_point<F>::value,
+                                    bool>::type = true>
+  constexpr explicit operator F() const {
+    return static_cast<F>(
+        static_cast<impl::fixed_conversion_type<F>>(raw_)
+        * (static_cast<impl::fixed_conversion_type<F>>(1)
+           / static_cast<impl::fixed_conversion_type<F>>(
+               static_cast<uintmax_t>(1) << FracBits)));
+  }
+
+  /// Add a value with saturation.
+  ///
+  /// @param y A value to add
+  ///
+  /// @return This object
+  fixed& operator+=(fixed y) {
+    raw_ = saturated::add(raw_, y.raw_);
+    return *this;
+  }
+
+  /// Subtract a value with saturation.
+  ///
+  /// @param y A value to subtract
+  ///
+  /// @return This object
+  fixed& operator-=(fixed y) {
+    raw_ = saturated::sub(raw_, y.raw_);
+    return *this;
+  }
+
+  /// Multiply by a value with rounding and saturation.
+  ///
+  /// @param y A value to multiply by
+  ///
+  /// @return This object
+  fixed& operator*=(fixed y) {
+    raw_ = impl::rounding_mul<FracBits>(raw_, y.raw_);
+    return *this;
+  }
+
+ private:
+  constexpr fixed(impl::raw_tag, Storage raw)
+      : raw_(raw) {
+  }
+
+  Storage raw_;
+};
+
+template <int IntBits, int FracBits, typename Storage>
+constexpr int fixed<IntBits, FracBits, Storage>::kIntBits;
+
+template <int IntBits, int FracBits, typename Storage>
+constexpr int fixed<IntBits, FracBits, Storage>::kFracBits;
+
+/// Add fixed-point values with saturation.
+///
+/// @param x A value to add
+/// @param y A value to add
+///
+/// @return x + y saturated into the range of fixed
+template <int IntBits, int FracBits, typename Storage>
+constexpr fixed<IntBits, FracBits, Storage> operator+(
+    fixed<IntBits, FracBits, Storage> x,
+    fixed<IntBits, FracBits, Storage> y) {
+  return fixed<IntBits, FracBits, Storage>::from_raw(
+      saturated::add(x.raw(), y.raw()));
+}
+
+/// Subtract fixed-point values with saturation.
+///
+/// @param x A value to subtract from
+/// @param y A value to subtract
+///
+/// @return x - y saturated into the range of fixed
+template <int IntBits, int FracBits, typename Storage>
+constexpr fixed<IntBits, FracBits, Storage> operator-(
+    fixed<IntBits, FracBits, Storage> x,
+    fixed<IntBits, FracBits, Storage> y) {
+  return fixed<IntBits, FracBits, Storage>::from_raw(
+      saturated::sub(x.raw(), y.raw()));
+}
+
+/// Negate a fixed-point value with saturation.
+///
+/// @param x A value to negate
+///
+/// @return -x, which is max of fixed if x is lowest of it
+template <int IntBits, int FracBits, typename Storage>
+constexpr fixed<IntBits, FracBits, Storage> operator-(
+    fixed<IntBits, FracBits, Storage> x) {
+  return fixed<IntBits, FracBits, Storage>::from_raw(
+      saturated::sub(static_cast<Storage>(0), x.raw()));
+}
+
+/// Multiply fixed-point values with rounding and saturation.
+///
+/// @param x A value to multiply
+/// @param y A value to multiply
+///
+/// @return x * y rounded to nearest, ties toward +inf,
+///         and saturated into the range of fixed
+template <int IntBits, int FracBits, typename Storage>
+constexpr fixed<IntBits, FracBits, Storage> operator*(
+    fixed<IntBits, FracBits, Storage> x,
+    fixed<IntBits, FracBits, Storage> y) {
+  return fixed<IntBits, FracBits, Storage>::from_raw(
+      impl::rounding_mul<FracBits>(x.raw(), y.raw()));
+}
+
+/// Compare fixed-point values.
+///
+/// @param x A value to compare
+/// @param y A value to compare
+///
+/// @return true if x and y are equal
+template <int IntBits, int FracBits, typename Storage>
+constexpr bool operator==(fixed<IntBits, FracBits, Storage> x,
+                          fixed<IntBits, FracBits, Storage> y) {
+  return (x.raw() == y.raw());
+}
+
+/// Compare fixed-point values.
+///
+/// @param x A value to compare
+/// @param y A value to compare
+///
+/// @return true if x and y are not equal
+template <int IntBits, int FracBits, typename Storage>
+constexpr bool operator!=(fixed<IntBits, FracBits, Storage> x,
+                          fixed<IntBits, FracBits, Storage> y) {
+  return (x.raw() != y.raw());
+}
+
+/// Compare fixed-point values.
+///
+/// @param x A value to compare
+/// @param y A value to compare
+///
+/// @return true if x is less than y
+template <int IntBits, int FracBits, typename Storage>
+constexpr bool operator<(fixed<IntBits, FracBits, Storage> x,
+                         fixed<IntBits, FracBits, Storage> y) {
+  return (x.raw() < y.raw());
+}
+
+/// Compare fixed-point values.
+///
+/// @param x A value to compare
+/// @param y A value to compare
+///
+/// @return true if x is less than or equal to y
+template <int IntBits, int FracBits, typename Storage>
+constexpr bool operator<=(fixed<IntBits, FracBits, Storage> x,
+                          fixed<IntBits, FracBits, Storage> y) {
+  return (x.raw() <= y.raw());
+}
+
+/// Compare fixed-point values.
+///
+/// @param x A value to compare
+/// @param y A value to compare
+///
+/// @return true if x is greater than y
+template <int IntBits, int FracBits, typename Storage>
+constexpr bool operator>(fixed<IntBits, FracBits, Storage> x,
+                         fixed<IntBits, FracBits, Storage> y) {
+  return (x.raw() > y.raw());
+}
+
+/// Compare fixed-point values.
+///
+/// @param x A value to compare
+/// @param y A value to compare
+///
+/// @return true if x is greater than or equal to y
+template <int IntBits, int FracBits, typename Storage>
+constexpr bool operator>=(fixed<IntBits, FracBits, Storage> x,
+                          fixed<IntBits, FracBits, Storage> y) {
+  return (x.raw() >= y.raw());
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_FIXED_PRIV_H_
@@ -0,0 +1,323 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_GEMM_PRIV_H_
+#define INCLUDE_SATOP_GEMM_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "satop_cast-priv.h"
+#include "satop_dispatch-priv.h"
+#include "satop_op-priv.h"
+#include "satop_simd-priv.h"
+#include "satop_view-priv.h"
+#include "satop_wider_type-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Requantization of 32 bits accumulators of gemm() into results,
+/// saturate_cast<Out>(((acc * multiplier + rounding) >> shift) + offset)
+/// calculated in 64 bits, where rounding is half of 1 << shift
+/// to round ties upward.
+struct requantization {
+  int32_t multiplier;  ///< Multiplier of accumulators
+  int shift;           ///< Right shift of products, from 0 to 31
+  int32_t offset;      ///< Offset added after shift, as zero point
+};
+
+/// @}
+
+namespace impl {
+
+// Dot products of pairs have an accumulator and 2 operands.
+template <typename Isa, typename T>
+struct has_vector_binary<
+  Isa, dot_pairs_op, T,
+  decltype(static_cast<void>(Isa::apply(dot_pairs_op(),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        type_tag<T>())))>
+    : public std::true_type {
+};
+
+// Blocking of gemm() as BLIS.  A block of kGemmBlockPairs pairs
+// of rows of b and kGemmBlockCols columns is packed to stay in L3 cache,
+// and a block of kGemmBlockRows rows of a is packed to stay in L2 cache.
+// Micro tiles of kGemmTileRows rows and 2 vectors of columns
+// are accumulated in registers.
+constexpr std::size_t kGemmTileRows = 4;
+constexpr std::size_t kGemmBlockRows = 64;
+constexpr std::size_t kGemmBlockCols = 512;
+constexpr std::size_t kGemmBlockPairs = 128;
+
+// Columns of a micro tile, kGemmMaxTileCols for the widest one.
+template <typename Isa>
+constexpr std::size_t gemm_tile_cols(Isa) {
+  return 2 * sizeof(typename Isa::vector_type) / sizeof(int32_t);
+}
+
+constexpr std::size_t gemm_tile_cols(scalar_isa) {
+  return 8;
+}
+
+constexpr std::size_t kGemmMaxTileCols = 32;
+
+constexpr std::size_t round_up(std::size_t n, std::size_t unit) {
+  return (n + unit - 1) / unit * unit;
+}
+
+// Element (row, col) of x widened into int16_t, or 0 out of x.
+template <typename T>
+int16_t element_or_zero(const matrix_view<T>& x,
+                        std::size_t row, std::size_t col) {
+  return ((row < x.rows) && (col < x.cols))
+      ? static_cast<int16_t>(*element_of(x, row, col))
+      : int16_t(0);
+}
+
+// Elements of a pair of columns of a in a 32 bits lane,
+// the lower column in lower 16 bits.
+template <typename T>
+int32_t pair_of_cols(const matrix_view<T>& a,
+                     std::size_t row, std::size_t pair) {
+  const uint16_t lo =
+      static_cast<uint16_t>(element_or_zero(a, row, 2 * pair));
+  const uint16_t hi =
+      static_cast<uint16_t>(element_or_zero(a, row, 2 * pair + 1));
+  return static_cast<int32_t>(static_cast<uint32_t>(lo)
+                              | (static_cast<uint32_t>(hi) << 16));
+}
+
+// Pack rows of a from row0 into panels of kGemmTileRows rows,
+// where pairs of columns of each row are in 32 bits lanes
+// and rows of a pair are contiguous.
+template <typename T>
+void pack_gemm_rows(const matrix_view<T>& a, std::size_t row0,
+                    std::size_t rows, std::size_t pair0,
+                    std::size_t pairs, int32_t* out) {
+  for (std::size_t panel = 0; panel < rows; panel += kGemmTileRows) {
+    for (std::size_t pair = pair0; pair < pair0 + pairs; ++pair) {
+      for (std::size_t row = 0; row < kGemmTileRows; ++row) {
+        *out++ = pair_of_cols(a, row0 + panel + row, pair);
+      }
+    }
+  }
+}
+
+// Pack columns of b from col0 into panels of tile_cols columns,
+// where a pair of rows of each column are in a 32 bits lane
+// and columns of a pair are contiguous.
+template <typename T>
+void pack_gemm_cols(const matrix_view<T>& b, std::size_t col0,
+                    std::size_t cols, std::size_t tile_cols,
+                    std::size_t pair0, std::size_t pairs, int16_t* out) {
+  for (std::size_t panel = 0; panel < cols; panel += tile_cols) {
+    for (std::size_t pair = pair0; pair < pair0 + pairs; ++pair) {
+      for (std::size_t col = 0; col < tile_cols; ++col) {
+        *out++ = element_or_zero(b, 2 * pair, col0 + panel + col);
+        *out++ = element_or_zero(b, 2 * pair + 1, col0 + panel + col);
+      }
+    }
+  }
+}
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+// Accumulate a micro tile of packed a and b into acc.
+SATOP_ALWAYS_INLINE void gemm_tile(scalar_isa, const int32_t* a,
+                                   const int16_t* b, std::size_t pairs,
+                                   int32_t* acc, std::size_t acc_stride) {
+  constexpr std::size_t kCols = gemm_tile_cols(scalar_isa());
+  for (std::size_t row = 0; row < kGemmTileRows; ++row) {
+    for (std::size_t col = 0; col < kCols; ++col) {
+      int32_t sum = acc[row * acc_stride + col];
+      for (std::size_t pair = 0; pair < pairs; ++pair) {
+        const int32_t x = a[pair * kGemmTileRows + row];
+        const int16_t* y = b + (pair * kCols + col) * 2;
+        sum = clamp_cast<int32_t>(
+            sum + int64_t{static_cast<int16_t>(x & 0xffff)} * y[0]
+            + int64_t{static_cast<int16_t>(x >> 16)} * y[1]);
+      }
+      acc[row * acc_stride + col] = sum;
+    }
+  }
+}
+
+template <typename Isa>
+SATOP_ALWAYS_INLINE void gemm_tile(Isa, const int32_t* a,
+                                   const int16_t* b, std::size_t pairs,
+                                   int32_t* acc, std::size_t acc_stride) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(int32_t);
+  vector_type sums[kGemmTileRows][2];
+  for (std::size_t row = 0; row < kGemmTileRows; ++row) {
+    sums[row][0] = Isa::load(acc + row * acc_stride);
+    sums[row][1] = Isa::load(acc + row * acc_stride + kLanes);
+  }
+  for (std::size_t pair = 0; pair < pairs; ++pair) {
+    const vector_type y0 = Isa::load(b);
+    const vector_type y1 = Isa::load(b + 2 * kLanes);
+    for (std::size_t row = 0; row < kGemmTileRows; ++row) {
+      const vector_type x = Isa::broadcast(a[row]);
+      sums[row][0] = Isa::apply(dot_pairs_op(), sums[row][0], x, y0,
+                                type_tag<int16_t>());
+      sums[row][1] = Isa::apply(dot_pairs_op(), sums[row][1], x, y1,
+                                type_tag<int16_t>());
+    }
+    a += kGemmTileRows;
+    b += 4 * kLanes;
+  }
+  for (std::size_t row = 0; row < kGemmTileRows; ++row) {
+    Isa::store(acc + row * acc_stride, sums[row][0]);
+    Isa::store(acc + row * acc_stride + kLanes, sums[row][1]);
+  }
+}
+
+// Kernel of gemm() for dispatch_vnni(), which accumulates products
+// of a and columns from col0 of b into acc, whose rows and columns
+// are padded to multiples of micro tiles.
+struct gemm_kernel {
+  template <typename Isas, typename TA, typename TB>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      matrix_view<TA> a,
+                                      matrix_view<TB> b,
+                                      std::size_t col0, std::size_t cols,
+                                      int32_t* acc, std::size_t acc_stride,
+                                      int32_t* a_pack, int16_t* b_pack) {
+    using isa = typename select_isa<dot_pairs_op, int16_t, Isas>::type;
+    constexpr std::size_t kCols = gemm_tile_cols(isa());
+    const std::size_t all_pairs = (a.cols + 1) / 2;
+    const std::size_t padded_cols = round_up(cols, kCols);
+    for (std::size_t pair0 = 0; pair0 < all_pairs;
+         pair0 += kGemmBlockPairs) {
+      const std::size_t pairs = std::min(kGemmBlockPairs, all_pairs - pair0);
+      pack_gemm_cols(b, col0, padded_cols, kCols, pair0, pairs, b_pack);
+      for (std::size_t row0 = 0; row0 < a.rows; row0 += kGemmBlockRows) {
+        const std::size_t rows =
+            round_up(std::min(kGemmBlockRows, a.rows - row0), kGemmTileRows);
+        pack_gemm_rows(a, row0, rows, pair0, pairs, a_pack);
+        for (std::size_t col = 0; col < padded_cols; col += kCols) {
+          for (std::size_t row = 0; row < rows; row += kGemmTileRows) {
+            gemm_tile(isa(), a_pack + row * pairs, b_pack + col * pairs * 2,
+                      pairs, acc + (row0 + row) * acc_stride + col,
+                      acc_stride);
+          }
+        }
+      }
+    }
+  }
+};
+
+SATOP_GENERIC_SIMD_END()
+
+template <typename Out>
+Out requantize(int32_t acc, const requantization& q) {
+  const int64_t rounding =
+      (q.shift > 0) ? (int64_t{1} << (q.shift - 1)) : int64_t{0};
+  return saturated::saturate_cast<Out>(
+      ((int64_t{acc} * q.multiplier + rounding) >> q.shift) + q.offset);
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Multiply matrices of 8 bits or 16 bits integers with saturation
+/// into 32 bits accumulators, and requantize them.
+///
+/// Each accumulator starts from 0, and products of pairs of columns
+/// of a row of a and rows of a column of b are added into it
+/// in order of columns of a, as acc = sat(acc + a0 * b0 + a1 * b1)
+/// where only the sum is saturated into int32_t,
+/// same as vpdpwssds of AVX512-VNNI.  The last pair has a0 * b0 only
+/// if columns of a are odd.
+/// Results are the same in all instruction sets.
+///
+/// @tparam TA  Type of elements of a, int8_t or int16_t, may be const
+/// @tparam TB  Type of elements of b, int8_t or int16_t, may be const
+/// @tparam Out Type of elements of c, integral type
+///
+/// @param a A matrix of M rows and K columns
+/// @param b A matrix of K rows and N columns
+/// @param c A matrix of M rows and N columns to store results into,
+///          which must not overlap a or b
+/// @param q Requantization of accumulators into c,
+///          accumulators are saturated into Out by default
+template <typename TA, typename TB, typename Out>
+void gemm(const matrix_view<TA>& a, const matrix_view<TB>& b,
+          const matrix_view<Out>& c,
+          const requantization& q = requantization{1, 0, 0}) {
+  using a_type = typename std::remove_const<TA>::type;
+  using b_type = typename std::remove_const<TB>::type;
+  static_assert((std::is_same<a_type, int8_t>::value
+                 || std::is_same<a_type, int16_t>::value)
+                && (std::is_same<b_type, int8_t>::value
+                    || std::is_same<b_type, int16_t>::value),
+                "gemm() supports only int8_t and int16_t for inputs.");
+  static_assert(std::is_integral<Out>::value && !std::is_const<Out>::value,
+                "gemm() stores results into integral types.");
+  if ((c.rows == 0) || (c.cols == 0)) {
+    return;
+  }
+  const std::size_t pairs =
+      std::min((a.cols + 1) / 2, impl::kGemmBlockPairs);
+  const std::size_t block_cols = std::min(c.cols, impl::kGemmBlockCols);
+  const std::size_t acc_stride =
+      impl::round_up(block_cols, impl::kGemmMaxTileCols);
+  std::vector<int32_t> acc(impl::round_up(c.rows, impl::kGemmTileRows)
+                           * acc_stride);
+  std::vector<int32_t> a_pack(
+      impl::round_up(std::min(c.rows, impl::kGemmBlockRows),
+                     impl::kGemmTileRows) * pairs);
+  std::vector<int16_t> b_pack(acc_stride * pairs * 2);
+  for (std::size_t col0 = 0; col0 < c.cols; col0 += impl::kGemmBlockCols) {
+    const std::size_t cols = std::min(impl::kGemmBlockCols, c.cols - col0);
+    std::fill(acc.begin(), acc.end(), 0);
+    impl::dispatch_vnni<impl::gemm_kernel>(a, b, col0, cols, acc.data(),
+                                           acc_stride, a_pack.data(),
+                                           b_pack.data());
+    for (std::size_t row = 0; row < c.rows; ++row) {
+      const int32_t* sums = acc.data() + row * acc_stride;
+      for (std::size_t col = 0; col < cols; ++col) {
+        *impl::element_of(c, row, col0 + col) =
+            impl::requantize<Out>(sums[col], q);
+      }
+    }
+  }
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_GEMM_PRIV_H_
@@ -0,0 +1,442 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_IMAGE_PRIV_H_
+#define INCLUDE_SATOP_IMAGE_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "satop_batch-priv.h"
+#include "satop_dispatch-priv.h"
+#include "satop_fixed-priv.h"
+#include "satop_op-priv.h"
+#include "satop_simd-priv.h"
+#include "satop_wider_type-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// View of an image whose channels are T, which does not own them.
+///
+/// Each row has width * channels elements, and rows are stride elements
+/// apart.  Images of interleaved RGBA have 4 channels, and each plane
+/// of planar images is an image of 1 channel.
+///
+/// @tparam T Type of channels, uint8_t or const uint8_t
+template <typename T>
+struct image_view {
+  T* data;                ///< The first element of the first row
+  std::size_t width;      ///< Number of pixels in each row
+  std::size_t height;     ///< Number of rows
+  std::ptrdiff_t stride;  ///< Elements from a row to the next row,
+                          ///< negative for bottom-up images
+  std::size_t channels;   ///< Number of interleaved channels of each pixel
+
+  /// Read only view of the same image.
+  template <typename U,
+            typename std::enable_if<std::is_same<U, const T>::value
+                                    && !std::is_const<T>::value,
+                                    bool>::type = true>
+  operator image_view<U>() const {
+    return image_view<U>{data, width, height, stride, channels};
+  }
+};
+
+/// Gain of scale_image() in Q7.8, 1.0 keeps values.
+using image_gain = fixed<7, 8, int16_t>;
+
+/// @}
+
+namespace impl {
+
+// Image operations have 8 bits channels, and they are not binary.
+template <typename Isa, typename T>
+struct has_vector_binary<
+  Isa, scale_op, T,
+  decltype(static_cast<void>(Isa::apply(scale_op(),
+                                        Isa::load(nullptr),
+                                        int16_t(), int16_t(),
+                                        type_tag<T>())))>
+    : public std::true_type {
+};
+
+template <typename Isa, typename T>
+struct has_vector_binary<
+  Isa, blend_op, T,
+  decltype(static_cast<void>(Isa::apply(blend_op(),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        uint8_t(),
+                                        type_tag<T>())))>
+    : public std::true_type {
+};
+
+template <typename Isa, typename T>
+struct has_vector_binary<
+  Isa, composite_op, T,
+  decltype(static_cast<void>(Isa::apply(composite_op(),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        type_tag<T>())))>
+    : public std::true_type {
+};
+
+// Rounded quotient of v up to 255 * 255 divided by 255.
+// v / 255 is never a tie, so adding 127 rounds it to nearest.
+constexpr uint8_t div255(unsigned int v) {
+  return static_cast<uint8_t>((v + 127U) / 255U);
+}
+
+constexpr uint8_t apply(scale_op, uint8_t x, int16_t gain, int16_t offset) {
+  return clamp_cast<uint8_t>(
+      ((static_cast<int32_t>(x) * gain + 128) >> 8) + offset);
+}
+
+constexpr uint8_t apply(blend_op, uint8_t x, uint8_t y, uint8_t alpha) {
+  return div255(static_cast<unsigned int>(x) * alpha
+                + static_cast<unsigned int>(y) * (UINT8_MAX - alpha));
+}
+
+// Premultiplied src is composited over dst, where src saturates
+// if its channels are larger than alpha.
+constexpr uint8_t apply(composite_op, uint8_t src, uint8_t alpha,
+                        uint8_t dst) {
+  return apply(add_op(), src,
+               div255(static_cast<unsigned int>(dst)
+                      * (UINT8_MAX - alpha)));
+}
+
+// The first element of a row of an image.
+template <typename T>
+T* row_of(const image_view<T>& image, std::size_t y) {
+  return image.data + static_cast<std::ptrdiff_t>(y) * image.stride;
+}
+
+// Number of elements in each row of an image.
+template <typename T>
+std::size_t row_size(const image_view<T>& image) {
+  return image.width * image.channels;
+}
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+SATOP_ALWAYS_INLINE void scale_loop(scalar_isa,
+                                    const uint8_t* x, int16_t gain,
+                                    int16_t offset, uint8_t* out,
+                                    std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = apply(scale_op(), x[i], gain, offset);
+  }
+}
+
+template <typename Isa>
+SATOP_ALWAYS_INLINE void scale_loop(Isa,
+                                    const uint8_t* x, int16_t gain,
+                                    int16_t offset, uint8_t* out,
+                                    std::size_t n) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    Isa::store(out + i, Isa::apply(scale_op(), Isa::load(x + i),
+                                   gain, offset, type_tag<uint8_t>()));
+  }
+  scale_loop(scalar_isa(), x + i, gain, offset, out + i, n - i);
+}
+
+SATOP_ALWAYS_INLINE void blend_loop(scalar_isa,
+                                    const uint8_t* x, const uint8_t* y,
+                                    uint8_t alpha, uint8_t* out,
+                                    std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = apply(blend_op(), x[i], y[i], alpha);
+  }
+}
+
+template <typename Isa>
+SATOP_ALWAYS_INLINE void blend_loop(Isa,
+                                    const uint8_t* x, const uint8_t* y,
+                                    uint8_t alpha, uint8_t* out,
+                                    std::size_t n) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    Isa::store(out + i, Isa::apply(blend_op(),
+                                   Isa::load(x + i), Isa::load(y + i),
+                                   alpha, type_tag<uint8_t>()));
+  }
+  blend_loop(scalar_isa(), x + i, y + i, alpha, out + i, n - i);
+}
+
+// Alpha of planar images is in a plane.
+SATOP_ALWAYS_INLINE void composite_loop(scalar_isa,
+                                        const uint8_t* src,
+                                        const uint8_t* alpha,
+                                        const uint8_t* dst, uint8_t* out,
+                                        std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = apply(composite_op(), src[i], alpha[i], dst[i]);
+  }
+}
+
+template <typename Isa>
+SATOP_ALWAYS_INLINE void composite_loop(Isa,
+                                        const uint8_t* src,
+                                        const uint8_t* alpha,
+                                        const uint8_t* dst, uint8_t* out,
+                                        std::size_t n) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    Isa::store(out + i, Isa::apply(composite_op(),
+                                   Isa::load(src + i), Isa::load(alpha + i),
+                                   Isa::load(dst + i), type_tag<uint8_t>()));
+  }
+  composite_loop(scalar_isa(), src + i, alpha + i, dst + i, out + i, n - i);
+}
+
+// Alpha of RGBA images is the last channel of each pixel,
+// and n is number of channels.
+SATOP_ALWAYS_INLINE void composite_rgba_loop(scalar_isa,
+                                             const uint8_t* src,
+                                             const uint8_t* dst,
+                                             uint8_t* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = apply(composite_op(), src[i], src[i | 3], dst[i]);
+  }
+}
+
+// Vectors hold whole pixels because their sizes are multiples of 4.
+template <typename Isa>
+SATOP_ALWAYS_INLINE void composite_rgba_loop(Isa,
+                                             const uint8_t* src,
+                                             const uint8_t* dst,
+                                             uint8_t* out, std::size_t n) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type);
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const typename Isa::vector_type s = Isa::load(src + i);
+    Isa::store(out + i, Isa::apply(composite_op(),
+                                   s, Isa::broadcast_alpha(s),
+                                   Isa::load(dst + i), type_tag<uint8_t>()));
+  }
+  composite_rgba_loop(scalar_isa(), src + i, dst + i, out + i, n - i);
+}
+
+// Kernels of image operations for dispatch(), which process rows
+// by the widest instruction set in Isas having Op for uint8_t.
+template <typename Op>
+struct image_kernel {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      image_view<const uint8_t> x,
+                                      image_view<const uint8_t> y,
+                                      image_view<uint8_t> out) {
+    using isa = typename select_isa<Op, uint8_t, Isas>::type;
+    for (std::size_t row = 0; row < out.height; ++row) {
+      binary_loop<Op>(isa(), row_of(x, row), row_of(y, row),
+                      row_of(out, row), row_size(out), store_output());
+    }
+  }
+};
+
+template <>
+struct image_kernel<scale_op> {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      image_view<const uint8_t> x,
+                                      int16_t gain, int16_t offset,
+                                      image_view<uint8_t> out) {
+    using isa = typename select_isa<scale_op, uint8_t, Isas>::type;
+    for (std::size_t row = 0; row < out.height; ++row) {
+      scale_loop(isa(), row_of(x, row), gain, offset,
+                 row_of(out, row), row_size(out));
+    }
+  }
+};
+
+template <>
+struct image_kernel<blend_op> {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      image_view<const uint8_t> x,
+                                      image_view<const uint8_t> y,
+                                      uint8_t alpha,
+                                      image_view<uint8_t> out) {
+    using isa = typename select_isa<blend_op, uint8_t, Isas>::type;
+    for (std::size_t row = 0; row < out.height; ++row) {
+      blend_loop(isa(), row_of(x, row), row_of(y, row), alpha,
+                 row_of(out, row), row_size(out));
+    }
+  }
+};
+
+template <>
+struct image_kernel<composite_op> {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      image_view<const uint8_t> src,
+                                      image_view<const uint8_t> dst,
+                                      image_view<uint8_t> out) {
+    using isa = typename select_isa<composite_op, uint8_t, Isas>::type;
+    for (std::size_t row = 0; row < out.height; ++row) {
+      composite_rgba_loop(isa(), row_of(src, row), row_of(dst, row),
+                          row_of(out, row), row_size(out));
+    }
+  }
+
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      image_view<const uint8_t> src,
+                                      image_view<const uint8_t> alpha,
+                                      image_view<const uint8_t> dst,
+                                      image_view<uint8_t> out) {
+    using isa = typename select_isa<composite_op, uint8_t, Isas>::type;
+    for (std::size_t row = 0; row < out.height; ++row) {
+      composite_loop(isa(), row_of(src, row), row_of(alpha, row),
+                     row_of(dst, row), row_of(out, row), row_size(out));
+    }
+  }
+};
+
+SATOP_GENERIC_SIMD_END()
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Add channels of 2 images with saturation.
+///
+/// Sizes of x and y must be the same as out.
+/// out may be the same image as x or y, but must not overlap them
+/// otherwise.
+///
+/// @param x   An image to add
+/// @param y   An image to add
+/// @param out An image to store add(x, y) of each channel into
+inline void add_images(const image_view<const uint8_t>& x,
+                       const image_view<const uint8_t>& y,
+                       const image_view<uint8_t>& out) {
+  impl::dispatch<impl::image_kernel<impl::add_op>>(x, y, out);
+}
+
+/// Subtract channels of an image from ones of another image
+/// with saturation.
+///
+/// Sizes of x and y must be the same as out.
+/// out may be the same image as x or y, but must not overlap them
+/// otherwise.
+///
+/// @param x   An image to be subtracted
+/// @param y   An image to subtract
+/// @param out An image to store sub(x, y) of each channel into
+inline void sub_images(const image_view<const uint8_t>& x,
+                       const image_view<const uint8_t>& y,
+                       const image_view<uint8_t>& out) {
+  impl::dispatch<impl::image_kernel<impl::sub_op>>(x, y, out);
+}
+
+/// Scale channels of an image and add an offset with saturation,
+/// to adjust contrast and brightness.
+///
+/// Each channel is (x * gain) rounded to nearest, ties toward +inf,
+/// plus offset and saturated into [0, 255].
+///
+/// @param x      An image to scale
+/// @param gain   Gain to multiply channels by
+/// @param offset Value to add after scaling
+/// @param out    An image to store results into,
+///               whose size must be the same as x
+inline void scale_image(const image_view<const uint8_t>& x,
+                        image_gain gain, int16_t offset,
+                        const image_view<uint8_t>& out) {
+  impl::dispatch<impl::image_kernel<impl::scale_op>>(x, gain.raw(), offset,
+                                                     out);
+}
+
+/// Blend 2 images by a constant alpha.
+///
+/// Each channel is (x * alpha + y * (255 - alpha)) / 255
+/// rounded to nearest.
+///
+/// @param x     An image weighted by alpha
+/// @param y     An image weighted by 255 - alpha
+/// @param alpha Weight of x, 255 is x itself
+/// @param out   An image to store results into,
+///              whose size must be the same as x and y
+inline void blend_images(const image_view<const uint8_t>& x,
+                         const image_view<const uint8_t>& y,
+                         uint8_t alpha,
+                         const image_view<uint8_t>& out) {
+  impl::dispatch<impl::image_kernel<impl::blend_op>>(x, y, alpha, out);
+}
+
+/// Composite an interleaved image with premultiplied alpha
+/// over another image.
+///
+/// Each channel is add(src, dst * (255 - alpha) / 255 rounded to nearest),
+/// where alpha is the last channel of each pixel of src,
+/// such as RGBA and BGRA.
+///
+/// @param src An image of 4 channels composited over dst
+/// @param dst An image of 4 channels composited under src
+/// @param out An image to store results into,
+///            whose size must be the same as src and dst
+inline void composite_images(const image_view<const uint8_t>& src,
+                             const image_view<const uint8_t>& dst,
+                             const image_view<uint8_t>& out) {
+  impl::dispatch<impl::image_kernel<impl::composite_op>>(src, dst, out);
+}
+
+/// Composite a plane of a planar image with premultiplied alpha
+/// over a plane of another image.
+///
+/// Call it for each plane including the alpha plane,
+/// where src_alpha is the alpha plane of src.
+/// out must not be src_alpha unless it is the last plane to composite.
+///
+/// @param src       A plane composited over dst
+/// @param src_alpha Alpha of src
+/// @param dst       A plane composited under src
+/// @param out       A plane to store results into,
+///                  whose size must be the same as src and dst
+inline void composite_images(const image_view<const uint8_t>& src,
+                             const image_view<const uint8_t>& src_alpha,
+                             const image_view<const uint8_t>& dst,
+                             const image_view<uint8_t>& out) {
+  impl::dispatch<impl::image_kernel<impl::composite_op>>(src, src_alpha, dst,
+                                                         out);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_IMAGE_PRIV_H_
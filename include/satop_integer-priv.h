@@ -0,0 +1,457 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_INTEGER_PRIV_H_
+#define INCLUDE_SATOP_INTEGER_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "satop_div-priv.h"
+#include "satop_op-priv.h"
+#include "satop_sign_util-priv.h"
+#include "satop_wider_type-priv.h"
+
+// constexpr for functions which modify objects, available since C++14.
+#if (__cplusplus >= 201402L) \
+    || (defined(_MSVC_LANG) && (_MSVC_LANG >= 201402L))
+#define SATOP_CXX14_CONSTEXPR constexpr
+#else
+#define SATOP_CXX14_CONSTEXPR
+#endif
+
+namespace saturated {
+
+template <typename T>
+class integer;
+
+namespace impl {
+
+// Signed native type to evaluate expressions of integer<T> in,
+// or T itself if there is no wider one.
+template <typename T>
+using fused_type = typename std::conditional<
+  (sizeof(T) < sizeof(int32_t)),
+  int32_t,
+  typename std::conditional<(sizeof(T) < sizeof(int64_t)),
+                            int64_t,
+                            T>::type>::type;
+
+// Upper bound of magnitude of values of T.
+template <typename T>
+constexpr uintmax_t magnitude_bound() {
+  return (static_cast<uintmax_t>(std::numeric_limits<T>::max())
+          + (std::is_signed<T>::value ? 1 : 0));
+}
+
+template <typename T>
+constexpr uintmax_t fused_capacity() {
+  return static_cast<uintmax_t>(std::numeric_limits<fused_type<T>>::max());
+}
+
+// Magnitude bounds of results of operations
+// whose operands have magnitude bounds x and y.
+constexpr uintmax_t bound_of(add_op, uintmax_t x, uintmax_t y) {
+  return x + y;
+}
+
+constexpr uintmax_t bound_of(sub_op, uintmax_t x, uintmax_t y) {
+  return x + y;
+}
+
+constexpr uintmax_t bound_of(mul_op, uintmax_t x, uintmax_t y) {
+  return x * y;
+}
+
+// Quotients never exceed dividends, and quotients by 0 are values of T
+// whose bound never exceeds bounds of any terms.
+constexpr uintmax_t bound_of(div_op, uintmax_t x, uintmax_t /* y */) {
+  return x;
+}
+
+// Whether results of operations never exceed capacity,
+// checked without overflow of uintmax_t.
+constexpr bool fits_in(add_op, uintmax_t x, uintmax_t y, uintmax_t capacity) {
+  return ((x <= capacity) && (y <= capacity - x));
+}
+
+constexpr bool fits_in(sub_op, uintmax_t x, uintmax_t y, uintmax_t capacity) {
+  return fits_in(add_op(), x, y, capacity);
+}
+
+constexpr bool fits_in(mul_op, uintmax_t x, uintmax_t y, uintmax_t capacity) {
+  return ((y == 0) || (x <= capacity / y));
+}
+
+constexpr bool fits_in(div_op, uintmax_t x, uintmax_t y, uintmax_t capacity) {
+  return ((x <= capacity) && (y <= capacity));
+}
+
+template <typename T, typename W>
+constexpr W apply_wide(add_op, W x, W y) {
+  return static_cast<W>(x + y);
+}
+
+template <typename T, typename W>
+constexpr W apply_wide(sub_op, W x, W y) {
+  return static_cast<W>(x - y);
+}
+
+template <typename T, typename W>
+constexpr W apply_wide(mul_op, W x, W y) {
+  return static_cast<W>(x * y);
+}
+
+// Division by 0 results as same as div() for T.
+template <typename T, typename W>
+constexpr W apply_wide(div_op, W x, W y) {
+  return ((y == 0)
+          ? static_cast<W>(div_by_zero(clamp_cast<T>(x)))
+          : static_cast<W>(x / y));
+}
+
+template <typename Op, typename L, typename R>
+class expression;
+
+// Operands of expressions, integer<T> or expression.
+template <typename X>
+struct term {
+};
+
+template <typename T>
+struct term<integer<T>> {
+  using value_type = T;
+  static constexpr uintmax_t kBound = magnitude_bound<T>();
+
+  static constexpr fused_type<T> wide_value(const integer<T>& x) {
+    return static_cast<fused_type<T>>(x.value());
+  }
+};
+
+template <typename Op, typename L, typename R>
+struct term<expression<Op, L, R>> {
+  using value_type = typename term<L>::value_type;
+  static constexpr uintmax_t kBound =
+      bound_of(Op(), term<L>::kBound, term<R>::kBound);
+
+  static constexpr fused_type<value_type> wide_value(
+      const expression<Op, L, R>& x) {
+    return x.wide_value();
+  }
+};
+
+// Expression of integer<T> evaluated lazily in fused_type<T>,
+// and saturated into T only at the end.
+// Expressions of 2 integer<T> are evaluated by scalar functions
+// such as add() instead, which are optimized for each operation.
+template <typename Op, typename L, typename R>
+class expression {
+ public:
+  using value_type = typename term<L>::value_type;
+
+  constexpr expression(const L& lhs, const R& rhs)
+      : lhs_(lhs), rhs_(rhs) {
+  }
+
+  constexpr fused_type<value_type> wide_value() const {
+    return apply_wide<value_type>(Op(),
+                                  term<L>::wide_value(lhs_),
+                                  term<R>::wide_value(rhs_));
+  }
+
+  constexpr value_type value() const {
+    return value(std::integral_constant<
+                 bool,
+                 std::is_same<L, integer<value_type>>::value
+                 && std::is_same<R, integer<value_type>>::value>());
+  }
+
+ private:
+  constexpr value_type value(std::true_type /* is_leaf */) const {
+    return apply(Op(), lhs_.value(), rhs_.value());
+  }
+
+  constexpr value_type value(std::false_type /* is_leaf */) const {
+    return clamp_cast<value_type>(wide_value());
+  }
+
+  L lhs_;
+  R rhs_;
+};
+
+// Result of Op for operands X and Y, defined only if they are terms
+// of the same T.
+// It is expression if it fits in fused_type<T>,
+// otherwise integer<T> saturated at this step.
+template <typename Op, typename X, typename Y, typename Enable = void>
+struct combined {
+};
+
+template <typename Op, typename X, typename Y>
+struct combined<
+  Op, X, Y,
+  typename std::enable_if<
+    std::is_same<typename term<X>::value_type,
+                 typename term<Y>::value_type>::value>::type> {
+  using value_type = typename term<X>::value_type;
+  using fits = std::integral_constant<
+    bool,
+    (sizeof(fused_type<value_type>) > sizeof(value_type))
+    && fits_in(Op(), term<X>::kBound, term<Y>::kBound,
+               fused_capacity<value_type>())>;
+  using type = typename std::conditional<fits::value,
+                                         expression<Op, X, Y>,
+                                         integer<value_type>>::type;
+};
+
+template <typename Op, typename X, typename Y>
+constexpr expression<Op, X, Y> combine(Op, const X& x, const Y& y,
+                                       std::true_type /* fits */) {
+  return expression<Op, X, Y>(x, y);
+}
+
+template <typename Op, typename X, typename Y>
+constexpr integer<typename term<X>::value_type> combine(
+    Op op, const X& x, const Y& y, std::false_type /* fits */) {
+  return integer<typename term<X>::value_type>(
+      apply(op, x.value(), y.value()));
+}
+
+template <typename Op, typename X, typename Y>
+constexpr typename combined<Op, X, Y>::type combine(Op op,
+                                                    const X& x,
+                                                    const Y& y) {
+  return combine(op, x, y, typename combined<Op, X, Y>::fits());
+}
+
+// Enabled if X and Y are terms of the same T, for comparisons.
+template <typename X, typename Y>
+using enable_if_terms = typename std::enable_if<
+  std::is_same<typename term<X>::value_type,
+               typename term<Y>::value_type>::value,
+  bool>::type;
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Integer value whose arithmetic operators saturate.
+///
+/// Operators of integer<T> return expressions,
+/// which are converted into integer<T> implicitly.
+/// Expressions are evaluated in a wider native type
+/// as long as their intermediate values fit in it,
+/// and saturated only once when they are converted,
+/// so a * b + c is saturated(a * b + c)
+/// instead of add(mul(a, b), c).
+/// Expressions which may exceed it are saturated at that operation.
+///
+/// @tparam T Type of value, integral type except bool
+template <typename T>
+class integer {
+  static_assert(std::is_integral<T>::value
+                && !std::is_same<T, bool>::value,
+                "integer supports only integral types except bool");
+
+ public:
+  /// Type of value.
+  using value_type = T;
+
+  /// Construct integer of 0.
+  constexpr integer()
+      : value_(0) {
+  }
+
+  /// Construct integer of a value.
+  ///
+  /// @param value A value
+  constexpr explicit integer(T value)
+      : value_(value) {
+  }
+
+  /// Evaluate an expression with saturation.
+  ///
+  /// @param expression An expression of integer<T>
+  template <typename Op, typename L, typename R>
+  constexpr integer(  // NOLINT(runtime/explicit)
+      const impl::expression<Op, L, R>& expression)
+      : value_(expression.value()) {
+  }
+
+  /// @return The value
+  constexpr T value() const {
+    return value_;
+  }
+
+  /// @return The value
+  constexpr explicit operator T() const {
+    return value_;
+  }
+
+  /// Add a value or an expression with saturation.
+  ///
+  /// @param y A value or an expression to add
+  ///
+  /// @return This object
+  template <typename Y>
+  SATOP_CXX14_CONSTEXPR integer& operator+=(const Y& y) {
+    return (*this = impl::combine(impl::add_op(), *this, y));
+  }
+
+  /// Subtract a value or an expression with saturation.
+  ///
+  /// @param y A value or an expression to subtract
+  ///
+  /// @return This object
+  template <typename Y>
+  SATOP_CXX14_CONSTEXPR integer& operator-=(const Y& y) {
+    return (*this = impl::combine(impl::sub_op(), *this, y));
+  }
+
+  /// Multiply by a value or an expression with saturation.
+  ///
+  /// @param y A value or an expression to multiply by
+  ///
+  /// @return This object
+  template <typename Y>
+  SATOP_CXX14_CONSTEXPR integer& operator*=(const Y& y) {
+    return (*this = impl::combine(impl::mul_op(), *this, y));
+  }
+
+  /// Divide by a value or an expression with saturation.
+  ///
+  /// @param y A value or an expression to divide by
+  ///
+  /// @return This object
+  template <typename Y>
+  SATOP_CXX14_CONSTEXPR integer& operator/=(const Y& y) {
+    return (*this = impl::combine(impl::div_op(), *this, y));
+  }
+
+ private:
+  T value_;
+};
+
+/// Add integer values or expressions of them with saturation.
+///
+/// @param x A value or an expression to add
+/// @param y A value or an expression to add
+///
+/// @return Expression of x + y, or integer<T> if it is saturated now
+template <typename X, typename Y>
+constexpr typename impl::combined<impl::add_op, X, Y>::type operator+(
+    const X& x, const Y& y) {
+  return impl::combine(impl::add_op(), x, y);
+}
+
+/// Subtract integer values or expressions of them with saturation.
+///
+/// @param x A value or an expression to subtract from
+/// @param y A value or an expression to subtract
+///
+/// @return Expression of x - y, or integer<T> if it is saturated now
+template <typename X, typename Y>
+constexpr typename impl::combined<impl::sub_op, X, Y>::type operator-(
+    const X& x, const Y& y) {
+  return impl::combine(impl::sub_op(), x, y);
+}
+
+/// Multiply integer values or expressions of them with saturation.
+///
+/// @param x A value or an expression to multiply
+/// @param y A value or an expression to multiply
+///
+/// @return Expression of x * y, or integer<T> if it is saturated now
+template <typename X, typename Y>
+constexpr typename impl::combined<impl::mul_op, X, Y>::type operator*(
+    const X& x, const Y& y) {
+  return impl::combine(impl::mul_op(), x, y);
+}
+
+/// Divide integer values or expressions of them with saturation.
+///
+/// Division by 0 results as same as div().
+///
+/// @param x A value or an expression to be divided
+/// @param y A value or an expression to divide by
+///
+/// @return Expression of x / y, or integer<T> if it is saturated now
+template <typename X, typename Y>
+constexpr typename impl::combined<impl::div_op, X, Y>::type operator/(
+    const X& x, const Y& y) {
+  return impl::combine(impl::div_op(), x, y);
+}
+
+/// Compare saturated values of integers or expressions.
+///
+/// @param x A value or an expression to compare
+/// @param y A value or an expression to compare
+///
+/// @return true if x and y are equal after saturation
+template <typename X, typename Y, impl::enable_if_terms<X, Y> = true>
+constexpr bool operator==(const X& x, const Y& y) {
+  return (x.value() == y.value());
+}
+
+/// @copydoc operator==
+/// @return true if x and y are not equal after saturation
+template <typename X, typename Y, impl::enable_if_terms<X, Y> = true>
+constexpr bool operator!=(const X& x, const Y& y) {
+  return (x.value() != y.value());
+}
+
+/// @copydoc operator==
+/// @return true if x is less than y after saturation
+template <typename X, typename Y, impl::enable_if_terms<X, Y> = true>
+constexpr bool operator<(const X& x, const Y& y) {
+  return (x.value() < y.value());
+}
+
+/// @copydoc operator==
+/// @return true if x is less than or equal to y after saturation
+template <typename X, typename Y, impl::enable_if_terms<X, Y> = true>
+constexpr bool operator<=(const X& x, const Y& y) {
+  return (x.value() <= y.value());
+}
+
+/// @copydoc operator==
+/// @return true if x is greater than y after saturation
+template <typename X, typename Y, impl::enable_if_terms<X, Y> = true>
+constexpr bool operator>(const X& x, const Y& y) {
+  return (x.value() > y.value());
+}
+
+/// @copydoc operator==
+/// @return true if x is greater than or equal to y after saturation
+template <typename X, typename Y, impl::enable_if_terms<X, Y> = true>
+constexpr bool operator>=(const X& x, const Y& y) {
+  return (x.value() >= y.value());
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_INTEGER_PRIV_H_
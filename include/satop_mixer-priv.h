@@ -0,0 +1,281 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_MIXER_PRIV_H_
+#define INCLUDE_SATOP_MIXER_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "satop_dispatch-priv.h"
+#include "satop_fixed-priv.h"
+#include "satop_op-priv.h"
+#include "satop_reduce-priv.h"
+#include "satop_simd-priv.h"
+#include "satop_wider_type-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Gain of streams to mix in Q15, whose max is nearly 1.
+using mix_gain = fixed<0, 15, int16_t>;
+
+/// @}
+
+namespace impl {
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+// Samples are scaled by gains and accumulated exactly in 32 bits,
+// which hold sums of 65536 streams at least.
+SATOP_ALWAYS_INLINE void mix_at_end_loop(scalar_isa,
+                                         const int16_t* const* x,
+                                         const mix_gain* gains,
+                                         std::size_t streams,
+                                         int16_t* out,
+                                         std::size_t begin, std::size_t n) {
+  for (std::size_t i = begin; i < n; ++i) {
+    int32_t acc = 0;
+    for (std::size_t s = 0; s < streams; ++s) {
+      acc += rounding_mul<15>(x[s][i], gains[s].raw());
+    }
+    out[i] = clamp_cast<int16_t>(acc);
+  }
+}
+
+template <typename Isa>
+SATOP_ALWAYS_INLINE void mix_at_end_loop(Isa,
+                                         const int16_t* const* x,
+                                         const mix_gain* gains,
+                                         std::size_t streams,
+                                         int16_t* out,
+                                         std::size_t begin, std::size_t n) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(int16_t);
+  std::size_t i = begin;
+  for (; i + kLanes <= n; i += kLanes) {
+    vector_type lo = Isa::zero();
+    vector_type hi = Isa::zero();
+    for (std::size_t s = 0; s < streams; ++s) {
+      const vector_type scaled =
+          Isa::apply(fixed_mul_op<15>(), Isa::load(x[s] + i),
+                     Isa::broadcast(gains[s].raw()), type_tag<int16_t>());
+      lo = Isa::wrapping(add_op(), lo, Isa::widen_lo_i16(scaled),
+                         lane_width<4>());
+      hi = Isa::wrapping(add_op(), hi, Isa::widen_hi_i16(scaled),
+                         lane_width<4>());
+    }
+    Isa::store(out + i,
+               Isa::narrow(lo, hi, type_tag<int32_t>(), type_tag<int16_t>()));
+  }
+  mix_at_end_loop(scalar_isa(), x, gains, streams, out, i, n);
+}
+
+// Samples are scaled by gains and added into the result one by one
+// in order of streams, as a loop of add().
+SATOP_ALWAYS_INLINE void mix_each_step_loop(scalar_isa,
+                                            const int16_t* const* x,
+                                            const mix_gain* gains,
+                                            std::size_t streams,
+                                            int16_t* out,
+                                            std::size_t begin,
+                                            std::size_t n) {
+  for (std::size_t i = begin; i < n; ++i) {
+    int16_t acc = 0;
+    for (std::size_t s = 0; s < streams; ++s) {
+      acc = apply(add_op(), acc, rounding_mul<15>(x[s][i], gains[s].raw()));
+    }
+    out[i] = acc;
+  }
+}
+
+template <typename Isa>
+SATOP_ALWAYS_INLINE void mix_each_step_loop(Isa,
+                                            const int16_t* const* x,
+                                            const mix_gain* gains,
+                                            std::size_t streams,
+                                            int16_t* out,
+                                            std::size_t begin,
+                                            std::size_t n) {
+  using vector_type = typename Isa::vector_type;
+  constexpr std::size_t kLanes = sizeof(vector_type) / sizeof(int16_t);
+  std::size_t i = begin;
+  for (; i + kLanes <= n; i += kLanes) {
+    vector_type acc = Isa::zero();
+    for (std::size_t s = 0; s < streams; ++s) {
+      acc = Isa::apply(add_op(), acc,
+                       Isa::apply(fixed_mul_op<15>(), Isa::load(x[s] + i),
+                                  Isa::broadcast(gains[s].raw()),
+                                  type_tag<int16_t>()),
+                       type_tag<int16_t>());
+    }
+    Isa::store(out + i, acc);
+  }
+  mix_each_step_loop(scalar_isa(), x, gains, streams, out, i, n);
+}
+
+// Kernel of mix() for dispatch(), where vectors hold samples
+// of each stream.
+struct mix_kernel {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const int16_t* const* x,
+                                      const mix_gain* gains,
+                                      std::size_t streams,
+                                      int16_t* out, std::size_t n,
+                                      reduction_mode mode) {
+    using isa = typename select_isa<fixed_mul_op<15>, int16_t, Isas>::type;
+    if (mode == reduction_mode::clamp_each_step) {
+      mix_each_step_loop(isa(), x, gains, streams, out, 0, n);
+    } else {
+      mix_at_end_loop(isa(), x, gains, streams, out, 0, n);
+    }
+  }
+};
+
+SATOP_GENERIC_SIMD_END()
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Mix streams of samples scaled by gains with saturation.
+///
+/// Each sample is scaled as multiplication of Q15,
+/// rounded to nearest and ties toward +inf.
+/// With reduction_mode::clamp_at_end, scaled samples are summed
+/// exactly and saturated once.
+/// With reduction_mode::clamp_each_step, they are added in order
+/// of streams as a loop of add() from 0.
+///
+/// @param x       Array of streams, each of them has n samples
+/// @param gains   Array of gains of streams
+/// @param streams Number of streams, up to 65536
+/// @param out     Array to store n mixed samples into,
+///                which may be one of streams
+/// @param n       Number of samples of each stream
+/// @param mode    When results are saturated
+inline void mix(const int16_t* const* x, const mix_gain* gains,
+                std::size_t streams, int16_t* out, std::size_t n,
+                reduction_mode mode = reduction_mode::clamp_at_end) {
+  impl::dispatch<impl::mix_kernel>(x, gains, streams, out, n, mode);
+}
+
+/// Mixer of streams of samples processed in chunks of fixed size.
+///
+/// Chunks of streams are pushed by push() and mixed by pull().
+/// All buffers are allocated at construction,
+/// so push() and pull() never allocate memory.
+class mixer {
+ public:
+  /// Construct mixer whose gains are max of mix_gain.
+  ///
+  /// @param streams    Number of streams, up to 65536
+  /// @param chunk_size Number of samples of each chunk
+  /// @param mode       When results are saturated, see mix()
+  mixer(std::size_t streams, std::size_t chunk_size,
+        reduction_mode mode = reduction_mode::clamp_at_end)
+      : chunk_size_(chunk_size),
+        mode_(mode),
+        gains_(streams, mix_gain::from_raw(INT16_MAX)),
+        samples_(streams * chunk_size),
+        is_pushed_(streams, false),
+        chunks_(streams),
+        chunk_gains_(streams) {
+  }
+
+  /// @return Number of streams
+  std::size_t streams() const {
+    return gains_.size();
+  }
+
+  /// @return Number of samples of each chunk
+  std::size_t chunk_size() const {
+    return chunk_size_;
+  }
+
+  /// @param stream Index of a stream
+  ///
+  /// @return Gain of the stream
+  mix_gain gain(std::size_t stream) const {
+    return gains_[stream];
+  }
+
+  /// Set gain of a stream, which is applied from the next pull().
+  ///
+  /// @param stream Index of a stream
+  /// @param gain   Gain of the stream
+  void set_gain(std::size_t stream, mix_gain gain) {
+    gains_[stream] = gain;
+  }
+
+  /// Copy a chunk of a stream to mix by the next pull().
+  ///
+  /// @param stream  Index of a stream
+  /// @param samples Array of chunk_size() samples
+  void push(std::size_t stream, const int16_t* samples) {
+    std::copy(samples, samples + chunk_size_,
+              samples_.begin()
+              + static_cast<std::ptrdiff_t>(stream * chunk_size_));
+    is_pushed_[stream] = true;
+  }
+
+  /// Mix chunks pushed since the last pull(),
+  /// where streams without pushed chunks are silent.
+  ///
+  /// @param out Array to store chunk_size() mixed samples into
+  void pull(int16_t* out) {
+    std::size_t pushed = 0;
+    for (std::size_t s = 0; s < is_pushed_.size(); ++s) {
+      if (is_pushed_[s]) {
+        chunks_[pushed] = samples_.data() + s * chunk_size_;
+        chunk_gains_[pushed] = gains_[s];
+        ++pushed;
+        is_pushed_[s] = false;
+      }
+    }
+    mix(chunks_.data(), chunk_gains_.data(), pushed, out, chunk_size_, mode_);
+  }
+
+ private:
+  std::size_t chunk_size_;
+  reduction_mode mode_;
+  std::vector<mix_gain> gains_;
+  std::vector<int16_t> samples_;
+  std::vector<bool> is_pushed_;
+  // Pushed chunks and their gains, which are passed to mix().
+  std::vector<const int16_t*> chunks_;
+  std::vector<mix_gain> chunk_gains_;
+};
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_MIXER_PRIV_H_
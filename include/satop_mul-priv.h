@@ -23,27 +23,177 @@
 #error Do not include this file directly, libsatop.h instead.
 #endif
 
+#include <cstdint>
 #include <limits>
+#include <type_traits>
 
 #include "satop_sign_util-priv.h"
+#include "satop_telemetry-priv.h"
+#include "satop_wider_type-priv.h"
+
+// __builtin_mul_overflow_p() of g++ detects overflow by flags
+// of a multiply instruction, and it is available in constant expressions.
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 7)
+#define SATOP_HAS_BUILTIN_MUL_OVERFLOW_P
+#endif
 
 namespace saturated {
 
 namespace impl {
 
+// Divisors of following checks are never 0,
+// and never -1 when dividend is lowest of T.
 template <typename T>
 constexpr bool is_mul_overflow(T x, T y) {
-  return ((csignbit(x) == csignbit(y))
-          && (x > std::numeric_limits<T>::max() / y));
+  return (((x > 0)
+           && (y > 0)
+           && (x > std::numeric_limits<T>::max() / y))
+          || (csignbit(x)
+              && csignbit(y)
+              && (x < std::numeric_limits<T>::max() / y)));
 }
 
 template <typename T>
 constexpr bool is_mul_underflow(T x, T y) {
-  return ((csignbit(x) != csignbit(y))
-          && ((x < std::numeric_limits<T>::lowest() / y)
-              || (y < std::numeric_limits<T>::lowest() / x)));
+  return ((csignbit(x)
+           && (y > 0)
+           && (x < std::numeric_limits<T>::lowest() / y))
+          || ((x > 0)
+              && csignbit(y)
+              && (y < std::numeric_limits<T>::lowest() / x)));
+}
+
+// Portable implementation, used for types without wider native type
+// and without __builtin_mul_overflow_p().
+template <typename T>
+constexpr T mul_by_compare(T x, T y) {
+  using limits = std::numeric_limits<T>;
+  return (is_mul_overflow(x, y)
+          ? limits::max()
+          : (is_mul_underflow(x, y)
+             ? limits::lowest()
+             : static_cast<T>(x * y)));
+}
+
+#ifdef SATOP_HAS_BUILTIN_MUL_OVERFLOW_P
+// Implementation without division for types without wider native type.
+// Products overflow into lowest only if signs of operands differ.
+template <typename T>
+constexpr T mul_by_builtin(T x, T y) {
+  return (__builtin_mul_overflow_p(x, y, T(0))
+          ? ((csignbit(x) != csignbit(y))
+             ? std::numeric_limits<T>::lowest()
+             : std::numeric_limits<T>::max())
+          : static_cast<T>(x * y));
+}
+#endif  // SATOP_HAS_BUILTIN_MUL_OVERFLOW_P
+
+// Implementation without division and branches,
+// calculating in wider type and clamping it at once.
+template <typename T>
+constexpr T mul_by_wider_type(T x, T y) {
+  using wider_t = typename wider_type<T>::type;
+  return clamp_cast<T>(static_cast<wider_t>(static_cast<wider_t>(x)
+                                            * static_cast<wider_t>(y)));
+}
+
+template <typename T>
+constexpr T mul(T x, T y, std::true_type /* has_wider_type */) {
+  return mul_by_wider_type(x, y);
+}
+
+template <typename T, typename Category>
+constexpr T mul_without_wider_type(T x, T y, Category) {
+  return mul_by_compare(x, y);
+}
+
+#ifdef SATOP_HAS_BUILTIN_MUL_OVERFLOW_P
+template <typename T>
+constexpr T mul_without_wider_type(T x, T y, unsigned_integer_tag) {
+  return mul_by_builtin(x, y);
 }
 
+template <typename T>
+constexpr T mul_without_wider_type(T x, T y, signed_integer_tag) {
+  return mul_by_builtin(x, y);
+}
+#endif  // SATOP_HAS_BUILTIN_MUL_OVERFLOW_P
+
+template <typename T>
+constexpr T mul(T x, T y, std::false_type /* has_wider_type */) {
+  return mul_without_wider_type(x, y, arithmetic_category<T>());
+}
+
+// mul(x, y) of integral types for y known before x.
+// Products saturate just when x is out of the range
+// [lowest_x_, max_x_] computed by divisions once,
+// into max if y is positive and x is above it for example.
+template <typename T>
+class mul_bounds {
+ public:
+  constexpr explicit mul_bounds(T y)
+      : y_(y),
+        lowest_x_(csignbit(y)
+                  ? static_cast<T>(std::numeric_limits<T>::max() / y)
+                  : ((y > 0)
+                     ? static_cast<T>(std::numeric_limits<T>::lowest() / y)
+                     : std::numeric_limits<T>::lowest())),
+        max_x_((csignbit(y) && (y != T(-1)))
+               ? static_cast<T>(std::numeric_limits<T>::lowest() / y)
+               : ((y > 0)
+                  ? static_cast<T>(std::numeric_limits<T>::max() / y)
+                  : std::numeric_limits<T>::max())),
+        below_(csignbit(y)
+               ? std::numeric_limits<T>::max()
+               : std::numeric_limits<T>::lowest()),
+        above_(csignbit(y)
+               ? std::numeric_limits<T>::lowest()
+               : std::numeric_limits<T>::max()) {
+  }
+
+  constexpr T operator()(T x) const {
+    return ((x < lowest_x_)
+            ? below_
+            : ((x > max_x_) ? above_ : static_cast<T>(x * y_)));
+  }
+
+ private:
+  T y_;
+  T lowest_x_;
+  T max_x_;
+  T below_;
+  T above_;
+};
+
+// Kind of saturation of mul(x, y) which returned result.
+template <typename T>
+constexpr saturation_kind mul_saturation(T x, T y, T result,
+                                         std::true_type /* has_wider_type */) {
+  using wider_t = typename wider_type<T>::type;
+  return saturation_if(static_cast<wider_t>(static_cast<wider_t>(x)
+                                            * static_cast<wider_t>(y))
+                       != static_cast<wider_t>(result),
+                       result);
+}
+
+template <typename T>
+constexpr saturation_kind mul_saturation(
+    T x, T y, T /* result */, std::false_type /* has_wider_type */) {
+  return (is_mul_overflow(x, y)
+          ? saturation_kind::overflow
+          : (is_mul_underflow(x, y)
+             ? saturation_kind::underflow
+             : saturation_kind::none));
+}
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_mul(T result, T x, T y) {
+  return observe(saturation_op::mul, result,
+                 mul_saturation(x, y, result, has_wider_type<T>()));
+}
+#endif  // SATOP_TELEMETRY
+
 }  // namespace impl
 
 /// @addtogroup libsatop
@@ -60,14 +210,34 @@ constexpr bool is_mul_underflow(T x, T y) {
 /// @return If multiply results causes overflow, returns max of T.
 ///         If underflow, returns min(lowest) of T.
 ///         If no overflow and no underflow, returns x + y.
+///
+/// @see saturation_snapshot() to count saturations
 template <typename T>
 constexpr T mul(T x, T y) {
-  using limits = std::numeric_limits<T>;
-  return (impl::is_mul_overflow(x, y)
-          ? limits::max()
-          : (impl::is_mul_underflow(x, y)
-             ? limits::lowest()
-             : static_cast<T>(x * y)));
+  return SATOP_OBSERVE(mul, impl::mul(x, y, impl::has_wider_type<T>()), x, y);
+}
+
+/// Multiply a value by a constant with saturation.
+///
+/// The range of x whose products do not saturate is a constant
+/// without divisions at runtime, so it is compiled into comparisons
+/// and a multiplication, or a comparison for unsigned types.
+///
+/// @tparam C A constant to multiply by, in the range of T
+/// @tparam T Type of the argument and the return value, integral type
+///
+/// @param x A value to multiply
+///
+/// @return x * C saturated into the range of T.
+///
+/// @see saturation_snapshot() to count saturations
+template <std::intmax_t C, typename T>
+constexpr T mul(T x) {
+  static_assert(std::is_integral<T>::value,
+                "mul<C> supports only integral types");
+  static_assert(impl::is_in_range<T>(C), "C must be in the range of T");
+  return SATOP_OBSERVE(mul, impl::mul_bounds<T>(static_cast<T>(C))(x),
+                       x, static_cast<T>(C));
 }
 
 /// @}
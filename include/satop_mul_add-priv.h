@@ -0,0 +1,119 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_MUL_ADD_PRIV_H_
+#define INCLUDE_SATOP_MUL_ADD_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <type_traits>
+
+#include "satop_add-priv.h"
+#include "satop_mul-priv.h"
+#include "satop_telemetry-priv.h"
+#include "satop_wider_type-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Product of 2 values of T plus a value of T fits in wider type,
+// so it is clamped only once.
+template <typename T>
+constexpr T mul_add(T x, T y, T z, std::true_type /* has_wider_type */) {
+  using wider_t = typename wider_type<T>::type;
+  return clamp_cast<T>(
+      static_cast<wider_t>(static_cast<wider_t>(static_cast<wider_t>(x)
+                                                * static_cast<wider_t>(y))
+                           + static_cast<wider_t>(z)));
+}
+
+template <typename T>
+constexpr T mul_add(T x, T y, T z, std::false_type /* has_wider_type */) {
+  return add(mul(x, y, std::false_type()), z, arithmetic_category<T>());
+}
+
+// Kind of saturation of mul_add(x, y, z) which returned result.
+template <typename T>
+constexpr saturation_kind mul_add_saturation(
+    T x, T y, T z, T result, std::true_type /* has_wider_type */) {
+  using wider_t = typename wider_type<T>::type;
+  return saturation_if(
+      static_cast<wider_t>(static_cast<wider_t>(static_cast<wider_t>(x)
+                                                * static_cast<wider_t>(y))
+                           + static_cast<wider_t>(z))
+      != static_cast<wider_t>(result),
+      result);
+}
+
+// Saturation of the product takes precedence over one of the sum.
+template <typename T>
+constexpr saturation_kind mul_add_saturation(
+    T x, T y, T z, T result, std::false_type /* has_wider_type */) {
+  return ((mul_saturation(x, y, T(), std::false_type())
+           != saturation_kind::none)
+          ? mul_saturation(x, y, T(), std::false_type())
+          : add_saturation(mul(x, y, std::false_type()), z, result,
+                           arithmetic_category<T>()));
+}
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_mul_add(T result, T x, T y, T z) {
+  return observe(saturation_op::mul_add, result,
+                 mul_add_saturation(x, y, z, result, has_wider_type<T>()));
+}
+#endif  // SATOP_TELEMETRY
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Multiply 2 values and add a value with saturation.
+///
+/// x * y + z is calculated in a wider native type
+/// and saturated only once, so mul_add(max, 2, -max) is max.
+/// For types without wider native type, floating point types
+/// and 64 bits integral types without __int128,
+/// it is the same as add(mul(x, y), z).
+///
+/// @tparam T Type of arguments and the return value
+///
+/// @param x A value to multiply
+/// @param y A value to multiply
+/// @param z A value to add to the product
+///
+/// @return x * y + z, saturated into the range of T.
+///
+/// @see saturation_snapshot() to count saturations
+template <typename T>
+constexpr T mul_add(T x, T y, T z) {
+  return SATOP_OBSERVE(mul_add,
+                       impl::mul_add(x, y, z, impl::has_wider_type<T>()),
+                       x, y, z);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_MUL_ADD_PRIV_H_
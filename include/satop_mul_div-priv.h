@@ -0,0 +1,115 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_MUL_DIV_PRIV_H_
+#define INCLUDE_SATOP_MUL_DIV_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <type_traits>
+
+#include "satop_div-priv.h"
+#include "satop_telemetry-priv.h"
+#include "satop_wider_type-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Product of 2 values of T, which never overflows wider type.
+template <typename T>
+constexpr typename wider_type<T>::type wide_product(T x, T y) {
+  using wider_t = typename wider_type<T>::type;
+  return static_cast<wider_t>(static_cast<wider_t>(x)
+                              * static_cast<wider_t>(y));
+}
+
+// Magnitude of the quotient is not more than one of the product,
+// so it never overflows wider type even if z is -1.
+template <typename T>
+constexpr typename wider_type<T>::type wide_quotient(T x, T y, T z) {
+  using wider_t = typename wider_type<T>::type;
+  return static_cast<wider_t>(wide_product(x, y) / static_cast<wider_t>(z));
+}
+
+// Product clamped into T keeps its sign for division by 0.
+template <typename T>
+constexpr T mul_div(T x, T y, T z) {
+  return ((z == 0)
+          ? div_by_zero(clamp_cast<T>(wide_product(x, y)))
+          : clamp_cast<T>(wide_quotient(x, y, z)));
+}
+
+// Kind of saturation of mul_div(x, y, z) which returned result.
+template <typename T>
+constexpr saturation_kind mul_div_saturation(T x, T y, T z, T result) {
+  using wider_t = typename wider_type<T>::type;
+  return ((z == 0)
+          ? div_by_zero_saturation(clamp_cast<T>(wide_product(x, y)))
+          : saturation_if(wide_quotient(x, y, z)
+                          != static_cast<wider_t>(result),
+                          result));
+}
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_mul_div(T result, T x, T y, T z) {
+  return observe(saturation_op::mul_div, result,
+                 mul_div_saturation(x, y, z, result));
+}
+#endif  // SATOP_TELEMETRY
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Multiply 2 values and divide the product by a value with saturation.
+///
+/// x * y is calculated in a wider native type, such as __int128
+/// for 64 bits integral types, so it never overflows before division.
+/// It is useful for rates like mul_div(bytes, 1000000000, nanoseconds).
+///
+/// @tparam T Type of arguments and the return value,
+///           integral type which has wider native type
+///
+/// @param x A value to multiply
+/// @param y A value to multiply
+/// @param z A value to divide the product by
+///
+/// @return x * y / z rounded toward 0, saturated into the range of T.
+///         If z is 0, returns the same value as div(x * y, 0).
+///
+/// @see saturation_snapshot() to count saturations
+template <typename T>
+constexpr T mul_div(T x, T y, T z) {
+  static_assert(std::is_integral<T>::value
+                && impl::has_wider_type<T>::value,
+                "mul_div supports only integral types up to 32 bits,"
+                " or 64 bits with __int128");
+  return SATOP_OBSERVE(mul_div, impl::mul_div(x, y, z), x, y, z);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_MUL_DIV_PRIV_H_
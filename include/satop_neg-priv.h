@@ -0,0 +1,98 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_NEG_PRIV_H_
+#define INCLUDE_SATOP_NEG_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <limits>
+#include <type_traits>
+
+#include "satop_sign_util-priv.h"
+#include "satop_telemetry-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Only negation of lowest overflows, into max.
+template <typename T>
+constexpr T neg(T x, signed_integer_tag) {
+  return ((x == std::numeric_limits<T>::lowest())
+          ? std::numeric_limits<T>::max()
+          : static_cast<T>(-x));
+}
+
+// Negation of any unsigned value except 0 underflows, into 0.
+template <typename T>
+constexpr T neg(T /* x */, unsigned_integer_tag) {
+  return T(0);
+}
+
+// Kind of saturation of neg(x).
+template <typename T>
+constexpr saturation_kind neg_saturation(T x, signed_integer_tag) {
+  return ((x == std::numeric_limits<T>::lowest())
+          ? saturation_kind::overflow
+          : saturation_kind::none);
+}
+
+template <typename T>
+constexpr saturation_kind neg_saturation(T x, unsigned_integer_tag) {
+  return ((x != 0) ? saturation_kind::underflow : saturation_kind::none);
+}
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_neg(T result, T x) {
+  return observe(saturation_op::neg, result,
+                 neg_saturation(x, arithmetic_category<T>()));
+}
+#endif  // SATOP_TELEMETRY
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Negate a value with saturation.
+///
+/// @tparam T Type of the argument and the return value, integral type
+///
+/// @param x A value to negate
+///
+/// @return -x saturated into the range of T,
+///         so max of T for lowest of T, and 0 for any unsigned x.
+///
+/// @see saturation_snapshot() to count saturations
+template <typename T>
+constexpr T neg(T x) {
+  static_assert(std::is_integral<T>::value,
+                "neg supports only integral types");
+  return SATOP_OBSERVE(neg, impl::neg(x, impl::arithmetic_category<T>()), x);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_NEG_PRIV_H_
@@ -0,0 +1,265 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_OP_PRIV_H_
+#define INCLUDE_SATOP_OP_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <type_traits>
+
+#include "satop_abs-priv.h"
+#include "satop_add-priv.h"
+#include "satop_cast-priv.h"
+#include "satop_div-priv.h"
+#include "satop_fixed-priv.h"
+#include "satop_mul-priv.h"
+#include "satop_mul_add-priv.h"
+#include "satop_neg-priv.h"
+#include "satop_shl-priv.h"
+#include "satop_sub-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Tags of operations to choose implementations by overloads.
+struct add_op {};
+struct sub_op {};
+struct mul_op {};
+struct div_op {};
+struct mul_add_op {};
+struct sum_op {};
+struct dot_op {};
+struct dot_pairs_op {};
+struct scale_op {};
+struct blend_op {};
+struct composite_op {};
+struct neg_op {};
+struct abs_op {};
+struct shl_op {};
+
+// Tag of conversion from From.
+template <typename From>
+struct cast_op {};
+
+// Tag of conversion from floating point type From rounding by Mode.
+template <typename From, rounding Mode>
+struct convert_op {};
+
+// Tag of rounding multiplication of fixed-point values
+// with FracBits fraction bits.
+template <int FracBits>
+struct fixed_mul_op {};
+
+// Tag of Op whose results wrap around instead of saturating.
+template <typename Op>
+struct wrap_op {};
+
+// Implementations without counting saturations,
+// which batch operations count by themselves.
+template <typename T>
+constexpr T apply(add_op, T x, T y) {
+  return add(x, y, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr T apply(sub_op, T x, T y) {
+  return sub(x, y, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr T apply(mul_op, T x, T y) {
+  return mul(x, y, has_wider_type<T>());
+}
+
+template <typename T>
+constexpr T apply(div_op, T x, T y) {
+  return div(x, y, arithmetic_category<T>());
+}
+
+template <int FracBits, typename T>
+constexpr T apply(fixed_mul_op<FracBits>, T x, T y) {
+  return rounding_mul<FracBits>(x, y);
+}
+
+template <typename T>
+constexpr T apply(mul_add_op, T x, T y, T z) {
+  return mul_add(x, y, z, has_wider_type<T>());
+}
+
+template <typename T>
+constexpr T apply(neg_op, T x) {
+  return neg(x, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr T apply(abs_op, T x) {
+  return abs(x, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr T apply(shl_op, T x, int shift) {
+  return shl(x, shift, arithmetic_category<T>());
+}
+
+// Unsigned type to wrap values of T around,
+// which is not promoted to int in arithmetic.
+template <typename T>
+using wrapping_type =
+    typename std::common_type<typename std::make_unsigned<T>::type,
+                              unsigned int>::type;
+
+template <typename T, typename Category>
+constexpr T wrapping(add_op, T x, T y, Category) {
+  return static_cast<T>(static_cast<wrapping_type<T>>(x)
+                        + static_cast<wrapping_type<T>>(y));
+}
+
+template <typename T>
+constexpr T wrapping(add_op, T x, T y, floating_point_tag) {
+  return x + y;
+}
+
+template <typename T, typename Category>
+constexpr T wrapping(sub_op, T x, T y, Category) {
+  return static_cast<T>(static_cast<wrapping_type<T>>(x)
+                        - static_cast<wrapping_type<T>>(y));
+}
+
+template <typename T>
+constexpr T wrapping(sub_op, T x, T y, floating_point_tag) {
+  return x - y;
+}
+
+template <typename T, typename Category>
+constexpr T wrapping(mul_op, T x, T y, Category) {
+  return static_cast<T>(static_cast<wrapping_type<T>>(x)
+                        * static_cast<wrapping_type<T>>(y));
+}
+
+template <typename T>
+constexpr T wrapping(mul_op, T x, T y, floating_point_tag) {
+  return x * y;
+}
+
+// Division by 0 has no wrapped result, so it is saturated.
+template <typename T>
+constexpr T wrapping(div_op, T x, T y, unsigned_integer_tag) {
+  return div(x, y, unsigned_integer_tag());
+}
+
+// Only lowest / -1 wraps around, into lowest.
+template <typename T>
+constexpr T wrapping(div_op, T x, T y, signed_integer_tag) {
+  return ((y == -1)
+          ? wrapping(sub_op(), T(0), x, signed_integer_tag())
+          : div(x, y, signed_integer_tag()));
+}
+
+template <typename T>
+constexpr T wrapping(div_op, T x, T y, floating_point_tag) {
+  return (((y < 0) || (y > 0)) ? (x / y) : div_by_zero(x));
+}
+
+template <typename Op, typename T>
+constexpr T apply(wrap_op<Op>, T x, T y) {
+  return wrapping(Op(), x, y, arithmetic_category<T>());
+}
+
+// Kinds of saturation of results of apply().
+template <typename T>
+constexpr saturation_kind saturation_of(add_op, T x, T y, T result) {
+  return add_saturation(x, y, result, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr saturation_kind saturation_of(sub_op, T x, T y, T result) {
+  return sub_saturation(x, y, result, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr saturation_kind saturation_of(mul_op, T x, T y, T result) {
+  return mul_saturation(x, y, result, has_wider_type<T>());
+}
+
+template <typename T>
+constexpr saturation_kind saturation_of(div_op, T x, T y, T /* result */) {
+  return div_saturation(x, y, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr saturation_kind saturation_of(mul_add_op, T x, T y, T z, T result) {
+  return mul_add_saturation(x, y, z, result, has_wider_type<T>());
+}
+
+template <typename T>
+constexpr saturation_kind saturation_of(neg_op, T x, T /* result */) {
+  return neg_saturation(x, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr saturation_kind saturation_of(abs_op, T x, T /* result */) {
+  return abs_saturation(x, arithmetic_category<T>());
+}
+
+template <typename T>
+constexpr saturation_kind saturation_of(shl_op, T x, int shift,
+                                        T /* result */) {
+  return shl_saturation(x, shift);
+}
+
+constexpr saturation_op saturation_op_of(add_op) {
+  return saturation_op::add;
+}
+
+constexpr saturation_op saturation_op_of(sub_op) {
+  return saturation_op::sub;
+}
+
+constexpr saturation_op saturation_op_of(mul_op) {
+  return saturation_op::mul;
+}
+
+constexpr saturation_op saturation_op_of(div_op) {
+  return saturation_op::div;
+}
+
+constexpr saturation_op saturation_op_of(mul_add_op) {
+  return saturation_op::mul_add;
+}
+
+constexpr saturation_op saturation_op_of(neg_op) {
+  return saturation_op::neg;
+}
+
+constexpr saturation_op saturation_op_of(abs_op) {
+  return saturation_op::abs;
+}
+
+constexpr saturation_op saturation_op_of(shl_op) {
+  return saturation_op::shl;
+}
+
+}  // namespace impl
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_OP_PRIV_H_
@@ -0,0 +1,1170 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_PARALLEL_PRIV_H_
+#define INCLUDE_SATOP_PARALLEL_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "satop_batch-priv.h"
+#include "satop_dispatch-priv.h"
+#include "satop_div-priv.h"
+#include "satop_reduce-priv.h"
+
+namespace saturated {
+
+class thread_pool;
+
+namespace impl {
+
+// Chunks [begin, end) owned by a thread, packed into an atomic word.
+// The owner takes chunks from begin one by one,
+// and idle threads steal the latter half from end.
+// It is padded to a cache line to avoid false sharing.
+class chunk_range {
+ public:
+  chunk_range()
+      : range_(0), padding_() {
+  }
+
+  void reset(uint32_t begin, uint32_t end) {
+    range_.store(pack(begin, end), std::memory_order_release);
+  }
+
+  bool pop(std::size_t* chunk) {
+    uint64_t range = range_.load(std::memory_order_acquire);
+    for (;;) {
+      const uint32_t begin = static_cast<uint32_t>(range >> 32);
+      const uint32_t end = static_cast<uint32_t>(range);
+      if (begin >= end) {
+        return false;
+      }
+      if (range_.compare_exchange_weak(range, pack(begin + 1, end),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        *chunk = begin;
+        return true;
+      }
+    }
+  }
+
+  bool steal(uint32_t* begin, uint32_t* end) {
+    uint64_t range = range_.load(std::memory_order_acquire);
+    for (;;) {
+      const uint32_t first = static_cast<uint32_t>(range >> 32);
+      const uint32_t last = static_cast<uint32_t>(range);
+      if (first >= last) {
+        return false;
+      }
+      const uint32_t middle = first + (last - first) / 2;
+      if (range_.compare_exchange_weak(range, pack(first, middle),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        *begin = middle;
+        *end = last;
+        return true;
+      }
+    }
+  }
+
+ private:
+  static uint64_t pack(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(begin) << 32) | end;
+  }
+
+  std::atomic<uint64_t> range_;
+  char padding_[64 - sizeof(std::atomic<uint64_t>)];
+};
+
+// Chunks of a call of thread_pool::run(), where body is called
+// through a function pointer to avoid allocations of std::function.
+struct parallel_job {
+  void (*call)(const void* body, std::size_t chunk);
+  const void* body;
+  chunk_range* ranges;
+  std::size_t threads;
+};
+
+// Run chunks of thread self, and steal chunks of other threads
+// until all chunks are taken.
+SATOP_NOINLINE void run_chunks(const parallel_job& job, std::size_t self) {
+  std::size_t chunk = 0;
+  for (;;) {
+    while (job.ranges[self].pop(&chunk)) {
+      job.call(job.body, chunk);
+    }
+    bool is_stolen = false;
+    for (std::size_t i = 1; (i < job.threads) && !is_stolen; ++i) {
+      uint32_t begin = 0;
+      uint32_t end = 0;
+      is_stolen = job.ranges[(self + i) % job.threads].steal(&begin, &end);
+      if (is_stolen) {
+        job.ranges[self].reset(begin, end);
+      }
+    }
+    if (!is_stolen) {
+      return;
+    }
+  }
+}
+
+// thread_pool whose run() the calling thread is in,
+// so that nested calls run serially instead of waiting for themselves.
+inline const thread_pool*& current_thread_pool() {
+  static thread_local const thread_pool* pool = nullptr;
+  return pool;
+}
+
+inline std::size_t hardware_threads() {
+  return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Threads which run chunks of batch operations with work stealing.
+///
+/// The thread calling run() runs chunks too,
+/// so a pool of 1 thread runs them serially without other threads.
+/// run() may be called from any threads, and calls are serialized.
+class thread_pool {
+ public:
+  /// Start threads.
+  ///
+  /// @param threads Number of threads including the calling thread,
+  ///                all hardware threads by default
+  explicit thread_pool(std::size_t threads = impl::hardware_threads())
+      : size_(std::max<std::size_t>(threads, 1)),
+        ranges_(new impl::chunk_range[size_]),
+        workers_(),
+        run_mutex_(),
+        mutex_(),
+        start_(),
+        done_(),
+        job_(nullptr),
+        generation_(0),
+        busy_(0),
+        stop_(false) {
+    for (std::size_t i = 1; i < size_; ++i) {
+      workers_.emplace_back(&thread_pool::work, this, i);
+    }
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  /// Stop threads after they finish the current run().
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /// Get number of threads including the calling thread.
+  ///
+  /// @return Number of threads
+  std::size_t size() const {
+    return size_;
+  }
+
+  /// Call body(chunk) for each chunk in [0, chunks) on threads,
+  /// and wait for all of them.
+  ///
+  /// Each thread starts from its own range of chunks in order,
+  /// and steals halves of ranges of others after it finishes them.
+  /// Calls from body run serially on the calling thread.
+  ///
+  /// @param chunks Number of chunks, less than 2^32
+  /// @param body   Function called with indices of chunks,
+  ///               which must not throw
+  template <typename Body>
+  void run(std::size_t chunks, const Body& body) {
+    if ((size_ == 1) || (chunks <= 1)
+        || (impl::current_thread_pool() == this)) {
+      for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+        body(chunk);
+      }
+      return;
+    }
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    const std::size_t threads = std::min(size_, chunks);
+    for (std::size_t i = 0; i < size_; ++i) {
+      const std::size_t begin = std::min(i, threads) * chunks / threads;
+      const std::size_t end = std::min(i + 1, threads) * chunks / threads;
+      ranges_[i].reset(static_cast<uint32_t>(begin),
+                       static_cast<uint32_t>(end));
+    }
+    const impl::parallel_job job{&call<Body>, &body, ranges_.get(), size_};
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = &job;
+      busy_ = workers_.size();
+      ++generation_;
+    }
+    start_.notify_all();
+    const thread_pool* const outer = impl::current_thread_pool();
+    impl::current_thread_pool() = this;
+    impl::run_chunks(job, 0);
+    impl::current_thread_pool() = outer;
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return busy_ == 0; });
+    job_ = nullptr;
+  }
+
+ private:
+  template <typename Body>
+  static void call(const void* body, std::size_t chunk) {
+    (*static_cast<const Body*>(body))(chunk);
+  }
+
+  void work(std::size_t index) {
+    impl::current_thread_pool() = this;
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      start_.wait(lock, [this, &seen]() {
+        return stop_ || (generation_ != seen);
+      });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+      const impl::parallel_job* const job = job_;
+      lock.unlock();
+      impl::run_chunks(*job, index);
+      lock.lock();
+      if (--busy_ == 0) {
+        done_.notify_all();
+      }
+    }
+  }
+
+  std::size_t size_;
+  std::unique_ptr<impl::chunk_range[]> ranges_;
+  std::vector<std::thread> workers_;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const impl::parallel_job* job_;
+  uint64_t generation_;
+  std::size_t busy_;
+  bool stop_;
+};
+
+/// @}
+
+namespace impl {
+
+// Pool of parallel_policy without on(), started at its first use.
+SATOP_NOINLINE thread_pool& default_thread_pool() {
+  static thread_pool pool;
+  return pool;
+}
+
+// Batch operations smaller than this run serially by default,
+// because waking threads costs microseconds.
+constexpr std::size_t kParallelThresholdBytes = std::size_t{1} << 20;
+
+// Bytes of each array in a chunk, which fit in L2 cache
+// with a few arrays.
+constexpr std::size_t kParallelChunkBytes = std::size_t{1} << 16;
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Execution policy to run batch operations on threads,
+/// passed as the first argument such as add(par, x, y, out, n).
+///
+/// Batch operations of arrays, including in-place ones, saturate_cast(),
+/// convert(), sum() and dot() take it.  Operations of image_view,
+/// mixer and strided or matrix views do not, as well as overflow
+/// policies other than saturation.
+///
+/// Arrays are split into chunks of 64 KiB, and results are the same
+/// as serial operations, including reductions.
+/// Saturations counted by SATOP_TELEMETRY are tallied for each chunk,
+/// and recorded into counts of the calling thread
+/// as well as serial operations.
+class parallel_policy {
+ public:
+  /// Policy running on a pool of all hardware threads
+  /// for arrays of 1 MiB or larger.
+  constexpr parallel_policy()
+      : pool_(nullptr), threshold_(impl::kParallelThresholdBytes) {
+  }
+
+  /// Get the same policy running on another pool.
+  ///
+  /// @param pool Pool which must be alive while operations run
+  ///
+  /// @return The policy on pool
+  constexpr parallel_policy on(thread_pool* pool) const {
+    return parallel_policy(pool, threshold_);
+  }
+
+  /// Get the same policy with another threshold.
+  ///
+  /// @param bytes Operations whose arrays are smaller than bytes
+  ///              run serially on the calling thread
+  ///
+  /// @return The policy with the threshold
+  constexpr parallel_policy with_threshold(std::size_t bytes) const {
+    return parallel_policy(pool_, bytes);
+  }
+
+  /// Get the pool to run operations.
+  ///
+  /// @return The pool given by on(), or the default pool
+  thread_pool& pool() const {
+    return (pool_ != nullptr) ? *pool_ : impl::default_thread_pool();
+  }
+
+  /// Get the threshold of sizes of arrays to run operations in parallel.
+  ///
+  /// @return The threshold in bytes
+  constexpr std::size_t threshold() const {
+    return threshold_;
+  }
+
+ private:
+  constexpr parallel_policy(thread_pool* pool, std::size_t threshold)
+      : pool_(pool), threshold_(threshold) {
+  }
+
+  thread_pool* pool_;
+  std::size_t threshold_;
+};
+
+/// Execution policy to run batch operations on the default pool.
+constexpr parallel_policy par;
+
+/// @}
+
+namespace impl {
+
+template <typename T>
+constexpr std::size_t parallel_chunk_size() {
+  return kParallelChunkBytes / sizeof(T);
+}
+
+// Number of chunks of n elements of T, 1 if they run serially.
+template <typename T>
+std::size_t parallel_chunks(const parallel_policy& policy, std::size_t n) {
+  return (n * sizeof(T) < std::max<std::size_t>(policy.threshold(), 1))
+      ? 1
+      : (n + parallel_chunk_size<T>() - 1) / parallel_chunk_size<T>();
+}
+
+// Call body(chunk, begin, end) for chunks of n elements of T.
+template <typename T, typename Body>
+void parallel_for(const parallel_policy& policy, std::size_t n,
+                  const Body& body) {
+  const std::size_t chunks = parallel_chunks<T>(policy, n);
+  if (chunks <= 1) {
+    body(0, 0, n);
+    return;
+  }
+  policy.pool().run(chunks, [n, &body](std::size_t chunk) {
+    const std::size_t begin = chunk * parallel_chunk_size<T>();
+    body(chunk, begin, std::min(n, begin + parallel_chunk_size<T>()));
+  });
+}
+
+// Operands of a chunk from begin, where arrays are offset
+// and values are the same for all chunks.
+template <typename T>
+const T* chunk_operand(const T* x, std::size_t begin) {
+  return x + begin;
+}
+
+template <typename T>
+T* chunk_operand(T* x, std::size_t begin) {
+  return x + begin;
+}
+
+template <typename Y>
+Y chunk_operand(Y y, std::size_t /* begin */) {
+  return y;
+}
+
+// Run Kernel of Op on T for chunks of n elements, whose operands
+// are Args followed by the number of elements of each chunk.
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void parallel_store_batch(const parallel_policy& policy, Op, std::size_t n,
+                          Args... args) {
+  parallel_for<T>(policy, n,
+                  [&](std::size_t, std::size_t begin, std::size_t end) {
+                    dispatch<Kernel<Op, T>>(chunk_operand(args, begin)...,
+                                            end - begin, store_output());
+                  });
+}
+
+// Saturations are tallied for each chunk on threads running it,
+// and recorded into counts of the calling thread at once.
+#ifdef SATOP_TELEMETRY
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void parallel_batch(const parallel_policy& policy, Op, std::size_t n,
+                    Args... args) {
+  std::vector<saturation_tally> tallies(parallel_chunks<T>(policy, n),
+                                        saturation_tally{0, 0});
+  parallel_for<T>(policy, n,
+                  [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    dispatch<Kernel<Op, T>>(chunk_operand(args, begin)...,
+                                            end - begin,
+                                            count_output{&tallies[chunk]});
+                  });
+  saturation_tally tally = {0, 0};
+  for (const saturation_tally& chunk : tallies) {
+    tally.overflow += chunk.overflow;
+    tally.underflow += chunk.underflow;
+  }
+  record_saturations(saturation_op_of(Op()), tally);
+}
+
+// Rounding multiplication of fixed-point values is not counted
+// as well as serial ones.
+template <template <typename, typename> class Kernel, typename T,
+          int FracBits, typename... Args>
+void parallel_batch(const parallel_policy& policy, fixed_mul_op<FracBits>,
+                    std::size_t n, Args... args) {
+  parallel_store_batch<Kernel, T>(policy, fixed_mul_op<FracBits>(), n,
+                                  args...);
+}
+#else
+template <template <typename, typename> class Kernel, typename T,
+          typename Op, typename... Args>
+void parallel_batch(const parallel_policy& policy, Op, std::size_t n,
+                    Args... args) {
+  parallel_store_batch<Kernel, T>(policy, Op(), n, args...);
+}
+#endif  // SATOP_TELEMETRY
+
+template <typename Op, typename T, typename Y>
+void parallel_binary(const parallel_policy& policy,
+                     const T* x, Y y, T* out, std::size_t n) {
+  parallel_batch<binary_kernel, T>(policy, Op(), n, x, y, out);
+}
+
+// Arrays of fixed are processed as arrays of their raw values,
+// as serial ones.
+template <typename Op, int IntBits, int FracBits, typename Storage>
+void parallel_binary(const parallel_policy& policy,
+                     const fixed<IntBits, FracBits, Storage>* x,
+                     const fixed<IntBits, FracBits, Storage>* y,
+                     fixed<IntBits, FracBits, Storage>* out,
+                     std::size_t n) {
+  parallel_binary<typename fixed_raw_op<Op, FracBits>::type>(
+      policy, raw_array(x), raw_array(y), raw_array(out), n);
+}
+
+template <typename Op, int IntBits, int FracBits, typename Storage>
+void parallel_binary(const parallel_policy& policy,
+                     const fixed<IntBits, FracBits, Storage>* x,
+                     fixed<IntBits, FracBits, Storage> y,
+                     fixed<IntBits, FracBits, Storage>* out,
+                     std::size_t n) {
+  parallel_binary<typename fixed_raw_op<Op, FracBits>::type>(
+      policy, raw_array(x), y.raw(), raw_array(out), n);
+}
+
+// Saturating additions of a chunk as a function of the accumulator
+// before it, acc = clamp(acc + sum, lowest, max), whose bounds follow
+// saturations in the chunk.  Functions of chunks are composed in order,
+// so the result is the same as the serial loop.
+template <typename T>
+class clamp_chain {
+ public:
+  clamp_chain()
+      : sum_(0),
+        lowest_(std::numeric_limits<T>::lowest()),
+        max_(std::numeric_limits<T>::max()) {
+  }
+
+  // Add value up to 2^62 in magnitude with saturation.
+  // sum_ is reset once the result is a constant,
+  // so it never exceeds the range of 2 values of T.
+  void add(int64_t value) {
+    sum_ += value;
+    lowest_ = clamp_cast<T>(lowest_ + value);
+    max_ = clamp_cast<T>(max_ + value);
+    if (std::numeric_limits<T>::lowest() + sum_ >= max_) {
+      lowest_ = max_;
+      sum_ = 0;
+    } else if (std::numeric_limits<T>::max() + sum_ <= lowest_) {
+      max_ = lowest_;
+      sum_ = 0;
+    }
+  }
+
+  T apply(T acc) const {
+    return static_cast<T>(std::min(std::max(acc + sum_, lowest_), max_));
+  }
+
+ private:
+  int64_t sum_;
+  int64_t lowest_;
+  int64_t max_;
+};
+
+template <typename T>
+T parallel_sum_at_end(const parallel_policy& policy,
+                      const T* x, std::size_t n) {
+  std::vector<wide_accumulator> partials(parallel_chunks<T>(policy, n));
+  parallel_for<T>(policy, n,
+                  [x, &partials](std::size_t chunk,
+                                 std::size_t begin, std::size_t end) {
+                    dispatch<sum_kernel<T>>(x + begin, end - begin,
+                                            &partials[chunk]);
+                  });
+  wide_accumulator acc;
+  for (const auto& partial : partials) {
+    acc.add(partial);
+  }
+  return acc.clamp<T>();
+}
+
+template <typename T>
+T parallel_dot_at_end(const parallel_policy& policy,
+                      const T* x, const T* y, std::size_t n) {
+  std::vector<wide_accumulator> partials(parallel_chunks<T>(policy, n));
+  parallel_for<T>(policy, n,
+                  [x, y, &partials](std::size_t chunk,
+                                    std::size_t begin, std::size_t end) {
+                    dispatch<dot_kernel<T>>(x + begin, y + begin,
+                                            end - begin, &partials[chunk]);
+                  });
+  wide_accumulator acc;
+  for (const auto& partial : partials) {
+    acc.add(partial);
+  }
+  return acc.clamp<T>();
+}
+
+// Unsigned reductions saturating at each step are the same
+// as ones saturating at the end, as serial ones.
+template <typename T>
+T parallel_sum_each_step(const parallel_policy& policy,
+                         const T* x, std::size_t n,
+                         std::false_type /* is_signed */) {
+  return parallel_sum_at_end(policy, x, n);
+}
+
+template <typename T>
+T parallel_sum_each_step(const parallel_policy& policy,
+                         const T* x, std::size_t n,
+                         std::true_type /* is_signed */) {
+  std::vector<clamp_chain<T>> chains(parallel_chunks<T>(policy, n));
+  parallel_for<T>(policy, n,
+                  [x, &chains](std::size_t chunk,
+                               std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                      chains[chunk].add(x[i]);
+                    }
+                  });
+  T acc = 0;
+  for (const auto& chain : chains) {
+    acc = chain.apply(acc);
+  }
+  return acc;
+}
+
+template <typename T>
+T parallel_dot_each_step(const parallel_policy& policy,
+                         const T* x, const T* y, std::size_t n,
+                         std::false_type /* is_signed */) {
+  return parallel_dot_at_end(policy, x, y, n);
+}
+
+template <typename T>
+T parallel_dot_each_step(const parallel_policy& policy,
+                         const T* x, const T* y, std::size_t n,
+                         std::true_type /* is_signed */) {
+  std::vector<clamp_chain<T>> chains(parallel_chunks<T>(policy, n));
+  parallel_for<T>(policy, n,
+                  [x, y, &chains](std::size_t chunk,
+                                  std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                      chains[chunk].add(int64_t{x[i]} * y[i]);
+                    }
+                  });
+  T acc = 0;
+  for (const auto& chain : chains) {
+    acc = chain.apply(acc);
+  }
+  return acc;
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Add 2 arrays element by element with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to add
+/// @param y      Array of values to add
+/// @param out    Array to store add(x[i], y[i]) into,
+///               it may be the same as x or y
+/// @param n      Number of elements of each array
+template <typename T>
+void add(const parallel_policy& policy,
+         const T* x, const T* y, T* out, std::size_t n) {
+  impl::parallel_binary<impl::add_op>(policy, x, y, out, n);
+}
+
+/// Add a value to each element of an array with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to add
+/// @param y      A value to add to each element of x
+/// @param out    Array to store add(x[i], y) into, it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void add(const parallel_policy& policy,
+         const T* x, T y, T* out, std::size_t n) {
+  impl::parallel_binary<impl::add_op>(policy, x, y, out, n);
+}
+
+/// Add an array to another one in place with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with add(x[i], y[i])
+/// @param y      Array of values to add
+/// @param n      Number of elements of each array
+template <typename T>
+void add(const parallel_policy& policy, T* x, const T* y, std::size_t n) {
+  add(policy, static_cast<const T*>(x), y, x, n);
+}
+
+/// Add a value to each element of an array in place with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with add(x[i], y)
+/// @param y      A value to add to each element of x
+/// @param n      Number of elements of x
+template <typename T>
+void add(const parallel_policy& policy, T* x, T y, std::size_t n) {
+  add(policy, static_cast<const T*>(x), y, x, n);
+}
+
+/// Subtract arrays element by element with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to be subtracted
+/// @param y      Array of values to subtract
+/// @param out    Array to store sub(x[i], y[i]) into,
+///               it may be the same as x or y
+/// @param n      Number of elements of each array
+template <typename T>
+void sub(const parallel_policy& policy,
+         const T* x, const T* y, T* out, std::size_t n) {
+  impl::parallel_binary<impl::sub_op>(policy, x, y, out, n);
+}
+
+/// Subtract a value from each element of an array with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to be subtracted
+/// @param y      A value to subtract from each element of x
+/// @param out    Array to store sub(x[i], y) into, it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void sub(const parallel_policy& policy,
+         const T* x, T y, T* out, std::size_t n) {
+  impl::parallel_binary<impl::sub_op>(policy, x, y, out, n);
+}
+
+/// Subtract an array from another one in place with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with sub(x[i], y[i])
+/// @param y      Array of values to subtract
+/// @param n      Number of elements of each array
+template <typename T>
+void sub(const parallel_policy& policy, T* x, const T* y, std::size_t n) {
+  sub(policy, static_cast<const T*>(x), y, x, n);
+}
+
+/// Subtract a value from each element of an array in place
+/// with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with sub(x[i], y)
+/// @param y      A value to subtract from each element of x
+/// @param n      Number of elements of x
+template <typename T>
+void sub(const parallel_policy& policy, T* x, T y, std::size_t n) {
+  sub(policy, static_cast<const T*>(x), y, x, n);
+}
+
+/// Multiply 2 arrays element by element with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to multiply
+/// @param y      Array of values to multiply
+/// @param out    Array to store mul(x[i], y[i]) into,
+///               it may be the same as x or y
+/// @param n      Number of elements of each array
+template <typename T>
+void mul(const parallel_policy& policy,
+         const T* x, const T* y, T* out, std::size_t n) {
+  impl::parallel_binary<impl::mul_op>(policy, x, y, out, n);
+}
+
+/// Multiply each element of an array by a value with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to multiply
+/// @param y      A value to multiply each element of x by
+/// @param out    Array to store mul(x[i], y) into, it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void mul(const parallel_policy& policy,
+         const T* x, T y, T* out, std::size_t n) {
+  impl::parallel_binary<impl::mul_op>(policy, x, y, out, n);
+}
+
+/// Multiply an array by another one in place with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with mul(x[i], y[i])
+/// @param y      Array of values to multiply by
+/// @param n      Number of elements of each array
+template <typename T>
+void mul(const parallel_policy& policy, T* x, const T* y, std::size_t n) {
+  mul(policy, static_cast<const T*>(x), y, x, n);
+}
+
+/// Multiply each element of an array by a value in place
+/// with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with mul(x[i], y)
+/// @param y      A value to multiply each element of x by
+/// @param n      Number of elements of x
+template <typename T>
+void mul(const parallel_policy& policy, T* x, T y, std::size_t n) {
+  mul(policy, static_cast<const T*>(x), y, x, n);
+}
+
+/// Divide each element of an array by a prepared divisor with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param policy Execution policy
+/// @param x      Array of values to be divided
+/// @param y      Divisor to divide each element of x by
+/// @param out    Array to store div(x[i], y.divisor()) into,
+///               it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void div(const parallel_policy& policy,
+         const T* x, const divider<T>& y, T* out, std::size_t n) {
+  impl::parallel_batch<impl::divide_kernel, T>(policy, impl::div_op(), n,
+                                              x, y, out);
+}
+
+/// Divide each element of an array by a value with saturation
+/// in parallel.
+///
+/// The divisor is prepared as divider once for all chunks.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param policy Execution policy
+/// @param x      Array of values to be divided
+/// @param y      A value to divide each element of x by
+/// @param out    Array to store div(x[i], y) into, it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void div(const parallel_policy& policy,
+         const T* x, T y, T* out, std::size_t n) {
+  div(policy, x, divider<T>(y), out, n);
+}
+
+/// Divide each element of an array by a prepared divisor in place
+/// with saturation in parallel.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with div(x[i], y.divisor())
+/// @param y      Divisor to divide each element of x by
+/// @param n      Number of elements of x
+template <typename T>
+void div(const parallel_policy& policy,
+         T* x, const divider<T>& y, std::size_t n) {
+  div(policy, static_cast<const T*>(x), y, x, n);
+}
+
+/// Divide each element of an array by a value in place with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with div(x[i], y)
+/// @param y      A value to divide each element of x by
+/// @param n      Number of elements of x
+template <typename T>
+void div(const parallel_policy& policy, T* x, T y, std::size_t n) {
+  div(policy, static_cast<const T*>(x), divider<T>(y), x, n);
+}
+
+/// Multiply elements of 2 arrays and add another one
+/// with saturation only at the end in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to multiply
+/// @param y      Array of values to multiply
+/// @param z      Array of values to add to the products
+/// @param out    Array to store mul_add(x[i], y[i], z[i]) into
+/// @param n      Number of elements of each array
+template <typename T>
+void mul_add(const parallel_policy& policy,
+             const T* x, const T* y, const T* z, T* out, std::size_t n) {
+  impl::parallel_batch<impl::ternary_kernel, T>(policy, impl::mul_add_op(),
+                                               n, x, y, z, out);
+}
+
+/// Multiply each element of an array by a value and add another array
+/// with saturation only at the end in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to multiply
+/// @param y      A value to multiply each element of x by
+/// @param z      Array of values to add to the products
+/// @param out    Array to store mul_add(x[i], y, z[i]) into,
+///               it may be the same as x or z
+/// @param n      Number of elements of each array
+template <typename T>
+void mul_add(const parallel_policy& policy,
+             const T* x, T y, const T* z, T* out, std::size_t n) {
+  impl::parallel_batch<impl::ternary_kernel, T>(policy, impl::mul_add_op(),
+                                               n, x, y, z, out);
+}
+
+/// Accumulate products of 2 arrays element by element with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to multiply
+/// @param y      Array of values to multiply
+/// @param acc    Array to be replaced with mul_add(x[i], y[i], acc[i])
+/// @param n      Number of elements of each array
+template <typename T>
+void mul_add(const parallel_policy& policy,
+             const T* x, const T* y, T* acc, std::size_t n) {
+  mul_add(policy, x, y, static_cast<const T*>(acc), acc, n);
+}
+
+/// Accumulate products of an array and a value element by element
+/// with saturation in parallel.
+///
+/// @tparam T Type of elements
+///
+/// @param policy Execution policy
+/// @param x      Array of values to multiply
+/// @param y      A value to multiply each element of x by
+/// @param acc    Array to be replaced with mul_add(x[i], y, acc[i])
+/// @param n      Number of elements of each array
+template <typename T>
+void mul_add(const parallel_policy& policy,
+             const T* x, T y, T* acc, std::size_t n) {
+  mul_add(policy, x, y, static_cast<const T*>(acc), acc, n);
+}
+
+/// Negate each element of an array with saturation in parallel.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param policy Execution policy
+/// @param x      Array of values to negate
+/// @param out    Array to store neg(x[i]) into, it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void neg(const parallel_policy& policy, const T* x, T* out, std::size_t n) {
+  static_assert(std::is_integral<T>::value,
+                "neg supports only integral types");
+  impl::parallel_batch<impl::unary_kernel, T>(policy, impl::neg_op(), n,
+                                             x, out);
+}
+
+/// Negate each element of an array in place with saturation in parallel.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with neg(x[i])
+/// @param n      Number of elements of x
+template <typename T>
+void neg(const parallel_policy& policy, T* x, std::size_t n) {
+  neg(policy, static_cast<const T*>(x), x, n);
+}
+
+/// Absolute value of each element of an array with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param policy Execution policy
+/// @param x      Array of values
+/// @param out    Array to store abs(x[i]) into, it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void abs(const parallel_policy& policy, const T* x, T* out, std::size_t n) {
+  static_assert(std::is_integral<T>::value,
+                "abs supports only integral types");
+  impl::parallel_batch<impl::unary_kernel, T>(policy, impl::abs_op(), n,
+                                             x, out);
+}
+
+/// Replace each element of an array with its absolute value
+/// with saturation in parallel.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with abs(x[i])
+/// @param n      Number of elements of x
+template <typename T>
+void abs(const parallel_policy& policy, T* x, std::size_t n) {
+  abs(policy, static_cast<const T*>(x), x, n);
+}
+
+/// Shift each element of an array left with saturation in parallel.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param policy Execution policy
+/// @param x      Array of values to shift
+/// @param shift  Number of bits to shift each element of x by, 0 or more
+/// @param out    Array to store shl(x[i], shift) into,
+///               it may be the same as x
+/// @param n      Number of elements of each array
+template <typename T>
+void shl(const parallel_policy& policy,
+         const T* x, int shift, T* out, std::size_t n) {
+  static_assert(std::is_integral<T>::value,
+                "shl supports only integral types");
+  impl::parallel_batch<impl::shift_kernel, T>(policy, impl::shl_op(), n,
+                                             x, shift, out);
+}
+
+/// Shift each element of an array left in place with saturation
+/// in parallel.
+///
+/// @tparam T Type of elements, integral type
+///
+/// @param policy Execution policy
+/// @param x      Array to be replaced with shl(x[i], shift)
+/// @param shift  Number of bits to shift each element of x by, 0 or more
+/// @param n      Number of elements of x
+template <typename T>
+void shl(const parallel_policy& policy, T* x, int shift, std::size_t n) {
+  shl(policy, static_cast<const T*>(x), shift, x, n);
+}
+
+/// Convert elements of an array into another type with saturation
+/// in parallel.
+///
+/// @tparam To   Type of elements to convert into
+/// @tparam From Type of elements of x
+///
+/// @param policy Execution policy
+/// @param x      Array of values to convert
+/// @param out    Array to store saturate_cast<To>(x[i]) into,
+///               which must not overlap x
+/// @param n      Number of elements of each array
+template <typename To, typename From>
+void saturate_cast(const parallel_policy& policy,
+                   const From* x, To* out, std::size_t n) {
+  impl::parallel_for<From>(policy, n,
+                           [=](std::size_t,
+                               std::size_t begin, std::size_t end) {
+                             saturate_cast(x + begin, out + begin,
+                                           end - begin);
+                           });
+}
+
+/// Convert elements of a floating point array into integral type
+/// with saturation, after multiplying them by a scale, in parallel.
+///
+/// Chunks are split by elements of x.
+///
+/// @tparam From Floating point type of elements of x
+/// @tparam To   Integral type of elements to convert into, except bool
+///
+/// @param policy Execution policy
+/// @param x      Array of values to convert
+/// @param out    Array to store results into, which must not overlap x
+/// @param n      Number of elements of each array
+/// @param scale  A value to multiply elements of x by
+/// @param mode   Rounding mode
+template <typename From, typename To>
+void convert(const parallel_policy& policy,
+             const From* x, To* out, std::size_t n, From scale,
+             rounding mode = rounding::toward_zero) {
+  impl::parallel_for<From>(policy, n,
+                           [=](std::size_t,
+                               std::size_t begin, std::size_t end) {
+                             convert(x + begin, out + begin, end - begin,
+                                     scale, mode);
+                           });
+}
+
+/// Convert elements of a floating point array into integral type
+/// with saturation in parallel.
+///
+/// @tparam From Floating point type of elements of x
+/// @tparam To   Integral type of elements to convert into, except bool
+///
+/// @param policy Execution policy
+/// @param x      Array of values to convert
+/// @param out    Array to store convert<To>(x[i], mode) into,
+///               which must not overlap x
+/// @param n      Number of elements of each array
+/// @param mode   Rounding mode
+template <typename From, typename To>
+void convert(const parallel_policy& policy,
+             const From* x, To* out, std::size_t n,
+             rounding mode = rounding::toward_zero) {
+  convert(policy, x, out, n, static_cast<From>(1), mode);
+}
+
+/// Sum elements of an array with saturation in parallel.
+///
+/// Results are the same as sum() without policy in both modes,
+/// regardless of threads.  With reduction_mode::clamp_each_step,
+/// each chunk is summarized as a saturating function
+/// of the sum before it, and they are composed in order.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param policy Execution policy
+/// @param x      Array of values to sum
+/// @param n      Number of elements of x
+/// @param mode   When the result is saturated
+///
+/// @return The sum saturated into the range of T, 0 if n is 0.
+template <typename T>
+T sum(const parallel_policy& policy, const T* x, std::size_t n,
+      reduction_mode mode = reduction_mode::clamp_at_end) {
+  static_assert(std::is_integral<T>::value && (sizeof(T) <= sizeof(int32_t)),
+                "sum supports only integral types up to 32 bits");
+  return (mode == reduction_mode::clamp_each_step)
+      ? impl::parallel_sum_each_step(policy, x, n, std::is_signed<T>())
+      : impl::parallel_sum_at_end(policy, x, n);
+}
+
+/// Sum products of elements of 2 arrays with saturation in parallel.
+///
+/// Results are the same as dot() without policy in both modes,
+/// regardless of threads.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param policy Execution policy
+/// @param x      Array of values to multiply
+/// @param y      Array of values to multiply
+/// @param n      Number of elements of each array
+/// @param mode   When the result is saturated
+///
+/// @return The sum of products saturated into the range of T,
+///         0 if n is 0.
+template <typename T>
+T dot(const parallel_policy& policy, const T* x, const T* y, std::size_t n,
+      reduction_mode mode = reduction_mode::clamp_at_end) {
+  static_assert(std::is_integral<T>::value && (sizeof(T) <= sizeof(int32_t)),
+                "dot supports only integral types up to 32 bits");
+  return (mode == reduction_mode::clamp_each_step)
+      ? impl::parallel_dot_each_step(policy, x, y, n, std::is_signed<T>())
+      : impl::parallel_dot_at_end(policy, x, y, n);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_PARALLEL_PRIV_H_
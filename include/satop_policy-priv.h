@@ -0,0 +1,283 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_POLICY_PRIV_H_
+#define INCLUDE_SATOP_POLICY_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "satop_op-priv.h"
+#include "satop_telemetry-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Overflow policy to saturate results, the same as functions without policy.
+struct saturate {};
+
+/// Overflow policy to wrap results around as unsigned integers.
+///
+/// Division by 0 is still saturated because it has no wrapped result.
+/// Results of floating point types are not clamped into finite values.
+struct wrap {};
+
+/// Overflow policy to throw saturation_error instead of saturating.
+///
+/// Batch operations throw before storing any result.
+struct trap {};
+
+/// Overflow policy to count saturations regardless of SATOP_TELEMETRY,
+/// and to return results of Base.
+///
+/// Counts are available by saturation_snapshot(),
+/// and saturation_occurred() works as a sticky flag.
+///
+/// @tparam Base saturate or wrap
+template <typename Base = saturate>
+struct report {
+  static_assert(std::is_same<Base, saturate>::value
+                || std::is_same<Base, wrap>::value,
+                "Base of report must be saturate or wrap");
+};
+
+/// Whether Policy is an overflow policy.
+///
+/// @tparam Policy A type to check
+template <typename Policy>
+struct is_overflow_policy : public std::false_type {
+};
+
+template <>
+struct is_overflow_policy<saturate> : public std::true_type {
+};
+
+template <>
+struct is_overflow_policy<wrap> : public std::true_type {
+};
+
+template <>
+struct is_overflow_policy<trap> : public std::true_type {
+};
+
+template <typename Base>
+struct is_overflow_policy<report<Base>> : public std::true_type {
+};
+
+/// Exception thrown by operations with trap policy.
+class saturation_error : public std::overflow_error {
+ public:
+  /// @param op        The operation which saturated
+  /// @param direction The direction of saturation
+  saturation_error(saturation_op op, saturation_direction direction)
+      : std::overflow_error(message_of(op, direction)),
+        op_(op),
+        direction_(direction) {
+  }
+
+  /// @return The operation which saturated
+  saturation_op op() const {
+    return op_;
+  }
+
+  /// @return The direction of saturation
+  saturation_direction direction() const {
+    return direction_;
+  }
+
+ private:
+  static std::string message_of(saturation_op op,
+                                saturation_direction direction) {
+    static const char* const kNames[] = {
+      "add", "sub", "mul", "div", "mul_add", "mul_div"
+    };
+    return (std::string("saturated::") + kNames[static_cast<int>(op)]
+            + ((direction == saturation_direction::overflow)
+               ? " overflowed"
+               : " underflowed"));
+  }
+
+  saturation_op op_;
+  saturation_direction direction_;
+};
+
+/// @}
+
+namespace impl {
+
+// Operation which kernels run for Op with Policy.
+// Policies which check saturations run saturated Op.
+template <typename Op, typename Policy>
+struct policy_op {
+  using type = Op;
+};
+
+template <typename Op>
+struct policy_op<Op, wrap> {
+  using type = wrap_op<Op>;
+};
+
+template <typename Op, typename Base>
+struct policy_op<Op, report<Base>> {
+  using type = typename policy_op<Op, Base>::type;
+};
+
+template <typename T>
+constexpr T apply_policy(saturate, add_op, T x, T y) {
+  return saturated::add(x, y);
+}
+
+template <typename T>
+constexpr T apply_policy(saturate, sub_op, T x, T y) {
+  return saturated::sub(x, y);
+}
+
+template <typename T>
+constexpr T apply_policy(saturate, mul_op, T x, T y) {
+  return saturated::mul(x, y);
+}
+
+template <typename T>
+constexpr T apply_policy(saturate, div_op, T x, T y) {
+  return saturated::div(x, y);
+}
+
+template <typename Op, typename T>
+constexpr T apply_policy(wrap, Op, T x, T y) {
+  return apply(wrap_op<Op>(), x, y);
+}
+
+inline saturation_error saturation_error_of(saturation_op op,
+                                            saturation_kind kind) {
+  return saturation_error(op,
+                          ((kind == saturation_kind::overflow)
+                           ? saturation_direction::overflow
+                           : saturation_direction::underflow));
+}
+
+template <typename Op, typename T>
+constexpr T trap_if_saturated(Op op, T x, T y, T result) {
+  return ((saturation_of(op, x, y, result) == saturation_kind::none)
+          ? result
+          : throw saturation_error_of(saturation_op_of(op),
+                                      saturation_of(op, x, y, result)));
+}
+
+template <typename Op, typename T>
+constexpr T apply_policy(trap, Op op, T x, T y) {
+  return trap_if_saturated(op, x, y, apply(op, x, y));
+}
+
+// Saturation is found by the saturated result,
+// even if the wrapped result is returned.
+template <typename Base, typename Op, typename T>
+constexpr T apply_policy(report<Base>, Op op, T x, T y) {
+  return observe(saturation_op_of(op),
+                 apply(typename policy_op<Op, Base>::type(), x, y),
+                 saturation_of(op, x, y, apply(op, x, y)));
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Add 2 values with an overflow policy.
+///
+/// The same kernel can be instantiated for each policy
+/// by calling add<Policy>(x, y) in it, without branches at runtime.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of arguments and the return value
+///
+/// @param x A value to add
+/// @param y A value to add
+///
+/// @return x + y if it does not overflow,
+///         otherwise the result by Policy
+template <typename Policy, typename T>
+constexpr typename std::enable_if<is_overflow_policy<Policy>::value, T>::type
+add(T x, T y) {
+  return impl::apply_policy(Policy(), impl::add_op(), x, y);
+}
+
+/// Subtract 2 values with an overflow policy.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of arguments and the return value
+///
+/// @param x Subtract from this value
+/// @param y Subtract this value
+///
+/// @return x - y if it does not overflow,
+///         otherwise the result by Policy
+template <typename Policy, typename T>
+constexpr typename std::enable_if<is_overflow_policy<Policy>::value, T>::type
+sub(T x, T y) {
+  return impl::apply_policy(Policy(), impl::sub_op(), x, y);
+}
+
+/// Multiply 2 values with an overflow policy.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of arguments and the return value
+///
+/// @param x A value to multiply
+/// @param y A value to multiply
+///
+/// @return x * y if it does not overflow,
+///         otherwise the result by Policy
+template <typename Policy, typename T>
+constexpr typename std::enable_if<is_overflow_policy<Policy>::value, T>::type
+mul(T x, T y) {
+  return impl::apply_policy(Policy(), impl::mul_op(), x, y);
+}
+
+/// Divide 2 values with an overflow policy.
+///
+/// Division by 0 is saturated with wrap,
+/// and it is an error with trap unless x is 0.
+///
+/// @tparam Policy saturate, wrap, trap or report
+/// @tparam T      Type of arguments and the return value
+///
+/// @param x A value to be divided
+/// @param y A value to divide by
+///
+/// @return x / y if it does not overflow,
+///         otherwise the result by Policy
+template <typename Policy, typename T>
+constexpr typename std::enable_if<is_overflow_policy<Policy>::value, T>::type
+div(T x, T y) {
+  return impl::apply_policy(Policy(), impl::div_op(), x, y);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_POLICY_PRIV_H_
@@ -0,0 +1,331 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_REDUCE_PRIV_H_
+#define INCLUDE_SATOP_REDUCE_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "satop_add-priv.h"
+#include "satop_dispatch-priv.h"
+#include "satop_mul_add-priv.h"
+#include "satop_op-priv.h"
+#include "satop_simd-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// When reductions saturate their results.
+enum class reduction_mode : int {
+  /// Accumulate exactly and saturate only the result,
+  /// which is vectorized.
+  clamp_at_end,
+  /// Saturate after each element as a loop of add() or mul_add(),
+  /// which is serial for signed types.
+  clamp_each_step,
+};
+
+/// @}
+
+namespace impl {
+
+// Reduction instruction set implementations for sum_op are unary.
+template <typename Isa, typename T>
+struct has_vector_binary<
+  Isa, sum_op, T,
+  decltype(static_cast<void>(Isa::apply(sum_op(),
+                                        Isa::load(nullptr),
+                                        type_tag<T>())))>
+    : public std::true_type {
+};
+
+// 128 bits two's complement accumulator,
+// which holds any sum of 64 bits values in practice.
+class wide_accumulator {
+ public:
+  wide_accumulator()
+      : lo_(0), hi_(0) {
+  }
+
+  void add(int64_t value) {
+    const uint64_t u = static_cast<uint64_t>(value);
+    lo_ += u;
+    hi_ += static_cast<uint64_t>(lo_ < u)
+           + ((value < 0) ? std::numeric_limits<uint64_t>::max() : 0);
+  }
+
+  void add(uint64_t value) {
+    lo_ += value;
+    hi_ += static_cast<uint64_t>(lo_ < value);
+  }
+
+  void add(const wide_accumulator& other) {
+    lo_ += other.lo_;
+    hi_ += other.hi_ + static_cast<uint64_t>(lo_ < other.lo_);
+  }
+
+  // Accumulated value saturated into the range of T.
+  template <typename T>
+  T clamp() const {
+    return clamp<T>(std::is_signed<T>());
+  }
+
+ private:
+  bool is_negative() const {
+    return (hi_ >> 63) != 0;
+  }
+
+  template <typename T>
+  T clamp(std::true_type /* is_signed */) const {
+    return (hi_ == (((lo_ >> 63) != 0)
+                    ? std::numeric_limits<uint64_t>::max()
+                    : 0))
+        ? clamp_cast<T>(static_cast<int64_t>(lo_))
+        : (is_negative()
+           ? std::numeric_limits<T>::lowest()
+           : std::numeric_limits<T>::max());
+  }
+
+  template <typename T>
+  T clamp(std::false_type /* is_signed */) const {
+    return (hi_ == 0)
+        ? clamp_cast<T>(lo_)
+        : (is_negative()
+           ? std::numeric_limits<T>::lowest()
+           : std::numeric_limits<T>::max());
+  }
+
+  uint64_t lo_;
+  uint64_t hi_;
+};
+
+// 64 bits type which holds any value of T
+// and any product of 2 values of T up to 32 bits.
+template <typename T>
+using accumulated_type = typename std::conditional<std::is_signed<T>::value,
+                                                   int64_t,
+                                                   uint64_t>::type;
+
+// Number of vectors accumulated in 64 bits lanes before they are
+// added into wide_accumulator.  Each vector adds less than 2^34
+// into each lane, so lanes never overflow.
+constexpr std::size_t kReductionBlockVectors = 65536;
+
+SATOP_GENERIC_SIMD_BEGIN()
+
+template <typename T>
+SATOP_ALWAYS_INLINE void sum_loop(scalar_isa,
+                                  const T* x, std::size_t n,
+                                  wide_accumulator* acc) {
+  for (std::size_t i = 0; i < n; ++i) {
+    acc->add(static_cast<accumulated_type<T>>(x[i]));
+  }
+}
+
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE void sum_loop(Isa,
+                                  const T* x, std::size_t n,
+                                  wide_accumulator* acc) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type) / sizeof(T);
+  std::size_t i = 0;
+  while (n - i >= kLanes) {
+    const std::size_t block_end =
+        i + std::min((n - i) / kLanes, kReductionBlockVectors) * kLanes;
+    typename Isa::vector_type partial = Isa::zero();
+    for (; i < block_end; i += kLanes) {
+      partial = Isa::add_i64(partial, Isa::apply(sum_op(),
+                                                 Isa::load(x + i),
+                                                 type_tag<T>()));
+    }
+    acc->add(Isa::reduce_add_i64(partial));
+  }
+  sum_loop(scalar_isa(), x + i, n - i, acc);
+}
+
+template <typename T>
+SATOP_ALWAYS_INLINE void dot_loop(scalar_isa,
+                                  const T* x, const T* y, std::size_t n,
+                                  wide_accumulator* acc) {
+  for (std::size_t i = 0; i < n; ++i) {
+    acc->add(static_cast<accumulated_type<T>>(
+        static_cast<accumulated_type<T>>(x[i])
+        * static_cast<accumulated_type<T>>(y[i])));
+  }
+}
+
+template <typename Isa, typename T>
+SATOP_ALWAYS_INLINE void dot_loop(Isa,
+                                  const T* x, const T* y, std::size_t n,
+                                  wide_accumulator* acc) {
+  constexpr std::size_t kLanes = sizeof(typename Isa::vector_type) / sizeof(T);
+  std::size_t i = 0;
+  while (n - i >= kLanes) {
+    const std::size_t block_end =
+        i + std::min((n - i) / kLanes, kReductionBlockVectors) * kLanes;
+    typename Isa::vector_type partial = Isa::zero();
+    for (; i < block_end; i += kLanes) {
+      partial = Isa::add_i64(partial, Isa::apply(dot_op(),
+                                                 Isa::load(x + i),
+                                                 Isa::load(y + i),
+                                                 type_tag<T>()));
+    }
+    acc->add(Isa::reduce_add_i64(partial));
+  }
+  dot_loop(scalar_isa(), x + i, y + i, n - i, acc);
+}
+
+template <typename T>
+struct sum_kernel {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, std::size_t n,
+                                      wide_accumulator* acc) {
+    sum_loop(typename select_isa<sum_op, T, Isas>::type(), x, n, acc);
+  }
+};
+
+template <typename T>
+struct dot_kernel {
+  template <typename Isas>
+  SATOP_ALWAYS_INLINE static void run(Isas,
+                                      const T* x, const T* y, std::size_t n,
+                                      wide_accumulator* acc) {
+    dot_loop(typename select_isa<dot_op, T, Isas>::type(), x, y, n, acc);
+  }
+};
+
+SATOP_GENERIC_SIMD_END()
+
+template <typename T>
+T sum_at_end(const T* x, std::size_t n) {
+  wide_accumulator acc;
+  dispatch<sum_kernel<T>>(x, n, &acc);
+  return acc.clamp<T>();
+}
+
+template <typename T>
+T dot_at_end(const T* x, const T* y, std::size_t n) {
+  wide_accumulator acc;
+  dispatch<dot_kernel<T>>(x, y, n, &acc);
+  return acc.clamp<T>();
+}
+
+// Saturated partial sums of unsigned values never decrease,
+// so saturating at each step is the same as saturating at the end.
+template <typename T>
+T sum_each_step(const T* x, std::size_t n, std::false_type /* is_signed */) {
+  return sum_at_end(x, n);
+}
+
+template <typename T>
+T sum_each_step(const T* x, std::size_t n, std::true_type /* is_signed */) {
+  T acc = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    acc = apply(add_op(), acc, x[i]);
+  }
+  return acc;
+}
+
+template <typename T>
+T dot_each_step(const T* x, const T* y, std::size_t n,
+                std::false_type /* is_signed */) {
+  return dot_at_end(x, y, n);
+}
+
+template <typename T>
+T dot_each_step(const T* x, const T* y, std::size_t n,
+                std::true_type /* is_signed */) {
+  T acc = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    acc = apply(mul_add_op(), x[i], y[i], acc);
+  }
+  return acc;
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Sum elements of an array with saturation.
+///
+/// With reduction_mode::clamp_at_end, the exact sum is saturated once,
+/// so sum of {max, max, lowest} is max - 1.
+/// With reduction_mode::clamp_each_step, the result is the same
+/// as a loop of add() from 0, add(add(max, max), lowest) = -1.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x    Array of values to sum
+/// @param n    Number of elements of x
+/// @param mode When the result is saturated
+///
+/// @return The sum saturated into the range of T, 0 if n is 0.
+template <typename T>
+T sum(const T* x, std::size_t n,
+      reduction_mode mode = reduction_mode::clamp_at_end) {
+  static_assert(std::is_integral<T>::value && (sizeof(T) <= sizeof(int32_t)),
+                "sum supports only integral types up to 32 bits");
+  return (mode == reduction_mode::clamp_each_step)
+      ? impl::sum_each_step(x, n, std::is_signed<T>())
+      : impl::sum_at_end(x, n);
+}
+
+/// Sum products of elements of 2 arrays with saturation.
+///
+/// With reduction_mode::clamp_at_end, the exact sum of exact products
+/// is saturated once.
+/// With reduction_mode::clamp_each_step, the result is the same
+/// as a loop of acc = mul_add(x[i], y[i], acc) from 0.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x    Array of values to multiply
+/// @param y    Array of values to multiply
+/// @param n    Number of elements of each array
+/// @param mode When the result is saturated
+///
+/// @return The sum of products saturated into the range of T,
+///         0 if n is 0.
+template <typename T>
+T dot(const T* x, const T* y, std::size_t n,
+      reduction_mode mode = reduction_mode::clamp_at_end) {
+  static_assert(std::is_integral<T>::value && (sizeof(T) <= sizeof(int32_t)),
+                "dot supports only integral types up to 32 bits");
+  return (mode == reduction_mode::clamp_each_step)
+      ? impl::dot_each_step(x, y, n, std::is_signed<T>())
+      : impl::dot_at_end(x, y, n);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_REDUCE_PRIV_H_
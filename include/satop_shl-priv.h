@@ -0,0 +1,149 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_SHL_PRIV_H_
+#define INCLUDE_SATOP_SHL_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <limits>
+#include <type_traits>
+
+#include "satop_sign_util-priv.h"
+#include "satop_telemetry-priv.h"
+
+namespace saturated {
+
+namespace impl {
+
+// Largest value of T which can be shifted left by shift bits
+// without overflow.  Only 0 can be shifted by its width or more.
+template <typename T>
+constexpr T shl_max(int shift) {
+  return ((shift >= std::numeric_limits<T>::digits)
+          ? T(0)
+          : static_cast<T>(std::numeric_limits<T>::max() >> shift));
+}
+
+// Lowest value of signed T which can be shifted left by shift bits
+// without underflow, -1 can be shifted into the sign bit.
+template <typename T>
+constexpr T shl_lowest(int shift) {
+  return ((shift > std::numeric_limits<T>::digits)
+          ? T(0)
+          : static_cast<T>(~shl_max<T>(shift)));
+}
+
+// Shift in unsigned type which is not promoted to int,
+// for values whose shifted results fit in T.
+template <typename T>
+constexpr T shift_left_bits(T x, int shift) {
+  using U = typename std::common_type<typename std::make_unsigned<T>::type,
+                                      unsigned int>::type;
+  return ((x == 0)
+          ? T(0)
+          : static_cast<T>(static_cast<U>(x) << shift));
+}
+
+template <typename T>
+constexpr T shl(T x, int shift, signed_integer_tag) {
+  return ((x > shl_max<T>(shift))
+          ? std::numeric_limits<T>::max()
+          : ((x < shl_lowest<T>(shift))
+             ? std::numeric_limits<T>::lowest()
+             : shift_left_bits(x, shift)));
+}
+
+template <typename T>
+constexpr T shl(T x, int shift, unsigned_integer_tag) {
+  return ((x > shl_max<T>(shift))
+          ? std::numeric_limits<T>::max()
+          : shift_left_bits(x, shift));
+}
+
+// Kind of saturation of shl(x, shift).
+template <typename T>
+constexpr saturation_kind shl_saturation(T x, int shift) {
+  return ((x > shl_max<T>(shift))
+          ? saturation_kind::overflow
+          : ((csignbit(x) && (x < shl_lowest<T>(shift)))
+             ? saturation_kind::underflow
+             : saturation_kind::none));
+}
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_shl(T result, T x, int shift) {
+  return observe(saturation_op::shl, result, shl_saturation(x, shift));
+}
+#endif  // SATOP_TELEMETRY
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Shift a value left with saturation.
+///
+/// Unlike operator<<, shifting by the width of T or more is defined,
+/// and it saturates any values except 0.
+///
+/// @tparam T Type of the argument and the return value, integral type
+///
+/// @param x     A value to shift
+/// @param shift Number of bits to shift x by, 0 or more
+///
+/// @return x * 2^shift saturated into the range of T.
+///
+/// @see saturation_snapshot() to count saturations
+template <typename T>
+constexpr T shl(T x, int shift) {
+  static_assert(std::is_integral<T>::value,
+                "shl supports only integral types");
+  return SATOP_OBSERVE(shl,
+                       impl::shl(x, shift, impl::arithmetic_category<T>()),
+                       x, shift);
+}
+
+/// Shift a value left by a constant number of bits with saturation.
+///
+/// The thresholds of saturation are constants,
+/// so it is compiled into 2 comparisons and a shift.
+///
+/// @tparam Shift Number of bits to shift x by, 0 or more
+/// @tparam T     Type of the argument and the return value, integral type
+///
+/// @param x A value to shift
+///
+/// @return x * 2^Shift saturated into the range of T.
+///
+/// @see saturation_snapshot() to count saturations
+template <int Shift, typename T>
+constexpr T shl(T x) {
+  static_assert(Shift >= 0, "Shift must not be negative");
+  return shl(x, Shift);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_SHL_PRIV_H_
@@ -23,6 +23,8 @@
 #error Do not include this file directly, libsatop.h instead.
 #endif
 
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 
 namespace saturated {
@@ -34,6 +36,38 @@ constexpr bool csignbit(T value) {
   return (std::is_signed<T>::value && (value < 0));
 }
 
+// Whether constant c of template arguments is in the range of T.
+template <typename T>
+constexpr bool is_in_range(std::intmax_t c) {
+  return ((c >= 0)
+          ? (static_cast<std::uintmax_t>(c)
+             <= static_cast<std::uintmax_t>(std::numeric_limits<T>::max()))
+          : (std::is_signed<T>::value
+             && (c >= static_cast<std::intmax_t>(
+                 std::numeric_limits<T>::lowest()))));
+}
+
+// Tags to choose implementation by category of arithmetic type.
+struct unsigned_integer_tag {};
+struct signed_integer_tag {};
+struct floating_point_tag {};
+
+template <typename T>
+using arithmetic_category = typename std::conditional<
+  std::is_integral<T>::value,
+  typename std::conditional<std::is_signed<T>::value,
+                            signed_integer_tag,
+                            unsigned_integer_tag>::type,
+  floating_point_tag>::type;
+
+// Saturated value in the direction of sign of x,
+// calculated from unsigned representation of signed integer x.
+template <typename T, typename U>
+constexpr U saturated_by_sign_bit(U x) {
+  return static_cast<U>((x >> std::numeric_limits<T>::digits)
+                        + static_cast<U>(std::numeric_limits<T>::max()));
+}
+
 }  // namespace impl
 
 }  // namespace saturated
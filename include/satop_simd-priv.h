@@ -0,0 +1,167 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_SIMD_PRIV_H_
+#define INCLUDE_SATOP_SIMD_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "satop_op-priv.h"
+
+// Instruction set implementations of batch operations are compiled
+// for x86 regardless of compiler options, with target attributes,
+// and one of them is chosen at runtime.
+// Define SATOP_NO_SIMD to use only portable implementations.
+#if !defined(SATOP_NO_SIMD) \
+    && (defined(__x86_64__) || defined(__i386__) \
+        || defined(_M_X64) || defined(_M_IX86))
+#define SATOP_SIMD_X86
+#endif
+
+#ifdef SATOP_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define SATOP_PRAGMA(x) _Pragma(#x)
+
+// Functions defined between SATOP_TARGET_REGION_BEGIN(isa)
+// and SATOP_TARGET_REGION_END() are compiled for instruction set isa.
+// Visual C++ needs nothing because it allows any intrinsics.
+#if defined(__clang__)
+#define SATOP_TARGET_REGION_BEGIN(isa) \
+  SATOP_PRAGMA(clang attribute push(__attribute__((target(isa))), \
+                                    apply_to = function))
+#define SATOP_TARGET_REGION_END() SATOP_PRAGMA(clang attribute pop)
+#elif defined(__GNUC__)
+#define SATOP_TARGET_REGION_BEGIN(isa) \
+  SATOP_PRAGMA(GCC push_options) SATOP_PRAGMA(GCC target(isa))
+#define SATOP_TARGET_REGION_END() SATOP_PRAGMA(GCC pop_options)
+#else
+#define SATOP_TARGET_REGION_BEGIN(isa)
+#define SATOP_TARGET_REGION_END()
+#endif
+
+// Generic loops are inlined into the entry function of each instruction
+// set, so they are compiled for that instruction set.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SATOP_ALWAYS_INLINE __forceinline
+#else
+#define SATOP_ALWAYS_INLINE inline __attribute__((always_inline))
+#endif
+
+// Cold functions in headers are never inlined,
+// and their inline only allows definitions in each translation unit.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SATOP_NOINLINE __declspec(noinline) inline
+#else
+#define SATOP_NOINLINE inline __attribute__((noinline))
+#endif
+
+// GCC warns that passing vectors to functions without target attributes
+// changes ABI, but such functions are always inlined as above.
+#if defined(__GNUC__) && !defined(__clang__)
+#define SATOP_GENERIC_SIMD_BEGIN() \
+  SATOP_PRAGMA(GCC diagnostic push) \
+  SATOP_PRAGMA(GCC diagnostic ignored "-Wpsabi")
+#define SATOP_GENERIC_SIMD_END() SATOP_PRAGMA(GCC diagnostic pop)
+#else
+#define SATOP_GENERIC_SIMD_BEGIN()
+#define SATOP_GENERIC_SIMD_END()
+#endif
+
+namespace saturated {
+
+namespace impl {
+
+// Tag to choose overloads of vector operations by element type
+// without implicit conversions between element types.
+template <typename T>
+struct type_tag {
+};
+
+// Instruction set implementation which processes element by element.
+struct scalar_isa {
+};
+
+// Tag to choose overloads of vector operations by width of elements,
+// for operations which do not depend on signedness.
+template <std::size_t Width>
+using lane_width = std::integral_constant<std::size_t, Width>;
+
+// Number of 1 bits, used to count lanes in masks.
+inline int popcount(uint64_t x) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Instruction set implementations usable in a context,
+// the widest one first.
+template <typename... Isas>
+struct isa_list {
+};
+
+// Whether instruction set implementation Isa has vector version
+// of binary operation Op for element type T.
+// Vector types are not used as template arguments
+// because their alignment attributes are ignored there.
+template <typename Isa, typename Op, typename T, typename Enable = void>
+struct has_vector_binary : public std::false_type {
+};
+
+template <typename Isa, typename Op, typename T>
+struct has_vector_binary<
+  Isa, Op, T,
+  decltype(static_cast<void>(Isa::apply(Op(),
+                                        Isa::load(nullptr),
+                                        Isa::load(nullptr),
+                                        type_tag<T>())))>
+    : public std::true_type {
+};
+
+// The first instruction set in Isas which has vector version
+// of Op for T, or scalar_isa if there is no such one.
+template <typename Op, typename T, typename Isas>
+struct select_isa {
+  using type = scalar_isa;
+};
+
+template <typename Op, typename T, typename First, typename... Rest>
+struct select_isa<Op, T, isa_list<First, Rest...>> {
+  using type = typename std::conditional<
+    has_vector_binary<First, Op, T>::value,
+    First,
+    typename select_isa<Op, T, isa_list<Rest...>>::type>::type;
+};
+
+}  // namespace impl
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_SIMD_PRIV_H_
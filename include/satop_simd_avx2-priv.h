@@ -0,0 +1,1002 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_SIMD_AVX2_PRIV_H_
+#define INCLUDE_SATOP_SIMD_AVX2_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include "satop_cast-priv.h"
+#include "satop_div-priv.h"
+#include "satop_simd-priv.h"
+
+#ifdef SATOP_SIMD_X86
+
+namespace saturated {
+
+namespace impl {
+
+SATOP_TARGET_REGION_BEGIN("avx2")
+
+// Batch operations by AVX2, 256 bits per vector.
+// Unpack and pack instructions of AVX2 work in each 128 bits lane,
+// so widening and narrowing by them keep order of elements.
+struct avx2 {
+  using vector_type = __m256i;
+
+  static vector_type load(const void* p) {
+    return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+  }
+
+  static void store(void* p, vector_type v) {
+    _mm256_storeu_si256(static_cast<__m256i*>(p), v);
+  }
+
+  static vector_type broadcast(int8_t v) {
+    return _mm256_set1_epi8(static_cast<char>(v));
+  }
+
+  static vector_type broadcast(uint8_t v) {
+    return _mm256_set1_epi8(static_cast<char>(v));
+  }
+
+  static vector_type broadcast(int16_t v) {
+    return _mm256_set1_epi16(v);
+  }
+
+  static vector_type broadcast(uint16_t v) {
+    return _mm256_set1_epi16(static_cast<int16_t>(v));
+  }
+
+  static vector_type broadcast(int32_t v) {
+    return _mm256_set1_epi32(v);
+  }
+
+  static vector_type broadcast(uint32_t v) {
+    return _mm256_set1_epi32(static_cast<int32_t>(v));
+  }
+
+  static vector_type all_ones() {
+    return _mm256_set1_epi32(-1);
+  }
+
+  // Saturated value in direction of sign of each 32 bits lane of x.
+  static vector_type saturated_by_sign_i32(vector_type x) {
+    return _mm256_xor_si256(_mm256_srai_epi32(x, 31),
+                            _mm256_set1_epi32(INT32_MAX));
+  }
+
+  // Lower and upper 32 bits of unsigned 64 bits products of each lanes.
+  static void mul_u32x8(vector_type x, vector_type y,
+                        vector_type* lo, vector_type* hi) {
+    const vector_type even = _mm256_mul_epu32(x, y);
+    const vector_type odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32),
+                                             _mm256_srli_epi64(y, 32));
+    const vector_type even_lo_hi =
+        _mm256_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));
+    const vector_type odd_lo_hi =
+        _mm256_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));
+    *lo = _mm256_unpacklo_epi32(even_lo_hi, odd_lo_hi);
+    *hi = _mm256_unpackhi_epi32(even_lo_hi, odd_lo_hi);
+  }
+
+  // Signed upper halves are calculated from unsigned ones.
+  static void mul_i32x8(vector_type x, vector_type y,
+                        vector_type* lo, vector_type* hi) {
+    mul_u32x8(x, y, lo, hi);
+    *hi = _mm256_sub_epi32(*hi,
+                           _mm256_and_si256(_mm256_srai_epi32(x, 31), y));
+    *hi = _mm256_sub_epi32(*hi,
+                           _mm256_and_si256(_mm256_srai_epi32(y, 31), x));
+  }
+
+  // Products of lower and upper halves of 8 bits lanes
+  // in 16 bits lanes, where they never overflow.
+  static void mul_i8x32(vector_type x, vector_type y,
+                        vector_type* lo, vector_type* hi) {
+    *lo = _mm256_mullo_epi16(
+        _mm256_srai_epi16(_mm256_unpacklo_epi8(x, x), 8),
+        _mm256_srai_epi16(_mm256_unpacklo_epi8(y, y), 8));
+    *hi = _mm256_mullo_epi16(
+        _mm256_srai_epi16(_mm256_unpackhi_epi8(x, x), 8),
+        _mm256_srai_epi16(_mm256_unpackhi_epi8(y, y), 8));
+  }
+
+  static void mul_u8x32(vector_type x, vector_type y,
+                        vector_type* lo, vector_type* hi) {
+    const vector_type kZero = _mm256_setzero_si256();
+    *lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(x, kZero),
+                             _mm256_unpacklo_epi8(y, kZero));
+    *hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(x, kZero),
+                             _mm256_unpackhi_epi8(y, kZero));
+  }
+
+  // Products plus z, which never overflow 16 bits lanes either.
+  static void mul_add_i8x32(vector_type x, vector_type y, vector_type z,
+                            vector_type* lo, vector_type* hi) {
+    mul_i8x32(x, y, lo, hi);
+    *lo = _mm256_add_epi16(*lo,
+                           _mm256_srai_epi16(_mm256_unpacklo_epi8(z, z), 8));
+    *hi = _mm256_add_epi16(*hi,
+                           _mm256_srai_epi16(_mm256_unpackhi_epi8(z, z), 8));
+  }
+
+  static void mul_add_u8x32(vector_type x, vector_type y, vector_type z,
+                            vector_type* lo, vector_type* hi) {
+    const vector_type kZero = _mm256_setzero_si256();
+    mul_u8x32(x, y, lo, hi);
+    *lo = _mm256_add_epi16(*lo, _mm256_unpacklo_epi8(z, kZero));
+    *hi = _mm256_add_epi16(*hi, _mm256_unpackhi_epi8(z, kZero));
+  }
+
+  // x and z are interleaved and so are y and 1,
+  // then pmaddwd calculates x * y + z * 1 in 32 bits lanes.
+  static void mul_add_i16x16(vector_type x, vector_type y, vector_type z,
+                             vector_type* lo, vector_type* hi) {
+    const vector_type kOne = _mm256_set1_epi16(1);
+    *lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(x, z),
+                            _mm256_unpacklo_epi16(y, kOne));
+    *hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(x, z),
+                            _mm256_unpackhi_epi16(y, kOne));
+  }
+
+  // 16 bits lanes which are sign or zero extension of 8 bits,
+  // and 32 bits lanes which are sign extension of 16 bits.
+  static vector_type fits_i8(vector_type v) {
+    return _mm256_cmpeq_epi16(v,
+                              _mm256_srai_epi16(_mm256_slli_epi16(v, 8), 8));
+  }
+
+  static vector_type fits_u8(vector_type v) {
+    return _mm256_cmpeq_epi16(_mm256_srli_epi16(v, 8),
+                              _mm256_setzero_si256());
+  }
+
+  static vector_type fits_i16(vector_type v) {
+    return _mm256_cmpeq_epi32(
+        v, _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16));
+  }
+
+  // Mask of lanes which are not all 1 in fits, as equal_mask().
+  static uint64_t unfit_mask(vector_type fits) {
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(fits));
+  }
+
+  static vector_type mask_of(bool value) {
+    return _mm256_set1_epi32(value ? -1 : 0);
+  }
+
+  // Unsigned quotients of 16 bits lanes by magic number,
+  // see divider for the algorithm.
+  static vector_type divide_u16(vector_type n, vector_type magic,
+                                int shift1, int shift2) {
+    const vector_type t = _mm256_mulhi_epu16(n, magic);
+    return _mm256_srl_epi16(
+        _mm256_add_epi16(t, _mm256_srl_epi16(_mm256_sub_epi16(n, t),
+                                             _mm_cvtsi32_si128(shift1))),
+        _mm_cvtsi32_si128(shift2));
+  }
+
+  // Upper halves of even lanes are shifted down,
+  // and ones of odd lanes are already in place.
+  static vector_type divide_u32(vector_type n, vector_type magic,
+                                int shift1, int shift2) {
+    const vector_type even = _mm256_mul_epu32(n, magic);
+    const vector_type odd = _mm256_mul_epu32(_mm256_srli_epi64(n, 32),
+                                             _mm256_srli_epi64(magic, 32));
+    const vector_type t =
+        _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    return _mm256_srl_epi32(
+        _mm256_add_epi32(t, _mm256_srl_epi32(_mm256_sub_epi32(n, t),
+                                             _mm_cvtsi32_si128(shift1))),
+        _mm_cvtsi32_si128(shift2));
+  }
+
+  // 8 bits lanes are divided in 16 bits lanes,
+  // where upper half of n * (magic << 8) is (n * magic) >> 8.
+  static vector_type divide_u8(vector_type n, uint8_t magic,
+                               int shift1, int shift2) {
+    const vector_type kZero = _mm256_setzero_si256();
+    const vector_type magic16 =
+        _mm256_set1_epi16(static_cast<int16_t>(magic << 8));
+    return _mm256_packus_epi16(
+        divide_u16(_mm256_unpacklo_epi8(n, kZero), magic16, shift1, shift2),
+        divide_u16(_mm256_unpackhi_epi8(n, kZero), magic16, shift1, shift2));
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    return _mm256_adds_epi8(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    return _mm256_adds_epu8(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    return _mm256_adds_epi16(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<uint16_t>) {
+    return _mm256_adds_epu16(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<int32_t>) {
+    const vector_type sum = _mm256_add_epi32(x, y);
+    const vector_type overflow =
+        _mm256_and_si256(_mm256_xor_si256(x, sum), _mm256_xor_si256(y, sum));
+    return _mm256_castps_si256(
+        _mm256_blendv_ps(_mm256_castsi256_ps(sum),
+                         _mm256_castsi256_ps(saturated_by_sign_i32(x)),
+                         _mm256_castsi256_ps(overflow)));
+  }
+
+  // y is clamped to room of x, so the sum never wraps.
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<uint32_t>) {
+    return _mm256_add_epi32(
+        x, _mm256_min_epu32(y, _mm256_xor_si256(x, all_ones())));
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    return _mm256_subs_epi8(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    return _mm256_subs_epu8(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    return _mm256_subs_epi16(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<uint16_t>) {
+    return _mm256_subs_epu16(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<int32_t>) {
+    const vector_type difference = _mm256_sub_epi32(x, y);
+    const vector_type overflow =
+        _mm256_and_si256(_mm256_xor_si256(x, y),
+                         _mm256_xor_si256(x, difference));
+    return _mm256_castps_si256(
+        _mm256_blendv_ps(_mm256_castsi256_ps(difference),
+                         _mm256_castsi256_ps(saturated_by_sign_i32(x)),
+                         _mm256_castsi256_ps(overflow)));
+  }
+
+  // max(x, y) - y is x - y if x >= y, otherwise 0.
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<uint32_t>) {
+    return _mm256_sub_epi32(_mm256_max_epu32(x, y), y);
+  }
+
+  // Absolute value of lowest is wrapped into lowest,
+  // which is clamped into max as unsigned value.
+  static vector_type apply(abs_op, vector_type x, type_tag<int8_t>) {
+    return _mm256_min_epu8(_mm256_abs_epi8(x), _mm256_set1_epi8(INT8_MAX));
+  }
+
+  static vector_type apply(abs_op, vector_type x, type_tag<int16_t>) {
+    return _mm256_min_epu16(_mm256_abs_epi16(x), _mm256_set1_epi16(INT16_MAX));
+  }
+
+  static vector_type apply(abs_op, vector_type x, type_tag<int32_t>) {
+    return _mm256_min_epu32(_mm256_abs_epi32(x), _mm256_set1_epi32(INT32_MAX));
+  }
+
+  // Multiply in 16 bits lanes and pack them with saturation.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_i8x32(x, y, &lo, &hi);
+    return _mm256_packs_epi16(lo, hi);
+  }
+
+  // Multiply in 16 bits lanes, clamp them to 255 and pack them.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    const vector_type kMax = _mm256_set1_epi16(UINT8_MAX);
+    vector_type lo;
+    vector_type hi;
+    mul_u8x32(x, y, &lo, &hi);
+    return _mm256_packus_epi16(_mm256_min_epu16(lo, kMax),
+                               _mm256_min_epu16(hi, kMax));
+  }
+
+  // Build 32 bits products from low and high halves,
+  // and pack them with saturation.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type lo = _mm256_mullo_epi16(x, y);
+    const vector_type hi = _mm256_mulhi_epi16(x, y);
+    return _mm256_packs_epi32(_mm256_unpacklo_epi16(lo, hi),
+                              _mm256_unpackhi_epi16(lo, hi));
+  }
+
+  // Products overflow if their upper halves are not 0.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<uint16_t>) {
+    const vector_type lo = _mm256_mullo_epi16(x, y);
+    const vector_type hi = _mm256_mulhi_epu16(x, y);
+    return _mm256_or_si256(
+        lo,
+        _mm256_andnot_si256(_mm256_cmpeq_epi16(hi, _mm256_setzero_si256()),
+                            all_ones()));
+  }
+
+  // Products overflow if upper halves are not sign extension
+  // of lower halves.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<int32_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_i32x8(x, y, &lo, &hi);
+    const vector_type not_overflow =
+        _mm256_cmpeq_epi32(hi, _mm256_srai_epi32(lo, 31));
+    return _mm256_blendv_epi8(saturated_by_sign_i32(_mm256_xor_si256(x, y)),
+                              lo,
+                              not_overflow);
+  }
+
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<uint32_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_u32x8(x, y, &lo, &hi);
+    return _mm256_or_si256(
+        lo,
+        _mm256_andnot_si256(_mm256_cmpeq_epi32(hi, _mm256_setzero_si256()),
+                            all_ones()));
+  }
+
+  // Products of 8 bits lanes plus z fit in 16 bits lanes,
+  // so they are packed with saturation at once.
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i8x32(x, y, z, &lo, &hi);
+    return _mm256_packs_epi16(lo, hi);
+  }
+
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<uint8_t>) {
+    const vector_type kMax = _mm256_set1_epi16(UINT8_MAX);
+    vector_type lo;
+    vector_type hi;
+    mul_add_u8x32(x, y, z, &lo, &hi);
+    return _mm256_packus_epi16(_mm256_min_epu16(lo, kMax),
+                               _mm256_min_epu16(hi, kMax));
+  }
+
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<int16_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i16x16(x, y, z, &lo, &hi);
+    return _mm256_packs_epi32(lo, hi);
+  }
+
+  // Sum overflows if upper halves of products are not 0,
+  // or if adding z to lower halves carries.
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<uint16_t>) {
+    const vector_type hi = _mm256_mulhi_epu16(x, y);
+    return _mm256_or_si256(
+        _mm256_adds_epu16(_mm256_mullo_epi16(x, y), z),
+        _mm256_andnot_si256(_mm256_cmpeq_epi16(hi, _mm256_setzero_si256()),
+                            all_ones()));
+  }
+
+  // Lanes which apply() saturates, as masks of equal_mask().
+  // Products are calculated in the same way as apply(),
+  // so that compilers share them with results.
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_i8x32(x, y, &lo, &hi);
+    return unfit_mask(_mm256_packs_epi16(fits_i8(lo), fits_i8(hi)));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<uint8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_u8x32(x, y, &lo, &hi);
+    return unfit_mask(_mm256_packs_epi16(fits_u8(lo), fits_u8(hi)));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<int16_t>) {
+    return unfit_mask(_mm256_cmpeq_epi16(
+        _mm256_mulhi_epi16(x, y),
+        _mm256_srai_epi16(_mm256_mullo_epi16(x, y), 15)));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<uint16_t>) {
+    return unfit_mask(_mm256_cmpeq_epi16(_mm256_mulhi_epu16(x, y),
+                                         _mm256_setzero_si256()));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<int32_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_i32x8(x, y, &lo, &hi);
+    return unfit_mask(_mm256_cmpeq_epi32(hi, _mm256_srai_epi32(lo, 31)));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<uint32_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_u32x8(x, y, &lo, &hi);
+    return unfit_mask(_mm256_cmpeq_epi32(hi, _mm256_setzero_si256()));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i8x32(x, y, z, &lo, &hi);
+    return unfit_mask(_mm256_packs_epi16(fits_i8(lo), fits_i8(hi)));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<uint8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_u8x32(x, y, z, &lo, &hi);
+    return unfit_mask(_mm256_packs_epi16(fits_u8(lo), fits_u8(hi)));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<int16_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i16x16(x, y, z, &lo, &hi);
+    return unfit_mask(_mm256_packs_epi32(fits_i16(lo), fits_i16(hi)));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<uint16_t>) {
+    const vector_type lo = _mm256_mullo_epi16(x, y);
+    return unfit_mask(_mm256_and_si256(
+        _mm256_cmpeq_epi16(_mm256_mulhi_epu16(x, y), _mm256_setzero_si256()),
+        _mm256_cmpeq_epi16(_mm256_adds_epu16(lo, z),
+                           _mm256_add_epi16(lo, z))));
+  }
+
+  // x and 1 are interleaved and so are y and the rounding constant,
+  // then pmaddwd calculates x * y + rounding in 32 bits lanes.
+  template <int FracBits>
+  static vector_type apply(fixed_mul_op<FracBits>,
+                           vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type kOne = _mm256_set1_epi16(1);
+    const vector_type kRounding =
+        _mm256_set1_epi16(static_cast<int16_t>((1 << FracBits) >> 1));
+    const vector_type lo = _mm256_madd_epi16(
+        _mm256_unpacklo_epi16(x, kOne), _mm256_unpacklo_epi16(y, kRounding));
+    const vector_type hi = _mm256_madd_epi16(
+        _mm256_unpackhi_epi16(x, kOne), _mm256_unpackhi_epi16(y, kRounding));
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, FracBits),
+                              _mm256_srai_epi32(hi, FracBits));
+  }
+
+  // pmulhrsw wraps only -1 * -1 into lowest,
+  // which is never a rounded product.
+  static vector_type apply(fixed_mul_op<15>, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type product = _mm256_mulhrs_epi16(x, y);
+    return _mm256_xor_si256(
+        product,
+        _mm256_cmpeq_epi16(product, _mm256_set1_epi16(INT16_MIN)));
+  }
+
+  static vector_type zero() {
+    return _mm256_setzero_si256();
+  }
+
+  static vector_type add_i64(vector_type x, vector_type y) {
+    return _mm256_add_epi64(x, y);
+  }
+
+  static int64_t reduce_add_i64(vector_type v) {
+    int64_t lanes[sizeof(vector_type) / sizeof(int64_t)];
+    store(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  }
+
+  // Sums of pairs of 32 bits lanes in 64 bits lanes,
+  // where sign is all 1 in lanes to be extended as negative.
+  static vector_type widen_add_32(vector_type v, vector_type sign) {
+    return _mm256_add_epi64(_mm256_unpacklo_epi32(v, sign),
+                            _mm256_unpackhi_epi32(v, sign));
+  }
+
+  // Partial sums of lanes of x in 64 bits lanes.
+  static vector_type apply(sum_op, vector_type x, type_tag<int8_t>) {
+    const vector_type kBias = _mm256_set1_epi8(INT8_MIN);
+    return _mm256_sub_epi64(_mm256_sad_epu8(_mm256_xor_si256(x, kBias),
+                                            _mm256_setzero_si256()),
+                            _mm256_set1_epi64x(8 * 128));
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<uint8_t>) {
+    return _mm256_sad_epu8(x, _mm256_setzero_si256());
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<int16_t>) {
+    const vector_type pairs = _mm256_madd_epi16(x, _mm256_set1_epi16(1));
+    return widen_add_32(pairs, _mm256_srai_epi32(pairs, 31));
+  }
+
+  // Biased into signed values, summed, and unbiased.
+  static vector_type apply(sum_op, vector_type x, type_tag<uint16_t>) {
+    const vector_type pairs =
+        _mm256_madd_epi16(_mm256_xor_si256(x, _mm256_set1_epi16(INT16_MIN)),
+                          _mm256_set1_epi16(1));
+    return _mm256_add_epi64(widen_add_32(pairs, _mm256_srai_epi32(pairs, 31)),
+                            _mm256_set1_epi64x(4 * 32768));
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<int32_t>) {
+    return widen_add_32(x, _mm256_srai_epi32(x, 31));
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<uint32_t>) {
+    return widen_add_32(x, _mm256_setzero_si256());
+  }
+
+  // Partial sums of products of lanes of x and y in 64 bits lanes.
+  static vector_type apply(dot_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    const vector_type pairs = _mm256_add_epi32(
+        _mm256_madd_epi16(_mm256_srai_epi16(_mm256_unpacklo_epi8(x, x), 8),
+                          _mm256_srai_epi16(_mm256_unpacklo_epi8(y, y), 8)),
+        _mm256_madd_epi16(_mm256_srai_epi16(_mm256_unpackhi_epi8(x, x), 8),
+                          _mm256_srai_epi16(_mm256_unpackhi_epi8(y, y), 8)));
+    return widen_add_32(pairs, _mm256_srai_epi32(pairs, 31));
+  }
+
+  static vector_type apply(dot_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    const vector_type kZero = _mm256_setzero_si256();
+    const vector_type pairs = _mm256_add_epi32(
+        _mm256_madd_epi16(_mm256_unpacklo_epi8(x, kZero),
+                          _mm256_unpacklo_epi8(y, kZero)),
+        _mm256_madd_epi16(_mm256_unpackhi_epi8(x, kZero),
+                          _mm256_unpackhi_epi8(y, kZero)));
+    return widen_add_32(pairs, kZero);
+  }
+
+  // pmaddwd wraps only (-32768 * -32768) * 2 into INT32_MIN,
+  // which is extended as positive.
+  static vector_type apply(dot_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type pairs = _mm256_madd_epi16(x, y);
+    const vector_type wrapped =
+        _mm256_cmpeq_epi32(pairs, _mm256_set1_epi32(INT32_MIN));
+    return widen_add_32(
+        pairs, _mm256_andnot_si256(wrapped, _mm256_srai_epi32(pairs, 31)));
+  }
+
+  // acc + x0 * y0 + x1 * y1 of pairs of 16 bits lanes
+  // saturated in 32 bits lanes, as vpdpwssds of AVX512-VNNI.
+  // pmaddwd wraps only (-32768 * -32768) * 2 into INT32_MIN,
+  // so INT32_MAX and 1 are added instead of it.
+  static vector_type apply(dot_pairs_op, vector_type acc, vector_type x,
+                           vector_type y, type_tag<int16_t>) {
+    const vector_type pairs = _mm256_madd_epi16(x, y);
+    const vector_type wrapped =
+        _mm256_cmpeq_epi32(pairs, _mm256_set1_epi32(INT32_MIN));
+    const vector_type sum = apply(add_op(), acc,
+                                  _mm256_xor_si256(pairs, wrapped),
+                                  type_tag<int32_t>());
+    const vector_type is_max =
+        _mm256_cmpeq_epi32(sum, _mm256_set1_epi32(INT32_MAX));
+    return _mm256_sub_epi32(sum, _mm256_andnot_si256(is_max, wrapped));
+  }
+
+  // Sign extended lower and upper halves of 16 bits lanes
+  // in 32 bits lanes, which narrow() packs back.
+  static vector_type widen_lo_i16(vector_type x) {
+    return _mm256_cvtepi16_epi32(_mm256_castsi256_si128(x));
+  }
+
+  static vector_type widen_hi_i16(vector_type x) {
+    return _mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1));
+  }
+
+  // Narrow 2 vectors into 1 vector of half width lanes with saturation,
+  // lanes of lo first.  Packing instructions interleave 128 bits lanes,
+  // so they are permuted back.
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int32_t>, type_tag<int16_t>) {
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi),
+                                    _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int32_t>, type_tag<uint16_t>) {
+    return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi),
+                                    _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint32_t>, type_tag<uint16_t>) {
+    const vector_type kMax = _mm256_set1_epi32(UINT16_MAX);
+    return _mm256_permute4x64_epi64(
+        _mm256_packus_epi32(_mm256_min_epu32(lo, kMax),
+                            _mm256_min_epu32(hi, kMax)),
+        _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint32_t>, type_tag<int16_t>) {
+    const vector_type kMax = _mm256_set1_epi32(INT16_MAX);
+    return _mm256_permute4x64_epi64(
+        _mm256_packs_epi32(_mm256_min_epu32(lo, kMax),
+                           _mm256_min_epu32(hi, kMax)),
+        _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int16_t>, type_tag<int8_t>) {
+    return _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi),
+                                    _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int16_t>, type_tag<uint8_t>) {
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi),
+                                    _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint16_t>, type_tag<uint8_t>) {
+    const vector_type kMax = _mm256_set1_epi16(UINT8_MAX);
+    return _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(_mm256_min_epu16(lo, kMax),
+                            _mm256_min_epu16(hi, kMax)),
+        _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint16_t>, type_tag<int8_t>) {
+    const vector_type kMax = _mm256_set1_epi16(INT8_MAX);
+    return _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(_mm256_min_epu16(lo, kMax),
+                            _mm256_min_epu16(hi, kMax)),
+        _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  // Convert lanes between signed and unsigned types of the same width.
+  static vector_type apply(cast_op<int8_t>, vector_type x, type_tag<uint8_t>) {
+    return _mm256_max_epi8(x, _mm256_setzero_si256());
+  }
+
+  static vector_type apply(cast_op<uint8_t>, vector_type x, type_tag<int8_t>) {
+    return _mm256_min_epu8(x, _mm256_set1_epi8(INT8_MAX));
+  }
+
+  static vector_type apply(cast_op<int16_t>, vector_type x,
+                           type_tag<uint16_t>) {
+    return _mm256_max_epi16(x, _mm256_setzero_si256());
+  }
+
+  static vector_type apply(cast_op<uint16_t>, vector_type x,
+                           type_tag<int16_t>) {
+    return _mm256_min_epu16(x, _mm256_set1_epi16(INT16_MAX));
+  }
+
+  static vector_type apply(cast_op<int32_t>, vector_type x,
+                           type_tag<uint32_t>) {
+    return _mm256_max_epi32(x, _mm256_setzero_si256());
+  }
+
+  static vector_type apply(cast_op<uint32_t>, vector_type x,
+                           type_tag<int32_t>) {
+    return _mm256_min_epu32(x, _mm256_set1_epi32(INT32_MAX));
+  }
+
+  // Convert lanes of floating point values multiplied by scale
+  // into int32_t with saturation as saturate_cast(), where NaN is 0,
+  // after rounding them by Mode.
+  template <rounding Mode>
+  static vector_type to_int32(const float* x, float scale,
+                              rounding_tag<Mode> mode) {
+    return truncate_i32(round(
+        _mm256_mul_ps(_mm256_loadu_ps(x), _mm256_set1_ps(scale)), mode));
+  }
+
+  template <rounding Mode>
+  static vector_type to_int32(const double* x, double scale,
+                              rounding_tag<Mode> mode) {
+    const __m256d vscale = _mm256_set1_pd(scale);
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(truncate_i32(round(
+            _mm256_mul_pd(_mm256_loadu_pd(x), vscale), mode))),
+        truncate_i32(round(_mm256_mul_pd(_mm256_loadu_pd(x + 4), vscale),
+                           mode)),
+        1);
+  }
+
+  template <typename V>
+  static V round(V v, rounding_tag<rounding::toward_zero>) {
+    return v;
+  }
+
+  static __m256 round(__m256 v, rounding_tag<rounding::to_nearest>) {
+    return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+
+  static __m256 round(__m256 v, rounding_tag<rounding::downward>) {
+    return _mm256_round_ps(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+
+  static __m256 round(__m256 v, rounding_tag<rounding::upward>) {
+    return _mm256_round_ps(v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  }
+
+  static __m256d round(__m256d v, rounding_tag<rounding::to_nearest>) {
+    return _mm256_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+
+  static __m256d round(__m256d v, rounding_tag<rounding::downward>) {
+    return _mm256_round_pd(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+
+  static __m256d round(__m256d v, rounding_tag<rounding::upward>) {
+    return _mm256_round_pd(v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  }
+
+  // Conversion returns 0x80000000 for values out of range,
+  // so it is flipped into max for too large values.
+  static vector_type truncate_i32(__m256 v) {
+    const __m256 too_large =
+        _mm256_cmp_ps(v, _mm256_set1_ps(2147483648.0f), _CMP_GE_OQ);
+    return _mm256_and_si256(
+        _mm256_xor_si256(_mm256_cvttps_epi32(v),
+                         _mm256_castps_si256(too_large)),
+        _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_ORD_Q)));
+  }
+
+  // Limits of int32_t are exact in double, so values are clamped
+  // before conversion.
+  static __m128i truncate_i32(__m256d v) {
+    const __m256d ordered = _mm256_and_pd(v, _mm256_cmp_pd(v, v, _CMP_ORD_Q));
+    return _mm256_cvttpd_epi32(
+        _mm256_max_pd(_mm256_min_pd(ordered, _mm256_set1_pd(INT32_MAX)),
+                      _mm256_set1_pd(INT32_MIN)));
+  }
+
+  // Rounded quotients of 16 bits lanes up to 255 * 255 divided by 255,
+  // which are (t + (t >> 8)) >> 8 where t = v + 128.
+  static vector_type div255_u16(vector_type v) {
+    const vector_type t = _mm256_add_epi16(v, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+  }
+
+  // Alpha, the last channel of each RGBA pixel, copied into its channels.
+  static vector_type broadcast_alpha(vector_type x) {
+    const vector_type a = _mm256_srli_epi32(x, 24);
+    const vector_type aa = _mm256_or_si256(a, _mm256_slli_epi32(a, 8));
+    return _mm256_or_si256(aa, _mm256_slli_epi32(aa, 16));
+  }
+
+  // x and 1 are interleaved and so are gain and the rounding constant,
+  // then pmaddwd calculates x * gain + 128 in 32 bits lanes.
+  static vector_type scale_u16(vector_type x, vector_type gain) {
+    const vector_type kOne = _mm256_set1_epi16(1);
+    const vector_type lo =
+        _mm256_madd_epi16(_mm256_unpacklo_epi16(x, kOne), gain);
+    const vector_type hi =
+        _mm256_madd_epi16(_mm256_unpackhi_epi16(x, kOne), gain);
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, 8),
+                              _mm256_srai_epi32(hi, 8));
+  }
+
+  static vector_type apply(scale_op, vector_type x,
+                           int16_t gain, int16_t offset, type_tag<uint8_t>) {
+    const vector_type kZero = _mm256_setzero_si256();
+    const vector_type kGain = _mm256_set1_epi32(
+        static_cast<int32_t>((128U << 16) | static_cast<uint16_t>(gain)));
+    const vector_type kOffset = _mm256_set1_epi16(offset);
+    const vector_type lo = scale_u16(_mm256_unpacklo_epi8(x, kZero), kGain);
+    const vector_type hi = scale_u16(_mm256_unpackhi_epi8(x, kZero), kGain);
+    return _mm256_packus_epi16(_mm256_adds_epi16(lo, kOffset),
+                               _mm256_adds_epi16(hi, kOffset));
+  }
+
+  // Sums of products fit in 16 bits lanes, up to 255 * 255.
+  static vector_type apply(blend_op, vector_type x, vector_type y,
+                           uint8_t alpha, type_tag<uint8_t>) {
+    const vector_type kZero = _mm256_setzero_si256();
+    const vector_type kAlpha = _mm256_set1_epi16(alpha);
+    const vector_type kInverse = _mm256_set1_epi16(
+        static_cast<int16_t>(UINT8_MAX - alpha));
+    const vector_type lo = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(x, kZero), kAlpha),
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(y, kZero), kInverse));
+    const vector_type hi = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(x, kZero), kAlpha),
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(y, kZero), kInverse));
+    return _mm256_packus_epi16(div255_u16(lo), div255_u16(hi));
+  }
+
+  // 255 - alpha is bitwise not of alpha.
+  static vector_type apply(composite_op, vector_type src, vector_type alpha,
+                           vector_type dst, type_tag<uint8_t>) {
+    const vector_type kZero = _mm256_setzero_si256();
+    const vector_type inverse = _mm256_xor_si256(alpha, all_ones());
+    const vector_type lo =
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, kZero),
+                           _mm256_unpacklo_epi8(inverse, kZero));
+    const vector_type hi =
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, kZero),
+                           _mm256_unpackhi_epi8(inverse, kZero));
+    return _mm256_adds_epu8(
+        src, _mm256_packus_epi16(div255_u16(lo), div255_u16(hi)));
+  }
+
+  // Divisor of following divisions must not be 0.
+  static vector_type apply(div_op, vector_type x, const divider<uint8_t>& d) {
+    return divide_u8(x, d.magic(), d.shift1(), d.shift2());
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<uint16_t>& d) {
+    return divide_u16(x, broadcast(d.magic()), d.shift1(), d.shift2());
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<uint32_t>& d) {
+    return divide_u32(x, broadcast(d.magic()), d.shift1(), d.shift2());
+  }
+
+  // Unsigned quotients are clamped to max, or max + 1 if they are negated,
+  // and negated where sign is all 1.
+  static vector_type apply(div_op, vector_type x, const divider<int8_t>& d) {
+    const vector_type sign =
+        _mm256_xor_si256(_mm256_cmpgt_epi8(_mm256_setzero_si256(), x),
+                         mask_of(d.is_negative()));
+    const vector_type q = _mm256_min_epu8(
+        divide_u8(_mm256_abs_epi8(x), d.magic(), d.shift1(), d.shift2()),
+        _mm256_sub_epi8(_mm256_set1_epi8(INT8_MAX), sign));
+    return _mm256_sub_epi8(_mm256_xor_si256(q, sign), sign);
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<int16_t>& d) {
+    const vector_type sign = _mm256_xor_si256(_mm256_srai_epi16(x, 15),
+                                              mask_of(d.is_negative()));
+    const vector_type q = _mm256_min_epu16(
+        divide_u16(_mm256_abs_epi16(x), broadcast(d.magic()),
+                   d.shift1(), d.shift2()),
+        _mm256_sub_epi16(_mm256_set1_epi16(INT16_MAX), sign));
+    return _mm256_sub_epi16(_mm256_xor_si256(q, sign), sign);
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<int32_t>& d) {
+    const vector_type sign = _mm256_xor_si256(_mm256_srai_epi32(x, 31),
+                                              mask_of(d.is_negative()));
+    const vector_type q = _mm256_min_epu32(
+        divide_u32(_mm256_abs_epi32(x), broadcast(d.magic()),
+                   d.shift1(), d.shift2()),
+        _mm256_sub_epi32(_mm256_set1_epi32(INT32_MAX), sign));
+    return _mm256_sub_epi32(_mm256_xor_si256(q, sign), sign);
+  }
+
+  // Results wrapped around, as ones of wrap_op.
+
+  static vector_type wrapping(add_op, vector_type x, vector_type y,
+                              lane_width<1>) {
+    return _mm256_add_epi8(x, y);
+  }
+
+  static vector_type wrapping(add_op, vector_type x, vector_type y,
+                              lane_width<2>) {
+    return _mm256_add_epi16(x, y);
+  }
+
+  static vector_type wrapping(add_op, vector_type x, vector_type y,
+                              lane_width<4>) {
+    return _mm256_add_epi32(x, y);
+  }
+
+  static vector_type wrapping(sub_op, vector_type x, vector_type y,
+                              lane_width<1>) {
+    return _mm256_sub_epi8(x, y);
+  }
+
+  static vector_type wrapping(sub_op, vector_type x, vector_type y,
+                              lane_width<2>) {
+    return _mm256_sub_epi16(x, y);
+  }
+
+  static vector_type wrapping(sub_op, vector_type x, vector_type y,
+                              lane_width<4>) {
+    return _mm256_sub_epi32(x, y);
+  }
+
+  static vector_type wrapping(mul_op, vector_type x, vector_type y,
+                              lane_width<2>) {
+    return _mm256_mullo_epi16(x, y);
+  }
+
+  static vector_type wrapping(mul_op, vector_type x, vector_type y,
+                              lane_width<4>) {
+    return _mm256_mullo_epi32(x, y);
+  }
+
+  template <typename Op, typename T>
+  static auto apply(wrap_op<Op>, vector_type x, vector_type y, type_tag<T>)
+      -> decltype(wrapping(Op(), x, y, lane_width<sizeof(T)>())) {
+    return wrapping(Op(), x, y, lane_width<sizeof(T)>());
+  }
+
+  // Lanes where x equals y, whose mask has bits_per_lane() bits per lane.
+
+  static uint64_t equal_mask(vector_type x, vector_type y, lane_width<1>) {
+    return static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+  }
+
+  static uint64_t equal_mask(vector_type x, vector_type y, lane_width<2>) {
+    return static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi16(x, y)));
+  }
+
+  static uint64_t equal_mask(vector_type x, vector_type y, lane_width<4>) {
+    return static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi32(x, y)));
+  }
+
+  template <std::size_t Width>
+  static constexpr int bits_per_lane(lane_width<Width>) {
+    return static_cast<int>(Width);
+  }
+};
+
+SATOP_TARGET_REGION_END()
+
+}  // namespace impl
+
+}  // namespace saturated
+
+#endif  // SATOP_SIMD_X86
+
+#endif  // INCLUDE_SATOP_SIMD_AVX2_PRIV_H_
@@ -0,0 +1,1082 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_SIMD_AVX512BW_PRIV_H_
+#define INCLUDE_SATOP_SIMD_AVX512BW_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include "satop_cast-priv.h"
+#include "satop_div-priv.h"
+#include "satop_simd-priv.h"
+
+#ifdef SATOP_SIMD_X86
+
+namespace saturated {
+
+namespace impl {
+
+SATOP_TARGET_REGION_BEGIN("avx512f,avx512bw")
+
+// Intrinsics of GCC use self initialized variables as undefined values,
+// and they are warned as uninitialized when they are inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+SATOP_PRAGMA(GCC diagnostic push)
+SATOP_PRAGMA(GCC diagnostic ignored "-Wmaybe-uninitialized")
+#endif
+
+// Batch operations by AVX-512BW, 512 bits per vector.
+// Unpack and pack instructions work in each 128 bits lane as AVX2,
+// and comparisons produce mask registers for blending.
+struct avx512bw {
+  using vector_type = __m512i;
+
+  static vector_type load(const void* p) {
+    return _mm512_loadu_si512(p);
+  }
+
+  static void store(void* p, vector_type v) {
+    _mm512_storeu_si512(p, v);
+  }
+
+  static vector_type broadcast(int8_t v) {
+    return _mm512_set1_epi8(static_cast<char>(v));
+  }
+
+  static vector_type broadcast(uint8_t v) {
+    return _mm512_set1_epi8(static_cast<char>(v));
+  }
+
+  static vector_type broadcast(int16_t v) {
+    return _mm512_set1_epi16(v);
+  }
+
+  static vector_type broadcast(uint16_t v) {
+    return _mm512_set1_epi16(static_cast<int16_t>(v));
+  }
+
+  static vector_type broadcast(int32_t v) {
+    return _mm512_set1_epi32(v);
+  }
+
+  static vector_type broadcast(uint32_t v) {
+    return _mm512_set1_epi32(static_cast<int32_t>(v));
+  }
+
+  static vector_type all_ones() {
+    return _mm512_set1_epi32(-1);
+  }
+
+  // Saturated value in direction of sign of each 32 bits lane of x.
+  static vector_type saturated_by_sign_i32(vector_type x) {
+    return _mm512_xor_si512(_mm512_srai_epi32(x, 31),
+                            _mm512_set1_epi32(INT32_MAX));
+  }
+
+  // Mask of 32 bits lanes whose sign bit is set.
+  static __mmask16 sign_mask_i32(vector_type x) {
+    return _mm512_test_epi32_mask(x, _mm512_set1_epi32(INT32_MIN));
+  }
+
+  // Products of lower and upper halves of 8 bits lanes
+  // in 16 bits lanes, where they never overflow.
+  static void mul_i8x64(vector_type x, vector_type y,
+                        vector_type* lo, vector_type* hi) {
+    *lo = _mm512_mullo_epi16(
+        _mm512_srai_epi16(_mm512_unpacklo_epi8(x, x), 8),
+        _mm512_srai_epi16(_mm512_unpacklo_epi8(y, y), 8));
+    *hi = _mm512_mullo_epi16(
+        _mm512_srai_epi16(_mm512_unpackhi_epi8(x, x), 8),
+        _mm512_srai_epi16(_mm512_unpackhi_epi8(y, y), 8));
+  }
+
+  static void mul_u8x64(vector_type x, vector_type y,
+                        vector_type* lo, vector_type* hi) {
+    const vector_type kZero = _mm512_setzero_si512();
+    *lo = _mm512_mullo_epi16(_mm512_unpacklo_epi8(x, kZero),
+                             _mm512_unpacklo_epi8(y, kZero));
+    *hi = _mm512_mullo_epi16(_mm512_unpackhi_epi8(x, kZero),
+                             _mm512_unpackhi_epi8(y, kZero));
+  }
+
+  // Products plus z, which never overflow 16 bits lanes either.
+  static void mul_add_i8x64(vector_type x, vector_type y, vector_type z,
+                            vector_type* lo, vector_type* hi) {
+    mul_i8x64(x, y, lo, hi);
+    *lo = _mm512_add_epi16(*lo,
+                           _mm512_srai_epi16(_mm512_unpacklo_epi8(z, z), 8));
+    *hi = _mm512_add_epi16(*hi,
+                           _mm512_srai_epi16(_mm512_unpackhi_epi8(z, z), 8));
+  }
+
+  static void mul_add_u8x64(vector_type x, vector_type y, vector_type z,
+                            vector_type* lo, vector_type* hi) {
+    const vector_type kZero = _mm512_setzero_si512();
+    mul_u8x64(x, y, lo, hi);
+    *lo = _mm512_add_epi16(*lo, _mm512_unpacklo_epi8(z, kZero));
+    *hi = _mm512_add_epi16(*hi, _mm512_unpackhi_epi8(z, kZero));
+  }
+
+  // x and z are interleaved and so are y and 1,
+  // then pmaddwd calculates x * y + z * 1 in 32 bits lanes.
+  static void mul_add_i16x32(vector_type x, vector_type y, vector_type z,
+                             vector_type* lo, vector_type* hi) {
+    const vector_type kOne = _mm512_set1_epi16(1);
+    *lo = _mm512_madd_epi16(_mm512_unpacklo_epi16(x, z),
+                            _mm512_unpacklo_epi16(y, kOne));
+    *hi = _mm512_madd_epi16(_mm512_unpackhi_epi16(x, z),
+                            _mm512_unpackhi_epi16(y, kOne));
+  }
+
+  // 64 bits products of even and odd 32 bits lanes.
+  static void mul_i32x16(vector_type x, vector_type y,
+                         vector_type* even, vector_type* odd) {
+    *even = _mm512_mul_epi32(x, y);
+    *odd = _mm512_mul_epi32(_mm512_srli_epi64(x, 32),
+                            _mm512_srli_epi64(y, 32));
+  }
+
+  static void mul_u32x16(vector_type x, vector_type y,
+                         vector_type* even, vector_type* odd) {
+    *even = _mm512_mul_epu32(x, y);
+    *odd = _mm512_mul_epu32(_mm512_srli_epi64(x, 32),
+                            _mm512_srli_epi64(y, 32));
+  }
+
+  // Products plus z extended into 64 bits lanes.
+  static void mul_add_i32x16(vector_type x, vector_type y, vector_type z,
+                             vector_type* even, vector_type* odd) {
+    mul_i32x16(x, y, even, odd);
+    *even = _mm512_add_epi64(*even,
+                             _mm512_srai_epi64(_mm512_slli_epi64(z, 32), 32));
+    *odd = _mm512_add_epi64(*odd, _mm512_srai_epi64(z, 32));
+  }
+
+  static void mul_add_u32x16(vector_type x, vector_type y, vector_type z,
+                             vector_type* even, vector_type* odd) {
+    const vector_type kMax = _mm512_set1_epi64(UINT32_MAX);
+    mul_u32x16(x, y, even, odd);
+    *even = _mm512_add_epi64(*even, _mm512_and_si512(z, kMax));
+    *odd = _mm512_add_epi64(*odd, _mm512_srli_epi64(z, 32));
+  }
+
+  // 64 bits lanes clamped into the range of 32 bits.
+  static vector_type clamp_i64_i32(vector_type v) {
+    return _mm512_min_epi64(_mm512_max_epi64(v, _mm512_set1_epi64(INT32_MIN)),
+                            _mm512_set1_epi64(INT32_MAX));
+  }
+
+  static vector_type clamp_u64_u32(vector_type v) {
+    return _mm512_min_epu64(v, _mm512_set1_epi64(UINT32_MAX));
+  }
+
+  // Masks of lanes in the same order as packs of lo and hi,
+  // and as interleaving even and odd lanes.
+  static uint64_t packed_mask_i16(__mmask32 lo, __mmask32 hi) {
+    return _mm512_movepi8_mask(_mm512_packs_epi16(_mm512_movm_epi16(lo),
+                                                  _mm512_movm_epi16(hi)));
+  }
+
+  static uint64_t packed_mask_i32(__mmask16 lo, __mmask16 hi) {
+    return _mm512_movepi16_mask(
+        _mm512_packs_epi32(_mm512_maskz_mov_epi32(lo, all_ones()),
+                           _mm512_maskz_mov_epi32(hi, all_ones())));
+  }
+
+  static uint64_t interleaved_mask_i64(__mmask8 even, __mmask8 odd) {
+    const vector_type lanes = _mm512_mask_blend_epi32(
+        0xAAAA,
+        _mm512_maskz_mov_epi64(even, all_ones()),
+        _mm512_maskz_mov_epi64(odd, all_ones()));
+    return _mm512_test_epi32_mask(lanes, lanes);
+  }
+
+  // 16 bits lanes which are not sign or zero extension of 8 bits,
+  // and 32 bits lanes which are not sign extension of 16 bits.
+  static __mmask32 unfit_mask_i8(vector_type v) {
+    return _mm512_cmpneq_epi16_mask(
+        v, _mm512_srai_epi16(_mm512_slli_epi16(v, 8), 8));
+  }
+
+  static __mmask32 unfit_mask_u8(vector_type v) {
+    return _mm512_cmpgt_epu16_mask(v, _mm512_set1_epi16(UINT8_MAX));
+  }
+
+  static __mmask16 unfit_mask_i16(vector_type v) {
+    return _mm512_cmpneq_epi32_mask(
+        v, _mm512_srai_epi32(_mm512_slli_epi32(v, 16), 16));
+  }
+
+  // Unsigned quotients of 16 bits lanes by magic number,
+  // see divider for the algorithm.
+  static vector_type divide_u16(vector_type n, vector_type magic,
+                                int shift1, int shift2) {
+    const vector_type t = _mm512_mulhi_epu16(n, magic);
+    return _mm512_srl_epi16(
+        _mm512_add_epi16(t, _mm512_srl_epi16(_mm512_sub_epi16(n, t),
+                                             _mm_cvtsi32_si128(shift1))),
+        _mm_cvtsi32_si128(shift2));
+  }
+
+  // Upper halves of even lanes are shifted down,
+  // and ones of odd lanes are already in place.
+  static vector_type divide_u32(vector_type n, vector_type magic,
+                                int shift1, int shift2) {
+    const vector_type even = _mm512_mul_epu32(n, magic);
+    const vector_type odd = _mm512_mul_epu32(_mm512_srli_epi64(n, 32),
+                                             _mm512_srli_epi64(magic, 32));
+    const vector_type t =
+        _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+    return _mm512_srl_epi32(
+        _mm512_add_epi32(t, _mm512_srl_epi32(_mm512_sub_epi32(n, t),
+                                             _mm_cvtsi32_si128(shift1))),
+        _mm_cvtsi32_si128(shift2));
+  }
+
+  // 8 bits lanes are divided in 16 bits lanes,
+  // where upper half of n * (magic << 8) is (n * magic) >> 8.
+  static vector_type divide_u8(vector_type n, uint8_t magic,
+                               int shift1, int shift2) {
+    const vector_type kZero = _mm512_setzero_si512();
+    const vector_type magic16 =
+        _mm512_set1_epi16(static_cast<int16_t>(magic << 8));
+    return _mm512_packus_epi16(
+        divide_u16(_mm512_unpacklo_epi8(n, kZero), magic16, shift1, shift2),
+        divide_u16(_mm512_unpackhi_epi8(n, kZero), magic16, shift1, shift2));
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    return _mm512_adds_epi8(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    return _mm512_adds_epu8(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    return _mm512_adds_epi16(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<uint16_t>) {
+    return _mm512_adds_epu16(x, y);
+  }
+
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<int32_t>) {
+    const vector_type sum = _mm512_add_epi32(x, y);
+    const __mmask16 overflow = sign_mask_i32(
+        _mm512_and_si512(_mm512_xor_si512(x, sum), _mm512_xor_si512(y, sum)));
+    return _mm512_mask_blend_epi32(overflow, sum, saturated_by_sign_i32(x));
+  }
+
+  // y is clamped to room of x, so the sum never wraps.
+  static vector_type apply(add_op, vector_type x, vector_type y,
+                           type_tag<uint32_t>) {
+    return _mm512_add_epi32(
+        x, _mm512_min_epu32(y, _mm512_xor_si512(x, all_ones())));
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    return _mm512_subs_epi8(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    return _mm512_subs_epu8(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    return _mm512_subs_epi16(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<uint16_t>) {
+    return _mm512_subs_epu16(x, y);
+  }
+
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<int32_t>) {
+    const vector_type difference = _mm512_sub_epi32(x, y);
+    const __mmask16 overflow = sign_mask_i32(
+        _mm512_and_si512(_mm512_xor_si512(x, y),
+                         _mm512_xor_si512(x, difference)));
+    return _mm512_mask_blend_epi32(overflow,
+                                   difference,
+                                   saturated_by_sign_i32(x));
+  }
+
+  // max(x, y) - y is x - y if x >= y, otherwise 0.
+  static vector_type apply(sub_op, vector_type x, vector_type y,
+                           type_tag<uint32_t>) {
+    return _mm512_sub_epi32(_mm512_max_epu32(x, y), y);
+  }
+
+  // Absolute value of lowest is wrapped into lowest,
+  // which is clamped into max as unsigned value.
+  static vector_type apply(abs_op, vector_type x, type_tag<int8_t>) {
+    return _mm512_min_epu8(_mm512_abs_epi8(x), _mm512_set1_epi8(INT8_MAX));
+  }
+
+  static vector_type apply(abs_op, vector_type x, type_tag<int16_t>) {
+    return _mm512_min_epu16(_mm512_abs_epi16(x), _mm512_set1_epi16(INT16_MAX));
+  }
+
+  static vector_type apply(abs_op, vector_type x, type_tag<int32_t>) {
+    return _mm512_min_epu32(_mm512_abs_epi32(x), _mm512_set1_epi32(INT32_MAX));
+  }
+
+  // Multiply in 16 bits lanes and pack them with saturation.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_i8x64(x, y, &lo, &hi);
+    return _mm512_packs_epi16(lo, hi);
+  }
+
+  // Multiply in 16 bits lanes, clamp them to 255 and pack them.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    const vector_type kMax = _mm512_set1_epi16(UINT8_MAX);
+    vector_type lo;
+    vector_type hi;
+    mul_u8x64(x, y, &lo, &hi);
+    return _mm512_packus_epi16(_mm512_min_epu16(lo, kMax),
+                               _mm512_min_epu16(hi, kMax));
+  }
+
+  // Build 32 bits products from low and high halves,
+  // and pack them with saturation.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type lo = _mm512_mullo_epi16(x, y);
+    const vector_type hi = _mm512_mulhi_epi16(x, y);
+    return _mm512_packs_epi32(_mm512_unpacklo_epi16(lo, hi),
+                              _mm512_unpackhi_epi16(lo, hi));
+  }
+
+  // Products overflow if their upper halves are not 0.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<uint16_t>) {
+    const __mmask32 overflow =
+        _mm512_test_epi16_mask(_mm512_mulhi_epu16(x, y),
+                               _mm512_set1_epi16(-1));
+    return _mm512_mask_mov_epi16(_mm512_mullo_epi16(x, y),
+                                 overflow,
+                                 all_ones());
+  }
+
+  // 64 bits products of even and odd lanes are clamped
+  // with 64 bits min and max, and interleaved again.
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<int32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_i32x16(x, y, &even, &odd);
+    return _mm512_mask_blend_epi32(0xAAAA,
+                                   clamp_i64_i32(even),
+                                   _mm512_slli_epi64(clamp_i64_i32(odd), 32));
+  }
+
+  static vector_type apply(mul_op, vector_type x, vector_type y,
+                           type_tag<uint32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_u32x16(x, y, &even, &odd);
+    return _mm512_mask_blend_epi32(0xAAAA,
+                                   clamp_u64_u32(even),
+                                   _mm512_slli_epi64(clamp_u64_u32(odd), 32));
+  }
+
+  // Products of 8 bits lanes plus z fit in 16 bits lanes,
+  // so they are packed with saturation at once.
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i8x64(x, y, z, &lo, &hi);
+    return _mm512_packs_epi16(lo, hi);
+  }
+
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<uint8_t>) {
+    const vector_type kMax = _mm512_set1_epi16(UINT8_MAX);
+    vector_type lo;
+    vector_type hi;
+    mul_add_u8x64(x, y, z, &lo, &hi);
+    return _mm512_packus_epi16(_mm512_min_epu16(lo, kMax),
+                               _mm512_min_epu16(hi, kMax));
+  }
+
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<int16_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i16x32(x, y, z, &lo, &hi);
+    return _mm512_packs_epi32(lo, hi);
+  }
+
+  // Sum overflows if upper halves of products are not 0,
+  // or if adding z to lower halves carries.
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<uint16_t>) {
+    const __mmask32 overflow =
+        _mm512_test_epi16_mask(_mm512_mulhi_epu16(x, y),
+                               _mm512_set1_epi16(-1));
+    return _mm512_mask_mov_epi16(
+        _mm512_adds_epu16(_mm512_mullo_epi16(x, y), z),
+        overflow,
+        all_ones());
+  }
+
+  // Sums in 64 bits lanes are clamped as mul_op.
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<int32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_add_i32x16(x, y, z, &even, &odd);
+    return _mm512_mask_blend_epi32(0xAAAA,
+                                   clamp_i64_i32(even),
+                                   _mm512_slli_epi64(clamp_i64_i32(odd), 32));
+  }
+
+  static vector_type apply(mul_add_op, vector_type x, vector_type y,
+                           vector_type z, type_tag<uint32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_add_u32x16(x, y, z, &even, &odd);
+    return _mm512_mask_blend_epi32(0xAAAA,
+                                   clamp_u64_u32(even),
+                                   _mm512_slli_epi64(clamp_u64_u32(odd), 32));
+  }
+
+  // Lanes which apply() saturates, as masks of equal_mask().
+  // Products are calculated in the same way as apply(),
+  // so that compilers share them with results.
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_i8x64(x, y, &lo, &hi);
+    return packed_mask_i16(unfit_mask_i8(lo), unfit_mask_i8(hi));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<uint8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_u8x64(x, y, &lo, &hi);
+    return packed_mask_i16(unfit_mask_u8(lo), unfit_mask_u8(hi));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<int16_t>) {
+    return _mm512_cmpneq_epi16_mask(
+        _mm512_mulhi_epi16(x, y),
+        _mm512_srai_epi16(_mm512_mullo_epi16(x, y), 15));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<uint16_t>) {
+    return _mm512_test_epi16_mask(_mm512_mulhi_epu16(x, y),
+                                  _mm512_set1_epi16(-1));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<int32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_i32x16(x, y, &even, &odd);
+    return interleaved_mask_i64(
+        _mm512_cmpneq_epi64_mask(even, clamp_i64_i32(even)),
+        _mm512_cmpneq_epi64_mask(odd, clamp_i64_i32(odd)));
+  }
+
+  static uint64_t saturated_mask(mul_op, vector_type x, vector_type y,
+                                 type_tag<uint32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_u32x16(x, y, &even, &odd);
+    return interleaved_mask_i64(
+        _mm512_cmpneq_epi64_mask(even, clamp_u64_u32(even)),
+        _mm512_cmpneq_epi64_mask(odd, clamp_u64_u32(odd)));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<int8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i8x64(x, y, z, &lo, &hi);
+    return packed_mask_i16(unfit_mask_i8(lo), unfit_mask_i8(hi));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<uint8_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_u8x64(x, y, z, &lo, &hi);
+    return packed_mask_i16(unfit_mask_u8(lo), unfit_mask_u8(hi));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<int16_t>) {
+    vector_type lo;
+    vector_type hi;
+    mul_add_i16x32(x, y, z, &lo, &hi);
+    return packed_mask_i32(unfit_mask_i16(lo), unfit_mask_i16(hi));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<uint16_t>) {
+    const vector_type lo = _mm512_mullo_epi16(x, y);
+    return (_mm512_test_epi16_mask(_mm512_mulhi_epu16(x, y),
+                                   _mm512_set1_epi16(-1))
+            | _mm512_cmpneq_epi16_mask(_mm512_adds_epu16(lo, z),
+                                       _mm512_add_epi16(lo, z)));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<int32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_add_i32x16(x, y, z, &even, &odd);
+    return interleaved_mask_i64(
+        _mm512_cmpneq_epi64_mask(even, clamp_i64_i32(even)),
+        _mm512_cmpneq_epi64_mask(odd, clamp_i64_i32(odd)));
+  }
+
+  static uint64_t saturated_mask(mul_add_op, vector_type x, vector_type y,
+                                 vector_type z, type_tag<uint32_t>) {
+    vector_type even;
+    vector_type odd;
+    mul_add_u32x16(x, y, z, &even, &odd);
+    return interleaved_mask_i64(
+        _mm512_cmpneq_epi64_mask(even, clamp_u64_u32(even)),
+        _mm512_cmpneq_epi64_mask(odd, clamp_u64_u32(odd)));
+  }
+
+  // x and 1 are interleaved and so are y and the rounding constant,
+  // then pmaddwd calculates x * y + rounding in 32 bits lanes.
+  template <int FracBits>
+  static vector_type apply(fixed_mul_op<FracBits>,
+                           vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type kOne = _mm512_set1_epi16(1);
+    const vector_type kRounding =
+        _mm512_set1_epi16(static_cast<int16_t>((1 << FracBits) >> 1));
+    const vector_type lo = _mm512_madd_epi16(
+        _mm512_unpacklo_epi16(x, kOne), _mm512_unpacklo_epi16(y, kRounding));
+    const vector_type hi = _mm512_madd_epi16(
+        _mm512_unpackhi_epi16(x, kOne), _mm512_unpackhi_epi16(y, kRounding));
+    return _mm512_packs_epi32(_mm512_srai_epi32(lo, FracBits),
+                              _mm512_srai_epi32(hi, FracBits));
+  }
+
+  // pmulhrsw wraps only -1 * -1 into lowest,
+  // which is never a rounded product.
+  static vector_type apply(fixed_mul_op<15>, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type product = _mm512_mulhrs_epi16(x, y);
+    return _mm512_mask_sub_epi16(
+        product,
+        _mm512_cmpeq_epi16_mask(product, _mm512_set1_epi16(INT16_MIN)),
+        product,
+        _mm512_set1_epi16(1));
+  }
+
+  static vector_type zero() {
+    return _mm512_setzero_si512();
+  }
+
+  static vector_type add_i64(vector_type x, vector_type y) {
+    return _mm512_add_epi64(x, y);
+  }
+
+  static int64_t reduce_add_i64(vector_type v) {
+    int64_t lanes[sizeof(vector_type) / sizeof(int64_t)];
+    store(lanes, v);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]))
+        + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+  }
+
+  // Sums of pairs of 32 bits lanes in 64 bits lanes,
+  // where sign is all 1 in lanes to be extended as negative.
+  static vector_type widen_add_32(vector_type v, vector_type sign) {
+    return _mm512_add_epi64(_mm512_unpacklo_epi32(v, sign),
+                            _mm512_unpackhi_epi32(v, sign));
+  }
+
+  // Partial sums of lanes of x in 64 bits lanes.
+  static vector_type apply(sum_op, vector_type x, type_tag<int8_t>) {
+    const vector_type kBias = _mm512_set1_epi8(INT8_MIN);
+    return _mm512_sub_epi64(_mm512_sad_epu8(_mm512_xor_si512(x, kBias),
+                                            _mm512_setzero_si512()),
+                            _mm512_set1_epi64(8 * 128));
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<uint8_t>) {
+    return _mm512_sad_epu8(x, _mm512_setzero_si512());
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<int16_t>) {
+    const vector_type pairs = _mm512_madd_epi16(x, _mm512_set1_epi16(1));
+    return widen_add_32(pairs, _mm512_srai_epi32(pairs, 31));
+  }
+
+  // Biased into signed values, summed, and unbiased.
+  static vector_type apply(sum_op, vector_type x, type_tag<uint16_t>) {
+    const vector_type pairs =
+        _mm512_madd_epi16(_mm512_xor_si512(x, _mm512_set1_epi16(INT16_MIN)),
+                          _mm512_set1_epi16(1));
+    return _mm512_add_epi64(widen_add_32(pairs, _mm512_srai_epi32(pairs, 31)),
+                            _mm512_set1_epi64(4 * 32768));
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<int32_t>) {
+    return widen_add_32(x, _mm512_srai_epi32(x, 31));
+  }
+
+  static vector_type apply(sum_op, vector_type x, type_tag<uint32_t>) {
+    return widen_add_32(x, _mm512_setzero_si512());
+  }
+
+  // Partial sums of products of lanes of x and y in 64 bits lanes.
+  static vector_type apply(dot_op, vector_type x, vector_type y,
+                           type_tag<int8_t>) {
+    const vector_type pairs = _mm512_add_epi32(
+        _mm512_madd_epi16(_mm512_srai_epi16(_mm512_unpacklo_epi8(x, x), 8),
+                          _mm512_srai_epi16(_mm512_unpacklo_epi8(y, y), 8)),
+        _mm512_madd_epi16(_mm512_srai_epi16(_mm512_unpackhi_epi8(x, x), 8),
+                          _mm512_srai_epi16(_mm512_unpackhi_epi8(y, y), 8)));
+    return widen_add_32(pairs, _mm512_srai_epi32(pairs, 31));
+  }
+
+  static vector_type apply(dot_op, vector_type x, vector_type y,
+                           type_tag<uint8_t>) {
+    const vector_type kZero = _mm512_setzero_si512();
+    const vector_type pairs = _mm512_add_epi32(
+        _mm512_madd_epi16(_mm512_unpacklo_epi8(x, kZero),
+                          _mm512_unpacklo_epi8(y, kZero)),
+        _mm512_madd_epi16(_mm512_unpackhi_epi8(x, kZero),
+                          _mm512_unpackhi_epi8(y, kZero)));
+    return widen_add_32(pairs, kZero);
+  }
+
+  // pmaddwd wraps only (-32768 * -32768) * 2 into INT32_MIN,
+  // which is extended as positive.
+  static vector_type apply(dot_op, vector_type x, vector_type y,
+                           type_tag<int16_t>) {
+    const vector_type pairs = _mm512_madd_epi16(x, y);
+    const __mmask16 not_wrapped =
+        _mm512_cmpneq_epi32_mask(pairs, _mm512_set1_epi32(INT32_MIN));
+    return widen_add_32(pairs,
+                        _mm512_maskz_srai_epi32(not_wrapped, pairs, 31));
+  }
+
+  static vector_type concat(__m256i lo, __m256i hi) {
+    return _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+  }
+
+  // acc + x0 * y0 + x1 * y1 of pairs of 16 bits lanes
+  // saturated in 32 bits lanes, as vpdpwssds of AVX512-VNNI.
+  // pmaddwd wraps only (-32768 * -32768) * 2 into INT32_MIN,
+  // so INT32_MAX and 1 are added instead of it.
+  static vector_type apply(dot_pairs_op, vector_type acc, vector_type x,
+                           vector_type y, type_tag<int16_t>) {
+    const vector_type pairs = _mm512_madd_epi16(x, y);
+    const __mmask16 wrapped =
+        _mm512_cmpeq_epi32_mask(pairs, _mm512_set1_epi32(INT32_MIN));
+    const vector_type sum = apply(
+        add_op(), acc,
+        _mm512_mask_mov_epi32(pairs, wrapped, _mm512_set1_epi32(INT32_MAX)),
+        type_tag<int32_t>());
+    const __mmask16 not_max = _mm512_mask_cmpneq_epi32_mask(
+        wrapped, sum, _mm512_set1_epi32(INT32_MAX));
+    return _mm512_mask_add_epi32(sum, not_max, sum, _mm512_set1_epi32(1));
+  }
+
+  // Sign extended lower and upper halves of 16 bits lanes
+  // in 32 bits lanes, which narrow() packs back.
+  static vector_type widen_lo_i16(vector_type x) {
+    return _mm512_cvtepi16_epi32(_mm512_castsi512_si256(x));
+  }
+
+  static vector_type widen_hi_i16(vector_type x) {
+    return _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(x, 1));
+  }
+
+  // Narrow 2 vectors into 1 vector of half width lanes with saturation,
+  // lanes of lo first, by vpmov* instructions.
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int32_t>, type_tag<int16_t>) {
+    return concat(_mm512_cvtsepi32_epi16(lo), _mm512_cvtsepi32_epi16(hi));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int32_t>, type_tag<uint16_t>) {
+    const vector_type kZero = _mm512_setzero_si512();
+    return concat(_mm512_cvtusepi32_epi16(_mm512_max_epi32(lo, kZero)),
+                  _mm512_cvtusepi32_epi16(_mm512_max_epi32(hi, kZero)));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint32_t>, type_tag<uint16_t>) {
+    return concat(_mm512_cvtusepi32_epi16(lo), _mm512_cvtusepi32_epi16(hi));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint32_t>, type_tag<int16_t>) {
+    const vector_type kMax = _mm512_set1_epi32(INT16_MAX);
+    return concat(_mm512_cvtepi32_epi16(_mm512_min_epu32(lo, kMax)),
+                  _mm512_cvtepi32_epi16(_mm512_min_epu32(hi, kMax)));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int16_t>, type_tag<int8_t>) {
+    return concat(_mm512_cvtsepi16_epi8(lo), _mm512_cvtsepi16_epi8(hi));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<int16_t>, type_tag<uint8_t>) {
+    const vector_type kZero = _mm512_setzero_si512();
+    return concat(_mm512_cvtusepi16_epi8(_mm512_max_epi16(lo, kZero)),
+                  _mm512_cvtusepi16_epi8(_mm512_max_epi16(hi, kZero)));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint16_t>, type_tag<uint8_t>) {
+    return concat(_mm512_cvtusepi16_epi8(lo), _mm512_cvtusepi16_epi8(hi));
+  }
+
+  static vector_type narrow(vector_type lo, vector_type hi,
+                            type_tag<uint16_t>, type_tag<int8_t>) {
+    const vector_type kMax = _mm512_set1_epi16(INT8_MAX);
+    return concat(_mm512_cvtepi16_epi8(_mm512_min_epu16(lo, kMax)),
+                  _mm512_cvtepi16_epi8(_mm512_min_epu16(hi, kMax)));
+  }
+
+  // Convert lanes between signed and unsigned types of the same width.
+  static vector_type apply(cast_op<int8_t>, vector_type x, type_tag<uint8_t>) {
+    return _mm512_max_epi8(x, _mm512_setzero_si512());
+  }
+
+  static vector_type apply(cast_op<uint8_t>, vector_type x, type_tag<int8_t>) {
+    return _mm512_min_epu8(x, _mm512_set1_epi8(INT8_MAX));
+  }
+
+  static vector_type apply(cast_op<int16_t>, vector_type x,
+                           type_tag<uint16_t>) {
+    return _mm512_max_epi16(x, _mm512_setzero_si512());
+  }
+
+  static vector_type apply(cast_op<uint16_t>, vector_type x,
+                           type_tag<int16_t>) {
+    return _mm512_min_epu16(x, _mm512_set1_epi16(INT16_MAX));
+  }
+
+  static vector_type apply(cast_op<int32_t>, vector_type x,
+                           type_tag<uint32_t>) {
+    return _mm512_max_epi32(x, _mm512_setzero_si512());
+  }
+
+  static vector_type apply(cast_op<uint32_t>, vector_type x,
+                           type_tag<int32_t>) {
+    return _mm512_min_epu32(x, _mm512_set1_epi32(INT32_MAX));
+  }
+
+  // Convert lanes of floating point values multiplied by scale
+  // into int32_t with saturation as saturate_cast(), where NaN is 0,
+  // after rounding them by Mode.
+  template <rounding Mode>
+  static vector_type to_int32(const float* x, float scale,
+                              rounding_tag<Mode> mode) {
+    return truncate_i32(round(
+        _mm512_mul_ps(_mm512_loadu_ps(x), _mm512_set1_ps(scale)), mode));
+  }
+
+  template <rounding Mode>
+  static vector_type to_int32(const double* x, double scale,
+                              rounding_tag<Mode> mode) {
+    const __m512d vscale = _mm512_set1_pd(scale);
+    return _mm512_inserti64x4(
+        _mm512_castsi256_si512(truncate_i32(round(
+            _mm512_mul_pd(_mm512_loadu_pd(x), vscale), mode))),
+        truncate_i32(round(_mm512_mul_pd(_mm512_loadu_pd(x + 8), vscale),
+                           mode)),
+        1);
+  }
+
+  template <typename V>
+  static V round(V v, rounding_tag<rounding::toward_zero>) {
+    return v;
+  }
+
+  static __m512 round(__m512 v, rounding_tag<rounding::to_nearest>) {
+    return _mm512_roundscale_ps(v,
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+
+  static __m512 round(__m512 v, rounding_tag<rounding::downward>) {
+    return _mm512_roundscale_ps(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+
+  static __m512 round(__m512 v, rounding_tag<rounding::upward>) {
+    return _mm512_roundscale_ps(v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  }
+
+  static __m512d round(__m512d v, rounding_tag<rounding::to_nearest>) {
+    return _mm512_roundscale_pd(v,
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+
+  static __m512d round(__m512d v, rounding_tag<rounding::downward>) {
+    return _mm512_roundscale_pd(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+
+  static __m512d round(__m512d v, rounding_tag<rounding::upward>) {
+    return _mm512_roundscale_pd(v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+  }
+
+  // Conversion returns 0x80000000 for values out of range,
+  // so too large values are replaced with max, and NaN with 0.
+  static vector_type truncate_i32(__m512 v) {
+    const __mmask16 too_large =
+        _mm512_cmp_ps_mask(v, _mm512_set1_ps(2147483648.0f), _CMP_GE_OQ);
+    return _mm512_maskz_mov_epi32(
+        _mm512_cmp_ps_mask(v, v, _CMP_ORD_Q),
+        _mm512_mask_mov_epi32(_mm512_cvttps_epi32(v), too_large,
+                              _mm512_set1_epi32(INT32_MAX)));
+  }
+
+  // Limits of int32_t are exact in double, so values are clamped
+  // before conversion.
+  static __m256i truncate_i32(__m512d v) {
+    const __m512d ordered =
+        _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(v, v, _CMP_ORD_Q), v);
+    return _mm512_cvttpd_epi32(
+        _mm512_max_pd(_mm512_min_pd(ordered, _mm512_set1_pd(INT32_MAX)),
+                      _mm512_set1_pd(INT32_MIN)));
+  }
+
+  // Rounded quotients of 16 bits lanes up to 255 * 255 divided by 255,
+  // which are (t + (t >> 8)) >> 8 where t = v + 128.
+  static vector_type div255_u16(vector_type v) {
+    const vector_type t = _mm512_add_epi16(v, _mm512_set1_epi16(128));
+    return _mm512_srli_epi16(_mm512_add_epi16(t, _mm512_srli_epi16(t, 8)), 8);
+  }
+
+  // Alpha, the last channel of each RGBA pixel, copied into its channels.
+  static vector_type broadcast_alpha(vector_type x) {
+    const vector_type a = _mm512_srli_epi32(x, 24);
+    const vector_type aa = _mm512_or_si512(a, _mm512_slli_epi32(a, 8));
+    return _mm512_or_si512(aa, _mm512_slli_epi32(aa, 16));
+  }
+
+  // x and 1 are interleaved and so are gain and the rounding constant,
+  // then pmaddwd calculates x * gain + 128 in 32 bits lanes.
+  static vector_type scale_u16(vector_type x, vector_type gain) {
+    const vector_type kOne = _mm512_set1_epi16(1);
+    const vector_type lo =
+        _mm512_madd_epi16(_mm512_unpacklo_epi16(x, kOne), gain);
+    const vector_type hi =
+        _mm512_madd_epi16(_mm512_unpackhi_epi16(x, kOne), gain);
+    return _mm512_packs_epi32(_mm512_srai_epi32(lo, 8),
+                              _mm512_srai_epi32(hi, 8));
+  }
+
+  static vector_type apply(scale_op, vector_type x,
+                           int16_t gain, int16_t offset, type_tag<uint8_t>) {
+    const vector_type kZero = _mm512_setzero_si512();
+    const vector_type kGain = _mm512_set1_epi32(
+        static_cast<int32_t>((128U << 16) | static_cast<uint16_t>(gain)));
+    const vector_type kOffset = _mm512_set1_epi16(offset);
+    const vector_type lo = scale_u16(_mm512_unpacklo_epi8(x, kZero), kGain);
+    const vector_type hi = scale_u16(_mm512_unpackhi_epi8(x, kZero), kGain);
+    return _mm512_packus_epi16(_mm512_adds_epi16(lo, kOffset),
+                               _mm512_adds_epi16(hi, kOffset));
+  }
+
+  // Sums of products fit in 16 bits lanes, up to 255 * 255.
+  static vector_type apply(blend_op, vector_type x, vector_type y,
+                           uint8_t alpha, type_tag<uint8_t>) {
+    const vector_type kZero = _mm512_setzero_si512();
+    const vector_type kAlpha = _mm512_set1_epi16(alpha);
+    const vector_type kInverse = _mm512_set1_epi16(
+        static_cast<int16_t>(UINT8_MAX - alpha));
+    const vector_type lo = _mm512_add_epi16(
+        _mm512_mullo_epi16(_mm512_unpacklo_epi8(x, kZero), kAlpha),
+        _mm512_mullo_epi16(_mm512_unpacklo_epi8(y, kZero), kInverse));
+    const vector_type hi = _mm512_add_epi16(
+        _mm512_mullo_epi16(_mm512_unpackhi_epi8(x, kZero), kAlpha),
+        _mm512_mullo_epi16(_mm512_unpackhi_epi8(y, kZero), kInverse));
+    return _mm512_packus_epi16(div255_u16(lo), div255_u16(hi));
+  }
+
+  // 255 - alpha is bitwise not of alpha.
+  static vector_type apply(composite_op, vector_type src, vector_type alpha,
+                           vector_type dst, type_tag<uint8_t>) {
+    const vector_type kZero = _mm512_setzero_si512();
+    const vector_type inverse = _mm512_xor_si512(alpha, all_ones());
+    const vector_type lo =
+        _mm512_mullo_epi16(_mm512_unpacklo_epi8(dst, kZero),
+                           _mm512_unpacklo_epi8(inverse, kZero));
+    const vector_type hi =
+        _mm512_mullo_epi16(_mm512_unpackhi_epi8(dst, kZero),
+                           _mm512_unpackhi_epi8(inverse, kZero));
+    return _mm512_adds_epu8(
+        src, _mm512_packus_epi16(div255_u16(lo), div255_u16(hi)));
+  }
+
+  // Divisor of following divisions must not be 0.
+  static vector_type apply(div_op, vector_type x, const divider<uint8_t>& d) {
+    return divide_u8(x, d.magic(), d.shift1(), d.shift2());
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<uint16_t>& d) {
+    return divide_u16(x, broadcast(d.magic()), d.shift1(), d.shift2());
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<uint32_t>& d) {
+    return divide_u32(x, broadcast(d.magic()), d.shift1(), d.shift2());
+  }
+
+  // Unsigned quotients are negated in negative lanes,
+  // and clamped to max in the other lanes.
+  static vector_type apply(div_op, vector_type x, const divider<int8_t>& d) {
+    const __mmask64 negative = static_cast<__mmask64>(
+        _mm512_movepi8_mask(x) ^ (d.is_negative() ? ~__mmask64(0) : 0));
+    const vector_type q =
+        divide_u8(_mm512_abs_epi8(x), d.magic(), d.shift1(), d.shift2());
+    const vector_type kMax = _mm512_set1_epi8(INT8_MAX);
+    return _mm512_mask_sub_epi8(_mm512_min_epu8(q, kMax),
+                                negative, _mm512_setzero_si512(), q);
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<int16_t>& d) {
+    const __mmask32 negative = static_cast<__mmask32>(
+        _mm512_movepi16_mask(x) ^ (d.is_negative() ? ~__mmask32(0) : 0));
+    const vector_type q = divide_u16(_mm512_abs_epi16(x), broadcast(d.magic()),
+                                     d.shift1(), d.shift2());
+    const vector_type kMax = _mm512_set1_epi16(INT16_MAX);
+    return _mm512_mask_sub_epi16(_mm512_min_epu16(q, kMax),
+                                 negative, _mm512_setzero_si512(), q);
+  }
+
+  static vector_type apply(div_op, vector_type x, const divider<int32_t>& d) {
+    const __mmask16 negative = static_cast<__mmask16>(
+        sign_mask_i32(x) ^ (d.is_negative() ? 0xFFFF : 0));
+    const vector_type q = divide_u32(_mm512_abs_epi32(x), broadcast(d.magic()),
+                                     d.shift1(), d.shift2());
+    const vector_type kMax = _mm512_set1_epi32(INT32_MAX);
+    return _mm512_mask_sub_epi32(_mm512_min_epu32(q, kMax),
+                                 negative, _mm512_setzero_si512(), q);
+  }
+
+  // Results wrapped around, as ones of wrap_op.
+
+  static vector_type wrapping(add_op, vector_type x, vector_type y,
+                              lane_width<1>) {
+    return _mm512_add_epi8(x, y);
+  }
+
+  static vector_type wrapping(add_op, vector_type x, vector_type y,
+                              lane_width<2>) {
+    return _mm512_add_epi16(x, y);
+  }
+
+  static vector_type wrapping(add_op, vector_type x, vector_type y,
+                              lane_width<4>) {
+    return _mm512_add_epi32(x, y);
+  }
+
+  static vector_type wrapping(sub_op, vector_type x, vector_type y,
+                              lane_width<1>) {
+    return _mm512_sub_epi8(x, y);
+  }
+
+  static vector_type wrapping(sub_op, vector_type x, vector_type y,
+                              lane_width<2>) {
+    return _mm512_sub_epi16(x, y);
+  }
+
+  static vector_type wrapping(sub_op, vector_type x, vector_type y,
+                              lane_width<4>) {
+    return _mm512_sub_epi32(x, y);
+  }
+
+  static vector_type wrapping(mul_op, vector_type x, vector_type y,
+                              lane_width<2>) {
+    return _mm512_mullo_epi16(x, y);
+  }
+
+  static vector_type wrapping(mul_op, vector_type x, vector_type y,
+                              lane_width<4>) {
+    return _mm512_mullo_epi32(x, y);
+  }
+
+  template <typename Op, typename T>
+  static auto apply(wrap_op<Op>, vector_type x, vector_type y, type_tag<T>)
+      -> decltype(wrapping(Op(), x, y, lane_width<sizeof(T)>())) {
+    return wrapping(Op(), x, y, lane_width<sizeof(T)>());
+  }
+
+  // Lanes where x equals y, whose mask has bits_per_lane() bits per lane.
+
+  static uint64_t equal_mask(vector_type x, vector_type y, lane_width<1>) {
+    return _mm512_cmpeq_epi8_mask(x, y);
+  }
+
+  static uint64_t equal_mask(vector_type x, vector_type y, lane_width<2>) {
+    return _mm512_cmpeq_epi16_mask(x, y);
+  }
+
+  static uint64_t equal_mask(vector_type x, vector_type y, lane_width<4>) {
+    return _mm512_cmpeq_epi32_mask(x, y);
+  }
+
+  template <std::size_t Width>
+  static constexpr int bits_per_lane(lane_width<Width>) {
+    return 1;
+  }
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+SATOP_PRAGMA(GCC diagnostic pop)
+#endif
+
+SATOP_TARGET_REGION_END()
+
+}  // namespace impl
+
+}  // namespace saturated
+
+#endif  // SATOP_SIMD_X86
+
+#endif  // INCLUDE_SATOP_SIMD_AVX512BW_PRIV_H_
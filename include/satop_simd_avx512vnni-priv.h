@@ -0,0 +1,58 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_SIMD_AVX512VNNI_PRIV_H_
+#define INCLUDE_SATOP_SIMD_AVX512VNNI_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstdint>
+
+#include "satop_simd-priv.h"
+#include "satop_simd_avx512bw-priv.h"
+
+#ifdef SATOP_SIMD_X86
+
+namespace saturated {
+
+namespace impl {
+
+SATOP_TARGET_REGION_BEGIN("avx512f,avx512bw,avx512vnni")
+
+// Dot products of pairs of lanes by AVX512-VNNI.
+// It is not a level of simd_level, and it is used before avx512bw
+// if the CPU supports it.  Other operations are hidden,
+// so that avx512bw is chosen for them.
+struct avx512vnni : public avx512bw {
+  static vector_type apply(dot_pairs_op, vector_type acc, vector_type x,
+                           vector_type y, type_tag<int16_t>) {
+    return _mm512_dpwssds_epi32(acc, x, y);
+  }
+};
+
+SATOP_TARGET_REGION_END()
+
+}  // namespace impl
+
+}  // namespace saturated
+
+#endif  // SATOP_SIMD_X86
+
+#endif  // INCLUDE_SATOP_SIMD_AVX512VNNI_PRIV_H_
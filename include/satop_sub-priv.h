@@ -23,9 +23,13 @@
 #error Do not include this file directly, libsatop.h instead.
 #endif
 
+#include <cstdint>
 #include <limits>
 #include <type_traits>
 
+#include "satop_sign_util-priv.h"
+#include "satop_telemetry-priv.h"
+
 namespace saturated {
 
 namespace impl {
@@ -48,11 +52,110 @@ constexpr bool is_sub_underflow(
 
 template <typename T>
 constexpr bool is_sub_overflow(T x, T y) {
-  return ((x > 0)
+  return ((x >= 0)
           && (y < 0)
           && (x > std::numeric_limits<T>::max() + y));
 }
 
+// Portable implementation,
+// used for floating point types and unsigned integer types.
+template <typename T>
+constexpr T sub_by_compare(T x, T y) {
+  return (is_sub_underflow(x, y)
+          ? std::numeric_limits<T>::lowest()
+          : (is_sub_overflow(x, y)
+             ? std::numeric_limits<T>::max()
+             : static_cast<T>(x - y)));
+}
+
+// Signed subtraction overflows only if signs of operands differ
+// and sign of the wrapped difference differs from sign of x.
+template <typename T, typename U>
+constexpr T sub_select_by_sign_bit(U x, U y, U difference) {
+  return static_cast<T>(
+      ((((x ^ y) & (x ^ difference)) >> std::numeric_limits<T>::digits) != 0)
+      ? saturated_by_sign_bit<T>(x)
+      : difference);
+}
+
+template <typename T>
+constexpr T sub(T x, T y, unsigned_integer_tag) {
+  return sub_by_compare(x, y);
+}
+
+template <typename T>
+constexpr T sub(T x, T y, signed_integer_tag) {
+  using U = typename std::make_unsigned<T>::type;
+  return sub_select_by_sign_bit<T>(
+      static_cast<U>(x),
+      static_cast<U>(y),
+      static_cast<U>(static_cast<U>(x) - static_cast<U>(y)));
+}
+
+template <typename T>
+constexpr T sub(T x, T y, floating_point_tag) {
+  return sub_by_compare(x, y);
+}
+
+// Kind of saturation of sub(x, y) which returned result.
+// Integral results are saturated only if they differ
+// from wrapped differences.
+template <typename T>
+constexpr saturation_kind sub_saturation(T x, T y, T /* result */,
+                                         floating_point_tag) {
+  return (is_sub_underflow(x, y)
+          ? saturation_kind::underflow
+          : (is_sub_overflow(x, y)
+             ? saturation_kind::overflow
+             : saturation_kind::none));
+}
+
+template <typename T, typename Category>
+constexpr saturation_kind sub_saturation(T x, T y, T result, Category) {
+  using U = typename std::make_unsigned<T>::type;
+  return saturation_if(static_cast<U>(static_cast<U>(x) - static_cast<U>(y))
+                       != static_cast<U>(result),
+                       result);
+}
+
+// sub(x, y) of integral types for y known before x.
+// Differences saturate just when x is out of the range
+// [lowest + y, max + y], so x is clamped into it
+// and subtracted without overflow.
+template <typename T>
+class sub_bounds {
+ public:
+  constexpr explicit sub_bounds(T y)
+      : y_(y),
+        lowest_x_(csignbit(y)
+                  ? std::numeric_limits<T>::lowest()
+                  : static_cast<T>(std::numeric_limits<T>::lowest() + y)),
+        max_x_(csignbit(y)
+               ? static_cast<T>(std::numeric_limits<T>::max() + y)
+               : std::numeric_limits<T>::max()) {
+  }
+
+  constexpr T operator()(T x) const {
+    return static_cast<T>(((x < lowest_x_)
+                           ? lowest_x_
+                           : ((x > max_x_) ? max_x_ : x))
+                          - y_);
+  }
+
+ private:
+  T y_;
+  T lowest_x_;
+  T max_x_;
+};
+
+#ifdef SATOP_TELEMETRY
+template <typename T>
+constexpr T observe_sub(T result, T x, T y) {
+  return observe(saturation_op::sub, result,
+                 sub_saturation(x, y, result, arithmetic_category<T>()));
+}
+#endif  // SATOP_TELEMETRY
+
 }  // namespace impl
 
 /// @addtogroup libsatop
@@ -70,13 +173,35 @@ constexpr bool is_sub_overflow(T x, T y) {
 /// @return If subtraction results causes overflow, returns max of T.
 ///         If underflow, returns min(lowest) of T.
 ///         If no overflow and no underflow, returns x - y.
+///
+/// @see saturation_snapshot() to count saturations
 template <typename T>
 constexpr T sub(T x, T y) {
-  return (impl::is_sub_underflow(x, y)
-          ? std::numeric_limits<T>::lowest()
-          : (impl::is_sub_overflow(x, y)
-             ? std::numeric_limits<T>::max()
-             : static_cast<T>(x - y)));
+  return SATOP_OBSERVE(sub,
+                       impl::sub(x, y, impl::arithmetic_category<T>()),
+                       x, y);
+}
+
+/// Subtract a constant from a value with saturation.
+///
+/// The range of x whose differences do not saturate is a constant,
+/// so it is compiled into a comparison and a subtraction.
+///
+/// @tparam C A constant to subtract, in the range of T
+/// @tparam T Type of the argument and the return value, integral type
+///
+/// @param x Subtract from this value
+///
+/// @return x - C saturated into the range of T.
+///
+/// @see saturation_snapshot() to count saturations
+template <std::intmax_t C, typename T>
+constexpr T sub(T x) {
+  static_assert(std::is_integral<T>::value,
+                "sub<C> supports only integral types");
+  static_assert(impl::is_in_range<T>(C), "C must be in the range of T");
+  return SATOP_OBSERVE(sub, impl::sub_bounds<T>(static_cast<T>(C))(x),
+                       x, static_cast<T>(C));
 }
 
 /// @}
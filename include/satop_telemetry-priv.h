@@ -0,0 +1,374 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_TELEMETRY_PRIV_H_
+#define INCLUDE_SATOP_TELEMETRY_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+// Operations skip counting in constant evaluation,
+// which is detected by the builtin of compilers.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define SATOP_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(SATOP_IS_CONSTANT_EVALUATED) \
+    && ((defined(__GNUC__) && (__GNUC__ >= 9)) \
+        || (defined(_MSC_VER) && (_MSC_VER >= 1925)))
+#define SATOP_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+// Saturations are counted only if SATOP_TELEMETRY is defined,
+// and it must be defined in all translation units or none of them.
+// Otherwise operations are compiled into the same code as before.
+#ifdef SATOP_TELEMETRY
+#ifndef SATOP_IS_CONSTANT_EVALUATED
+#error SATOP_TELEMETRY needs __builtin_is_constant_evaluated()
+#endif
+#define SATOP_OBSERVE(op, result, ...) \
+  ::saturated::impl::observe_##op((result), __VA_ARGS__)
+#else
+#define SATOP_OBSERVE(op, result, ...) (result)
+#endif
+
+// Without the builtin, counting operations can not be constant evaluated.
+#ifndef SATOP_IS_CONSTANT_EVALUATED
+#define SATOP_IS_CONSTANT_EVALUATED() false
+#endif
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Operations whose saturations are counted.
+enum class saturation_op : int {
+  add,      ///< add()
+  sub,      ///< sub()
+  mul,      ///< mul()
+  div,      ///< div()
+  mul_add,  ///< mul_add()
+  mul_div,  ///< mul_div()
+  neg,      ///< neg()
+  abs,      ///< abs()
+  shl,      ///< shl()
+};
+
+/// Directions of saturation.
+enum class saturation_direction : int {
+  overflow,   ///< Saturated into max
+  underflow,  ///< Saturated into lowest
+};
+
+/// Numbers of saturations by operation and direction.
+///
+/// They are counted for integral types
+/// only if SATOP_TELEMETRY is defined before including satop.h,
+/// or by operations with report policy.
+class saturation_counts {
+ public:
+  /// Construct counts of 0.
+  constexpr saturation_counts()
+      : counts_{} {
+  }
+
+  /// @param op        An operation
+  /// @param direction A direction of saturation
+  ///
+  /// @return Number of saturations of op in direction
+  uint64_t count(saturation_op op, saturation_direction direction) const {
+    return counts_[static_cast<int>(op)][static_cast<int>(direction)];
+  }
+
+  /// @return Number of saturations of all operations in all directions
+  uint64_t total() const {
+    uint64_t sum = 0;
+    for (const auto& directions : counts_) {
+      for (const uint64_t count : directions) {
+        sum += count;
+      }
+    }
+    return sum;
+  }
+
+  /// Add saturations.
+  ///
+  /// @param op        An operation
+  /// @param direction A direction of saturation
+  /// @param n         Number of saturations to add
+  void record(saturation_op op, saturation_direction direction, uint64_t n) {
+    counts_[static_cast<int>(op)][static_cast<int>(direction)] += n;
+  }
+
+  /// Aggregate counts, such as ones of other threads.
+  ///
+  /// @param other Counts to add
+  ///
+  /// @return This object
+  saturation_counts& operator+=(const saturation_counts& other) {
+    for (int op = 0; op < kOps; ++op) {
+      for (int direction = 0; direction < kDirections; ++direction) {
+        counts_[op][direction] += other.counts_[op][direction];
+      }
+    }
+    return *this;
+  }
+
+ private:
+  static constexpr int kOps = static_cast<int>(saturation_op::shl) + 1;
+  static constexpr int kDirections =
+      static_cast<int>(saturation_direction::underflow) + 1;
+
+  uint64_t counts_[kOps][kDirections];
+};
+
+/// @}
+
+namespace impl {
+
+// Counts of each thread.  Only the thread writes them, so they are
+// added without atomic read-modify-write, but they are atomic
+// to be read by saturation_aggregate() in other threads.
+class thread_counts {
+ public:
+  thread_counts();
+  ~thread_counts();
+
+  thread_counts(const thread_counts&) = delete;
+  thread_counts& operator=(const thread_counts&) = delete;
+
+  void record(saturation_op op, saturation_direction direction, uint64_t n) {
+    std::atomic<uint64_t>& count =
+        counts_[static_cast<int>(op)][static_cast<int>(direction)];
+    count.store(count.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+  }
+
+  saturation_counts snapshot() const {
+    saturation_counts counts;
+    for (int op = 0; op < kOps; ++op) {
+      for (int direction = 0; direction < kDirections; ++direction) {
+        counts.record(static_cast<saturation_op>(op),
+                      static_cast<saturation_direction>(direction),
+                      counts_[op][direction].load(std::memory_order_relaxed));
+      }
+    }
+    return counts;
+  }
+
+  uint64_t total() const {
+    uint64_t sum = 0;
+    for (const auto& directions : counts_) {
+      for (const std::atomic<uint64_t>& count : directions) {
+        sum += count.load(std::memory_order_relaxed);
+      }
+    }
+    return sum;
+  }
+
+  void reset() {
+    for (auto& directions : counts_) {
+      for (std::atomic<uint64_t>& count : directions) {
+        count.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  static constexpr int kOps = static_cast<int>(saturation_op::shl) + 1;
+  static constexpr int kDirections =
+      static_cast<int>(saturation_direction::underflow) + 1;
+
+  std::atomic<uint64_t> counts_[kOps][kDirections];
+};
+
+// Counts of live threads, and ones folded in at exit of threads.
+struct saturation_registry {
+  saturation_registry()
+      : mutex(), threads(), exited() {
+  }
+
+  std::mutex mutex;
+  std::vector<const thread_counts*> threads;
+  saturation_counts exited;
+};
+
+// The registry is constructed before counts of any thread,
+// so that it is destructed after them.
+inline saturation_registry& global_saturation_registry() {
+  static saturation_registry registry;
+  return registry;
+}
+
+inline thread_counts::thread_counts()
+    : counts_() {
+  saturation_registry& registry = global_saturation_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.threads.push_back(this);
+}
+
+inline thread_counts::~thread_counts() {
+  saturation_registry& registry = global_saturation_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.exited += snapshot();
+  registry.threads.erase(std::find(registry.threads.begin(),
+                                   registry.threads.end(),
+                                   this));
+}
+
+// Counts of the calling thread, as a static member of a class template
+// to be defined in headers.  Its initialization is in the wrapper
+// generated by compilers, out of callers.
+template <typename Tag = void>
+struct thread_counts_holder {
+  static thread_local thread_counts counts;
+};
+
+template <typename Tag>
+thread_local thread_counts thread_counts_holder<Tag>::counts;
+
+inline thread_counts& thread_saturation_counts() {
+  return thread_counts_holder<>::counts;
+}
+
+// Whether and in which direction a result is saturated.
+enum class saturation_kind : int {
+  none,
+  overflow,
+  underflow,
+};
+
+// Kind of saturation of result which is max or lowest of T if saturated.
+template <typename T>
+constexpr saturation_kind saturation_if(bool saturated, T result) {
+  return (!saturated
+          ? saturation_kind::none
+          : ((result == std::numeric_limits<T>::max())
+             ? saturation_kind::overflow
+             : saturation_kind::underflow));
+}
+
+// Numbers of saturations of elements in batch operations.
+struct saturation_tally {
+  uint64_t overflow;
+  uint64_t underflow;
+
+  void add(saturation_kind kind) {
+    overflow += (kind == saturation_kind::overflow) ? 1 : 0;
+    underflow += (kind == saturation_kind::underflow) ? 1 : 0;
+  }
+};
+
+inline void record_saturations(saturation_op op,
+                               const saturation_tally& tally) {
+  thread_counts& counts = thread_saturation_counts();
+  counts.record(op, saturation_direction::overflow, tally.overflow);
+  counts.record(op, saturation_direction::underflow, tally.underflow);
+}
+
+template <typename T>
+T record_saturation(saturation_op op, T result, saturation_kind kind) {
+  if (kind != saturation_kind::none) {
+    thread_saturation_counts().record(
+        op,
+        ((kind == saturation_kind::overflow)
+         ? saturation_direction::overflow
+         : saturation_direction::underflow),
+        1);
+  }
+  return result;
+}
+
+// Count saturation of result of op unless it is constant evaluation.
+template <typename T>
+constexpr T observe(saturation_op op, T result, saturation_kind kind) {
+  return (SATOP_IS_CONSTANT_EVALUATED()
+          ? result
+          : record_saturation(op, result, kind));
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// @return true if saturations are counted, by SATOP_TELEMETRY
+constexpr bool is_saturation_counted() {
+#ifdef SATOP_TELEMETRY
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// Get counts of saturations in the calling thread since the last reset.
+///
+/// Counts of threads can be aggregated by saturation_counts::operator+=(),
+/// or by saturation_aggregate().
+///
+/// @return A copy of counts of the calling thread
+inline saturation_counts saturation_snapshot() {
+  return impl::thread_saturation_counts().snapshot();
+}
+
+/// Get counts of saturations in all threads, including exited ones.
+///
+/// Counts of each thread are since its last reset,
+/// and counts of running threads may be being updated.
+///
+/// @return Sum of counts of all threads
+inline saturation_counts saturation_aggregate() {
+  impl::saturation_registry& registry = impl::global_saturation_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  saturation_counts counts = registry.exited;
+  for (const impl::thread_counts* thread : registry.threads) {
+    counts += thread->snapshot();
+  }
+  return counts;
+}
+
+/// Sticky flag of saturation, as status registers of DSPs.
+///
+/// @return true if any saturation is counted in the calling thread
+///         since the last reset
+inline bool saturation_occurred() {
+  return (impl::thread_saturation_counts().total() != 0);
+}
+
+/// Reset counts of saturations of the calling thread into 0.
+inline void reset_saturation_counts() {
+  impl::thread_saturation_counts().reset();
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_TELEMETRY_PRIV_H_
@@ -0,0 +1,460 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_VIEW_PRIV_H_
+#define INCLUDE_SATOP_VIEW_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#include "satop_batch-priv.h"
+#include "satop_div-priv.h"
+
+namespace saturated {
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// View of elements which are stride elements apart,
+/// which does not own them.
+///
+/// It is a column of a matrix or a channel of interleaved channels,
+/// such as strided_view<int16_t>{samples + 1, n, 2}
+/// for the right channel of stereo samples.
+///
+/// @tparam T Type of elements, which may be const
+template <typename T>
+struct strided_view {
+  T* data;                ///< The first element
+  std::size_t size;       ///< Number of elements
+  std::ptrdiff_t stride;  ///< Elements from an element to the next one,
+                          ///< it may be 0 or negative
+
+  /// Read only view of the same elements.
+  template <typename U,
+            typename std::enable_if<std::is_same<U, const T>::value
+                                    && !std::is_const<T>::value,
+                                    bool>::type = true>
+  operator strided_view<U>() const {
+    return strided_view<U>{data, size, stride};
+  }
+};
+
+/// View of a matrix which does not own its elements,
+/// like std::mdspan with std::layout_stride.
+///
+/// Element (row, col) is data[row * row_stride + col * col_stride],
+/// so a row major matrix whose rows are padded to ld elements is
+/// {data, rows, cols, ld, 1}, and its transposed matrix is
+/// {data, cols, rows, 1, ld}.
+///
+/// @tparam T Type of elements, which may be const
+template <typename T>
+struct matrix_view {
+  T* data;                    ///< Element (0, 0)
+  std::size_t rows;           ///< Number of rows
+  std::size_t cols;           ///< Number of columns
+  std::ptrdiff_t row_stride;  ///< Elements from a row to the next row
+  std::ptrdiff_t col_stride;  ///< Elements from a column to the next column
+
+  /// Read only view of the same matrix.
+  template <typename U,
+            typename std::enable_if<std::is_same<U, const T>::value
+                                    && !std::is_const<T>::value,
+                                    bool>::type = true>
+  operator matrix_view<U>() const {
+    return matrix_view<U>{data, rows, cols, row_stride, col_stride};
+  }
+};
+
+/// @}
+
+namespace impl {
+
+// Type of parameters whose template arguments are deduced
+// from other parameters, so that views of T are converted
+// into views of const T.
+template <typename T>
+struct identity {
+  using type = T;
+};
+
+template <typename T>
+using non_deduced = typename identity<T>::type;
+
+template <typename T>
+matrix_view<T> as_matrix(const strided_view<T>& x) {
+  return matrix_view<T>{x.data, 1, x.size, 0, x.stride};
+}
+
+template <typename T>
+matrix_view<T> transposed(const matrix_view<T>& x) {
+  return matrix_view<T>{x.data, x.cols, x.rows, x.col_stride, x.row_stride};
+}
+
+template <typename T>
+T* element_of(const matrix_view<T>& x, std::size_t row, std::size_t col) {
+  return x.data + static_cast<std::ptrdiff_t>(row) * x.row_stride
+      + static_cast<std::ptrdiff_t>(col) * x.col_stride;
+}
+
+// Elements of a tile are processed row by row.  Each row of a tile
+// is a cache line of elements, and each column of a tile is short
+// enough to be gathered into buffers on stack, so lines of operands
+// whose columns are contiguous stay in L1 cache across rows of a tile.
+constexpr std::size_t kTileCols = 256;
+
+template <typename T>
+constexpr std::size_t tile_rows() {
+  return (sizeof(T) < 64) ? (64 / sizeof(T)) : 1;
+}
+
+// Contiguous elements of x, or copies of them in buffer.
+template <typename T>
+const T* gather(const T* x, std::ptrdiff_t stride, std::size_t n,
+                T* buffer) {
+  if (stride == 1) {
+    return x;
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    buffer[i] = x[static_cast<std::ptrdiff_t>(i) * stride];
+  }
+  return buffer;
+}
+
+template <typename T>
+void scatter(const T* buffer, std::size_t n, T* out, std::ptrdiff_t stride) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[static_cast<std::ptrdiff_t>(i) * stride] = buffer[i];
+  }
+}
+
+// Batch operations on contiguous elements for apply_views().
+template <typename Op>
+struct view_kernel;
+
+template <>
+struct view_kernel<add_op> {
+  template <typename T>
+  void operator()(const T* const* in, T* out, std::size_t n) const {
+    batch<add_op>(in[0], in[1], out, n);
+  }
+};
+
+template <>
+struct view_kernel<sub_op> {
+  template <typename T>
+  void operator()(const T* const* in, T* out, std::size_t n) const {
+    batch<sub_op>(in[0], in[1], out, n);
+  }
+};
+
+template <>
+struct view_kernel<mul_op> {
+  template <typename T>
+  void operator()(const T* const* in, T* out, std::size_t n) const {
+    batch<mul_op>(in[0], in[1], out, n);
+  }
+};
+
+template <>
+struct view_kernel<mul_add_op> {
+  template <typename T>
+  void operator()(const T* const* in, T* out, std::size_t n) const {
+    batch<mul_add_op>(in[0], in[1], in[2], out, n);
+  }
+};
+
+// Magic numbers of the divisor are calculated once for all elements.
+template <typename T>
+struct divide_kernel_of {
+  explicit divide_kernel_of(T divisor)
+      : y(divisor) {
+  }
+
+  void operator()(const T* const* in, T* out, std::size_t n) const {
+    divide_with(saturate(), in[0], y, out, n);
+  }
+
+  divider<T> y;
+};
+
+// Apply kernel to elements of views.
+// The inner loop runs along the dimension whose stride of out is 1,
+// and rows whose columns are contiguous in all views are passed
+// to kernel as they are, otherwise they are processed tile by tile.
+template <typename T, std::size_t N, typename Kernel>
+void apply_views(const Kernel& kernel,
+                 std::array<matrix_view<const T>, N> in,
+                 matrix_view<T> out) {
+  if ((out.col_stride != 1)
+      && ((out.row_stride == 1)
+          || ((in[0].col_stride != 1) && (in[0].row_stride == 1)))) {
+    for (auto& x : in) {
+      x = transposed(x);
+    }
+    out = transposed(out);
+  }
+
+  const T* rows[N];
+  bool contiguous = (out.col_stride == 1);
+  for (const auto& x : in) {
+    contiguous = contiguous && (x.col_stride == 1);
+  }
+  if (contiguous) {
+    for (std::size_t row = 0; row < out.rows; ++row) {
+      for (std::size_t i = 0; i < N; ++i) {
+        rows[i] = element_of(in[i], row, 0);
+      }
+      kernel(rows, element_of(out, row, 0), out.cols);
+    }
+    return;
+  }
+
+  T buffers[N + 1][kTileCols];
+  for (std::size_t row0 = 0; row0 < out.rows; row0 += tile_rows<T>()) {
+    const std::size_t row1 = std::min(out.rows, row0 + tile_rows<T>());
+    for (std::size_t col = 0; col < out.cols; col += kTileCols) {
+      const std::size_t n = std::min(kTileCols, out.cols - col);
+      for (std::size_t row = row0; row < row1; ++row) {
+        for (std::size_t i = 0; i < N; ++i) {
+          rows[i] = gather(element_of(in[i], row, col), in[i].col_stride, n,
+                           buffers[i]);
+        }
+        T* const dst = element_of(out, row, col);
+        if (out.col_stride == 1) {
+          kernel(rows, dst, n);
+        } else {
+          kernel(rows, buffers[N], n);
+          scatter(buffers[N], n, dst, out.col_stride);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace impl
+
+/// @addtogroup libsatop
+///
+/// @{
+
+/// Add elements of 2 strided views with saturation.
+///
+/// Sizes of x and y must be the same as out.
+/// out may be the same view as x or y, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Elements to add
+/// @param y   Elements to add
+/// @param out Elements to store add(x[i], y[i]) into
+template <typename T>
+void add(const impl::non_deduced<strided_view<const T>>& x,
+         const impl::non_deduced<strided_view<const T>>& y,
+         const strided_view<T>& out) {
+  impl::apply_views<T, 2>(impl::view_kernel<impl::add_op>(),
+                          {{impl::as_matrix(x), impl::as_matrix(y)}},
+                          impl::as_matrix(out));
+}
+
+/// Add elements of 2 matrices with saturation.
+///
+/// Rows whose columns are contiguous are processed
+/// by the widest available instruction set without copies,
+/// and others are processed tile by tile through buffers.
+/// Sizes of x and y must be the same as out.
+/// out may be the same view as x or y, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   A matrix to add
+/// @param y   A matrix to add
+/// @param out A matrix to store add(x, y) of each element into
+template <typename T>
+void add(const impl::non_deduced<matrix_view<const T>>& x,
+         const impl::non_deduced<matrix_view<const T>>& y,
+         const matrix_view<T>& out) {
+  impl::apply_views<T, 2>(impl::view_kernel<impl::add_op>(), {{x, y}}, out);
+}
+
+/// Subtract elements of a strided view from another one with saturation.
+///
+/// Sizes of x and y must be the same as out.
+/// out may be the same view as x or y, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Elements to subtract from
+/// @param y   Elements to subtract
+/// @param out Elements to store sub(x[i], y[i]) into
+template <typename T>
+void sub(const impl::non_deduced<strided_view<const T>>& x,
+         const impl::non_deduced<strided_view<const T>>& y,
+         const strided_view<T>& out) {
+  impl::apply_views<T, 2>(impl::view_kernel<impl::sub_op>(),
+                          {{impl::as_matrix(x), impl::as_matrix(y)}},
+                          impl::as_matrix(out));
+}
+
+/// Subtract elements of a matrix from another one with saturation.
+///
+/// Sizes of x and y must be the same as out.
+/// out may be the same view as x or y, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   A matrix to subtract from
+/// @param y   A matrix to subtract
+/// @param out A matrix to store sub(x, y) of each element into
+template <typename T>
+void sub(const impl::non_deduced<matrix_view<const T>>& x,
+         const impl::non_deduced<matrix_view<const T>>& y,
+         const matrix_view<T>& out) {
+  impl::apply_views<T, 2>(impl::view_kernel<impl::sub_op>(), {{x, y}}, out);
+}
+
+/// Multiply elements of 2 strided views with saturation.
+///
+/// Sizes of x and y must be the same as out.
+/// out may be the same view as x or y, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Elements to multiply
+/// @param y   Elements to multiply
+/// @param out Elements to store mul(x[i], y[i]) into
+template <typename T>
+void mul(const impl::non_deduced<strided_view<const T>>& x,
+         const impl::non_deduced<strided_view<const T>>& y,
+         const strided_view<T>& out) {
+  impl::apply_views<T, 2>(impl::view_kernel<impl::mul_op>(),
+                          {{impl::as_matrix(x), impl::as_matrix(y)}},
+                          impl::as_matrix(out));
+}
+
+/// Multiply elements of 2 matrices with saturation.
+///
+/// Sizes of x and y must be the same as out.
+/// out may be the same view as x or y, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   A matrix to multiply
+/// @param y   A matrix to multiply
+/// @param out A matrix to store mul(x, y) of each element into
+template <typename T>
+void mul(const impl::non_deduced<matrix_view<const T>>& x,
+         const impl::non_deduced<matrix_view<const T>>& y,
+         const matrix_view<T>& out) {
+  impl::apply_views<T, 2>(impl::view_kernel<impl::mul_op>(), {{x, y}}, out);
+}
+
+/// Divide elements of a strided view by a value with saturation.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x   Elements to be divided
+/// @param y   A value to divide each element of x by, it may be 0
+/// @param out Elements to store div(x[i], y) into,
+///            which may be the same view as x
+template <typename T>
+void div(const impl::non_deduced<strided_view<const T>>& x, T y,
+         const strided_view<T>& out) {
+  impl::apply_views<T, 1>(impl::divide_kernel_of<T>(y),
+                          {{impl::as_matrix(x)}}, impl::as_matrix(out));
+}
+
+/// Divide elements of a matrix by a value with saturation.
+///
+/// @tparam T Type of elements, integral type whose width is up to 32 bits
+///
+/// @param x   A matrix to be divided
+/// @param y   A value to divide each element of x by, it may be 0
+/// @param out A matrix to store div(x, y) of each element into,
+///            which may be the same view as x
+template <typename T>
+void div(const impl::non_deduced<matrix_view<const T>>& x, T y,
+         const matrix_view<T>& out) {
+  impl::apply_views<T, 1>(impl::divide_kernel_of<T>(y), {{x}}, out);
+}
+
+/// Multiply elements of 2 strided views and add another one
+/// with saturation only at the end.
+///
+/// Sizes of x, y and z must be the same as out.
+/// out may be the same view as x, y or z, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   Elements to multiply
+/// @param y   Elements to multiply
+/// @param z   Elements to add
+/// @param out Elements to store mul_add(x[i], y[i], z[i]) into
+template <typename T>
+void mul_add(const impl::non_deduced<strided_view<const T>>& x,
+             const impl::non_deduced<strided_view<const T>>& y,
+             const impl::non_deduced<strided_view<const T>>& z,
+             const strided_view<T>& out) {
+  impl::apply_views<T, 3>(impl::view_kernel<impl::mul_add_op>(),
+                          {{impl::as_matrix(x), impl::as_matrix(y),
+                            impl::as_matrix(z)}},
+                          impl::as_matrix(out));
+}
+
+/// Multiply elements of 2 matrices and add another one
+/// with saturation only at the end.
+///
+/// Sizes of x, y and z must be the same as out.
+/// out may be the same view as x, y or z, but must not overlap them
+/// otherwise.
+///
+/// @tparam T Type of elements
+///
+/// @param x   A matrix to multiply
+/// @param y   A matrix to multiply
+/// @param z   A matrix to add
+/// @param out A matrix to store mul_add(x, y, z) of each element into
+template <typename T>
+void mul_add(const impl::non_deduced<matrix_view<const T>>& x,
+             const impl::non_deduced<matrix_view<const T>>& y,
+             const impl::non_deduced<matrix_view<const T>>& z,
+             const matrix_view<T>& out) {
+  impl::apply_views<T, 3>(impl::view_kernel<impl::mul_add_op>(), {{x, y, z}},
+                          out);
+}
+
+/// @}
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_VIEW_PRIV_H_
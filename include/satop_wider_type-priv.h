@@ -0,0 +1,124 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCLUDE_SATOP_WIDER_TYPE_PRIV_H_
+#define INCLUDE_SATOP_WIDER_TYPE_PRIV_H_
+
+#ifndef SATOP_INTERNAL
+#error Do not include this file directly, libsatop.h instead.
+#endif
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// 128 bits integers are available as wider type of 64 bits types
+// on g++ and clang for 64 bits targets.
+#if defined(__SIZEOF_INT128__)
+#define SATOP_HAS_INT128
+#endif
+
+namespace saturated {
+
+namespace impl {
+
+#ifdef SATOP_HAS_INT128
+// __extension__ suppresses warnings of -Wpedantic for __int128.
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+#endif  // SATOP_HAS_INT128
+
+// Native integer type which can hold any sum, difference or product
+// of 2 values of T without overflow.
+// It has no member "type" if there is no such type for T.
+template <typename T, typename Enable = void>
+struct wider_type {
+};
+
+template <typename T>
+struct wider_type<
+  T,
+  typename std::enable_if<std::is_integral<T>::value
+                          && (sizeof(T) < sizeof(int32_t))>::type> {
+  using type = typename std::conditional<std::is_signed<T>::value,
+                                         int32_t,
+                                         uint32_t>::type;
+};
+
+template <typename T>
+struct wider_type<
+  T,
+  typename std::enable_if<std::is_integral<T>::value
+                          && (sizeof(T) == sizeof(int32_t))>::type> {
+  using type = typename std::conditional<std::is_signed<T>::value,
+                                         int64_t,
+                                         uint64_t>::type;
+};
+
+#ifdef SATOP_HAS_INT128
+template <typename T>
+struct wider_type<
+  T,
+  typename std::enable_if<std::is_integral<T>::value
+                          && (sizeof(T) == sizeof(int64_t))>::type> {
+  using type = typename std::conditional<std::is_signed<T>::value,
+                                         int128_t,
+                                         uint128_t>::type;
+};
+#endif  // SATOP_HAS_INT128
+
+template <typename T, typename Enable = void>
+struct has_wider_type : public std::false_type {
+};
+
+template <typename T>
+struct has_wider_type<
+  T,
+  typename std::conditional<false,
+                            typename wider_type<T>::type,
+                            void>::type> : public std::true_type {
+};
+
+template <typename T, typename W>
+constexpr W clamp_lowest(W value) {
+  return ((value < static_cast<W>(std::numeric_limits<T>::lowest()))
+          ? static_cast<W>(std::numeric_limits<T>::lowest())
+          : value);
+}
+
+template <typename T, typename W>
+constexpr W clamp_max(W value) {
+  return ((value > static_cast<W>(std::numeric_limits<T>::max()))
+          ? static_cast<W>(std::numeric_limits<T>::max())
+          : value);
+}
+
+// Convert wide value into T, clamping it into the range of T.
+// Lower and upper bounds are applied as independent selections
+// instead of nested conditional, so compilers can generate them
+// as conditional moves (or min/max instructions) without branches.
+template <typename T, typename W>
+constexpr T clamp_cast(W value) {
+  return static_cast<T>(clamp_max<T>(clamp_lowest<T>(value)));
+}
+
+}  // namespace impl
+
+}  // namespace saturated
+
+#endif  // INCLUDE_SATOP_WIDER_TYPE_PRIV_H_
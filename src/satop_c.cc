@@ -0,0 +1,127 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+// Functions of satop_c.h which instantiate operations of satop.h.
+// Batch operations are dispatched at runtime as in C++ programs.
+
+#define SATOP_C_BUILD
+
+#include "satop_c.h"
+
+#include <type_traits>
+
+#include "satop.h"
+
+static_assert(static_cast<int>(saturated::simd_level::scalar)
+              == SATOP_SIMD_SCALAR, "Mismatch of satop_simd_level");
+static_assert(static_cast<int>(saturated::simd_level::sse2)
+              == SATOP_SIMD_SSE2, "Mismatch of satop_simd_level");
+static_assert(static_cast<int>(saturated::simd_level::avx2)
+              == SATOP_SIMD_AVX2, "Mismatch of satop_simd_level");
+static_assert(static_cast<int>(saturated::simd_level::avx512bw)
+              == SATOP_SIMD_AVX512BW, "Mismatch of satop_simd_level");
+
+namespace {
+
+// divider supports types up to 32 bits,
+// so 64 bits types are divided element by element.
+template <typename T>
+typename std::enable_if<(sizeof(T) <= 4)>::type
+divide(const T* x, T y, T* out, size_t n) {
+  saturated::div(x, y, out, n);
+}
+
+template <typename T>
+typename std::enable_if<(sizeof(T) > 4)>::type
+divide(const T* x, T y, T* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = saturated::div(x[i], y);
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+satop_simd_level satop_supported_simd_level(void) {
+  return static_cast<satop_simd_level>(saturated::supported_simd_level());
+}
+
+satop_simd_level satop_current_simd_level(void) {
+  return static_cast<satop_simd_level>(saturated::current_simd_level());
+}
+
+int satop_force_simd_level(satop_simd_level level) {
+  return saturated::force_simd_level(static_cast<saturated::simd_level>(level))
+      ? 1 : 0;
+}
+
+void satop_reset_simd_level(void) {
+  saturated::reset_simd_level();
+}
+
+#define SATOP_C_DEFINE(name, type)                                      \
+  type satop_add_##name(type x, type y) {                               \
+    return saturated::add(x, y);                                        \
+  }                                                                     \
+  type satop_sub_##name(type x, type y) {                               \
+    return saturated::sub(x, y);                                        \
+  }                                                                     \
+  type satop_mul_##name(type x, type y) {                               \
+    return saturated::mul(x, y);                                        \
+  }                                                                     \
+  type satop_div_##name(type x, type y) {                               \
+    return saturated::div(x, y);                                        \
+  }                                                                     \
+  type satop_mul_add_##name(type x, type y, type z) {                   \
+    return saturated::mul_add(x, y, z);                                 \
+  }                                                                     \
+  void satop_add_##name##_batch(const type* x, const type* y,           \
+                                type* out, size_t n) {                  \
+    saturated::add(x, y, out, n);                                       \
+  }                                                                     \
+  void satop_sub_##name##_batch(const type* x, const type* y,           \
+                                type* out, size_t n) {                  \
+    saturated::sub(x, y, out, n);                                       \
+  }                                                                     \
+  void satop_mul_##name##_batch(const type* x, const type* y,           \
+                                type* out, size_t n) {                  \
+    saturated::mul(x, y, out, n);                                       \
+  }                                                                     \
+  void satop_div_##name##_batch(const type* x, type y,                  \
+                                type* out, size_t n) {                  \
+    divide(x, y, out, n);                                               \
+  }                                                                     \
+  void satop_mul_add_##name##_batch(const type* x, const type* y,       \
+                                    const type* z, type* out,           \
+                                    size_t n) {                         \
+    saturated::mul_add(x, y, z, out, n);                                \
+  }
+
+SATOP_C_DEFINE(i8, int8_t)
+SATOP_C_DEFINE(u8, uint8_t)
+SATOP_C_DEFINE(i16, int16_t)
+SATOP_C_DEFINE(u16, uint16_t)
+SATOP_C_DEFINE(i32, int32_t)
+SATOP_C_DEFINE(u32, uint32_t)
+SATOP_C_DEFINE(i64, int64_t)
+SATOP_C_DEFINE(u64, uint64_t)
+
+#undef SATOP_C_DEFINE
+
+}  // extern "C"
@@ -0,0 +1,131 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+// Tests of satop_c.h compiled as C and linked with libsatop.so,
+// for each supported instruction set level.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "satop_c.h"
+
+enum {
+  kNumElements = 131
+};
+
+static int failures = 0;
+
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      fprintf(stderr, "%s:%d: Failure: %s\n", __FILE__, __LINE__,       \
+              #condition);                                              \
+      ++failures;                                                       \
+    }                                                                   \
+  } while (0)
+
+// Pseudo random values to compare batch functions with scalar ones.
+static uint64_t next_random(uint64_t* state) {
+  *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *state >> 11;
+}
+
+// Test functions for integer type "type" with suffix "name"
+// whose range is [lowest, max].
+#define DEFINE_TEST(name, type, lowest, max)                            \
+  static void test_##name(void) {                                       \
+    type x[kNumElements];                                               \
+    type y[kNumElements];                                               \
+    type z[kNumElements];                                               \
+    type out[kNumElements];                                             \
+    uint64_t state = 1;                                                 \
+    int i;                                                              \
+    CHECK(satop_add_##name((max), 1) == (max));                         \
+    CHECK(satop_sub_##name((lowest), 1) == (lowest));                   \
+    CHECK(satop_mul_##name((max), 2) == (max));                         \
+    CHECK(satop_div_##name((max), 0) == (max));                         \
+    CHECK(satop_mul_add_##name(2, 3, 1) == 7);                          \
+    CHECK(satop_mul_add_##name((max), 2, 0) == (max));                  \
+    for (i = 0; i < kNumElements; ++i) {                                \
+      x[i] = (type)next_random(&state);                                 \
+      y[i] = (type)next_random(&state);                                 \
+      z[i] = (type)next_random(&state);                                 \
+    }                                                                   \
+    satop_add_##name##_batch(x, y, out, kNumElements);                  \
+    for (i = 0; i < kNumElements; ++i) {                                \
+      CHECK(out[i] == satop_add_##name(x[i], y[i]));                    \
+    }                                                                   \
+    satop_sub_##name##_batch(x, y, out, kNumElements);                  \
+    for (i = 0; i < kNumElements; ++i) {                                \
+      CHECK(out[i] == satop_sub_##name(x[i], y[i]));                    \
+    }                                                                   \
+    satop_mul_##name##_batch(x, y, out, kNumElements);                  \
+    for (i = 0; i < kNumElements; ++i) {                                \
+      CHECK(out[i] == satop_mul_##name(x[i], y[i]));                    \
+    }                                                                   \
+    satop_div_##name##_batch(x, y[0], out, kNumElements);               \
+    for (i = 0; i < kNumElements; ++i) {                                \
+      CHECK(out[i] == satop_div_##name(x[i], y[0]));                    \
+    }                                                                   \
+    satop_div_##name##_batch(x, 0, out, kNumElements);                  \
+    for (i = 0; i < kNumElements; ++i) {                                \
+      CHECK(out[i] == satop_div_##name(x[i], 0));                       \
+    }                                                                   \
+    satop_mul_add_##name##_batch(x, y, z, out, kNumElements);           \
+    for (i = 0; i < kNumElements; ++i) {                                \
+      CHECK(out[i] == satop_mul_add_##name(x[i], y[i], z[i]));          \
+    }                                                                   \
+  }
+
+DEFINE_TEST(i8, int8_t, INT8_MIN, INT8_MAX)
+DEFINE_TEST(u8, uint8_t, 0, UINT8_MAX)
+DEFINE_TEST(i16, int16_t, INT16_MIN, INT16_MAX)
+DEFINE_TEST(u16, uint16_t, 0, UINT16_MAX)
+DEFINE_TEST(i32, int32_t, INT32_MIN, INT32_MAX)
+DEFINE_TEST(u32, uint32_t, 0, UINT32_MAX)
+DEFINE_TEST(i64, int64_t, INT64_MIN, INT64_MAX)
+DEFINE_TEST(u64, uint64_t, 0, UINT64_MAX)
+
+int main(void) {
+  const satop_simd_level supported = satop_supported_simd_level();
+  int level;
+  CHECK(satop_current_simd_level() == supported);
+  for (level = SATOP_SIMD_SCALAR; level <= (int)supported; ++level) {
+    CHECK(satop_force_simd_level((satop_simd_level)level));
+    CHECK(satop_current_simd_level() == (satop_simd_level)level);
+    test_i8();
+    test_u8();
+    test_i16();
+    test_u16();
+    test_i32();
+    test_u32();
+    test_i64();
+    test_u64();
+  }
+  satop_reset_simd_level();
+  CHECK(satop_current_simd_level() == supported);
+  CHECK(!satop_force_simd_level((satop_simd_level)(SATOP_SIMD_AVX512BW + 1)));
+
+  if (failures != 0) {
+    printf("[  FAILED  ] C API, %d failures\n", failures);
+    return 1;
+  }
+  printf("[  PASSED  ] C API at %d instruction set levels\n",
+         (int)supported + 1);
+  return 0;
+}
@@ -0,0 +1,99 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+// Pairs of functions fused_<name> and manual_<name>
+// which must be compiled into the same instructions.
+// build/check_codegen.sh compares them.
+
+#include <cstdint>
+
+#include "satop.h"
+
+using saturated::integer;
+
+extern "C" {
+
+int16_t fused_mul_add_i16(int16_t a, int16_t b, int16_t c);
+int16_t manual_mul_add_i16(int16_t a, int16_t b, int16_t c);
+int32_t fused_mul_sub_i32(int32_t a, int32_t b, int32_t c);
+int32_t manual_mul_sub_i32(int32_t a, int32_t b, int32_t c);
+uint8_t fused_add_sub_u8(uint8_t a, uint8_t b, uint8_t c);
+uint8_t manual_add_sub_u8(uint8_t a, uint8_t b, uint8_t c);
+int8_t fused_add_i8(int8_t a, int8_t b);
+int8_t manual_add_i8(int8_t a, int8_t b);
+uint32_t fused_sub_u32(uint32_t a, uint32_t b);
+uint32_t manual_sub_u32(uint32_t a, uint32_t b);
+
+// a * b + c of int16_t is evaluated in int32_t and saturated once.
+int16_t fused_mul_add_i16(int16_t a, int16_t b, int16_t c) {
+  return (integer<int16_t>(a) * integer<int16_t>(b)
+          + integer<int16_t>(c)).value();
+}
+
+int16_t manual_mul_add_i16(int16_t a, int16_t b, int16_t c) {
+  int32_t wide = static_cast<int32_t>(a) * b + c;
+  wide = (wide < INT16_MIN) ? INT16_MIN : wide;
+  wide = (wide > INT16_MAX) ? INT16_MAX : wide;
+  return static_cast<int16_t>(wide);
+}
+
+// a * b - c of int32_t is evaluated in int64_t and saturated once.
+int32_t fused_mul_sub_i32(int32_t a, int32_t b, int32_t c) {
+  return (integer<int32_t>(a) * integer<int32_t>(b)
+          - integer<int32_t>(c)).value();
+}
+
+int32_t manual_mul_sub_i32(int32_t a, int32_t b, int32_t c) {
+  int64_t wide = static_cast<int64_t>(a) * b - c;
+  wide = (wide < INT32_MIN) ? INT32_MIN : wide;
+  wide = (wide > INT32_MAX) ? INT32_MAX : wide;
+  return static_cast<int32_t>(wide);
+}
+
+// a + b - c of uint8_t is evaluated in int32_t, so it never wraps.
+uint8_t fused_add_sub_u8(uint8_t a, uint8_t b, uint8_t c) {
+  return (integer<uint8_t>(a) + integer<uint8_t>(b)
+          - integer<uint8_t>(c)).value();
+}
+
+uint8_t manual_add_sub_u8(uint8_t a, uint8_t b, uint8_t c) {
+  int32_t wide = static_cast<int32_t>(a) + b - c;
+  wide = (wide < 0) ? 0 : wide;
+  wide = (wide > UINT8_MAX) ? UINT8_MAX : wide;
+  return static_cast<uint8_t>(wide);
+}
+
+// Single operations are as same as scalar functions.
+int8_t fused_add_i8(int8_t a, int8_t b) {
+  return (integer<int8_t>(a) + integer<int8_t>(b)).value();
+}
+
+int8_t manual_add_i8(int8_t a, int8_t b) {
+  return saturated::add(a, b);
+}
+
+uint32_t fused_sub_u32(uint32_t a, uint32_t b) {
+  integer<uint32_t> x(a);
+  x -= integer<uint32_t>(b);
+  return x.value();
+}
+
+uint32_t manual_sub_u32(uint32_t a, uint32_t b) {
+  return saturated::sub(a, b);
+}
+
+}  // extern "C"
@@ -0,0 +1,482 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+#ifndef SATOP_TELEMETRY
+#error This test must be built with SATOP_TELEMETRY
+#endif
+
+namespace {
+
+using saturated::saturation_direction;
+using saturated::saturation_op;
+
+constexpr const std::size_t kSize = 1000;
+
+uint64_t GetCount(saturation_op op, saturation_direction direction) {
+  return saturated::saturation_snapshot().count(op, direction);
+}
+
+void ExpectSameCounts(const saturated::saturation_counts& expected,
+                      const saturated::saturation_counts& actual) {
+  for (const auto op : {saturation_op::add, saturation_op::sub,
+                        saturation_op::mul, saturation_op::div,
+                        saturation_op::mul_add, saturation_op::mul_div,
+                        saturation_op::neg, saturation_op::abs,
+                        saturation_op::shl}) {
+    for (const auto direction : {saturation_direction::overflow,
+                                 saturation_direction::underflow}) {
+      EXPECT_EQ(expected.count(op, direction), actual.count(op, direction))
+          << "op = " << static_cast<int>(op)
+          << ", direction = " << static_cast<int>(direction);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(SaturationTelemetryTest, Enabled) {
+  static_assert(saturated::is_saturation_counted(),
+                "SATOP_TELEMETRY must enable counting");
+}
+
+template <typename T>
+class SaturationCountTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+
+  void SetUp() override {
+    saturated::reset_saturation_counts();
+  }
+};
+
+using TypesForCountTests = ::testing::Types<int8_t, int16_t, int32_t, int64_t,
+                                            uint8_t, uint16_t, uint32_t,
+                                            uint64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(SaturationCountTest, TypesForCountTests, );  // NOLINT
+
+TYPED_TEST(SaturationCountTest, Overflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kZero(0);
+  constexpr const T kOne(1);
+  constexpr const T kTwo(2);
+  EXPECT_FALSE(saturated::saturation_occurred());
+
+  EXPECT_EQ(kMax, saturated::add(kMax, kOne));
+  EXPECT_EQ(kMax, saturated::add(static_cast<T>(kMax - kOne), kOne));
+  EXPECT_EQ(kMax, saturated::mul(kMax, kTwo));
+  EXPECT_EQ(kMax, saturated::mul(kMax, kOne));
+  EXPECT_EQ(kMax, saturated::div(kMax, kZero));
+  EXPECT_EQ(kZero, saturated::div(kZero, kZero));
+  EXPECT_EQ(kMax, saturated::mul_add(kMax, kTwo, kZero));
+
+  EXPECT_TRUE(saturated::saturation_occurred());
+  EXPECT_EQ(1u, GetCount(saturation_op::add, saturation_direction::overflow));
+  EXPECT_EQ(1u, GetCount(saturation_op::mul, saturation_direction::overflow));
+  EXPECT_EQ(1u, GetCount(saturation_op::div, saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::mul_add, saturation_direction::overflow));
+  EXPECT_EQ(4u, saturated::saturation_snapshot().total());
+
+  saturated::reset_saturation_counts();
+  EXPECT_FALSE(saturated::saturation_occurred());
+  EXPECT_EQ(0u, saturated::saturation_snapshot().total());
+}
+
+TYPED_TEST(SaturationCountTest, Underflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  constexpr const T kOne(1);
+
+  EXPECT_EQ(kLowest, saturated::sub(kLowest, kOne));
+  EXPECT_EQ(static_cast<T>(0), saturated::sub(kOne, kOne));
+
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::sub, saturation_direction::underflow));
+  EXPECT_EQ(1u, saturated::saturation_snapshot().total());
+}
+
+TYPED_TEST(SaturationCountTest, ConstantEvaluation) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kSaturated = saturated::add(kMax, static_cast<T>(1));
+  EXPECT_EQ(kMax, kSaturated);
+  EXPECT_FALSE(saturated::saturation_occurred());
+}
+
+TYPED_TEST(SaturationCountTest, Constant) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+
+  EXPECT_EQ(kMax, saturated::add<1>(kMax));
+  EXPECT_EQ(kMax, saturated::add<0>(kMax));
+  EXPECT_EQ(kLowest, saturated::sub<1>(kLowest));
+  EXPECT_EQ(kMax, saturated::mul<2>(kMax));
+  EXPECT_EQ(kMax, saturated::mul<1>(kMax));
+
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::add, saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::sub, saturation_direction::underflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::mul, saturation_direction::overflow));
+  EXPECT_EQ(3u, saturated::saturation_snapshot().total());
+}
+
+TYPED_TEST(SaturationCountTest, Atomic) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  constexpr const T kOne(1);
+  saturated::atomic<T> value(static_cast<T>(kMax - kOne));
+
+  EXPECT_EQ(static_cast<T>(kMax - kOne), value.fetch_add(kOne));
+  EXPECT_EQ(kMax, value.fetch_add(kOne));
+  value.store(kLowest);
+  EXPECT_EQ(kLowest, value.fetch_sub(kOne));
+
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::add, saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::sub, saturation_direction::underflow));
+  EXPECT_EQ(2u, saturated::saturation_snapshot().total());
+}
+
+template <typename T>
+class SignedSaturationCountTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+
+  void SetUp() override {
+    saturated::reset_saturation_counts();
+  }
+};
+
+using TypesForSignedCountTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                  int64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(SignedSaturationCountTest,
+                 TypesForSignedCountTests, );  // NOLINT
+
+TYPED_TEST(SignedSaturationCountTest, Underflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kOne(1);
+  constexpr const T kMinusOne(-1);
+  constexpr const T kTwo(2);
+
+  EXPECT_EQ(kLowest, saturated::add(kLowest, kMinusOne));
+  EXPECT_EQ(kMax, saturated::sub(kMax, kMinusOne));
+  EXPECT_EQ(kLowest, saturated::mul(kLowest, kTwo));
+  EXPECT_EQ(kMax, saturated::div(kLowest, kMinusOne));
+  EXPECT_EQ(kLowest, saturated::div(kMinusOne, static_cast<T>(0)));
+  EXPECT_EQ(kLowest, saturated::mul_add(kLowest, kOne, kMinusOne));
+
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::add, saturation_direction::underflow));
+  EXPECT_EQ(1u, GetCount(saturation_op::sub, saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::mul, saturation_direction::underflow));
+  EXPECT_EQ(1u, GetCount(saturation_op::div, saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::div, saturation_direction::underflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::mul_add,
+                     saturation_direction::underflow));
+  EXPECT_EQ(6u, saturated::saturation_snapshot().total());
+}
+
+template <typename T>
+class BatchSaturationCountTest
+    : public ::testing::Test {
+ protected:
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+    saturated::reset_saturation_counts();
+  }
+
+  // Counts of batch operations must be the same as ones of
+  // scalar operations for each element on any instruction set.
+  template <typename BatchFunc, typename ScalarFunc>
+  static void TestCounts(BatchFunc batch_func, ScalarFunc scalar_func) {
+    const auto x = GetTestValues<T>(kSize, 0);
+    const auto y = GetTestValues<T>(kSize, 1);
+    saturated::reset_saturation_counts();
+    for (std::size_t i = 0; i < kSize; ++i) {
+      scalar_func(x[i], y[i]);
+    }
+    const auto expected = saturated::saturation_snapshot();
+    EXPECT_TRUE(saturated::saturation_occurred());
+    for (const auto level : GetSupportedLevels()) {
+      SCOPED_TRACE(static_cast<int>(level));
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      saturated::reset_saturation_counts();
+      std::vector<T> out(x);
+      batch_func(x.data(), y.data(), out.data(), kSize);
+      ExpectSameCounts(expected, saturated::saturation_snapshot());
+    }
+  }
+};
+
+using TypesForBatchCountTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                 uint8_t, uint16_t, uint32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(BatchSaturationCountTest,
+                 TypesForBatchCountTests, );  // NOLINT
+
+TYPED_TEST(BatchSaturationCountTest, Add) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestCounts(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::add(x, y, out, n);
+      },
+      [](T x, T y) { saturated::add(x, y); });
+}
+
+// Chunks on other threads are counted into the calling thread.
+TYPED_TEST(BatchSaturationCountTest, AddParallel) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const std::size_t kChunk = (std::size_t{1} << 16) / sizeof(T);
+  constexpr const std::size_t kParallelSize = kChunk * 3 + 5;
+  const auto x = GetTestValues<T>(kParallelSize, 0);
+  const auto y = GetTestValues<T>(kParallelSize, 1);
+  saturated::reset_saturation_counts();
+  for (std::size_t i = 0; i < kParallelSize; ++i) {
+    saturated::add(x[i], y[i]);
+  }
+  const auto expected = saturated::saturation_snapshot();
+  saturated::thread_pool pool(4);
+  saturated::reset_saturation_counts();
+  std::vector<T> out(kParallelSize);
+  saturated::add(saturated::par.on(&pool).with_threshold(1),
+                 x.data(), y.data(), out.data(), kParallelSize);
+  ExpectSameCounts(expected, saturated::saturation_snapshot());
+}
+
+TYPED_TEST(BatchSaturationCountTest, AddInPlace) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestCounts(
+      [](const T*, const T* y, T* out, std::size_t n) {
+        saturated::add(out, y, n);
+      },
+      [](T x, T y) { saturated::add(x, y); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, AddValue) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kValue = std::numeric_limits<T>::max() / 2;
+  TestFixture::TestCounts(
+      [](const T* x, const T*, T* out, std::size_t n) {
+        saturated::add(x, kValue, out, n);
+      },
+      [](T x, T) { saturated::add(x, kValue); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, Sub) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestCounts(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::sub(x, y, out, n);
+      },
+      [](T x, T y) { saturated::sub(x, y); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, Mul) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestCounts(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::mul(x, y, out, n);
+      },
+      [](T x, T y) { saturated::mul(x, y); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, MulValue) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kValue = 3;
+  TestFixture::TestCounts(
+      [](const T* x, const T*, T* out, std::size_t n) {
+        saturated::mul(x, kValue, out, n);
+      },
+      [](T x, T) { saturated::mul(x, kValue); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, MulAdd) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestCounts(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::mul_add(x, y, out, n);
+      },
+      [](T x, T y) { saturated::mul_add(x, y, x); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, Div) {
+  using T = typename TestFixture::test_target_t;
+  for (const auto divisor : {static_cast<T>(0), static_cast<T>(-1)}) {
+    if (divisor == std::numeric_limits<T>::max()) {
+      continue;
+    }
+    TestFixture::TestCounts(
+        [divisor](const T* x, const T*, T* out, std::size_t n) {
+          saturated::div(x, divisor, out, n);
+        },
+        [divisor](T x, T) { saturated::div(x, divisor); });
+  }
+}
+
+TYPED_TEST(BatchSaturationCountTest, Neg) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestCounts(
+      [](const T* x, const T*, T* out, std::size_t n) {
+        saturated::neg(x, out, n);
+      },
+      [](T x, T) { saturated::neg(x); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, Abs) {
+  using T = typename TestFixture::test_target_t;
+  if (!std::is_signed<T>::value) {
+    return;
+  }
+  TestFixture::TestCounts(
+      [](const T* x, const T*, T* out, std::size_t n) {
+        saturated::abs(x, out, n);
+      },
+      [](T x, T) { saturated::abs(x); });
+}
+
+TYPED_TEST(BatchSaturationCountTest, Shl) {
+  using T = typename TestFixture::test_target_t;
+  for (const int shift : {1,
+                          std::numeric_limits<T>::digits,
+                          std::numeric_limits<T>::digits + 1}) {
+    TestFixture::TestCounts(
+        [shift](const T* x, const T*, T* out, std::size_t n) {
+          saturated::shl(x, shift, out, n);
+        },
+        [shift](T x, T) { saturated::shl(x, shift); });
+  }
+}
+
+TEST(SaturationCountsTest, PerThread) {
+  saturated::reset_saturation_counts();
+  saturated::saturation_counts other_thread;
+  std::thread thread([&other_thread]() {
+    saturated::add(static_cast<int8_t>(INT8_MAX), static_cast<int8_t>(1));
+    other_thread = saturated::saturation_snapshot();
+  });
+  thread.join();
+  EXPECT_FALSE(saturated::saturation_occurred());
+  EXPECT_EQ(1u,
+            other_thread.count(saturation_op::add,
+                               saturation_direction::overflow));
+
+  saturated::sub(static_cast<uint8_t>(0), static_cast<uint8_t>(1));
+  saturated::saturation_counts aggregated = saturated::saturation_snapshot();
+  aggregated += other_thread;
+  EXPECT_EQ(1u,
+            aggregated.count(saturation_op::add,
+                             saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            aggregated.count(saturation_op::sub,
+                             saturation_direction::underflow));
+  EXPECT_EQ(2u, aggregated.total());
+  saturated::reset_saturation_counts();
+}
+
+TEST(SaturationCountsTest, Aggregate) {
+  const uint64_t before =
+      saturated::saturation_aggregate().count(saturation_op::add,
+                                              saturation_direction::overflow);
+  std::promise<void> counted;
+  std::promise<void> finish;
+  std::future<void> finished = finish.get_future();
+  std::thread thread([&counted, &finished]() {
+    saturated::add(static_cast<int8_t>(INT8_MAX), static_cast<int8_t>(1));
+    counted.set_value();
+    finished.wait();
+  });
+  counted.get_future().wait();
+  EXPECT_EQ(before + 1,
+            saturated::saturation_aggregate().count(
+                saturation_op::add, saturation_direction::overflow));
+
+  finish.set_value();
+  thread.join();
+  saturated::add(static_cast<int16_t>(INT16_MAX), static_cast<int16_t>(1));
+  EXPECT_EQ(before + 2,
+            saturated::saturation_aggregate().count(
+                saturation_op::add, saturation_direction::overflow));
+  saturated::reset_saturation_counts();
+}
+
+TEST(SaturationCountsTest, FloatingPoint) {
+  saturated::reset_saturation_counts();
+  constexpr const double kMax = std::numeric_limits<double>::max();
+  EXPECT_DOUBLE_EQ(kMax, saturated::add(kMax, kMax));
+  EXPECT_DOUBLE_EQ(-kMax, saturated::mul(kMax, -2.0));
+  EXPECT_DOUBLE_EQ(2.0, saturated::div(4.0, 2.0));
+  EXPECT_EQ(1u, GetCount(saturation_op::add, saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::mul, saturation_direction::underflow));
+  EXPECT_EQ(2u, saturated::saturation_snapshot().total());
+  saturated::reset_saturation_counts();
+}
+
+TEST(SaturationCountsTest, MulDiv) {
+  saturated::reset_saturation_counts();
+  constexpr const int32_t kMax = std::numeric_limits<int32_t>::max();
+  EXPECT_EQ(kMax, saturated::mul_div(kMax, kMax, kMax));
+  EXPECT_EQ(kMax, saturated::mul_div(kMax, kMax, 2));
+  EXPECT_EQ(std::numeric_limits<int32_t>::lowest(),
+            saturated::mul_div(-1, 1, 0));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::mul_div, saturation_direction::overflow));
+  EXPECT_EQ(1u,
+            GetCount(saturation_op::mul_div, saturation_direction::underflow));
+  EXPECT_EQ(2u, saturated::saturation_snapshot().total());
+  saturated::reset_saturation_counts();
+}
@@ -17,12 +17,52 @@
 // along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstdint>
+#include <initializer_list>
 #include <limits>
+#include <type_traits>
+#include <vector>
 
 #include "gtest_compat.h"
 
 #include "satop.h"
 
+namespace {
+
+// Values around bases, which wrap around at edges of T.
+template <typename T>
+std::vector<T> GetValuesAround(std::initializer_list<T> bases) {
+  using U = typename std::make_unsigned<T>::type;
+  std::vector<T> values;
+  for (const T base : bases) {
+    for (int offset = -2; offset <= 2; ++offset) {
+      values.push_back(static_cast<T>(static_cast<U>(
+          static_cast<U>(base) + static_cast<U>(offset))));
+    }
+  }
+  return values;
+}
+
+// Add<C>(x) is the same as add(x, C) around edges of T
+// and around x whose sums saturate.
+template <std::intmax_t C, typename T>
+void ExpectConstantAdd() {
+  using Limits = std::numeric_limits<T>;
+  using U = typename std::make_unsigned<T>::type;
+  constexpr const T kC = static_cast<T>(C);
+  for (const T x : GetValuesAround<T>({
+           Limits::lowest(), T(0), Limits::max(),
+           static_cast<T>(static_cast<U>(Limits::max())
+                          - static_cast<U>(kC)),
+           static_cast<T>(static_cast<U>(Limits::lowest())
+                          - static_cast<U>(kC))
+       })) {
+    EXPECT_EQ(saturated::add(x, kC), saturated::add<C>(x))
+        << "x = " << +x << ", C = " << C;
+  }
+}
+
+}  // namespace
+
 template <typename T>
 class AddOverflowTest
     : public ::testing::Test {
@@ -32,7 +72,8 @@ class AddOverflowTest
 };
 
 using TypesForOverflowTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
-                                               int8_t, int16_t, int32_t>;
+                                               int8_t, int16_t, int32_t,
+                                               uint64_t, int64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
@@ -56,6 +97,16 @@ TYPED_TEST(AddOverflowTest, NotOverflow) {
   EXPECT_EQ(x + y, saturated::add(y, x));
 }
 
+TYPED_TEST(AddOverflowTest, Constant) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kSaturated = saturated::add<1>(TestFixture::Limits::max());
+  EXPECT_EQ(TestFixture::Limits::max(), kSaturated);
+  ExpectConstantAdd<0, T>();
+  ExpectConstantAdd<1, T>();
+  ExpectConstantAdd<3, T>();
+  ExpectConstantAdd<std::numeric_limits<int8_t>::max(), T>();
+}
+
 template <typename T>
 class AddSignedUnderflowTest
     : public ::testing::Test {
@@ -64,7 +115,8 @@ class AddSignedUnderflowTest
   using test_target_t = T;
 };
 
-using TypesForSignedUnderflowTests = ::testing::Types<int8_t, int16_t, int32_t>;
+using TypesForSignedUnderflowTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                      int64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
@@ -86,6 +138,16 @@ TYPED_TEST(AddSignedUnderflowTest, NotUnderflow) {
       saturated::add(kMinusOne, kMinusOne));
 }
 
+TYPED_TEST(AddSignedUnderflowTest, Constant) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kSaturated =
+      saturated::add<-1>(TestFixture::Limits::lowest());
+  EXPECT_EQ(TestFixture::Limits::lowest(), kSaturated);
+  ExpectConstantAdd<-1, T>();
+  ExpectConstantAdd<-3, T>();
+  ExpectConstantAdd<std::numeric_limits<int8_t>::lowest(), T>();
+}
+
 template <typename T>
 class AddUnsignedUnderflowTest
     : public ::testing::Test {
@@ -95,7 +157,7 @@ class AddUnsignedUnderflowTest
 };
 
 using TypesForUnsignedUnderflowTests =
-    ::testing::Types<uint8_t, uint16_t, uint32_t>;
+    ::testing::Types<uint8_t, uint16_t, uint32_t, uint64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
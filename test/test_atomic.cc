@@ -0,0 +1,180 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "gtest_compat.h"
+
+#include "satop.h"
+
+namespace {
+
+constexpr const std::size_t kThreads = 4;
+
+constexpr const int kIterations = 10000;
+
+// Run body in kThreads threads at once.
+template <typename Body>
+void RunThreads(Body body) {
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back(body);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+template <typename T>
+class AtomicTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForAtomicTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                             int8_t, int16_t, int32_t,
+                                             uint64_t, int64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(AtomicTest, TypesForAtomicTests, );  // NOLINT
+
+TYPED_TEST(AtomicTest, FetchAdd) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  saturated::atomic<T> value(static_cast<T>(kMax - 1));
+  EXPECT_EQ(static_cast<T>(kMax - 1), value.fetch_add(T(2)));
+  EXPECT_EQ(kMax, value.load());
+  EXPECT_EQ(kMax, value.fetch_add(T(1)));
+  EXPECT_EQ(kMax, value.load());
+}
+
+TYPED_TEST(AtomicTest, FetchSub) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  saturated::atomic<T> value(static_cast<T>(kLowest + 1));
+  EXPECT_EQ(static_cast<T>(kLowest + 1), value.fetch_sub(T(2)));
+  EXPECT_EQ(kLowest, value.load());
+  EXPECT_EQ(kLowest, value.fetch_sub(T(1), std::memory_order_relaxed));
+  EXPECT_EQ(kLowest, value.load());
+}
+
+TYPED_TEST(AtomicTest, NotSaturated) {
+  using T = typename TestFixture::test_target_t;
+  saturated::atomic<T> value(T(3));
+  EXPECT_EQ(T(3), value.fetch_add(T(4), std::memory_order_acq_rel));
+  EXPECT_EQ(T(7), value.fetch_sub(T(5), std::memory_order_release));
+  EXPECT_EQ(T(2), value.load(std::memory_order_acquire));
+}
+
+TYPED_TEST(AtomicTest, Exchange) {
+  using T = typename TestFixture::test_target_t;
+  saturated::atomic<T> value;
+  EXPECT_EQ(T(0), value.exchange(T(5)));
+  T expected(4);
+  EXPECT_FALSE(value.compare_exchange_strong(expected, T(6)));
+  EXPECT_EQ(T(5), expected);
+  EXPECT_TRUE(value.compare_exchange_strong(expected, T(6)));
+  value.store(T(1));
+  EXPECT_EQ(T(1), value.load());
+}
+
+TYPED_TEST(AtomicTest, ConcurrentAdd) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  saturated::atomic<T> value;
+  RunThreads([&value]() {
+    for (int i = 0; i < kIterations; ++i) {
+      value.fetch_add(T(1));
+    }
+  });
+
+  const auto total = static_cast<uint64_t>(kThreads * kIterations);
+  EXPECT_EQ((total < static_cast<uint64_t>(kMax)) ? static_cast<T>(total)
+                                                    : kMax,
+            value.load());
+}
+
+template <typename T>
+class ShardedCounterTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForShardedCounterTests = ::testing::Types<uint8_t, uint16_t,
+                                                     uint32_t, int8_t,
+                                                     int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(ShardedCounterTest, TypesForShardedCounterTests, );  // NOLINT
+
+TYPED_TEST(ShardedCounterTest, ConcurrentAdd) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  saturated::sharded_counter<T> counter(kThreads);
+  EXPECT_EQ(kThreads, counter.shards());
+  RunThreads([&counter]() {
+    for (int i = 0; i < kIterations; ++i) {
+      counter.add(T(1));
+    }
+  });
+
+  const auto total = static_cast<uint64_t>(kThreads * kIterations);
+  EXPECT_EQ((total < static_cast<uint64_t>(kMax)) ? static_cast<T>(total)
+                                                    : kMax,
+            counter.value());
+}
+
+TYPED_TEST(ShardedCounterTest, SaturateOnRead) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  saturated::sharded_counter<T> counter(2);
+  counter.add(kMax);
+  counter.add(kMax);
+  EXPECT_EQ(kMax, counter.value());
+
+  // Sums are exact until read, so subtraction brings them back.
+  counter.sub(kMax);
+  EXPECT_EQ(kMax, counter.value());
+  counter.sub(T(1));
+  EXPECT_EQ(static_cast<T>(kMax - 1), counter.value());
+
+  counter.reset();
+  counter.sub(kMax);
+  counter.sub(kMax);
+  EXPECT_EQ(kLowest, counter.value());
+}
+
+TEST(ShardedCounterTest, DefaultShards) {
+  saturated::sharded_counter<int32_t> counter;
+  EXPECT_LE(1u, counter.shards());
+  EXPECT_EQ(0, counter.value());
+}
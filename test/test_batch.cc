@@ -0,0 +1,292 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Sizes around multiples of vector lanes, to test remainders.
+constexpr const std::size_t kSizes[] = {
+  0, 1, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 257
+};
+
+}  // namespace
+
+template <typename T>
+class BatchTest
+    : public ::testing::Test {
+ protected:
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+
+  template <typename BatchFunc, typename ScalarFunc>
+  static void TestArrays(BatchFunc batch_func, ScalarFunc scalar_func) {
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const auto n : kSizes) {
+        const auto x = GetTestValues<T>(n + 128, 0);
+        const auto y = GetTestValues<T>(n + 128, 1);
+        std::vector<T> out(n);
+        batch_func(x.data(), y.data(), out.data(), n);
+        for (std::size_t i = 0; i < n; ++i) {
+          EXPECT_EQ(scalar_func(x[i], y[i]), out[i])
+              << "level = " << static_cast<int>(level) << ", n = " << n
+              << ", x = " << +x[i] << ", y = " << +y[i];
+        }
+      }
+    }
+  }
+
+  template <typename BatchFunc, typename ScalarFunc>
+  static void TestArrayAndValue(BatchFunc batch_func,
+                                ScalarFunc scalar_func) {
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const auto y : GetEdgeValues<T>()) {
+        for (const auto n : kSizes) {
+          const auto x = GetTestValues<T>(n + 128, 0);
+          std::vector<T> out(n);
+          batch_func(x.data(), y, out.data(), n);
+          for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(scalar_func(x[i], y), out[i])
+                << "level = " << static_cast<int>(level) << ", n = " << n
+                << ", x = " << +x[i] << ", y = " << +y;
+          }
+        }
+      }
+    }
+  }
+
+  template <typename BatchFunc, typename ScalarFunc>
+  static void TestTernaryArrays(BatchFunc batch_func,
+                                ScalarFunc scalar_func) {
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const auto n : kSizes) {
+        const auto x = GetTestValues<T>(n + 128, 0);
+        const auto y = GetTestValues<T>(n + 128, 1);
+        const auto z = GetTestValues<T>(n + 128, 2);
+        std::vector<T> out(n);
+        batch_func(x.data(), y.data(), z.data(), out.data(), n);
+        for (std::size_t i = 0; i < n; ++i) {
+          EXPECT_EQ(scalar_func(x[i], y[i], z[i]), out[i])
+              << "level = " << static_cast<int>(level) << ", n = " << n
+              << ", x = " << +x[i] << ", y = " << +y[i]
+              << ", z = " << +z[i];
+        }
+      }
+    }
+  }
+
+  template <typename BatchFunc, typename ScalarFunc>
+  static void TestTernaryArraysAndValue(BatchFunc batch_func,
+                                        ScalarFunc scalar_func) {
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const auto y : GetEdgeValues<T>()) {
+        for (const auto n : kSizes) {
+          const auto x = GetTestValues<T>(n + 128, 0);
+          const auto z = GetTestValues<T>(n + 128, 3);
+          std::vector<T> out(n);
+          batch_func(x.data(), y, z.data(), out.data(), n);
+          for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(scalar_func(x[i], y, z[i]), out[i])
+                << "level = " << static_cast<int>(level) << ", n = " << n
+                << ", x = " << +x[i] << ", y = " << +y << ", z = " << +z[i];
+          }
+        }
+      }
+    }
+  }
+};
+
+using TypesForBatchTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                            int8_t, int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(BatchTest, TypesForBatchTests, );  // NOLINT
+
+TYPED_TEST(BatchTest, Add) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestArrays(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::add(x, y, out, n);
+      },
+      [](T x, T y) { return saturated::add(x, y); });
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        saturated::add(x, y, out, n);
+      },
+      [](T x, T y) { return saturated::add(x, y); });
+}
+
+TYPED_TEST(BatchTest, Sub) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestArrays(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::sub(x, y, out, n);
+      },
+      [](T x, T y) { return saturated::sub(x, y); });
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        saturated::sub(x, y, out, n);
+      },
+      [](T x, T y) { return saturated::sub(x, y); });
+}
+
+TYPED_TEST(BatchTest, Mul) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestArrays(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::mul(x, y, out, n);
+      },
+      [](T x, T y) { return saturated::mul(x, y); });
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        saturated::mul(x, y, out, n);
+      },
+      [](T x, T y) { return saturated::mul(x, y); });
+}
+
+TYPED_TEST(BatchTest, InPlace) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestArrays(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        std::copy(x, x + n, out);
+        saturated::add(out, y, n);
+      },
+      [](T x, T y) { return saturated::add(x, y); });
+  TestFixture::TestArrays(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        std::copy(x, x + n, out);
+        saturated::sub(out, y, n);
+      },
+      [](T x, T y) { return saturated::sub(x, y); });
+  TestFixture::TestArrays(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        std::copy(x, x + n, out);
+        saturated::mul(out, y, n);
+      },
+      [](T x, T y) { return saturated::mul(x, y); });
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        std::copy(x, x + n, out);
+        saturated::add(out, y, n);
+      },
+      [](T x, T y) { return saturated::add(x, y); });
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        std::copy(x, x + n, out);
+        saturated::sub(out, y, n);
+      },
+      [](T x, T y) { return saturated::sub(x, y); });
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        std::copy(x, x + n, out);
+        saturated::mul(out, y, n);
+      },
+      [](T x, T y) { return saturated::mul(x, y); });
+}
+
+template <typename T>
+class BatchFloatingTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForBatchFloatingTests = ::testing::Types<float, double>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(BatchFloatingTest, TypesForBatchFloatingTests, );  // NOLINT
+
+TYPED_TEST(BatchFloatingTest, Add) {
+  using T = typename TestFixture::test_target_t;
+  const std::vector<T> x{TestFixture::Limits::max(),
+                         TestFixture::Limits::lowest(),
+                         T(1)};
+  const std::vector<T> y{TestFixture::Limits::max(),
+                         TestFixture::Limits::lowest(),
+                         T(2)};
+  std::vector<T> out(x.size());
+  saturated::add(x.data(), y.data(), out.data(), x.size());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    EXPECT_DOUBLE_EQ(static_cast<double>(saturated::add(x[i], y[i])),
+                     static_cast<double>(out[i]));
+  }
+}
+
+TYPED_TEST(BatchTest, Div) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        saturated::div(x, saturated::divider<T>(y), out, n);
+      },
+      [](T x, T y) { return saturated::div(x, y); });
+  TestFixture::TestArrayAndValue(
+      [](const T* x, T y, T* out, std::size_t n) {
+        std::copy(x, x + n, out);
+        saturated::div(out, y, n);
+      },
+      [](T x, T y) { return saturated::div(x, y); });
+}
+
+TYPED_TEST(BatchTest, MulAdd) {
+  using T = typename TestFixture::test_target_t;
+  const auto scalar_func = [](T x, T y, T z) {
+    return saturated::mul_add(x, y, z);
+  };
+  TestFixture::TestTernaryArrays(
+      [](const T* x, const T* y, const T* z, T* out, std::size_t n) {
+        saturated::mul_add(x, y, z, out, n);
+      },
+      scalar_func);
+  TestFixture::TestTernaryArrays(
+      [](const T* x, const T* y, const T* z, T* out, std::size_t n) {
+        std::copy(z, z + n, out);
+        saturated::mul_add(x, y, out, n);
+      },
+      scalar_func);
+  TestFixture::TestTernaryArraysAndValue(
+      [](const T* x, T y, const T* z, T* out, std::size_t n) {
+        saturated::mul_add(x, y, z, out, n);
+      },
+      scalar_func);
+  TestFixture::TestTernaryArraysAndValue(
+      [](const T* x, T y, const T* z, T* out, std::size_t n) {
+        std::copy(z, z + n, out);
+        saturated::mul_add(x, y, out, n);
+      },
+      scalar_func);
+}
@@ -0,0 +1,295 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+template <typename F, typename T>
+struct Conversion {
+  using from_t = F;
+  using to_t = T;
+};
+
+// Expected result by round trip, which is exact if value is in range of T.
+template <typename T, typename F>
+T ExpectedCast(F value) {
+  const T converted = static_cast<T>(value);
+  const bool is_negative = value < F(0);
+  const bool in_range = (static_cast<F>(converted) == value)
+      && (is_negative == (converted < T(0)));
+  return in_range
+      ? converted
+      : (is_negative ? std::numeric_limits<T>::lowest()
+                     : std::numeric_limits<T>::max());
+}
+
+template <typename F>
+std::vector<F> GetTestValues(std::size_t n) {
+  using Limits = std::numeric_limits<F>;
+  std::vector<F> values{Limits::lowest(), Limits::max(),
+                        static_cast<F>(Limits::lowest() + 1),
+                        static_cast<F>(Limits::max() - 1),
+                        F(0), F(1), static_cast<F>(-1),
+                        F(127), F(128), F(255), F(256),
+                        static_cast<F>(-128), static_cast<F>(-129),
+                        static_cast<F>(32767), static_cast<F>(32768),
+                        static_cast<F>(65535), static_cast<F>(65536),
+                        static_cast<F>(-32768), static_cast<F>(-32769)};
+  std::mt19937 engine(0);
+  while (values.size() < n) {
+    values.push_back(static_cast<F>(engine()));
+  }
+  return values;
+}
+
+}  // namespace
+
+template <typename C>
+class CastTest
+    : public ::testing::Test {
+ protected:
+  using from_t = typename C::from_t;
+  using to_t = typename C::to_t;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+using TypesForCastTests = ::testing::Types<
+  Conversion<int32_t, int16_t>, Conversion<int32_t, uint16_t>,
+  Conversion<uint32_t, uint16_t>, Conversion<uint32_t, int16_t>,
+  Conversion<int16_t, int8_t>, Conversion<int16_t, uint8_t>,
+  Conversion<uint16_t, uint8_t>, Conversion<uint16_t, int8_t>,
+  Conversion<int32_t, int8_t>, Conversion<int32_t, uint8_t>,
+  Conversion<uint32_t, uint8_t>, Conversion<uint32_t, int8_t>,
+  Conversion<int8_t, uint8_t>, Conversion<uint8_t, int8_t>,
+  Conversion<int16_t, uint16_t>, Conversion<uint16_t, int16_t>,
+  Conversion<int32_t, uint32_t>, Conversion<uint32_t, int32_t>,
+  Conversion<int8_t, int32_t>, Conversion<int8_t, uint32_t>,
+  Conversion<int64_t, int32_t>, Conversion<uint64_t, int64_t>,
+  Conversion<int64_t, uint64_t>, Conversion<int32_t, int32_t>>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(CastTest, TypesForCastTests, );  // NOLINT
+
+TYPED_TEST(CastTest, Scalar) {
+  using F = typename TestFixture::from_t;
+  using T = typename TestFixture::to_t;
+  for (const auto value : GetTestValues<F>(1000)) {
+    EXPECT_EQ(ExpectedCast<T>(value), saturated::saturate_cast<T>(value))
+        << "value = " << +value;
+  }
+}
+
+TYPED_TEST(CastTest, Batch) {
+  using F = typename TestFixture::from_t;
+  using T = typename TestFixture::to_t;
+  const auto x = GetTestValues<F>(1000);
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const std::size_t n : {std::size_t(0), std::size_t(1),
+                                std::size_t(63), std::size_t(64),
+                                std::size_t(65), std::size_t(1000)}) {
+      std::vector<T> out(n);
+      saturated::saturate_cast(x.data(), out.data(), n);
+      for (std::size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(ExpectedCast<T>(x[i]), out[i])
+            << "level = " << static_cast<int>(level) << ", n = " << n
+            << ", x = " << +x[i];
+      }
+    }
+  }
+}
+
+TEST(CastTest, ConstantEvaluation) {
+  constexpr const int16_t kSaturated =
+      saturated::saturate_cast<int16_t>(INT32_MAX);
+  EXPECT_EQ(INT16_MAX, kSaturated);
+  constexpr const uint8_t kZero = saturated::saturate_cast<uint8_t>(-1.5);
+  EXPECT_EQ(uint8_t(0), kZero);
+}
+
+TEST(CastTest, FloatingPointToIntegral) {
+  EXPECT_EQ(INT32_MAX, saturated::saturate_cast<int32_t>(3e9));
+  EXPECT_EQ(INT32_MIN, saturated::saturate_cast<int32_t>(-3e9f));
+  EXPECT_EQ(INT32_MAX, saturated::saturate_cast<int32_t>(2147483648.0));
+  EXPECT_EQ(INT32_MAX, saturated::saturate_cast<int32_t>(2147483647.0));
+  EXPECT_EQ(INT32_MIN, saturated::saturate_cast<int32_t>(-2147483648.5));
+  EXPECT_EQ(int16_t(-1), saturated::saturate_cast<int16_t>(-1.9f));
+  EXPECT_EQ(uint16_t(1), saturated::saturate_cast<uint16_t>(1.9));
+  EXPECT_EQ(UINT64_MAX, saturated::saturate_cast<uint64_t>(1e30));
+  EXPECT_EQ(uint64_t(1) << 63,
+            saturated::saturate_cast<uint64_t>(9223372036854775808.0));
+  EXPECT_EQ(INT64_MAX,
+            saturated::saturate_cast<int64_t>(9223372036854775808.0));
+  EXPECT_EQ(int8_t(0), saturated::saturate_cast<int8_t>(std::nan("")));
+  EXPECT_EQ(uint32_t(0), saturated::saturate_cast<uint32_t>(std::nanf("")));
+  EXPECT_EQ(INT8_MAX, saturated::saturate_cast<int8_t>(HUGE_VAL));
+  EXPECT_EQ(INT8_MIN, saturated::saturate_cast<int8_t>(-HUGE_VALF));
+  EXPECT_EQ(uint8_t(0), saturated::saturate_cast<uint8_t>(-HUGE_VAL));
+}
+
+TEST(CastTest, FloatingPointToFloatingPoint) {
+  constexpr const float kMax = std::numeric_limits<float>::max();
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   static_cast<double>(
+                       saturated::saturate_cast<float>(1e300)));
+  EXPECT_DOUBLE_EQ(static_cast<double>(-kMax),
+                   static_cast<double>(
+                       saturated::saturate_cast<float>(-HUGE_VAL)));
+  EXPECT_DOUBLE_EQ(0.5,
+                   static_cast<double>(saturated::saturate_cast<float>(0.5)));
+  EXPECT_TRUE(std::isnan(saturated::saturate_cast<float>(std::nan(""))));
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   saturated::saturate_cast<double>(kMax));
+  EXPECT_DOUBLE_EQ(4294967295.0,
+                   saturated::saturate_cast<double>(UINT32_MAX));
+}
+
+namespace {
+
+// Values around edges of integral types and halves to see rounding,
+// scaled values follow them.
+template <typename F>
+std::vector<F> GetConvertValues(std::size_t n) {
+  std::vector<F> values{F(0), static_cast<F>(-0.0), F(0.5), F(1.5), F(2.5),
+                        static_cast<F>(-0.5), static_cast<F>(-1.5),
+                        static_cast<F>(-2.5), static_cast<F>(0.49),
+                        static_cast<F>(-0.51), F(127.5), F(128.5),
+                        static_cast<F>(-128.5), static_cast<F>(-129.5),
+                        F(255.5), F(32767.5), static_cast<F>(-32768.5),
+                        F(65535.5), F(2147483520), F(2147483648),
+                        static_cast<F>(-2147483648.0), F(4294967296),
+                        std::numeric_limits<F>::max(),
+                        std::numeric_limits<F>::lowest()};
+#if !defined(__FINITE_MATH_ONLY__) || !__FINITE_MATH_ONLY__
+  // Non finite values are undefined with -ffinite-math-only by -Ofast.
+  values.push_back(std::numeric_limits<F>::infinity());
+  values.push_back(-std::numeric_limits<F>::infinity());
+  values.push_back(std::numeric_limits<F>::quiet_NaN());
+#endif
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<F> distribution(F(-70000), F(70000));
+  while (values.size() < n) {
+    values.push_back(distribution(engine));
+  }
+  return values;
+}
+
+}  // namespace
+
+template <typename C>
+class ConvertTest
+    : public ::testing::Test {
+ protected:
+  using from_t = typename C::from_t;
+  using to_t = typename C::to_t;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+using TypesForConvertTests = ::testing::Types<
+  Conversion<float, int8_t>, Conversion<float, uint8_t>,
+  Conversion<float, int16_t>, Conversion<float, uint16_t>,
+  Conversion<float, int32_t>, Conversion<float, uint32_t>,
+  Conversion<float, int64_t>,
+  Conversion<double, int8_t>, Conversion<double, uint8_t>,
+  Conversion<double, int16_t>, Conversion<double, uint16_t>,
+  Conversion<double, int32_t>, Conversion<double, uint64_t>>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(ConvertTest, TypesForConvertTests, );  // NOLINT
+
+TYPED_TEST(ConvertTest, Batch) {
+  using F = typename TestFixture::from_t;
+  using T = typename TestFixture::to_t;
+  const auto x = GetConvertValues<F>(1000);
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto mode : {saturated::rounding::toward_zero,
+                            saturated::rounding::to_nearest,
+                            saturated::rounding::downward,
+                            saturated::rounding::upward}) {
+      for (const F scale : {F(1), F(0.5), F(32768)}) {
+        for (const std::size_t n : {std::size_t(0), std::size_t(1),
+                                    std::size_t(63), std::size_t(1000)}) {
+          std::vector<T> out(n);
+          saturated::convert(x.data(), out.data(), n, scale, mode);
+          for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(saturated::convert<T>(static_cast<F>(x[i] * scale),
+                                            mode),
+                      out[i])
+                << "level = " << static_cast<int>(level)
+                << ", mode = " << static_cast<int>(mode)
+                << ", scale = " << scale << ", n = " << n
+                << ", x = " << x[i];
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(ConvertTest, Rounding) {
+  using saturated::convert;
+  using saturated::rounding;
+  EXPECT_EQ(2, convert<int32_t>(2.5f, rounding::to_nearest));
+  EXPECT_EQ(4, convert<int32_t>(3.5, rounding::to_nearest));
+  EXPECT_EQ(-2, convert<int32_t>(-2.5f, rounding::to_nearest));
+  EXPECT_EQ(3, convert<int32_t>(2.5, rounding::upward));
+  EXPECT_EQ(-3, convert<int32_t>(-2.5f, rounding::downward));
+  EXPECT_EQ(-2, convert<int32_t>(-2.5, rounding::toward_zero));
+  EXPECT_EQ(-2, convert<int32_t>(-2.5));
+  EXPECT_EQ(INT16_MAX, convert<int16_t>(32767.5f, rounding::to_nearest));
+  EXPECT_EQ(INT16_MAX, convert<int16_t>(32767.5f, rounding::toward_zero));
+  EXPECT_EQ(uint8_t(0), convert<uint8_t>(-0.5, rounding::downward));
+  EXPECT_EQ(uint8_t(0), convert<uint8_t>(-0.5, rounding::to_nearest));
+#if !defined(__FINITE_MATH_ONLY__) || !__FINITE_MATH_ONLY__
+  EXPECT_EQ(INT32_MAX, convert<int32_t>(HUGE_VALF, rounding::upward));
+  EXPECT_EQ(0, convert<int32_t>(std::nanf(""), rounding::to_nearest));
+#endif
+}
+
+TEST(ConvertTest, Scale) {
+  const std::vector<float> x{0.5f, -1.0f, 0.99999f, -0.25f};
+  std::vector<int16_t> out(x.size());
+  saturated::convert(x.data(), out.data(), x.size(), 32768.0f,
+                     saturated::rounding::to_nearest);
+  EXPECT_EQ(16384, out[0]);
+  EXPECT_EQ(INT16_MIN, out[1]);
+  EXPECT_EQ(32767, out[2]);
+  EXPECT_EQ(-8192, out[3]);
+}
@@ -0,0 +1,62 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+#include "gtest_compat.h"
+
+#include "satop.h"
+
+class DispatchTest
+    : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+TEST_F(DispatchTest, DefaultLevel) {
+  EXPECT_EQ(saturated::supported_simd_level(),
+            saturated::current_simd_level());
+#if defined(SATOP_SIMD_X86)
+  EXPECT_LE(saturated::simd_level::sse2, saturated::supported_simd_level());
+#else
+  EXPECT_EQ(saturated::simd_level::scalar, saturated::supported_simd_level());
+#endif
+}
+
+TEST_F(DispatchTest, ForceLevel) {
+  EXPECT_TRUE(saturated::force_simd_level(saturated::simd_level::scalar));
+  EXPECT_EQ(saturated::simd_level::scalar, saturated::current_simd_level());
+  EXPECT_TRUE(
+      saturated::force_simd_level(saturated::supported_simd_level()));
+  EXPECT_EQ(saturated::supported_simd_level(),
+            saturated::current_simd_level());
+  saturated::force_simd_level(saturated::simd_level::scalar);
+  saturated::reset_simd_level();
+  EXPECT_EQ(saturated::supported_simd_level(),
+            saturated::current_simd_level());
+}
+
+TEST_F(DispatchTest, ForceUnsupportedLevel) {
+  const auto supported = saturated::supported_simd_level();
+  if (supported == saturated::simd_level::avx512bw) {
+    GTEST_SKIP() << "All levels are supported";
+  }
+  const auto wider =
+      static_cast<saturated::simd_level>(static_cast<int>(supported) + 1);
+  EXPECT_FALSE(saturated::force_simd_level(wider));
+  EXPECT_EQ(supported, saturated::current_simd_level());
+}
@@ -32,7 +32,8 @@ class DivOverflowTest
 };
 
 using TypesForOverflowTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
-                                               int8_t, int16_t, int32_t>;
+                                               int8_t, int16_t, int32_t,
+                                               uint64_t, int64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
@@ -47,3 +48,151 @@ TYPED_TEST(DivOverflowTest, NotOverflow) {
             saturated::div(kOne, kMaxValue));
   EXPECT_EQ(kOne, saturated::div(kMaxValue, kMaxValue));
 }
+
+TYPED_TEST(DivOverflowTest, DivideByZero) {
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kZero(0);
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  EXPECT_EQ(kMaxValue, saturated::div(kOne, kZero));
+  EXPECT_EQ(kMaxValue, saturated::div(kMaxValue, kZero));
+  EXPECT_EQ(kZero, saturated::div(kZero, kZero));
+}
+
+TYPED_TEST(DivOverflowTest, ConstantEvaluation) {
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kZero(0);
+  constexpr const typename TestFixture::test_target_t kTwo(2);
+  static_assert(saturated::div(kMaxValue, kZero) == kMaxValue,
+                "Division by 0 must saturate at compile time");
+  static_assert(saturated::div(kTwo, kTwo) == 1,
+                "Division must be evaluated at compile time");
+}
+
+template <typename T>
+class DividerTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForDividerTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                              int8_t, int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(DividerTest, TypesForDividerTests, );  // NOLINT
+
+TYPED_TEST(DividerTest, Divide) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kValues[] = {
+    TestFixture::Limits::lowest(),
+    static_cast<T>(TestFixture::Limits::lowest() + 1),
+    static_cast<T>(-7),
+    static_cast<T>(-1),
+    static_cast<T>(0),
+    static_cast<T>(1),
+    static_cast<T>(2),
+    static_cast<T>(3),
+    static_cast<T>(7),
+    static_cast<T>(64),
+    static_cast<T>(TestFixture::Limits::max() / 3),
+    static_cast<T>(TestFixture::Limits::max() - 1),
+    TestFixture::Limits::max()
+  };
+  for (const auto y : kValues) {
+    const saturated::divider<T> divider(y);
+    EXPECT_EQ(y, divider.divisor());
+    for (const auto x : kValues) {
+      EXPECT_EQ(saturated::div(x, y), divider.divide(x))
+          << "x = " << +x << ", y = " << +y;
+    }
+  }
+}
+
+template <typename T>
+class DivUnderflowTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForUnderflowTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                int64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(DivUnderflowTest, TypesForUnderflowTests, );  // NOLINT
+
+TYPED_TEST(DivUnderflowTest, Overflow) {
+  constexpr const auto kLowest = TestFixture::Limits::lowest();
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kMinusOne(-1);
+  EXPECT_EQ(kMaxValue, saturated::div(kLowest, kMinusOne));
+  EXPECT_EQ(static_cast<typename TestFixture::test_target_t>(-kMaxValue),
+            saturated::div(kMaxValue, kMinusOne));
+}
+
+TYPED_TEST(DivUnderflowTest, DivideByZero) {
+  constexpr const auto kLowest = TestFixture::Limits::lowest();
+  constexpr const typename TestFixture::test_target_t kZero(0);
+  constexpr const typename TestFixture::test_target_t kMinusOne(-1);
+  EXPECT_EQ(kLowest, saturated::div(kMinusOne, kZero));
+  EXPECT_EQ(kLowest, saturated::div(kLowest, kZero));
+}
+
+TYPED_TEST(DivUnderflowTest, NotUnderflow) {
+  constexpr const auto kLowest = TestFixture::Limits::lowest();
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  constexpr const typename TestFixture::test_target_t kMinusTwo(-2);
+  constexpr const typename TestFixture::test_target_t kSeven(7);
+  EXPECT_EQ(kLowest, saturated::div(kLowest, kOne));
+  EXPECT_EQ(static_cast<typename TestFixture::test_target_t>(kLowest / -2),
+            saturated::div(kLowest, kMinusTwo));
+  EXPECT_EQ(static_cast<typename TestFixture::test_target_t>(-3),
+            saturated::div(static_cast<typename TestFixture::test_target_t>(
+                -23), kSeven));
+}
+
+template <typename T>
+class DivFloatingTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForFloatingTest = ::testing::Types<float, double>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(DivFloatingTest, TypesForFloatingTest, );  // NOLINT
+
+TYPED_TEST(DivFloatingTest, Saturation) {
+  constexpr const typename TestFixture::test_target_t kMax =
+      TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kLowest =
+      TestFixture::Limits::lowest();
+  constexpr const typename TestFixture::test_target_t kHalf(0.5);
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   static_cast<double>(saturated::div(kMax, kHalf)));
+  EXPECT_DOUBLE_EQ(static_cast<double>(kLowest),
+                   static_cast<double>(saturated::div(kLowest, kHalf)));
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   static_cast<double>(saturated::div(kLowest, -kHalf)));
+}
+
+TYPED_TEST(DivFloatingTest, DivideByZero) {
+  constexpr const typename TestFixture::test_target_t kMax =
+      TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kLowest =
+      TestFixture::Limits::lowest();
+  constexpr const typename TestFixture::test_target_t kZero(0);
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   static_cast<double>(saturated::div(kOne, kZero)));
+  EXPECT_DOUBLE_EQ(static_cast<double>(kLowest),
+                   static_cast<double>(saturated::div(-kOne, kZero)));
+  EXPECT_DOUBLE_EQ(0.0, static_cast<double>(saturated::div(kZero, kZero)));
+}
@@ -0,0 +1,170 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Sizes around chunks of expressions.
+constexpr const std::size_t kSizes[] = {0, 1, 1023, 1024, 3000};
+
+template <typename T>
+std::vector<T> RandomValues(std::size_t n, uint32_t seed) {
+  std::mt19937 engine(seed);
+  std::vector<T> values(n);
+  for (auto& value : values) {
+    value = static_cast<T>(engine());
+  }
+  return values;
+}
+
+}  // namespace
+
+template <typename T>
+class ExprTest
+    : public ::testing::Test {
+ protected:
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+
+  // Test expression of arrays x, y and z and value v
+  // against scalar operation of each element.
+  template <typename Expr, typename Scalar>
+  static void Test(Expr expr, Scalar scalar) {
+    const T v = static_cast<T>(RandomValues<uint32_t>(1, 4)[0]);
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const auto n : kSizes) {
+        const auto x = RandomValues<T>(n, 1);
+        const auto y = RandomValues<T>(n, 2);
+        const auto z = RandomValues<T>(n, 3);
+        using result_t = decltype(scalar(T(), T(), T(), T()));
+        std::vector<result_t> out(n);
+        saturated::evaluate(expr(saturated::lazy(x.data()),
+                                 saturated::lazy(y.data()),
+                                 saturated::lazy(z.data()), v),
+                            out.data(), n);
+        for (std::size_t i = 0; i < n; ++i) {
+          ASSERT_EQ(+scalar(x[i], y[i], z[i], v), +out[i])
+              << "level = " << static_cast<int>(level)
+              << ", n = " << n << ", i = " << i;
+        }
+      }
+    }
+  }
+};
+
+using TypesForExprTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                           int8_t, int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(ExprTest, TypesForExprTests, );  // NOLINT
+
+TYPED_TEST(ExprTest, Array) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::Test([](auto x, auto, auto, T) { return x; },
+                    [](T x, T, T, T) { return x; });
+}
+
+TYPED_TEST(ExprTest, MulAdd) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::Test(
+      [](auto x, auto y, auto z, T) { return x * y + z; },
+      [](T x, T y, T z, T) {
+        return saturated::add(saturated::mul(x, y), z);
+      });
+}
+
+TYPED_TEST(ExprTest, Values) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::Test(
+      [](auto x, auto y, auto, T v) { return (v - x) * v + (y - v); },
+      [](T x, T y, T, T v) {
+        return saturated::add(saturated::mul(saturated::sub(v, x), v),
+                              saturated::sub(y, v));
+      });
+  TestFixture::Test(
+      [](auto x, auto, auto, T v) { return v * x + v; },
+      [](T x, T, T, T v) {
+        return saturated::add(saturated::mul(v, x), v);
+      });
+}
+
+TYPED_TEST(ExprTest, Clamp) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::Test(
+      [](auto x, auto y, auto z, T) {
+        return clamp(x - y, T(3), T(100)) * z;
+      },
+      [](T x, T y, T z, T) {
+        return saturated::mul(
+            std::min(std::max(saturated::sub(x, y), T(3)), T(100)), z);
+      });
+}
+
+TYPED_TEST(ExprTest, SaturateCast) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::Test(
+      [](auto x, auto y, auto, T) {
+        return saturated::saturate_cast<int8_t>(x + y)
+            + saturated::saturate_cast<int8_t>(y);
+      },
+      [](T x, T y, T, T) {
+        return saturated::add(
+            saturated::saturate_cast<int8_t>(saturated::add(x, y)),
+            saturated::saturate_cast<int8_t>(y));
+      });
+  TestFixture::Test(
+      [](auto x, auto, auto, T) {
+        return saturated::saturate_cast<int64_t>(x) * int64_t{3};
+      },
+      [](T x, T, T, T) {
+        return saturated::mul(saturated::saturate_cast<int64_t>(x),
+                              int64_t{3});
+      });
+}
+
+TEST(ExprInPlaceTest, SameArray) {
+  std::vector<int16_t> x = RandomValues<int16_t>(3000, 1);
+  const std::vector<int16_t> y = RandomValues<int16_t>(3000, 2);
+  const std::vector<int16_t> original = x;
+  const auto lazy_x = saturated::lazy(x.data());
+  saturated::evaluate(lazy_x * int16_t{3} + saturated::lazy(y.data())
+                      - lazy_x, x.data(), x.size());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    ASSERT_EQ(saturated::sub(saturated::add(saturated::mul(original[i],
+                                                           int16_t{3}),
+                                            y[i]),
+                             original[i]),
+              x[i]) << "i = " << i;
+  }
+}
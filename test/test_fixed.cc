@@ -0,0 +1,204 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Rounded product by floor division instead of shifts,
+// ties toward +inf, saturated into T.
+template <int FracBits, typename T>
+T ReferenceRoundingMul(T x, T y) {
+  const int64_t scale = int64_t(1) << FracBits;
+  const int64_t rounded = int64_t(x) * int64_t(y) + scale / 2;
+  int64_t quotient = rounded / scale;
+  if ((rounded % scale != 0) && (rounded < 0)) {
+    --quotient;
+  }
+  if (quotient > int64_t(std::numeric_limits<T>::max())) {
+    return std::numeric_limits<T>::max();
+  }
+  if (quotient < int64_t(std::numeric_limits<T>::lowest())) {
+    return std::numeric_limits<T>::lowest();
+  }
+  return static_cast<T>(quotient);
+}
+
+template <typename T>
+std::vector<T> GetTestRawValues(std::size_t n) {
+  using Limits = std::numeric_limits<T>;
+  std::vector<T> values{Limits::lowest(), Limits::max(),
+                        static_cast<T>(Limits::lowest() + 1),
+                        static_cast<T>(Limits::max() - 1),
+                        T(0), T(1), static_cast<T>(-1),
+                        static_cast<T>(Limits::max() / 2),
+                        static_cast<T>(Limits::max() / 2 + 1),
+                        static_cast<T>(Limits::lowest() / 2),
+                        static_cast<T>(Limits::lowest() / 2 - 1)};
+  std::mt19937 engine(0);
+  while (values.size() < n) {
+    values.push_back(static_cast<T>(engine()));
+  }
+  return values;
+}
+
+}  // namespace
+
+template <typename Q>
+class FixedTest
+    : public ::testing::Test {
+ protected:
+  using fixed_t = Q;
+  using storage_t = typename Q::storage_type;
+  static constexpr int kFracBits = Q::kFracBits;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+using TypesForFixedTests = ::testing::Types<
+  saturated::fixed<0, 15, int16_t>, saturated::fixed<3, 12, int16_t>,
+  saturated::fixed<7, 8, int16_t>, saturated::fixed<15, 0, int16_t>,
+  saturated::fixed<0, 31, int32_t>, saturated::fixed<15, 16, int32_t>,
+  saturated::fixed<0, 7, int8_t>>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(FixedTest, TypesForFixedTests, );  // NOLINT
+
+TYPED_TEST(FixedTest, Mul) {
+  using Q = typename TestFixture::fixed_t;
+  using S = typename TestFixture::storage_t;
+  const auto values = GetTestRawValues<S>(200);
+  for (const auto x : values) {
+    for (const auto y : values) {
+      EXPECT_EQ(ReferenceRoundingMul<TestFixture::kFracBits>(x, y),
+                (Q::from_raw(x) * Q::from_raw(y)).raw())
+          << "x = " << +x << ", y = " << +y;
+    }
+  }
+}
+
+TYPED_TEST(FixedTest, AddAndSub) {
+  using Q = typename TestFixture::fixed_t;
+  using S = typename TestFixture::storage_t;
+  constexpr const Q kMax = Q::from_raw(std::numeric_limits<S>::max());
+  constexpr const Q kLowest = Q::from_raw(std::numeric_limits<S>::lowest());
+  constexpr const Q kOne = Q::from_raw(S(1));
+  EXPECT_EQ(kMax, kMax + kOne);
+  EXPECT_EQ(kLowest, kLowest - kOne);
+  EXPECT_EQ(kMax, -kLowest);
+  EXPECT_EQ(Q::from_raw(S(2)), kOne + kOne);
+  EXPECT_EQ(Q(), kOne - kOne);
+  EXPECT_LT(kLowest, kMax);
+
+  Q value = kMax;
+  value += kOne;
+  EXPECT_EQ(kMax, value);
+  value -= kMax;
+  EXPECT_EQ(Q(), value);
+  value -= kMax;
+  value -= kOne;
+  value -= kOne;
+  EXPECT_EQ(kLowest, value);
+  value *= kLowest;
+  EXPECT_EQ(Q::from_raw(ReferenceRoundingMul<TestFixture::kFracBits>(
+                kLowest.raw(), kLowest.raw())),
+            value);
+}
+
+TYPED_TEST(FixedTest, FloatingPointConversion) {
+  using Q = typename TestFixture::fixed_t;
+  using S = typename TestFixture::storage_t;
+  constexpr const double kScale =
+      static_cast<double>(uintmax_t(1) << TestFixture::kFracBits);
+  EXPECT_EQ(S(0), Q(0.0).raw());
+  EXPECT_EQ(S(0), Q(std::nan("")).raw());
+  EXPECT_EQ(std::numeric_limits<S>::max(), Q(1e30).raw());
+  EXPECT_EQ(std::numeric_limits<S>::lowest(), Q(-HUGE_VALF).raw());
+  EXPECT_EQ(S(1), Q(0.5 / kScale).raw());
+  EXPECT_EQ(S(-1), Q(-0.5 / kScale).raw());
+  EXPECT_EQ(S(0), Q(0.49 / kScale).raw());
+  for (const auto raw : GetTestRawValues<S>(100)) {
+    const Q value = Q::from_raw(raw);
+    const double converted = static_cast<double>(value);
+    EXPECT_DOUBLE_EQ(static_cast<double>(raw) / kScale, converted);
+    EXPECT_EQ(value, Q(converted));
+  }
+}
+
+TYPED_TEST(FixedTest, Batch) {
+  using Q = typename TestFixture::fixed_t;
+  using S = typename TestFixture::storage_t;
+  std::vector<Q> x;
+  for (const auto raw : GetTestRawValues<S>(1000)) {
+    x.push_back(Q::from_raw(raw));
+  }
+  std::vector<Q> y(x.rbegin(), x.rend());
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    std::vector<Q> product(x.size());
+    std::vector<Q> sum(x.size());
+    std::vector<Q> scaled(x.size());
+    saturated::mul(x.data(), y.data(), product.data(), x.size());
+    saturated::add(x.data(), y.data(), sum.data(), x.size());
+    saturated::mul(x.data(), y[0], scaled.data(), x.size());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+      EXPECT_EQ(x[i] * y[i], product[i])
+          << "level = " << static_cast<int>(level)
+          << ", x = " << +x[i].raw() << ", y = " << +y[i].raw();
+      EXPECT_EQ(x[i] + y[i], sum[i]);
+      EXPECT_EQ(x[i] * y[0], scaled[i]);
+    }
+  }
+}
+
+TEST(FixedTest, Q15) {
+  using q15 = saturated::fixed<0, 15, int16_t>;
+  constexpr const q15 kMinusOne(-1.0);
+  constexpr const q15 kHalf(0.5);
+  EXPECT_EQ(INT16_MIN, kMinusOne.raw());
+  EXPECT_EQ(INT16_MAX, q15(1.0).raw());
+  EXPECT_EQ(INT16_MAX, (kMinusOne * kMinusOne).raw());
+  EXPECT_EQ(q15(-0.5), kHalf * kMinusOne);
+  EXPECT_EQ(q15(0.25), kHalf * kHalf);
+  EXPECT_EQ(int16_t(1), (q15::from_raw(1) * kHalf).raw());
+  EXPECT_EQ(int16_t(0), (q15::from_raw(-1) * kHalf).raw());
+  EXPECT_DOUBLE_EQ(-0.5, static_cast<double>(kHalf * kMinusOne));
+  EXPECT_DOUBLE_EQ(0.25, static_cast<double>(static_cast<float>(q15(0.25))));
+}
+
+TEST(FixedTest, ConstantEvaluation) {
+  using q31 = saturated::fixed<0, 31, int32_t>;
+  constexpr const q31 kProduct = q31(-1.0) * q31(-1.0);
+  EXPECT_EQ(INT32_MAX, kProduct.raw());
+  constexpr const double kHalf = static_cast<double>(q31(0.5) * q31(1.0));
+  EXPECT_DOUBLE_EQ(0.5, kHalf);
+}
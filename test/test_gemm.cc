@@ -0,0 +1,252 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Matrix of random elements in row major or column major order.
+template <typename T>
+class Matrix {
+ public:
+  Matrix(std::size_t rows, std::size_t cols, bool column_major,
+         uint32_t seed)
+      : rows_(rows), cols_(cols), column_major_(column_major),
+        elements_(rows * cols) {
+    std::mt19937 engine(seed);
+    for (auto& element : elements_) {
+      element = static_cast<T>(engine());
+    }
+  }
+
+  saturated::matrix_view<T> View() {
+    const auto rows = static_cast<std::ptrdiff_t>(rows_);
+    const auto cols = static_cast<std::ptrdiff_t>(cols_);
+    return saturated::matrix_view<T>{
+      elements_.data(), rows_, cols_,
+      column_major_ ? 1 : cols, column_major_ ? rows : 1};
+  }
+
+  T& At(std::size_t row, std::size_t col) {
+    return column_major_ ? elements_[col * rows_ + row]
+                         : elements_[row * cols_ + col];
+  }
+
+ private:
+  std::size_t rows_;
+  std::size_t cols_;
+  bool column_major_;
+  std::vector<T> elements_;
+};
+
+// Accumulator of (row, col) saturated after each pair of products.
+template <typename TA, typename TB>
+int32_t ReferenceGemm(Matrix<TA>* a, Matrix<TB>* b, std::size_t k,
+                      std::size_t row, std::size_t col) {
+  int64_t acc = 0;
+  for (std::size_t i = 0; i < k; i += 2) {
+    int64_t pair = int64_t{a->At(row, i)} * b->At(i, col);
+    if (i + 1 < k) {
+      pair += int64_t{a->At(row, i + 1)} * b->At(i + 1, col);
+    }
+    acc = std::min<int64_t>(std::max<int64_t>(acc + pair, INT32_MIN),
+                            INT32_MAX);
+  }
+  return static_cast<int32_t>(acc);
+}
+
+}  // namespace
+
+template <typename T>
+class GemmTest
+    : public ::testing::Test {
+ protected:
+  using a_type = typename std::tuple_element<0, T>::type;
+  using b_type = typename std::tuple_element<1, T>::type;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+
+  // Test gemm() of random matrices against ReferenceGemm(),
+  // in sizes over blocks and micro tiles.
+  static void TestRandomMatrices(uint32_t bits) {
+    struct Size {
+      std::size_t m;
+      std::size_t k;
+      std::size_t n;
+    };
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const Size size : {Size{1, 1, 1}, Size{5, 7, 9},
+                              Size{67, 301, 530}}) {
+        for (int layouts = 0; layouts < 4; ++layouts) {
+          Matrix<a_type> a(size.m, size.k, (layouts & 1) != 0, 1);
+          Matrix<b_type> b(size.k, size.n, (layouts & 2) != 0, 2);
+          Shift(&a, size.m, size.k, bits);
+          Shift(&b, size.k, size.n, bits);
+          Matrix<int32_t> c(size.m, size.n, false, 3);
+          saturated::gemm(a.View(), b.View(), c.View());
+          for (std::size_t row = 0; row < size.m; ++row) {
+            for (std::size_t col = 0; col < size.n; ++col) {
+              ASSERT_EQ(ReferenceGemm(&a, &b, size.k, row, col),
+                        c.At(row, col))
+                  << "level = " << static_cast<int>(level)
+                  << ", m = " << size.m << ", k = " << size.k
+                  << ", n = " << size.n << ", layouts = " << layouts
+                  << ", row = " << row << ", col = " << col;
+            }
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  // Shift elements to keep upper bits, so that accumulators saturate
+  // with large bits and do not saturate with small bits.
+  template <typename U>
+  static void Shift(Matrix<U>* x, std::size_t rows, std::size_t cols,
+                    uint32_t bits) {
+    const int shift = std::numeric_limits<U>::digits + 1
+        - static_cast<int>(std::min<uint32_t>(
+            bits, std::numeric_limits<U>::digits + 1));
+    for (std::size_t row = 0; row < rows; ++row) {
+      for (std::size_t col = 0; col < cols; ++col) {
+        x->At(row, col) = static_cast<U>(x->At(row, col) / (1 << shift));
+      }
+    }
+  }
+};
+
+using TypesForGemmTests = ::testing::Types<std::tuple<int8_t, int8_t>,
+                                           std::tuple<int16_t, int16_t>,
+                                           std::tuple<int8_t, int16_t>>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(GemmTest, TypesForGemmTests, );  // NOLINT
+
+TYPED_TEST(GemmTest, Saturated) {
+  TestFixture::TestRandomMatrices(16);
+}
+
+TYPED_TEST(GemmTest, NotSaturated) {
+  TestFixture::TestRandomMatrices(6);
+}
+
+class GemmCornerTest
+    : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+// pmaddwd wraps a pair of -32768 * -32768 around,
+// and its sum must saturate only at the end of the pair.
+TEST_F(GemmCornerTest, PairsOfLowest) {
+  constexpr const std::size_t kCols = 40;
+  constexpr const int16_t kLowest = INT16_MIN;
+  const std::vector<int16_t> a = {-1, 0, kLowest, kLowest,
+                                  kLowest, kLowest, kLowest, kLowest};
+  std::vector<int16_t> b(8 * kCols, kLowest);
+  std::fill(b.begin(), b.begin() + 2 * kCols, int16_t(1));
+  const saturated::matrix_view<const int16_t> a_view{a.data(), 1, 8, 8, 1};
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    std::vector<int32_t> c(3 * kCols);
+    // -1 + 2^31 fits, and + 2^31 saturates.
+    saturated::gemm(a_view, saturated::matrix_view<const int16_t>{
+        b.data(), 8, kCols, kCols, 1},
+      saturated::matrix_view<int32_t>{c.data(), 1, kCols, kCols, 1});
+    // 2^31 saturates from 0.
+    saturated::gemm(
+        saturated::matrix_view<const int16_t>{a.data() + 2, 1, 2, 2, 1},
+        saturated::matrix_view<const int16_t>{
+          b.data() + 2 * kCols, 2, kCols, kCols, 1},
+        saturated::matrix_view<int32_t>{c.data() + kCols, 1, kCols, kCols, 1});
+    // 2^31 from -(2^31 - 2^16) is 2^16.
+    const std::vector<int16_t> x = {kLowest, kLowest, kLowest, kLowest};
+    const std::vector<int16_t> y = {INT16_MAX, INT16_MAX, kLowest, kLowest};
+    std::vector<int16_t> y_cols(4 * kCols);
+    for (std::size_t i = 0; i < y_cols.size(); ++i) {
+      y_cols[i] = y[i / kCols];
+    }
+    saturated::gemm(
+        saturated::matrix_view<const int16_t>{x.data(), 1, 4, 4, 1},
+        saturated::matrix_view<const int16_t>{
+          y_cols.data(), 4, kCols, kCols, 1},
+        saturated::matrix_view<int32_t>{
+          c.data() + 2 * kCols, 1, kCols, kCols, 1});
+    for (std::size_t col = 0; col < kCols; ++col) {
+      ASSERT_EQ(INT32_MAX, c[col])
+          << "level = " << static_cast<int>(level) << ", col = " << col;
+      ASSERT_EQ(INT32_MAX, c[kCols + col])
+          << "level = " << static_cast<int>(level) << ", col = " << col;
+      ASSERT_EQ(65536, c[2 * kCols + col])
+          << "level = " << static_cast<int>(level) << ", col = " << col;
+    }
+  }
+}
+
+TEST_F(GemmCornerTest, Requantization) {
+  constexpr const std::size_t kK = 9;
+  constexpr const std::size_t kCols = 37;
+  Matrix<int8_t> a(3, kK, false, 1);
+  Matrix<int8_t> b(kK, kCols, true, 2);
+  const saturated::requantization q{3, 6, -5};
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    Matrix<int8_t> c(3, kCols, false, 3);
+    saturated::gemm(a.View(), b.View(), c.View(), q);
+    for (std::size_t row = 0; row < 3; ++row) {
+      for (std::size_t col = 0; col < kCols; ++col) {
+        const int64_t acc = ReferenceGemm(&a, &b, kK, row, col);
+        const int64_t expected = ((acc * 3 + 32) >> 6) - 5;
+        ASSERT_EQ(std::min<int64_t>(std::max<int64_t>(expected, -128), 127),
+                  c.At(row, col))
+            << "level = " << static_cast<int>(level)
+            << ", row = " << row << ", col = " << col;
+      }
+    }
+  }
+}
+
+TEST_F(GemmCornerTest, EmptyInner) {
+  std::vector<int8_t> a(1);
+  std::vector<int8_t> b(1);
+  std::vector<int16_t> c(6, 1);
+  saturated::gemm(saturated::matrix_view<const int8_t>{a.data(), 2, 0, 0, 1},
+                  saturated::matrix_view<const int8_t>{b.data(), 0, 3, 3, 1},
+                  saturated::matrix_view<int16_t>{c.data(), 2, 3, 3, 1},
+                  saturated::requantization{1, 0, 7});
+  EXPECT_EQ(std::vector<int16_t>(6, 7), c);
+}
@@ -0,0 +1,238 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Widths in pixels around multiples of vector lanes, to test remainders.
+constexpr const std::size_t kWidths[] = {1, 3, 4, 15, 16, 17, 64, 100};
+
+constexpr const std::size_t kHeight = 3;
+
+// Elements between the end of a row and the next row.
+constexpr const std::ptrdiff_t kPadding = 5;
+
+// Image of random channels with padding at the end of each row,
+// which operations must not overwrite.
+class Image {
+ public:
+  Image(std::size_t width, std::size_t channels, uint32_t seed)
+      : width_(width), channels_(channels),
+        stride_(static_cast<std::ptrdiff_t>(width * channels) + kPadding),
+        pixels_(static_cast<std::size_t>(stride_) * kHeight) {
+    std::mt19937 engine(seed);
+    for (auto& channel : pixels_) {
+      channel = static_cast<uint8_t>(engine());
+    }
+  }
+
+  saturated::image_view<uint8_t> View() {
+    return saturated::image_view<uint8_t>{
+      pixels_.data(), width_, kHeight, stride_, channels_};
+  }
+
+  // The same image whose rows are in reverse order.
+  saturated::image_view<uint8_t> BottomUpView() {
+    return saturated::image_view<uint8_t>{
+      pixels_.data() + stride_ * static_cast<std::ptrdiff_t>(kHeight - 1),
+      width_, kHeight, -stride_, channels_};
+  }
+
+  uint8_t& At(std::size_t x, std::size_t y) {
+    return pixels_[y * static_cast<std::size_t>(stride_) + x];
+  }
+
+  std::size_t RowSize() const {
+    return width_ * channels_;
+  }
+
+  const std::vector<uint8_t>& Pixels() const {
+    return pixels_;
+  }
+
+ private:
+  std::size_t width_;
+  std::size_t channels_;
+  std::ptrdiff_t stride_;
+  std::vector<uint8_t> pixels_;
+};
+
+uint8_t Clamp(int value) {
+  return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+int RoundDiv255(int value) {
+  return static_cast<int>(std::lround(value / 255.0));
+}
+
+// Expects that out is expected in channels and unchanged in padding.
+void ExpectImage(Image* expected, Image* out,
+                 saturated::simd_level level, std::size_t width) {
+  for (std::size_t i = 0; i < expected->Pixels().size(); ++i) {
+    EXPECT_EQ(+expected->Pixels()[i], +out->Pixels()[i])
+        << "level = " << static_cast<int>(level)
+        << ", width = " << width << ", i = " << i;
+  }
+}
+
+}  // namespace
+
+class ImageTest
+    : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+TEST_F(ImageTest, AddSub) {
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto width : kWidths) {
+      Image x(width, 4, 1), y(width, 4, 2);
+      Image sum(width, 4, 3), difference(width, 4, 4);
+      Image expected_sum = sum, expected_difference = difference;
+      for (std::size_t row = 0; row < kHeight; ++row) {
+        for (std::size_t i = 0; i < x.RowSize(); ++i) {
+          expected_sum.At(i, row) = Clamp(x.At(i, row) + y.At(i, row));
+          expected_difference.At(i, row) = Clamp(x.At(i, row) - y.At(i, row));
+        }
+      }
+      saturated::add_images(x.View(), y.View(), sum.View());
+      saturated::sub_images(x.View(), y.View(), difference.View());
+      ExpectImage(&expected_sum, &sum, level, width);
+      ExpectImage(&expected_difference, &difference, level, width);
+    }
+  }
+}
+
+TEST_F(ImageTest, Scale) {
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto width : kWidths) {
+      for (const double gain : {1.0, 0.5, 1.5, 127.0, -1.0}) {
+        for (const int offset : {0, 16, -300, 32767}) {
+          const saturated::image_gain kGain(gain);
+          Image x(width, 4, 1), out(width, 4, 2);
+          Image expected = out;
+          for (std::size_t row = 0; row < kHeight; ++row) {
+            for (std::size_t i = 0; i < x.RowSize(); ++i) {
+              expected.At(i, row) = Clamp(
+                  static_cast<int>(std::floor(
+                      (x.At(i, row) * kGain.raw() + 128) / 256.0))
+                  + offset);
+            }
+          }
+          saturated::scale_image(x.View(), kGain, static_cast<int16_t>(offset),
+                                 out.View());
+          ExpectImage(&expected, &out, level, width);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(ImageTest, Blend) {
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto width : kWidths) {
+      for (const int alpha : {0, 1, 128, 254, 255}) {
+        Image x(width, 4, 1), y(width, 4, 2), out(width, 4, 3);
+        Image expected = out;
+        for (std::size_t row = 0; row < kHeight; ++row) {
+          for (std::size_t i = 0; i < x.RowSize(); ++i) {
+            expected.At(i, row) = static_cast<uint8_t>(RoundDiv255(
+                x.At(i, row) * alpha + y.At(i, row) * (255 - alpha)));
+          }
+        }
+        saturated::blend_images(x.View(), y.View(),
+                                static_cast<uint8_t>(alpha), out.View());
+        ExpectImage(&expected, &out, level, width);
+      }
+    }
+  }
+}
+
+TEST_F(ImageTest, CompositeInterleaved) {
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto width : kWidths) {
+      Image src(width, 4, 1), dst(width, 4, 2), out(width, 4, 3);
+      Image expected = out;
+      for (std::size_t row = 0; row < kHeight; ++row) {
+        for (std::size_t i = 0; i < src.RowSize(); ++i) {
+          const int alpha = src.At(i / 4 * 4 + 3, row);
+          expected.At(i, row) = Clamp(
+              src.At(i, row) + RoundDiv255(dst.At(i, row) * (255 - alpha)));
+        }
+      }
+      saturated::composite_images(src.View(), dst.View(), out.View());
+      ExpectImage(&expected, &out, level, width);
+    }
+  }
+}
+
+TEST_F(ImageTest, CompositePlanar) {
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto width : kWidths) {
+      Image src(width, 1, 1), alpha(width, 1, 2);
+      Image dst(width, 1, 3), out(width, 1, 4);
+      Image expected = out;
+      for (std::size_t row = 0; row < kHeight; ++row) {
+        for (std::size_t i = 0; i < src.RowSize(); ++i) {
+          expected.At(i, row) = Clamp(
+              src.At(i, row)
+              + RoundDiv255(dst.At(i, row) * (255 - alpha.At(i, row))));
+        }
+      }
+      saturated::composite_images(src.View(), alpha.View(), dst.View(),
+                                  out.View());
+      ExpectImage(&expected, &out, level, width);
+    }
+  }
+}
+
+TEST_F(ImageTest, InPlaceAndBottomUp) {
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto width : kWidths) {
+      Image x(width, 4, 1), y(width, 4, 2);
+      Image expected = x;
+      for (std::size_t row = 0; row < kHeight; ++row) {
+        for (std::size_t i = 0; i < x.RowSize(); ++i) {
+          expected.At(i, row) = Clamp(
+              x.At(i, row) + y.At(i, kHeight - 1 - row));
+        }
+      }
+      saturated::add_images(x.View(), y.BottomUpView(), x.View());
+      ExpectImage(&expected, &x, level, width);
+    }
+  }
+}
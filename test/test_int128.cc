@@ -0,0 +1,97 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <limits>
+
+#include "gtest_compat.h"
+
+#include "satop.h"
+
+// Standard library treats __int128 as integral type
+// only in GNU dialects, so this file is built with -std=gnu++17.
+#if defined(SATOP_HAS_INT128) && !defined(__STRICT_ANSI__)
+
+namespace {
+
+__extension__ typedef __int128 Int128;
+__extension__ typedef unsigned __int128 UInt128;
+
+}  // namespace
+
+template <typename T>
+class Int128Test
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForInt128Tests = ::testing::Types<Int128, UInt128>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(Int128Test, TypesForInt128Tests, );  // NOLINT
+
+TYPED_TEST(Int128Test, Overflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kOne(1);
+  constexpr const T kTwo(2);
+  EXPECT_TRUE(kMax == saturated::add(kMax, kOne));
+  EXPECT_TRUE(kMax == saturated::mul(kMax, kTwo));
+  EXPECT_TRUE(kMax == saturated::mul(static_cast<T>(kOne << 64),
+                                     static_cast<T>(kOne << 64)));
+  EXPECT_TRUE(kMax == saturated::div(kOne, T(0)));
+  EXPECT_TRUE(kMax == saturated::mul_add(kMax, kTwo, kOne));
+}
+
+TYPED_TEST(Int128Test, NotOverflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kOne(1);
+  constexpr const T kTwo(2);
+  constexpr const T kProduct = static_cast<T>(kOne << 62) * (kOne << 64);
+  EXPECT_TRUE(kMax == saturated::add(static_cast<T>(kMax - kOne), kOne));
+  EXPECT_TRUE(kProduct == saturated::mul(static_cast<T>(kOne << 62),
+                                         static_cast<T>(kOne << 64)));
+  EXPECT_TRUE(static_cast<T>(kMax / kTwo) == saturated::div(kMax, kTwo));
+}
+
+TYPED_TEST(Int128Test, ConstantEvaluation) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kSaturated = saturated::mul(kMax, T(2));
+  EXPECT_TRUE(kMax == kSaturated);
+}
+
+TEST(Int128Test, Underflow) {
+  constexpr const Int128 kLowest = std::numeric_limits<Int128>::lowest();
+  constexpr const Int128 kMax = std::numeric_limits<Int128>::max();
+  constexpr const Int128 kOne(1);
+  constexpr const Int128 kMinusOne(-1);
+  EXPECT_TRUE(kLowest == saturated::sub(kLowest, kOne));
+  EXPECT_TRUE(kLowest == saturated::mul(kMax, Int128(-2)));
+  EXPECT_TRUE(kMax == saturated::mul(kLowest, kMinusOne));
+  EXPECT_TRUE(kMax == saturated::div(kLowest, kMinusOne));
+  EXPECT_TRUE(kLowest == saturated::mul(static_cast<Int128>(kOne << 64),
+                                        static_cast<Int128>(-(kOne << 63))));
+  EXPECT_TRUE(UInt128(0) == saturated::sub(UInt128(1), UInt128(2)));
+}
+
+#endif  // defined(SATOP_HAS_INT128) && !defined(__STRICT_ANSI__)
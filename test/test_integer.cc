@@ -0,0 +1,187 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "gtest_compat.h"
+
+#include "satop.h"
+
+template <typename T>
+class IntegerTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+  using test_integer_t = saturated::integer<T>;
+};
+
+using TypesForIntegerTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                              int8_t, int16_t, int32_t,
+                                              uint64_t, int64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(IntegerTest, TypesForIntegerTests, );  // NOLINT
+
+TYPED_TEST(IntegerTest, SingleOperation) {
+  using T = typename TestFixture::test_target_t;
+  using integer_t = typename TestFixture::test_integer_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  const T kValues[] = {kLowest, static_cast<T>(kLowest + 1), T(0), T(1),
+                       T(2), T(3), static_cast<T>(kMax / 2),
+                       static_cast<T>(kMax - 1), kMax};
+  for (const T x : kValues) {
+    for (const T y : kValues) {
+      const integer_t sum = integer_t(x) + integer_t(y);
+      const integer_t difference = integer_t(x) - integer_t(y);
+      const integer_t product = integer_t(x) * integer_t(y);
+      const integer_t quotient = integer_t(x) / integer_t(y);
+      EXPECT_EQ(saturated::add(x, y), sum.value());
+      EXPECT_EQ(saturated::sub(x, y), difference.value());
+      EXPECT_EQ(saturated::mul(x, y), product.value());
+      EXPECT_EQ(saturated::div(x, y), quotient.value());
+    }
+  }
+}
+
+TYPED_TEST(IntegerTest, CompoundAssignment) {
+  using T = typename TestFixture::test_target_t;
+  using integer_t = typename TestFixture::test_integer_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  integer_t value(kMax);
+  value += integer_t(T(1));
+  EXPECT_EQ(kMax, value.value());
+  value -= integer_t(T(1));
+  EXPECT_EQ(static_cast<T>(kMax - 1), value.value());
+  value *= integer_t(T(2));
+  EXPECT_EQ(kMax, value.value());
+  value /= integer_t(T(0));
+  EXPECT_EQ(kMax, value.value());
+  value = integer_t(kLowest);
+  value -= integer_t(T(1));
+  EXPECT_EQ(kLowest, value.value());
+  value = integer_t(T(3));
+  value += integer_t(T(2)) * integer_t(T(2));
+  EXPECT_EQ(T(7), value.value());
+}
+
+TYPED_TEST(IntegerTest, Comparison) {
+  using T = typename TestFixture::test_target_t;
+  using integer_t = typename TestFixture::test_integer_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  const integer_t kOne(T(1));
+  const integer_t kTwo(T(2));
+  const integer_t kMaxValue(kMax);
+  EXPECT_TRUE(kOne == kOne);
+  EXPECT_TRUE(kOne != kTwo);
+  EXPECT_TRUE(kOne < kTwo);
+  EXPECT_TRUE(kOne <= kOne);
+  EXPECT_TRUE(kTwo > kOne);
+  EXPECT_TRUE(kTwo >= kTwo);
+  EXPECT_TRUE(kMaxValue + kOne == kMaxValue);
+  EXPECT_TRUE(kMaxValue * kTwo == kMaxValue);
+  EXPECT_FALSE(kMaxValue + kOne > kMaxValue);
+}
+
+TYPED_TEST(IntegerTest, ConstantEvaluation) {
+  using T = typename TestFixture::test_target_t;
+  using integer_t = typename TestFixture::test_integer_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const integer_t kSaturated =
+      integer_t(kMax) * integer_t(T(2)) + integer_t(T(1));
+  static_assert(kSaturated.value() == kMax, "Not saturated in constexpr");
+  constexpr const integer_t kDividedByZero = integer_t(kMax) / integer_t(T(0));
+  static_assert(kDividedByZero.value() == kMax, "Not saturated in constexpr");
+  EXPECT_EQ(kMax, static_cast<T>(kSaturated));
+}
+
+template <typename T>
+class IntegerFusedTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+  using test_integer_t = saturated::integer<T>;
+};
+
+using TypesForFusedTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                            int8_t, int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(IntegerFusedTest, TypesForFusedTests, );  // NOLINT
+
+TYPED_TEST(IntegerFusedTest, SaturatedOnce) {
+  using T = typename TestFixture::test_target_t;
+  using integer_t = typename TestFixture::test_integer_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  // max + max - max is max when saturated at each operation,
+  // but it is not saturated at all when saturated only once.
+  const integer_t kResult =
+      integer_t(kMax) + integer_t(kMax) - integer_t(kMax);
+  EXPECT_EQ(kMax, kResult.value());
+  const integer_t kDifference =
+      integer_t(T(0)) - integer_t(kMax) + integer_t(kMax) + integer_t(T(1));
+  EXPECT_EQ(T(1), kDifference.value());
+  const integer_t kQuotient =
+      (integer_t(kMax) + integer_t(T(1))) / integer_t(T(2));
+  EXPECT_EQ(static_cast<T>(kMax / 2 + 1), kQuotient.value());
+}
+
+TYPED_TEST(IntegerFusedTest, MulAdd) {
+  using T = typename TestFixture::test_target_t;
+  using integer_t = typename TestFixture::test_integer_t;
+  using wide_t = typename std::conditional<std::is_signed<T>::value,
+                                           int64_t, uint64_t>::type;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  const T kValues[] = {kLowest, static_cast<T>(kLowest + 1), T(0), T(1),
+                       T(3), static_cast<T>(kMax / 3),
+                       static_cast<T>(kMax - 1), kMax};
+  for (const T a : kValues) {
+    for (const T b : kValues) {
+      for (const T c : kValues) {
+        const wide_t exact = static_cast<wide_t>(a) * static_cast<wide_t>(b)
+                             + static_cast<wide_t>(c);
+        const T expected =
+            (exact > static_cast<wide_t>(kMax)) ? kMax
+            : ((exact < static_cast<wide_t>(kLowest)) ? kLowest
+               : static_cast<T>(exact));
+        const integer_t result = integer_t(a) * integer_t(b) + integer_t(c);
+        EXPECT_EQ(expected, result.value());
+      }
+    }
+  }
+}
+
+TEST(IntegerTest, SaturatedAtEachOperationIn64Bits) {
+  constexpr const int64_t kMax = std::numeric_limits<int64_t>::max();
+  using integer_t = saturated::integer<int64_t>;
+  // There is no wider native type than int64_t,
+  // so max * 2 is saturated before subtraction.
+  const integer_t kResult =
+      integer_t(kMax) * integer_t(int64_t(2)) - integer_t(kMax);
+  EXPECT_EQ(int64_t(0), kResult.value());
+}
@@ -0,0 +1,189 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Sizes around multiples of vector lanes, to test remainders.
+constexpr const std::size_t kSizes[] = {0, 1, 7, 8, 9, 31, 32, 33, 100};
+
+constexpr const std::size_t kStreams[] = {0, 1, 2, 3, 8, 64};
+
+// Samples scaled by gains as operator*() of mix_gain.
+int16_t Scale(int16_t sample, saturated::mix_gain gain) {
+  return (saturated::mix_gain::from_raw(sample) * gain).raw();
+}
+
+int16_t ExpectedMix(const std::vector<std::vector<int16_t>>& streams,
+                    const std::vector<saturated::mix_gain>& gains,
+                    std::size_t i, saturated::reduction_mode mode) {
+  if (mode == saturated::reduction_mode::clamp_each_step) {
+    int16_t acc = 0;
+    for (std::size_t s = 0; s < streams.size(); ++s) {
+      acc = saturated::add(acc, Scale(streams[s][i], gains[s]));
+    }
+    return acc;
+  }
+  int32_t acc = 0;
+  for (std::size_t s = 0; s < streams.size(); ++s) {
+    acc += Scale(streams[s][i], gains[s]);
+  }
+  return static_cast<int16_t>(std::min(std::max(acc, int32_t(INT16_MIN)),
+                                       int32_t(INT16_MAX)));
+}
+
+// Loud streams, whose sums overflow frequently.
+std::vector<std::vector<int16_t>> GetStreams(std::size_t streams,
+                                             std::size_t n) {
+  std::mt19937 engine(0);
+  std::vector<std::vector<int16_t>> x(streams, std::vector<int16_t>(n));
+  for (auto& stream : x) {
+    for (auto& sample : stream) {
+      sample = static_cast<int16_t>(engine());
+    }
+  }
+  return x;
+}
+
+std::vector<saturated::mix_gain> GetGains(std::size_t streams) {
+  std::vector<saturated::mix_gain> gains;
+  for (std::size_t s = 0; s < streams; ++s) {
+    gains.push_back(saturated::mix_gain::from_raw(
+        static_cast<int16_t>(INT16_MAX - static_cast<int>(s) * 1000)));
+  }
+  return gains;
+}
+
+std::vector<const int16_t*> GetPointers(
+    const std::vector<std::vector<int16_t>>& streams) {
+  std::vector<const int16_t*> pointers;
+  for (const auto& stream : streams) {
+    pointers.push_back(stream.data());
+  }
+  return pointers;
+}
+
+}  // namespace
+
+class MixerTest
+    : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+TEST_F(MixerTest, Mix) {
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto mode : {saturated::reduction_mode::clamp_at_end,
+                            saturated::reduction_mode::clamp_each_step}) {
+      for (const auto streams : kStreams) {
+        for (const auto n : kSizes) {
+          const auto x = GetStreams(streams, n);
+          const auto gains = GetGains(streams);
+          std::vector<int16_t> out(n);
+          saturated::mix(GetPointers(x).data(), gains.data(), streams,
+                         out.data(), n, mode);
+          for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(ExpectedMix(x, gains, i, mode), out[i])
+                << "level = " << static_cast<int>(level)
+                << ", mode = " << static_cast<int>(mode)
+                << ", streams = " << streams << ", n = " << n
+                << ", i = " << i;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(MixerTest, ClampAtEndAndEachStep) {
+  const std::vector<int16_t> loud(40, 30000);
+  const std::vector<int16_t> quiet(40, -30000);
+  const int16_t* const x[] = {loud.data(), loud.data(), quiet.data()};
+  const saturated::mix_gain gains[] = {saturated::mix_gain(0.5),
+                                       saturated::mix_gain(0.5),
+                                       saturated::mix_gain(0.5)};
+  std::vector<int16_t> at_end(loud.size());
+  std::vector<int16_t> each_step(loud.size());
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    saturated::mix(x, gains, 3, at_end.data(), at_end.size(),
+                   saturated::reduction_mode::clamp_at_end);
+    saturated::mix(x, gains, 3, each_step.data(), each_step.size(),
+                   saturated::reduction_mode::clamp_each_step);
+    for (std::size_t i = 0; i < loud.size(); ++i) {
+      // 15000 + 15000 - 15000 and add(add(15000, 15000), -15000).
+      EXPECT_EQ(15000, at_end[i]);
+      EXPECT_EQ(15000, each_step[i]);
+    }
+    const saturated::mix_gain full = saturated::mix_gain::from_raw(INT16_MAX);
+    const saturated::mix_gain full_gains[] = {full, full, full};
+    saturated::mix(x, full_gains, 3, at_end.data(), at_end.size(),
+                   saturated::reduction_mode::clamp_at_end);
+    saturated::mix(x, full_gains, 3, each_step.data(), each_step.size(),
+                   saturated::reduction_mode::clamp_each_step);
+    for (std::size_t i = 0; i < loud.size(); ++i) {
+      // 29999 + 29999 - 29999 and add(add(29999, 29999), -29999).
+      EXPECT_EQ(29999, at_end[i]);
+      EXPECT_EQ(INT16_MAX - 29999, each_step[i]);
+    }
+  }
+}
+
+TEST_F(MixerTest, PushAndPull) {
+  constexpr std::size_t kChunkSize = 50;
+  const auto x = GetStreams(3, kChunkSize * 2);
+  saturated::mixer mixer(3, kChunkSize,
+                         saturated::reduction_mode::clamp_each_step);
+  EXPECT_EQ(3U, mixer.streams());
+  EXPECT_EQ(kChunkSize, mixer.chunk_size());
+  EXPECT_EQ(INT16_MAX, mixer.gain(1).raw());
+  mixer.set_gain(1, saturated::mix_gain(0.25));
+  EXPECT_EQ(saturated::mix_gain(0.25).raw(), mixer.gain(1).raw());
+
+  // The 1st chunk mixes streams 1 and 2, and the 2nd one only stream 0.
+  std::vector<int16_t> out(kChunkSize);
+  mixer.push(2, x[2].data());
+  mixer.push(1, x[1].data());
+  mixer.pull(out.data());
+  for (std::size_t i = 0; i < kChunkSize; ++i) {
+    EXPECT_EQ(saturated::add(Scale(x[1][i], mixer.gain(1)),
+                             Scale(x[2][i], mixer.gain(2))),
+              out[i]) << "i = " << i;
+  }
+  mixer.push(0, x[0].data() + kChunkSize);
+  mixer.pull(out.data());
+  for (std::size_t i = 0; i < kChunkSize; ++i) {
+    EXPECT_EQ(Scale(x[0][kChunkSize + i], mixer.gain(0)), out[i])
+        << "i = " << i;
+  }
+  mixer.pull(out.data());
+  EXPECT_EQ(std::vector<int16_t>(kChunkSize, 0), out);
+}
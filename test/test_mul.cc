@@ -17,7 +17,10 @@
 // along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstdint>
+#include <initializer_list>
 #include <limits>
+#include <type_traits>
+#include <vector>
 
 #include "gtest_compat.h"
 
@@ -25,17 +28,53 @@
 
 namespace {
 
+// Bits of the root are decided from the highest one,
+// so it is quick even for 64 bits types.
 template <typename T>
 T GetRootOfMax() {
   constexpr const T kMax = std::numeric_limits<T>::max();
-  T root_of_max = 1;
-  for (root_of_max = 1; kMax / root_of_max >= root_of_max; ++root_of_max) ;
-
-  --root_of_max;
+  T root_of_max = 0;
+  for (int bit = std::numeric_limits<T>::digits / 2; bit >= 0; --bit) {
+    const T candidate = static_cast<T>(root_of_max | (T(1) << bit));
+    if (kMax / candidate >= candidate) {
+      root_of_max = candidate;
+    }
+  }
 
   return root_of_max;
 }
 
+// Values around bases, which wrap around at edges of T.
+template <typename T>
+std::vector<T> GetValuesAround(std::initializer_list<T> bases) {
+  using U = typename std::make_unsigned<T>::type;
+  std::vector<T> values;
+  for (const T base : bases) {
+    for (int offset = -2; offset <= 2; ++offset) {
+      values.push_back(static_cast<T>(static_cast<U>(
+          static_cast<U>(base) + static_cast<U>(offset))));
+    }
+  }
+  return values;
+}
+
+// mul<C>(x) is the same as mul(x, C) around edges of T
+// and around x whose products saturate.
+template <std::intmax_t C, typename T>
+void ExpectConstantMul() {
+  using Limits = std::numeric_limits<T>;
+  constexpr const T kC = static_cast<T>(C);
+  constexpr const T kDivisor = ((C == 0) || (C == -1)) ? T(2) : kC;
+  for (const T x : GetValuesAround<T>({
+           Limits::lowest(), T(0), Limits::max(),
+           static_cast<T>(Limits::max() / kDivisor),
+           static_cast<T>(Limits::lowest() / kDivisor)
+       })) {
+    EXPECT_EQ(saturated::mul(x, kC), saturated::mul<C>(x))
+        << "x = " << +x << ", C = " << C;
+  }
+}
+
 }  // namespace
 
 template <typename T>
@@ -47,7 +86,8 @@ class MulOverflowTest
 };
 
 using TypesForOverflowTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
-                                               int8_t, int16_t, int32_t>;
+                                               int8_t, int16_t, int32_t,
+                                               uint64_t, int64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
@@ -77,6 +117,32 @@ TYPED_TEST(MulOverflowTest, NotOverflow) {
   EXPECT_EQ(kRootOfMax * kRootOfMax, saturated::mul(kRootOfMax, kRootOfMax));
 }
 
+TYPED_TEST(MulOverflowTest, MultiplyByZero) {
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kZero(0);
+  EXPECT_EQ(kZero, saturated::mul(kMaxValue, kZero));
+  EXPECT_EQ(kZero, saturated::mul(kZero, kMaxValue));
+  EXPECT_EQ(kZero, saturated::mul(kZero, kZero));
+}
+
+TYPED_TEST(MulOverflowTest, ConstantEvaluation) {
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kTwo(2);
+  constexpr const auto kSaturated = saturated::mul(kMaxValue, kTwo);
+  EXPECT_EQ(kMaxValue, kSaturated);
+}
+
+TYPED_TEST(MulOverflowTest, Constant) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kSaturated = saturated::mul<2>(TestFixture::Limits::max());
+  EXPECT_EQ(TestFixture::Limits::max(), kSaturated);
+  ExpectConstantMul<0, T>();
+  ExpectConstantMul<1, T>();
+  ExpectConstantMul<2, T>();
+  ExpectConstantMul<3, T>();
+  ExpectConstantMul<std::numeric_limits<int8_t>::max(), T>();
+}
+
 template <typename T>
 class MulUnderflowTest
     : public ::testing::Test {
@@ -85,7 +151,8 @@ class MulUnderflowTest
   using test_target_t = T;
 };
 
-using TypesForUnderflowTests = ::testing::Types<int8_t, int16_t, int32_t>;
+using TypesForUnderflowTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                int64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
@@ -109,3 +176,64 @@ TYPED_TEST(MulUnderflowTest, NotUnderflow) {
   EXPECT_EQ(kMulResult, saturated::mul(kLowestDivThree, kThree));
   EXPECT_EQ(kMulResult, saturated::mul(kThree, kLowestDivThree));
 }
+
+TYPED_TEST(MulUnderflowTest, NegativeOperands) {
+  constexpr const auto kLowest = TestFixture::Limits::lowest();
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kZero(0);
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  constexpr const typename TestFixture::test_target_t kMinusOne(-1);
+  EXPECT_EQ(kOne, saturated::mul(kMinusOne, kMinusOne));
+  EXPECT_EQ(kMaxValue, saturated::mul(kLowest, kMinusOne));
+  EXPECT_EQ(kMaxValue, saturated::mul(kMinusOne, kLowest));
+  EXPECT_EQ(static_cast<typename TestFixture::test_target_t>(-kMaxValue),
+            saturated::mul(kMinusOne, kMaxValue));
+  EXPECT_EQ(kZero, saturated::mul(kZero, kMinusOne));
+  EXPECT_EQ(kZero, saturated::mul(kLowest, kZero));
+}
+
+TYPED_TEST(MulUnderflowTest, Constant) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kSaturated =
+      saturated::mul<-1>(TestFixture::Limits::lowest());
+  EXPECT_EQ(TestFixture::Limits::max(), kSaturated);
+  ExpectConstantMul<-1, T>();
+  ExpectConstantMul<-2, T>();
+  ExpectConstantMul<-3, T>();
+  ExpectConstantMul<std::numeric_limits<int8_t>::lowest(), T>();
+}
+
+template <typename T>
+class MulFloatingTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForFloatingTest = ::testing::Types<float, double>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(MulFloatingTest, TypesForFloatingTest, );  // NOLINT
+
+TYPED_TEST(MulFloatingTest, Saturation) {
+  constexpr const typename TestFixture::test_target_t kMax =
+      TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kLowest =
+      TestFixture::Limits::lowest();
+  constexpr const typename TestFixture::test_target_t kTwo(2);
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   static_cast<double>(saturated::mul(kMax, kTwo)));
+  EXPECT_DOUBLE_EQ(static_cast<double>(kLowest),
+                   static_cast<double>(saturated::mul(kLowest, kTwo)));
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   static_cast<double>(saturated::mul(kLowest, -kTwo)));
+}
+
+TYPED_TEST(MulFloatingTest, NegativeOperands) {
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  constexpr const typename TestFixture::test_target_t kMinusOne(-1);
+  EXPECT_DOUBLE_EQ(static_cast<double>(kOne),
+                   static_cast<double>(saturated::mul(kMinusOne, kMinusOne)));
+}
@@ -0,0 +1,152 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstdint>
+#include <limits>
+
+#include "gtest_compat.h"
+
+#include "satop.h"
+
+template <typename T>
+class MulAddOverflowTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForOverflowTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                               int8_t, int16_t, int32_t,
+                                               uint64_t, int64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(MulAddOverflowTest, TypesForOverflowTests, );  // NOLINT
+
+TYPED_TEST(MulAddOverflowTest, Overflow) {
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kZero(0);
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  constexpr const typename TestFixture::test_target_t kTwo(2);
+  EXPECT_EQ(kMaxValue, saturated::mul_add(kMaxValue, kTwo, kZero));
+  EXPECT_EQ(kMaxValue, saturated::mul_add(kMaxValue, kOne, kOne));
+  EXPECT_EQ(kMaxValue, saturated::mul_add(kMaxValue, kMaxValue, kMaxValue));
+}
+
+TYPED_TEST(MulAddOverflowTest, NotOverflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const T kZero(0);
+  constexpr const T kOne(1);
+  constexpr const T kTwo(2);
+  constexpr const T kThree(3);
+  EXPECT_EQ(kMaxValue, saturated::mul_add(kMaxValue, kOne, kZero));
+  EXPECT_EQ(kMaxValue, saturated::mul_add(kZero, kMaxValue, kMaxValue));
+  EXPECT_EQ(T(7), saturated::mul_add(kTwo, kTwo, kThree));
+  EXPECT_EQ(kMaxValue,
+            saturated::mul_add(static_cast<T>(kMaxValue / kTwo), kTwo,
+                               static_cast<T>(kMaxValue % kTwo)));
+}
+
+TYPED_TEST(MulAddOverflowTest, ConstantEvaluation) {
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kTwo(2);
+  constexpr const auto kSaturated =
+      saturated::mul_add(kMaxValue, kTwo, kMaxValue);
+  EXPECT_EQ(kMaxValue, kSaturated);
+}
+
+template <typename T>
+class MulAddUnderflowTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+// Products of 64 bits types are saturated once only with __int128.
+#ifdef SATOP_HAS_INT128
+using TypesForUnderflowTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                int64_t>;
+#else
+using TypesForUnderflowTests = ::testing::Types<int8_t, int16_t, int32_t>;
+#endif
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(MulAddUnderflowTest, TypesForUnderflowTests, );  // NOLINT
+
+TYPED_TEST(MulAddUnderflowTest, Underflow) {
+  constexpr const auto kLowest = TestFixture::Limits::lowest();
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kMinusOne(-1);
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  constexpr const typename TestFixture::test_target_t kTwo(2);
+  EXPECT_EQ(kLowest, saturated::mul_add(kLowest, kOne, kMinusOne));
+  EXPECT_EQ(kLowest, saturated::mul_add(kLowest, kTwo, kMaxValue));
+  EXPECT_EQ(kLowest, saturated::mul_add(kMaxValue, kMinusOne, kMinusOne));
+}
+
+// Products are not saturated before addition.
+TYPED_TEST(MulAddUnderflowTest, SaturatedOnce) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const auto kLowest = TestFixture::Limits::lowest();
+  constexpr const auto kMaxValue = TestFixture::Limits::max();
+  constexpr const T kMinusOne(-1);
+  constexpr const T kTwo(2);
+  EXPECT_EQ(kMaxValue, saturated::mul_add(kMaxValue, kTwo,
+                                          static_cast<T>(-kMaxValue)));
+  EXPECT_EQ(kLowest, saturated::mul_add(kLowest, kTwo, kMaxValue));
+  EXPECT_EQ(kMaxValue, saturated::mul_add(kLowest, kMinusOne, kMinusOne));
+  EXPECT_EQ(T(0), saturated::mul_add(kLowest, kMinusOne, kLowest));
+}
+
+template <typename T>
+class MulAddFloatingTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+using TypesForFloatingTest = ::testing::Types<float, double>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(MulAddFloatingTest, TypesForFloatingTest, );  // NOLINT
+
+TYPED_TEST(MulAddFloatingTest, Saturation) {
+  constexpr const typename TestFixture::test_target_t kMax =
+      TestFixture::Limits::max();
+  constexpr const typename TestFixture::test_target_t kLowest =
+      TestFixture::Limits::lowest();
+  constexpr const typename TestFixture::test_target_t kOne(1);
+  constexpr const typename TestFixture::test_target_t kTwo(2);
+  constexpr const typename TestFixture::test_target_t kThree(3);
+  EXPECT_DOUBLE_EQ(static_cast<double>(kMax),
+                   static_cast<double>(saturated::mul_add(kMax, kTwo, kMax)));
+  EXPECT_DOUBLE_EQ(static_cast<double>(kLowest),
+                   static_cast<double>(saturated::mul_add(kLowest, kTwo,
+                                                          kLowest)));
+  EXPECT_DOUBLE_EQ(7.0,
+                   static_cast<double>(saturated::mul_add(kTwo, kThree,
+                                                          kOne)));
+}
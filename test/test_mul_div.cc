@@ -0,0 +1,148 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdint>
+#include <limits>
+
+#include "gtest_compat.h"
+
+#include "satop.h"
+
+template <typename T>
+class MulDivTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+#ifdef SATOP_HAS_INT128
+using TypesForMulDivTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                             int8_t, int16_t, int32_t,
+                                             uint64_t, int64_t>;
+#else
+using TypesForMulDivTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                             int8_t, int16_t, int32_t>;
+#endif
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(MulDivTest, TypesForMulDivTests, );  // NOLINT
+
+// Products are not saturated before division.
+TYPED_TEST(MulDivTest, NotOverflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kOne(1);
+  constexpr const T kTwo(2);
+  constexpr const T kThree(3);
+  EXPECT_EQ(kMax, saturated::mul_div(kMax, kMax, kMax));
+  EXPECT_EQ(kMax, saturated::mul_div(kMax, kOne, kOne));
+  EXPECT_EQ(static_cast<T>(kMax / kThree * kTwo),
+            saturated::mul_div(static_cast<T>(kMax / kThree * kThree),
+                               kTwo, kThree));
+  EXPECT_EQ(static_cast<T>(kMax - kOne),
+            saturated::mul_div(static_cast<T>(kMax - kOne), kMax, kMax));
+  EXPECT_EQ(static_cast<T>(kMax / kTwo),
+            saturated::mul_div(kMax, kOne, kTwo));
+}
+
+TYPED_TEST(MulDivTest, Overflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kOne(1);
+  constexpr const T kTwo(2);
+  EXPECT_EQ(kMax, saturated::mul_div(kMax, kTwo, kOne));
+  EXPECT_EQ(kMax, saturated::mul_div(kMax, kMax, kTwo));
+}
+
+TYPED_TEST(MulDivTest, DivideByZero) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kZero(0);
+  constexpr const T kOne(1);
+  EXPECT_EQ(kMax, saturated::mul_div(kOne, kOne, kZero));
+  EXPECT_EQ(kZero, saturated::mul_div(kZero, kMax, kZero));
+}
+
+TYPED_TEST(MulDivTest, ConstantEvaluation) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kTwo(2);
+  constexpr const T kQuotient = saturated::mul_div(kMax, kTwo, kTwo);
+  EXPECT_EQ(kMax, kQuotient);
+}
+
+template <typename T>
+class SignedMulDivTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+};
+
+#ifdef SATOP_HAS_INT128
+using TypesForSignedMulDivTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                   int64_t>;
+#else
+using TypesForSignedMulDivTests = ::testing::Types<int8_t, int16_t, int32_t>;
+#endif
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(SignedMulDivTest, TypesForSignedMulDivTests, );  // NOLINT
+
+TYPED_TEST(SignedMulDivTest, Underflow) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  constexpr const T kOne(1);
+  constexpr const T kMinusOne(-1);
+  constexpr const T kTwo(2);
+  EXPECT_EQ(kLowest, saturated::mul_div(kLowest, kTwo, kOne));
+  EXPECT_EQ(kLowest, saturated::mul_div(kMax, kTwo, kMinusOne));
+  EXPECT_EQ(kLowest, saturated::mul_div(kMinusOne, kOne, T(0)));
+}
+
+TYPED_TEST(SignedMulDivTest, NegativeOperands) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  constexpr const T kMinusOne(-1);
+  constexpr const T kTwo(2);
+  constexpr const T kThree(3);
+  EXPECT_EQ(kMax, saturated::mul_div(kLowest, T(1), kMinusOne));
+  EXPECT_EQ(kLowest, saturated::mul_div(kLowest, kLowest, kLowest));
+  EXPECT_EQ(kMax, saturated::mul_div(kLowest, kLowest, kMax));
+  // Quotients are rounded toward 0.
+  EXPECT_EQ(kMinusOne, saturated::mul_div(kMinusOne, kThree, kTwo));
+}
+
+// 64 bits values are multiplied in 128 bits as timestamps of nanoseconds.
+#ifdef SATOP_HAS_INT128
+TEST(MulDivTest, Rate) {
+  constexpr const uint64_t kBytes = UINT64_C(3000000000000);
+  constexpr const uint64_t kNanoSeconds = UINT64_C(7000000000000);
+  EXPECT_EQ(UINT64_C(428571428),
+            saturated::mul_div(kBytes, UINT64_C(1000000000), kNanoSeconds));
+  EXPECT_EQ(INT64_C(-3074457345618258602),
+            saturated::mul_div(std::numeric_limits<int64_t>::max(),
+                               INT64_C(-2), INT64_C(6)));
+}
+#endif  // SATOP_HAS_INT128
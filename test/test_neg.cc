@@ -0,0 +1,105 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Sizes around multiples of vector lanes, to test remainders.
+constexpr const std::size_t kSizes[] = {
+  0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 257
+};
+
+}  // namespace
+
+template <typename T>
+class NegTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+using TypesForNegTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                          int8_t, int16_t, int32_t,
+                                          uint64_t, int64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(NegTest, TypesForNegTests, );  // NOLINT
+
+TYPED_TEST(NegTest, Scalar) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kZero(0);
+  constexpr const T kOne(1);
+  EXPECT_EQ(kZero, saturated::neg(kZero));
+  if (std::is_signed<T>::value) {
+    EXPECT_EQ(static_cast<T>(-1), saturated::neg(kOne));
+    EXPECT_EQ(kOne, saturated::neg(static_cast<T>(-1)));
+    EXPECT_EQ(TestFixture::Limits::max(),
+              saturated::neg(TestFixture::Limits::lowest()));
+    EXPECT_EQ(static_cast<T>(TestFixture::Limits::lowest() + 1),
+              saturated::neg(TestFixture::Limits::max()));
+  } else {
+    EXPECT_EQ(kZero, saturated::neg(kOne));
+    EXPECT_EQ(kZero, saturated::neg(TestFixture::Limits::max()));
+  }
+}
+
+TYPED_TEST(NegTest, ConstantEvaluation) {
+  constexpr const auto kNegated =
+      saturated::neg(TestFixture::Limits::lowest());
+  EXPECT_EQ(std::is_signed<typename TestFixture::test_target_t>::value
+            ? TestFixture::Limits::max()
+            : TestFixture::Limits::lowest(),
+            kNegated);
+}
+
+TYPED_TEST(NegTest, Batch) {
+  using T = typename TestFixture::test_target_t;
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const auto n : kSizes) {
+      const auto x = GetTestValues<T>(n, 0);
+      std::vector<T> out(n);
+      saturated::neg(x.data(), out.data(), n);
+      auto in_place = x;
+      saturated::neg(in_place.data(), n);
+      for (std::size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(saturated::neg(x[i]), out[i])
+            << "level = " << static_cast<int>(level)
+            << ", n = " << n << ", x = " << +x[i];
+        ASSERT_EQ(out[i], in_place[i]);
+      }
+    }
+  }
+}
@@ -0,0 +1,318 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Several chunks of 64 KiB for any element type, with a remainder.
+constexpr const std::size_t kSize = 3 * 65536 + 17;
+
+constexpr const std::size_t kThreads = 4;
+
+template <typename T>
+std::vector<T> RandomValues(std::size_t n, uint32_t seed) {
+  std::mt19937 engine(seed);
+  std::vector<T> values(n);
+  for (auto& value : values) {
+    value = static_cast<T>(engine());
+  }
+  return values;
+}
+
+// Runs of max and lowest of random lengths,
+// so partial sums saturate in both directions inside chunks.
+template <typename T>
+std::vector<T> AlternatingValues(std::size_t n, uint32_t seed) {
+  using Limits = std::numeric_limits<T>;
+  std::mt19937 engine(seed);
+  std::vector<T> values(n);
+  std::size_t i = 0;
+  for (bool is_max = true; i < n; is_max = !is_max) {
+    const std::size_t run = 1 + engine() % 50000;
+    for (std::size_t j = 0; (j < run) && (i < n); ++j, ++i) {
+      values[i] = (engine() % 4 == 0)
+          ? static_cast<T>(engine())
+          : (is_max ? Limits::max() : Limits::lowest());
+    }
+  }
+  return values;
+}
+
+}  // namespace
+
+template <typename T>
+class ParallelTest
+    : public ::testing::Test {
+ protected:
+  using test_target_t = T;
+
+  ParallelTest()
+      : pool_(kThreads),
+        policy_(saturated::par.on(&pool_).with_threshold(0)) {
+  }
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+
+  // Compare operation(policy_, ...) with operation(...) at each level.
+  template <typename Operation>
+  void TestBinary(const Operation& operation) {
+    const auto x = RandomValues<T>(kSize, 1);
+    const auto y = RandomValues<T>(kSize, 2);
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      std::vector<T> expected(kSize);
+      std::vector<T> actual(kSize);
+      operation(nullptr, x.data(), y.data(), expected.data());
+      operation(&policy_, x.data(), y.data(), actual.data());
+      ASSERT_EQ(expected, actual) << "level = " << static_cast<int>(level);
+    }
+  }
+
+  template <typename Reduction>
+  void TestReduction(const Reduction& reduction) {
+    const std::vector<std::vector<T>> inputs{
+      RandomValues<T>(kSize, 1),
+      AlternatingValues<T>(kSize, 2),
+      AlternatingValues<T>(kSize, 3),
+    };
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const auto mode : {saturated::reduction_mode::clamp_at_end,
+                              saturated::reduction_mode::clamp_each_step}) {
+        for (const auto& x : inputs) {
+          for (const auto& y : inputs) {
+            EXPECT_EQ(+reduction(nullptr, x.data(), y.data(), mode),
+                      +reduction(&policy_, x.data(), y.data(), mode))
+                << "level = " << static_cast<int>(level)
+                << ", mode = " << static_cast<int>(mode);
+          }
+        }
+      }
+    }
+  }
+
+  saturated::thread_pool pool_;
+  saturated::parallel_policy policy_;
+};
+
+using TypesForParallelTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                               int8_t, int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(ParallelTest, TypesForParallelTests, );  // NOLINT
+
+TYPED_TEST(ParallelTest, Arrays) {
+  using T = typename TestFixture::test_target_t;
+  using saturated::parallel_policy;
+  this->TestBinary([](const parallel_policy* policy,
+                      const T* x, const T* y, T* out) {
+    if (policy == nullptr) {
+      saturated::add(x, y, out, kSize);
+      saturated::sub(out, y, out, kSize);
+      saturated::mul(out, x, out, kSize);
+      saturated::mul_add(x, y, out, out, kSize);
+    } else {
+      saturated::add(*policy, x, y, out, kSize);
+      saturated::sub(*policy, out, y, out, kSize);
+      saturated::mul(*policy, out, x, out, kSize);
+      saturated::mul_add(*policy, x, y, out, out, kSize);
+    }
+  });
+}
+
+TYPED_TEST(ParallelTest, Values) {
+  using T = typename TestFixture::test_target_t;
+  using saturated::parallel_policy;
+  this->TestBinary([](const parallel_policy* policy,
+                      const T* x, const T* y, T* out) {
+    const T value = static_cast<T>(y[0] | 1);
+    if (policy == nullptr) {
+      saturated::add(x, value, out, kSize);
+      saturated::sub(out, value, out, kSize);
+      saturated::mul(out, value, out, kSize);
+      saturated::mul_add(x, value, y, out, kSize);
+      saturated::div(out, value, out, kSize);
+    } else {
+      saturated::add(*policy, x, value, out, kSize);
+      saturated::sub(*policy, out, value, out, kSize);
+      saturated::mul(*policy, out, value, out, kSize);
+      saturated::mul_add(*policy, x, value, y, out, kSize);
+      saturated::div(*policy, out, value, out, kSize);
+    }
+  });
+}
+
+TYPED_TEST(ParallelTest, InPlace) {
+  using T = typename TestFixture::test_target_t;
+  using saturated::parallel_policy;
+  this->TestBinary([](const parallel_policy* policy,
+                      const T* x, const T* y, T* out) {
+    const T value = static_cast<T>(y[0] | 1);
+    std::copy(x, x + kSize, out);
+    if (policy == nullptr) {
+      saturated::add(out, y, kSize);
+      saturated::sub(out, value, kSize);
+      saturated::mul(out, y, kSize);
+      saturated::mul_add(x, y, out, kSize);
+      saturated::mul_add(x, value, out, kSize);
+      saturated::div(out, value, kSize);
+    } else {
+      saturated::add(*policy, out, y, kSize);
+      saturated::sub(*policy, out, value, kSize);
+      saturated::mul(*policy, out, y, kSize);
+      saturated::mul_add(*policy, x, y, out, kSize);
+      saturated::mul_add(*policy, x, value, out, kSize);
+      saturated::div(*policy, out, value, kSize);
+    }
+  });
+}
+
+TYPED_TEST(ParallelTest, Unary) {
+  using T = typename TestFixture::test_target_t;
+  using saturated::parallel_policy;
+  this->TestBinary([](const parallel_policy* policy,
+                      const T* x, const T*, T* out) {
+    if (policy == nullptr) {
+      saturated::neg(x, out, kSize);
+      saturated::abs(out, kSize);
+      saturated::shl(out, 3, kSize);
+    } else {
+      saturated::neg(*policy, x, out, kSize);
+      saturated::abs(*policy, out, kSize);
+      saturated::shl(*policy, out, 3, kSize);
+    }
+  });
+}
+
+TYPED_TEST(ParallelTest, Convert) {
+  using T = typename TestFixture::test_target_t;
+  using saturated::parallel_policy;
+  this->TestBinary([](const parallel_policy* policy,
+                      const T* x, const T* y, T* out) {
+    std::vector<float> samples(kSize);
+    for (std::size_t i = 0; i < kSize; ++i) {
+      samples[i] = static_cast<float>(x[i]) / static_cast<float>(y[i] | 1);
+    }
+    if (policy == nullptr) {
+      saturated::convert(samples.data(), out, kSize, 1000.0f,
+                         saturated::rounding::to_nearest);
+    } else {
+      saturated::convert(*policy, samples.data(), out, kSize, 1000.0f,
+                         saturated::rounding::to_nearest);
+    }
+  });
+}
+
+TYPED_TEST(ParallelTest, SaturateCast) {
+  using T = typename TestFixture::test_target_t;
+  using saturated::parallel_policy;
+  this->TestBinary([](const parallel_policy* policy,
+                      const T* x, const T*, T* out) {
+    std::vector<int16_t> narrow(kSize);
+    if (policy == nullptr) {
+      saturated::saturate_cast(x, narrow.data(), kSize);
+      saturated::saturate_cast(narrow.data(), out, kSize);
+    } else {
+      saturated::saturate_cast(*policy, x, narrow.data(), kSize);
+      saturated::saturate_cast(*policy, narrow.data(), out, kSize);
+    }
+  });
+}
+
+TYPED_TEST(ParallelTest, Sum) {
+  using T = typename TestFixture::test_target_t;
+  this->TestReduction([](const saturated::parallel_policy* policy,
+                         const T* x, const T*,
+                         saturated::reduction_mode mode) {
+    return (policy == nullptr)
+        ? saturated::sum(x, kSize, mode)
+        : saturated::sum(*policy, x, kSize, mode);
+  });
+}
+
+TYPED_TEST(ParallelTest, Dot) {
+  using T = typename TestFixture::test_target_t;
+  this->TestReduction([](const saturated::parallel_policy* policy,
+                         const T* x, const T* y,
+                         saturated::reduction_mode mode) {
+    return (policy == nullptr)
+        ? saturated::dot(x, y, kSize, mode)
+        : saturated::dot(*policy, x, y, kSize, mode);
+  });
+}
+
+TEST(ThreadPoolTest, EachChunkOnce) {
+  saturated::thread_pool pool(kThreads);
+  ASSERT_EQ(kThreads, pool.size());
+  constexpr const std::size_t kChunks = 1000;
+  std::vector<std::atomic<int>> counts(kChunks);
+  for (int i = 0; i < 10; ++i) {
+    pool.run(kChunks, [&counts](std::size_t chunk) {
+      counts[chunk].fetch_add(1);
+    });
+  }
+  for (const auto& count : counts) {
+    EXPECT_EQ(10, count.load());
+  }
+}
+
+TEST(ThreadPoolTest, Nested) {
+  saturated::thread_pool pool(kThreads);
+  std::atomic<int> count(0);
+  pool.run(kThreads, [&pool, &count](std::size_t) {
+    pool.run(kThreads, [&count](std::size_t) {
+      count.fetch_add(1);
+    });
+  });
+  EXPECT_EQ(static_cast<int>(kThreads * kThreads), count.load());
+}
+
+TEST(ThreadPoolTest, SingleThread) {
+  saturated::thread_pool pool(1);
+  int count = 0;
+  pool.run(100, [&count](std::size_t) {
+    ++count;
+  });
+  EXPECT_EQ(100, count);
+}
+
+TEST(ParallelPolicyTest, BelowThreshold) {
+  // The default pool is not needed for small arrays.
+  std::vector<int16_t> x(1000, INT16_MAX);
+  std::vector<int16_t> out(x.size());
+  saturated::add(saturated::par, x.data(), x.data(), out.data(), x.size());
+  EXPECT_EQ(std::vector<int16_t>(x.size(), INT16_MAX), out);
+  EXPECT_EQ(INT16_MAX, saturated::sum(saturated::par, x.data(), x.size()));
+  EXPECT_EQ(std::size_t{1} << 20, saturated::par.threshold());
+}
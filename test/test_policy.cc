@@ -0,0 +1,339 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Wrapped results calculated in 64 bits unsigned integer.
+template <typename T>
+T WrappedAdd(T x, T y) {
+  return static_cast<T>(static_cast<uint64_t>(x) + static_cast<uint64_t>(y));
+}
+
+template <typename T>
+T WrappedSub(T x, T y) {
+  return static_cast<T>(static_cast<uint64_t>(x) - static_cast<uint64_t>(y));
+}
+
+template <typename T>
+T WrappedMul(T x, T y) {
+  return static_cast<T>(static_cast<uint64_t>(x) * static_cast<uint64_t>(y));
+}
+
+template <typename T>
+T WrappedDiv(T x, T y) {
+  return (y == 0)
+      ? saturated::div(x, y)
+      : ((std::is_signed<T>::value && (y == static_cast<T>(-1)))
+         ? WrappedSub(static_cast<T>(0), x)
+         : static_cast<T>(x / y));
+}
+
+}  // namespace
+
+template <typename T>
+class PolicyTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+
+  void SetUp() override {
+    saturated::reset_saturation_counts();
+  }
+
+  void TearDown() override {
+    saturated::reset_saturation_counts();
+  }
+};
+
+using TypesForPolicyTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                             int64_t, uint8_t, uint16_t,
+                                             uint32_t, uint64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(PolicyTest, TypesForPolicyTests, );  // NOLINT
+
+TYPED_TEST(PolicyTest, Saturate) {
+  using T = typename TestFixture::test_target_t;
+  for (const T x : GetEdgeValues<T>()) {
+    for (const T y : GetEdgeValues<T>()) {
+      EXPECT_EQ(saturated::add(x, y),
+                saturated::add<saturated::saturate>(x, y));
+      EXPECT_EQ(saturated::sub(x, y),
+                saturated::sub<saturated::saturate>(x, y));
+      EXPECT_EQ(saturated::mul(x, y),
+                saturated::mul<saturated::saturate>(x, y));
+      EXPECT_EQ(saturated::div(x, y),
+                saturated::div<saturated::saturate>(x, y));
+    }
+  }
+  EXPECT_FALSE(saturated::saturation_occurred());
+}
+
+TYPED_TEST(PolicyTest, Wrap) {
+  using T = typename TestFixture::test_target_t;
+  for (const T x : GetEdgeValues<T>()) {
+    for (const T y : GetEdgeValues<T>()) {
+      SCOPED_TRACE(testing::Message() << "x = " << +x << ", y = " << +y);
+      EXPECT_EQ(WrappedAdd(x, y), saturated::add<saturated::wrap>(x, y));
+      EXPECT_EQ(WrappedSub(x, y), saturated::sub<saturated::wrap>(x, y));
+      EXPECT_EQ(WrappedMul(x, y), saturated::mul<saturated::wrap>(x, y));
+      EXPECT_EQ(WrappedDiv(x, y), saturated::div<saturated::wrap>(x, y));
+    }
+  }
+  EXPECT_FALSE(saturated::saturation_occurred());
+}
+
+TYPED_TEST(PolicyTest, Trap) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  constexpr const T kOne(1);
+  constexpr const T kTwo(2);
+  EXPECT_EQ(kMax, saturated::add<saturated::trap>(
+      static_cast<T>(kMax - kOne), kOne));
+  EXPECT_EQ(kLowest, saturated::sub<saturated::trap>(
+      static_cast<T>(kLowest + kOne), kOne));
+  EXPECT_EQ(kMax, saturated::mul<saturated::trap>(kMax, kOne));
+  EXPECT_EQ(T(0), saturated::div<saturated::trap>(T(0), T(0)));
+
+  EXPECT_THROW(saturated::add<saturated::trap>(kMax, kOne),
+               saturated::saturation_error);
+  EXPECT_THROW(saturated::mul<saturated::trap>(kMax, kTwo),
+               saturated::saturation_error);
+  EXPECT_THROW(saturated::div<saturated::trap>(kOne, T(0)),
+               saturated::saturation_error);
+  try {
+    saturated::sub<saturated::trap>(kLowest, kOne);
+    ADD_FAILURE() << "saturation_error is not thrown";
+  } catch (const saturated::saturation_error& e) {
+    EXPECT_EQ(saturated::saturation_op::sub, e.op());
+    EXPECT_EQ(saturated::saturation_direction::underflow, e.direction());
+    EXPECT_STREQ("saturated::sub underflowed", e.what());
+  }
+  EXPECT_FALSE(saturated::saturation_occurred());
+}
+
+TYPED_TEST(PolicyTest, Report) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kOne(1);
+  EXPECT_EQ(kMax, saturated::add<saturated::report<>>(kMax, kOne));
+  EXPECT_EQ(WrappedAdd(kMax, kOne),
+            saturated::add<saturated::report<saturated::wrap>>(kMax, kOne));
+  EXPECT_EQ(kOne, saturated::mul<saturated::report<>>(kOne, kOne));
+  EXPECT_TRUE(saturated::saturation_occurred());
+  EXPECT_EQ(2u, saturated::saturation_snapshot().count(
+      saturated::saturation_op::add,
+      saturated::saturation_direction::overflow));
+  EXPECT_EQ(2u, saturated::saturation_snapshot().total());
+}
+
+TYPED_TEST(PolicyTest, ConstantEvaluation) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kOne(1);
+  constexpr const T kSaturated = saturated::add<saturated::saturate>(kMax,
+                                                                     kOne);
+  constexpr const T kWrapped = saturated::add<saturated::wrap>(kMax, kOne);
+  constexpr const T kTrapped = saturated::sub<saturated::trap>(kMax, kOne);
+  EXPECT_EQ(kMax, kSaturated);
+  EXPECT_EQ(TestFixture::Limits::lowest(), kWrapped);
+  EXPECT_EQ(static_cast<T>(kMax - kOne), kTrapped);
+}
+
+TEST(PolicyTest, IsOverflowPolicy) {
+  static_assert(saturated::is_overflow_policy<saturated::saturate>::value,
+                "saturate is a policy");
+  static_assert(saturated::is_overflow_policy<saturated::wrap>::value,
+                "wrap is a policy");
+  static_assert(saturated::is_overflow_policy<saturated::trap>::value,
+                "trap is a policy");
+  static_assert(saturated::is_overflow_policy<saturated::report<>>::value,
+                "report is a policy");
+  static_assert(!saturated::is_overflow_policy<int>::value,
+                "int is not a policy");
+}
+
+template <typename T>
+class BatchPolicyTest
+    : public ::testing::Test {
+ protected:
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+    saturated::reset_saturation_counts();
+  }
+
+  // Batch operations with Policy must be the same as scalar ones
+  // on any instruction set, including counts by report.
+  template <typename Policy, typename BatchFunc, typename ScalarFunc>
+  static void TestPolicy(BatchFunc batch_func, ScalarFunc scalar_func) {
+    constexpr std::size_t kSize = 1000;
+    const auto x = GetTestValues<T>(kSize, 0);
+    const auto y = GetTestValues<T>(kSize, 1);
+    saturated::reset_saturation_counts();
+    std::vector<T> expected(kSize);
+    for (std::size_t i = 0; i < kSize; ++i) {
+      expected[i] = scalar_func(Policy(), x[i], y[i]);
+    }
+    const uint64_t expected_total = saturated::saturation_snapshot().total();
+    for (const auto level : GetSupportedLevels()) {
+      SCOPED_TRACE(static_cast<int>(level));
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      saturated::reset_saturation_counts();
+      std::vector<T> out(kSize);
+      batch_func(Policy(), x.data(), y.data(), out.data(), kSize);
+      EXPECT_EQ(expected, out);
+      EXPECT_EQ(expected_total, saturated::saturation_snapshot().total());
+    }
+  }
+
+  template <typename BatchFunc, typename ScalarFunc>
+  static void TestPolicies(BatchFunc batch_func, ScalarFunc scalar_func) {
+    TestPolicy<saturated::saturate>(batch_func, scalar_func);
+    TestPolicy<saturated::wrap>(batch_func, scalar_func);
+    TestPolicy<saturated::report<>>(batch_func, scalar_func);
+    TestPolicy<saturated::report<saturated::wrap>>(batch_func, scalar_func);
+  }
+
+  // Trap throws before storing any result,
+  // if only the last element of x saturates with y,
+  // and stores results if none of them saturates.
+  template <typename BatchFunc>
+  static void TestTrap(BatchFunc batch_func, T x_value, T y_value) {
+    constexpr std::size_t kSize = 100;
+    std::vector<T> x(kSize, static_cast<T>(1));
+    const std::vector<T> y(kSize, y_value);
+    const std::vector<T> zeros(kSize, static_cast<T>(0));
+    for (const auto level : GetSupportedLevels()) {
+      SCOPED_TRACE(static_cast<int>(level));
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      std::vector<T> out(zeros);
+      x.back() = x_value;
+      EXPECT_THROW(batch_func(x.data(), y.data(), out.data(), kSize),
+                   saturated::saturation_error);
+      EXPECT_EQ(zeros, out);
+      x.back() = static_cast<T>(1);
+      const std::vector<T> unstored(kSize, std::numeric_limits<T>::max());
+      out = unstored;
+      batch_func(x.data(), y.data(), out.data(), kSize);
+      EXPECT_NE(unstored, out);
+    }
+  }
+};
+
+using TypesForBatchPolicyTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                  uint8_t, uint16_t,
+                                                  uint32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+TYPED_TEST_SUITE(BatchPolicyTest, TypesForBatchPolicyTests, );  // NOLINT
+
+TYPED_TEST(BatchPolicyTest, Add) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestPolicies(
+      [](auto policy, const T* x, const T* y, T* out, std::size_t n) {
+        saturated::add<decltype(policy)>(x, y, out, n);
+      },
+      [](auto policy, T x, T y) {
+        return saturated::add<decltype(policy)>(x, y);
+      });
+}
+
+TYPED_TEST(BatchPolicyTest, AddValue) {
+  using T = typename TestFixture::test_target_t;
+  const T value = std::numeric_limits<T>::max() / 2;
+  TestFixture::TestPolicies(
+      [value](auto policy, const T* x, const T*, T* out, std::size_t n) {
+        saturated::add<decltype(policy)>(x, value, out, n);
+      },
+      [value](auto policy, T x, T) {
+        return saturated::add<decltype(policy)>(x, value);
+      });
+}
+
+TYPED_TEST(BatchPolicyTest, Sub) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestPolicies(
+      [](auto policy, const T* x, const T* y, T* out, std::size_t n) {
+        saturated::sub<decltype(policy)>(x, y, out, n);
+      },
+      [](auto policy, T x, T y) {
+        return saturated::sub<decltype(policy)>(x, y);
+      });
+}
+
+TYPED_TEST(BatchPolicyTest, Mul) {
+  using T = typename TestFixture::test_target_t;
+  TestFixture::TestPolicies(
+      [](auto policy, const T* x, const T* y, T* out, std::size_t n) {
+        saturated::mul<decltype(policy)>(x, y, out, n);
+      },
+      [](auto policy, T x, T y) {
+        return saturated::mul<decltype(policy)>(x, y);
+      });
+}
+
+TYPED_TEST(BatchPolicyTest, Div) {
+  using T = typename TestFixture::test_target_t;
+  for (const T divisor : GetEdgeValues<T>()) {
+    SCOPED_TRACE(testing::Message() << "divisor = " << +divisor);
+    TestFixture::TestPolicies(
+        [divisor](auto policy, const T* x, const T*, T* out, std::size_t n) {
+          saturated::div<decltype(policy)>(x, divisor, out, n);
+        },
+        [divisor](auto policy, T x, T) {
+          return saturated::div<decltype(policy)>(x, divisor);
+        });
+  }
+}
+
+TYPED_TEST(BatchPolicyTest, Trap) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = std::numeric_limits<T>::max();
+  TestFixture::TestTrap(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::add<saturated::trap>(x, y, out, n);
+      },
+      kMax, static_cast<T>(1));
+  TestFixture::TestTrap(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::sub<saturated::trap>(x, y[0], out, n);
+      },
+      std::numeric_limits<T>::lowest(), static_cast<T>(1));
+  TestFixture::TestTrap(
+      [](const T* x, const T* y, T* out, std::size_t n) {
+        saturated::mul<saturated::trap>(x, y, out, n);
+      },
+      kMax, static_cast<T>(2));
+}
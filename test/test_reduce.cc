@@ -0,0 +1,278 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Sizes around multiples of vector lanes, to test remainders.
+constexpr const std::size_t kSizes[] = {
+  0, 1, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 257
+};
+
+// Exact sum of 64 bits values as high * 2^32 + low.
+class ReferenceSum {
+ public:
+  ReferenceSum()
+      : high_(0), low_(0) {
+  }
+
+  void Add(int64_t value) {
+    high_ += value / (int64_t(1) << 32);
+    low_ += value % (int64_t(1) << 32);
+  }
+
+  void Add(uint64_t value) {
+    high_ += static_cast<int64_t>(value >> 32);
+    low_ += static_cast<int64_t>(value & UINT32_MAX);
+  }
+
+  template <typename T>
+  T Clamp() const {
+    // high_ * 2^32 + low_ is out of range of T up to 32 bits
+    // unless it is in [-2^32, 2^32).
+    const int64_t high = high_ + FloorDiv(low_);
+    const int64_t low = low_ - FloorDiv(low_) * (int64_t(1) << 32);
+    if (high > 0) {
+      return std::numeric_limits<T>::max();
+    } else if (high < -1) {
+      return std::numeric_limits<T>::lowest();
+    }
+    const int64_t value = low - ((high < 0) ? (int64_t(1) << 32) : 0);
+    return (value > static_cast<int64_t>(std::numeric_limits<T>::max()))
+        ? std::numeric_limits<T>::max()
+        : ((value < static_cast<int64_t>(std::numeric_limits<T>::lowest()))
+           ? std::numeric_limits<T>::lowest()
+           : static_cast<T>(value));
+  }
+
+ private:
+  static int64_t FloorDiv(int64_t value) {
+    const int64_t kDivisor = int64_t(1) << 32;
+    return (value >= 0)
+        ? (value / kDivisor)
+        : -((-value + kDivisor - 1) / kDivisor);
+  }
+
+  int64_t high_;
+  int64_t low_;
+};
+
+// Values of T with 64 bits signedness of T.
+template <typename T>
+using Wide = typename std::conditional<std::is_signed<T>::value,
+                                       int64_t,
+                                       uint64_t>::type;
+
+template <typename T>
+T ReferenceSumAtEnd(const std::vector<T>& x, std::size_t n) {
+  ReferenceSum sum;
+  for (std::size_t i = 0; i < n; ++i) {
+    sum.Add(static_cast<Wide<T>>(x[i]));
+  }
+  return sum.template Clamp<T>();
+}
+
+template <typename T>
+T ReferenceDotAtEnd(const std::vector<T>& x, const std::vector<T>& y,
+                    std::size_t n) {
+  ReferenceSum sum;
+  for (std::size_t i = 0; i < n; ++i) {
+    sum.Add(static_cast<Wide<T>>(static_cast<Wide<T>>(x[i])
+                                 * static_cast<Wide<T>>(y[i])));
+  }
+  return sum.template Clamp<T>();
+}
+
+template <typename T>
+T ClampInt64(int64_t value) {
+  return static_cast<T>(
+      std::min<int64_t>(std::max<int64_t>(value,
+                                          std::numeric_limits<T>::lowest()),
+                        std::numeric_limits<T>::max()));
+}
+
+// Each step of them is calculated in int64_t.
+template <typename T>
+T ReferenceSumEachStep(const std::vector<T>& x, std::size_t n) {
+  T acc = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    acc = ClampInt64<T>(static_cast<int64_t>(acc)
+                        + static_cast<int64_t>(x[i]));
+  }
+  return acc;
+}
+
+template <typename T>
+T ReferenceDotEachStep(const std::vector<T>& x, const std::vector<T>& y,
+                       std::size_t n) {
+  T acc = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    // Products of uint32_t may exceed int64_t,
+    // but they saturate anyway.
+    const Wide<T> product =
+        static_cast<Wide<T>>(x[i]) * static_cast<Wide<T>>(y[i]);
+    const Wide<T> kBound = static_cast<Wide<T>>(INT64_MAX / 2);
+    acc = ClampInt64<T>(static_cast<int64_t>(acc)
+                        + static_cast<int64_t>(std::min(product, kBound)));
+  }
+  return acc;
+}
+
+// Edge values, small values whose sums may not saturate,
+// and random values.
+template <typename T>
+std::vector<T> GetReductionValues(std::size_t n, unsigned int seed) {
+  using Limits = std::numeric_limits<T>;
+  const std::vector<T> edges{Limits::lowest(), Limits::max(),
+                             static_cast<T>(-1), T(0), T(1), T(2)};
+  std::mt19937 engine(seed);
+  std::vector<T> values(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    switch (engine() % 3) {
+      case 0:
+        values[i] = edges[engine() % edges.size()];
+        break;
+      case 1:
+        values[i] = static_cast<T>(engine() % 8);
+        break;
+      default:
+        values[i] = static_cast<T>(engine());
+        break;
+    }
+  }
+  return values;
+}
+
+}  // namespace
+
+template <typename T>
+class ReduceTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+using TypesForReduceTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                             int8_t, int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(ReduceTest, TypesForReduceTests, );  // NOLINT
+
+TYPED_TEST(ReduceTest, Sum) {
+  using T = typename TestFixture::test_target_t;
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (unsigned int seed = 0; seed < 8; ++seed) {
+      for (const auto n : kSizes) {
+        const auto x = GetReductionValues<T>(n, seed);
+        EXPECT_EQ(ReferenceSumAtEnd(x, n), saturated::sum(x.data(), n))
+            << "level = " << static_cast<int>(level) << ", n = " << n
+            << ", seed = " << seed;
+        EXPECT_EQ(ReferenceSumEachStep(x, n),
+                  saturated::sum(x.data(), n,
+                                 saturated::reduction_mode::clamp_each_step))
+            << "level = " << static_cast<int>(level) << ", n = " << n
+            << ", seed = " << seed;
+      }
+    }
+  }
+}
+
+TYPED_TEST(ReduceTest, Dot) {
+  using T = typename TestFixture::test_target_t;
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (unsigned int seed = 0; seed < 8; ++seed) {
+      for (const auto n : kSizes) {
+        const auto x = GetReductionValues<T>(n, seed);
+        const auto y = GetReductionValues<T>(n, seed + 100);
+        EXPECT_EQ(ReferenceDotAtEnd(x, y, n),
+                  saturated::dot(x.data(), y.data(), n))
+            << "level = " << static_cast<int>(level) << ", n = " << n
+            << ", seed = " << seed;
+        EXPECT_EQ(ReferenceDotEachStep(x, y, n),
+                  saturated::dot(x.data(), y.data(), n,
+                                 saturated::reduction_mode::clamp_each_step))
+            << "level = " << static_cast<int>(level) << ", n = " << n
+            << ", seed = " << seed;
+      }
+    }
+  }
+}
+
+TYPED_TEST(ReduceTest, SaturatedOnlyAtEnd) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  constexpr const T kLowest = TestFixture::Limits::lowest();
+  const std::vector<T> x{kMax, kMax, kLowest};
+  const T kExpected = static_cast<T>(ReferenceSumAtEnd(x, x.size()));
+  EXPECT_EQ(kExpected, saturated::sum(x.data(), x.size()));
+  EXPECT_EQ(T(0), saturated::sum(x.data(), 0));
+  EXPECT_EQ(T(0), saturated::dot(x.data(), x.data(), 0));
+}
+
+// Partial sums in vector lanes are much larger than the result,
+// and they are carried over blocks.
+TYPED_TEST(ReduceTest, LargeArray) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kMax = TestFixture::Limits::max();
+  const std::size_t kSize = (std::size_t(1) << 22) + 5;
+  std::vector<T> x(kSize, kMax);
+  std::vector<T> y(kSize, kMax);
+  for (std::size_t i = 1; i < kSize; i += 2) {
+    x[i] = TestFixture::Limits::lowest();
+  }
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    EXPECT_EQ(ReferenceSumAtEnd(x, kSize), saturated::sum(x.data(), kSize))
+        << "level = " << static_cast<int>(level);
+    EXPECT_EQ(ReferenceDotAtEnd(x, y, kSize),
+              saturated::dot(x.data(), y.data(), kSize))
+        << "level = " << static_cast<int>(level);
+  }
+}
+
+TEST(ReduceTest, Int16WrappedPairs) {
+  const std::vector<int16_t> x(64, INT16_MIN);
+  const std::vector<int16_t> y{INT16_MIN, INT16_MIN, 1, -1};
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    EXPECT_EQ(INT16_MAX, saturated::dot(x.data(), x.data(), x.size()));
+    EXPECT_EQ(int16_t(0), saturated::dot(y.data() + 2, y.data() + 2, 0));
+  }
+  saturated::reset_simd_level();
+}
@@ -0,0 +1,135 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Sizes around multiples of vector lanes, to test remainders.
+constexpr const std::size_t kSizes[] = {
+  0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 257
+};
+
+// Reference of shl(x, shift) by multiplication in long double,
+// which is exact for values up to 64 bits shifted up to 64 bits.
+template <typename T>
+T ReferenceShl(T x, int shift) {
+  long double product = static_cast<long double>(x);
+  for (int i = 0; i < shift; ++i) {
+    product *= 2;
+  }
+  if (product > static_cast<long double>(std::numeric_limits<T>::max())) {
+    return std::numeric_limits<T>::max();
+  } else if (product
+             < static_cast<long double>(std::numeric_limits<T>::lowest())) {
+    return std::numeric_limits<T>::lowest();
+  }
+  return static_cast<T>(product);
+}
+
+}  // namespace
+
+template <typename T>
+class ShlTest
+    : public ::testing::Test {
+ protected:
+  using Limits = std::numeric_limits<T>;
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+};
+
+using TypesForShlTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                          int8_t, int16_t, int32_t,
+                                          uint64_t, int64_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(ShlTest, TypesForShlTests, );  // NOLINT
+
+TYPED_TEST(ShlTest, Scalar) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const int kWidth = static_cast<int>(sizeof(T) * 8);
+  for (const T x : GetTestValues<T>(256, 0)) {
+    for (int shift = 0; shift <= kWidth + 2; ++shift) {
+      ASSERT_EQ(ReferenceShl(x, shift), saturated::shl(x, shift))
+          << "x = " << +x << ", shift = " << shift;
+    }
+  }
+}
+
+TYPED_TEST(ShlTest, Edges) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const int kDigits = TestFixture::Limits::digits;
+  constexpr const T kOne(1);
+  EXPECT_EQ(static_cast<T>(kOne << (kDigits - 1)),
+            saturated::shl(kOne, kDigits - 1));
+  EXPECT_EQ(TestFixture::Limits::max(), saturated::shl(kOne, kDigits));
+  EXPECT_EQ(T(0), saturated::shl(T(0), kDigits + 1));
+  if (std::is_signed<T>::value) {
+    EXPECT_EQ(TestFixture::Limits::lowest(),
+              saturated::shl(static_cast<T>(-1), kDigits));
+    EXPECT_EQ(TestFixture::Limits::lowest(),
+              saturated::shl(static_cast<T>(-2), kDigits));
+  }
+}
+
+TYPED_TEST(ShlTest, ConstantShift) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const T kSaturated = saturated::shl<1>(TestFixture::Limits::max());
+  EXPECT_EQ(TestFixture::Limits::max(), kSaturated);
+  EXPECT_EQ(T(8), saturated::shl<3>(T(1)));
+  EXPECT_EQ(T(5), saturated::shl<0>(T(5)));
+}
+
+TYPED_TEST(ShlTest, Batch) {
+  using T = typename TestFixture::test_target_t;
+  constexpr const int kWidth = static_cast<int>(sizeof(T) * 8);
+  for (const auto level : GetSupportedLevels()) {
+    ASSERT_TRUE(saturated::force_simd_level(level));
+    for (const int shift : {0, 1, 3, kWidth - 2, kWidth - 1, kWidth,
+                            kWidth + 5}) {
+      for (const auto n : kSizes) {
+        const auto x = GetTestValues<T>(n, 0);
+        std::vector<T> out(n);
+        saturated::shl(x.data(), shift, out.data(), n);
+        auto in_place = x;
+        saturated::shl(in_place.data(), shift, n);
+        for (std::size_t i = 0; i < n; ++i) {
+          ASSERT_EQ(saturated::shl(x[i], shift), out[i])
+              << "level = " << static_cast<int>(level)
+              << ", shift = " << shift
+              << ", n = " << n << ", x = " << +x[i];
+          ASSERT_EQ(out[i], in_place[i]);
+        }
+      }
+    }
+  }
+}
@@ -17,12 +17,52 @@
 // along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstdint>
+#include <initializer_list>
 #include <limits>
+#include <type_traits>
+#include <vector>
 
 #include "gtest_compat.h"
 
 #include "satop.h"
 
+namespace {
+
+// Values around bases, which wrap around at edges of T.
+template <typename T>
+std::vector<T> GetValuesAround(std::initializer_list<T> bases) {
+  using U = typename std::make_unsigned<T>::type;
+  std::vector<T> values;
+  for (const T base : bases) {
+    for (int offset = -2; offset <= 2; ++offset) {
+      values.push_back(static_cast<T>(static_cast<U>(
+          static_cast<U>(base) + static_cast<U>(offset))));
+    }
+  }
+  return values;
+}
+
+// Sub<C>(x) is the same as sub(x, C) around edges of T
+// and around x whose differences saturate.
+template <std::intmax_t C, typename T>
+void ExpectConstantSub() {
+  using Limits = std::numeric_limits<T>;
+  using U = typename std::make_unsigned<T>::type;
+  constexpr const T kC = static_cast<T>(C);
+  for (const T x : GetValuesAround<T>({
+           Limits::lowest(), T(0), Limits::max(),
+           static_cast<T>(static_cast<U>(Limits::max())
+                          + static_cast<U>(kC)),
+           static_cast<T>(static_cast<U>(Limits::lowest())
+                          + static_cast<U>(kC))
+       })) {
+    EXPECT_EQ(saturated::sub(x, kC), saturated::sub<C>(x))
+        << "x = " << +x << ", C = " << C;
+  }
+}
+
+}  // namespace
+
 template <typename T>
 class SubUnderflowTests
     : public ::testing::Test {
@@ -32,7 +72,8 @@ class SubUnderflowTests
 };
 
 using TypesForSubUnderflowTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
-                                                   int8_t, int16_t, int32_t>;
+                                                   int8_t, int16_t, int32_t,
+                                                   uint64_t, int64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
@@ -60,6 +101,17 @@ TYPED_TEST(SubUnderflowTests, NotUnderflow) {
             saturated::sub(kLowestValuePlusOne, kOne));
 }
 
+TYPED_TEST(SubUnderflowTests, Constant) {
+  using T = typename TestFixture::type;
+  constexpr const T kSaturated =
+      saturated::sub<1>(TestFixture::Limits::lowest());
+  EXPECT_EQ(TestFixture::Limits::lowest(), kSaturated);
+  ExpectConstantSub<0, T>();
+  ExpectConstantSub<1, T>();
+  ExpectConstantSub<3, T>();
+  ExpectConstantSub<std::numeric_limits<int8_t>::max(), T>();
+}
+
 template <typename T>
 class SubOverflowTests
     : public ::testing::Test {
@@ -68,7 +120,8 @@ class SubOverflowTests
   using Limits = std::numeric_limits<T>;
 };
 
-using TypesForSubOverflowTests = ::testing::Types<int8_t, int16_t, int32_t>;
+using TypesForSubOverflowTests = ::testing::Types<int8_t, int16_t, int32_t,
+                                                  int64_t>;
 // This strange 3rd argument omission is quick hack
 // for warning with Google Test Framework.
 // See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
@@ -79,6 +132,8 @@ TYPED_TEST(SubOverflowTests, Overflow) {
   constexpr const auto kLowestValue = TestFixture::Limits::lowest();
   constexpr const auto kMaxValue = TestFixture::Limits::max();
   EXPECT_EQ(kMaxValue, saturated::sub(kOne, kLowestValue));
+  constexpr const auto kZero = static_cast<typename TestFixture::type>(0);
+  EXPECT_EQ(kMaxValue, saturated::sub(kZero, kLowestValue));
 }
 
 TYPED_TEST(SubOverflowTests, NotOverflow) {
@@ -86,6 +141,15 @@ TYPED_TEST(SubOverflowTests, NotOverflow) {
   EXPECT_EQ(kMinusOne - kMinusOne, saturated::sub(kMinusOne, kMinusOne));
 }
 
+TYPED_TEST(SubOverflowTests, Constant) {
+  using T = typename TestFixture::type;
+  constexpr const T kSaturated = saturated::sub<-1>(TestFixture::Limits::max());
+  EXPECT_EQ(TestFixture::Limits::max(), kSaturated);
+  ExpectConstantSub<-1, T>();
+  ExpectConstantSub<-3, T>();
+  ExpectConstantSub<std::numeric_limits<int8_t>::lowest(), T>();
+}
+
 template <typename T>
 class SubFloatingOverflowTest
     : public ::testing::Test {
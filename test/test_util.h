@@ -0,0 +1,78 @@
+//
+// Copyright 2020 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TEST_TEST_UTIL_H_
+#define TEST_TEST_UTIL_H_
+
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "satop.h"
+
+// Instruction set levels which this machine can run.
+SATOP_NOINLINE std::vector<saturated::simd_level> GetSupportedLevels() {
+  std::vector<saturated::simd_level> levels;
+  for (const auto level : {saturated::simd_level::scalar,
+                           saturated::simd_level::sse2,
+                           saturated::simd_level::avx2,
+                           saturated::simd_level::avx512bw}) {
+    if (level <= saturated::supported_simd_level()) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+// Edges of T, whose combinations are likely to saturate.
+template <typename T>
+std::vector<T> GetEdgeValues() {
+  using Limits = std::numeric_limits<T>;
+  return std::vector<T>{
+    Limits::lowest(),
+    static_cast<T>(Limits::lowest() + 1),
+    static_cast<T>(Limits::lowest() / 2),
+    static_cast<T>(-1),
+    static_cast<T>(0),
+    static_cast<T>(1),
+    static_cast<T>(2),
+    static_cast<T>(3),
+    static_cast<T>(Limits::max() / 2),
+    static_cast<T>(Limits::max() - 1),
+    Limits::max()
+  };
+}
+
+// Edge values and their combinations first, followed by random values.
+template <typename T>
+std::vector<T> GetTestValues(std::size_t n, unsigned int seed) {
+  const std::vector<T> edges = GetEdgeValues<T>();
+  std::mt19937 engine(seed);
+  std::vector<T> values(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::size_t edge_index =
+        ((seed % 2) == 0) ? i : (i / edges.size());
+    values[i] = (i < edges.size() * edges.size())
+        ? edges[edge_index % edges.size()]
+        : static_cast<T>(engine());
+  }
+  return values;
+}
+
+#endif  // TEST_TEST_UTIL_H_
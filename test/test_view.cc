@@ -0,0 +1,249 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest_compat.h"
+#include "test_util.h"
+
+#include "satop.h"
+
+namespace {
+
+// Sizes over a tile of 256 columns and 64 rows of 8 bits types.
+constexpr const std::size_t kRows = 70;
+constexpr const std::size_t kCols = 300;
+
+// Elements between the end of a row or a column and the next one.
+constexpr const std::size_t kPadding = 3;
+
+// Elements of strided views.
+constexpr const std::size_t kSize = 1000;
+
+// Matrix of kRows x kCols random elements with padding,
+// which operations must not overwrite.
+template <typename T>
+class Matrix {
+ public:
+  Matrix(bool column_major, uint32_t seed)
+      : column_major_(column_major),
+        ld_((column_major ? kRows : kCols) + kPadding),
+        elements_(ld_ * (column_major ? kCols : kRows)) {
+    std::mt19937 engine(seed);
+    for (auto& element : elements_) {
+      element = static_cast<T>(engine());
+    }
+  }
+
+  saturated::matrix_view<T> View() {
+    const auto ld = static_cast<std::ptrdiff_t>(ld_);
+    return saturated::matrix_view<T>{
+      elements_.data(), kRows, kCols,
+      column_major_ ? 1 : ld, column_major_ ? ld : 1};
+  }
+
+  T& At(std::size_t row, std::size_t col) {
+    return column_major_ ? elements_[col * ld_ + row]
+                         : elements_[row * ld_ + col];
+  }
+
+  const std::vector<T>& Elements() const {
+    return elements_;
+  }
+
+ private:
+  bool column_major_;
+  std::size_t ld_;
+  std::vector<T> elements_;
+};
+
+template <typename T>
+std::vector<T> RandomValues(std::size_t n, uint32_t seed) {
+  std::mt19937 engine(seed);
+  std::vector<T> values(n);
+  for (auto& value : values) {
+    value = static_cast<T>(engine());
+  }
+  return values;
+}
+
+}  // namespace
+
+template <typename T>
+class ViewTest
+    : public ::testing::Test {
+ protected:
+  using test_target_t = T;
+
+  void TearDown() override {
+    saturated::reset_simd_level();
+  }
+
+  // Test operation by views of x, y and z in each layout,
+  // against scalar operation of each element.
+  template <typename Views, typename Scalar>
+  static void TestMatrices(Views views, Scalar scalar) {
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (int layouts = 0; layouts < 8; ++layouts) {
+        Matrix<T> x((layouts & 1) != 0, 1);
+        Matrix<T> y((layouts & 2) != 0, 2);
+        Matrix<T> z(false, 3);
+        Matrix<T> out((layouts & 4) != 0, 4);
+        Matrix<T> expected = out;
+        for (std::size_t row = 0; row < kRows; ++row) {
+          for (std::size_t col = 0; col < kCols; ++col) {
+            expected.At(row, col) = scalar(x.At(row, col), y.At(row, col),
+                                           z.At(row, col));
+          }
+        }
+        views(x.View(), y.View(), z.View(), out.View());
+        ASSERT_EQ(expected.Elements(), out.Elements())
+            << "level = " << static_cast<int>(level)
+            << ", layouts = " << layouts;
+      }
+    }
+  }
+
+  // Test operation by strided views whose elements are
+  // interleaved, in reverse order, and contiguous.
+  template <typename Views, typename Scalar>
+  static void TestStridedViews(Views views, Scalar scalar) {
+    using saturated::strided_view;
+    std::vector<T> x = RandomValues<T>(kSize * 2, 1);
+    const std::vector<T> y = RandomValues<T>(kSize * 3, 2);
+    const std::vector<T> z = RandomValues<T>(kSize, 3);
+    const strided_view<const T> y_view{y.data() + (kSize - 1) * 3, kSize, -3};
+    const strided_view<const T> z_view{z.data(), kSize, 1};
+    for (const auto level : GetSupportedLevels()) {
+      ASSERT_TRUE(saturated::force_simd_level(level));
+      for (const std::ptrdiff_t stride : {1, 2, -1}) {
+        std::vector<T> out(kSize * 2, T(0));
+        T* const first = (stride < 0) ? (out.data() + kSize - 1) : out.data();
+        views(strided_view<const T>{x.data(), kSize, 2}, y_view, z_view,
+              strided_view<T>{first, kSize, stride});
+        for (std::size_t i = 0; i < kSize; ++i) {
+          ASSERT_EQ(+scalar(x[i * 2], y[(kSize - 1 - i) * 3], z[i]),
+                    +first[static_cast<std::ptrdiff_t>(i) * stride])
+              << "level = " << static_cast<int>(level)
+              << ", stride = " << stride << ", i = " << i;
+        }
+      }
+
+      // out is the same view as x.
+      std::vector<T> in_place = x;
+      const strided_view<T> x_view{in_place.data(), kSize, 2};
+      views(x_view, y_view, z_view, x_view);
+      for (std::size_t i = 0; i < kSize * 2; ++i) {
+        const T expected = ((i % 2) != 0)
+            ? x[i] : scalar(x[i], y[(kSize - 1 - i / 2) * 3], z[i / 2]);
+        ASSERT_EQ(+expected, +in_place[i])
+            << "level = " << static_cast<int>(level) << ", i = " << i;
+      }
+    }
+  }
+};
+
+using TypesForViewTests = ::testing::Types<uint8_t, uint16_t, uint32_t,
+                                           int8_t, int16_t, int32_t>;
+// This strange 3rd argument omission is quick hack
+// for warning with Google Test Framework.
+// See https://github.com/google/googletest/issues/2271#issuecomment-665742471 .
+// cppcheck-suppress syntaxError
+TYPED_TEST_SUITE(ViewTest, TypesForViewTests, );  // NOLINT
+
+TYPED_TEST(ViewTest, Add) {
+  using T = typename TestFixture::test_target_t;
+  const auto scalar = [](T x, T y, T) { return saturated::add(x, y); };
+  TestFixture::TestMatrices(
+      [](auto x, auto y, auto, auto out) { saturated::add<T>(x, y, out); },
+      scalar);
+  TestFixture::TestStridedViews(
+      [](auto x, auto y, auto, auto out) { saturated::add<T>(x, y, out); },
+      scalar);
+}
+
+TYPED_TEST(ViewTest, Sub) {
+  using T = typename TestFixture::test_target_t;
+  const auto scalar = [](T x, T y, T) { return saturated::sub(x, y); };
+  TestFixture::TestMatrices(
+      [](auto x, auto y, auto, auto out) { saturated::sub<T>(x, y, out); },
+      scalar);
+  TestFixture::TestStridedViews(
+      [](auto x, auto y, auto, auto out) { saturated::sub<T>(x, y, out); },
+      scalar);
+}
+
+TYPED_TEST(ViewTest, Mul) {
+  using T = typename TestFixture::test_target_t;
+  const auto scalar = [](T x, T y, T) { return saturated::mul(x, y); };
+  TestFixture::TestMatrices(
+      [](auto x, auto y, auto, auto out) { saturated::mul<T>(x, y, out); },
+      scalar);
+  TestFixture::TestStridedViews(
+      [](auto x, auto y, auto, auto out) { saturated::mul<T>(x, y, out); },
+      scalar);
+}
+
+TYPED_TEST(ViewTest, Div) {
+  using T = typename TestFixture::test_target_t;
+  for (const int divisor : {0, 3, -7}) {
+    const T y = static_cast<T>(divisor);
+    const auto scalar = [y](T x, T, T) { return saturated::div(x, y); };
+    TestFixture::TestMatrices(
+        [y](auto x, auto, auto, auto out) { saturated::div<T>(x, y, out); },
+        scalar);
+    TestFixture::TestStridedViews(
+        [y](auto x, auto, auto, auto out) { saturated::div<T>(x, y, out); },
+        scalar);
+  }
+}
+
+TYPED_TEST(ViewTest, MulAdd) {
+  using T = typename TestFixture::test_target_t;
+  const auto scalar = [](T x, T y, T z) { return saturated::mul_add(x, y, z); };
+  TestFixture::TestMatrices(
+      [](auto x, auto y, auto z, auto out) {
+        saturated::mul_add<T>(x, y, z, out);
+      },
+      scalar);
+  TestFixture::TestStridedViews(
+      [](auto x, auto y, auto z, auto out) {
+        saturated::mul_add<T>(x, y, z, out);
+      },
+      scalar);
+}
+
+TEST(ViewConversionTest, Deduction) {
+  std::vector<int16_t> x{1, 32767, -32768, 4};
+  const std::vector<int16_t> y{1, 1, -1, 4};
+  const saturated::strided_view<int16_t> x_view{x.data(), 2, 2};
+  saturated::add(x_view,
+                 saturated::strided_view<const int16_t>{y.data(), 2, 2},
+                 x_view);
+  EXPECT_EQ((std::vector<int16_t>{2, 32767, -32768, 4}), x);
+
+  const saturated::matrix_view<int16_t> matrix{x.data(), 2, 2, 2, 1};
+  saturated::sub(matrix,
+                 saturated::matrix_view<const int16_t>{y.data(), 2, 2, 1, 2},
+                 matrix);
+  EXPECT_EQ((std::vector<int16_t>{1, 32767, -32768, 0}), x);
+}
@@ -0,0 +1,504 @@
+//
+// Copyright 2021 Minoru Sekine
+//
+// This file is part of libsatop.
+//
+// libsatop is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// libsatop is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with libsatop.  If not, see <http://www.gnu.org/licenses/>.
+
+// Verification of scalar and batch operations for each SIMD level
+// against results calculated in a wider integer type and clamped.
+//
+// Usage: libsatop_verify [--filter=<substring of name>] [--threads=<n>]
+//                        [--samples=<n>]
+//
+// All pairs of operands are checked for 8 and 16 bits types,
+// and all triples for mul_add of 8 bits types.
+// Others are checked with random operands, half of which are chosen
+// from values around boundaries.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "satop.h"
+
+namespace {
+
+// Integer type of references, which holds any result of operations
+// of types whose width is less than half of it.
+#ifdef SATOP_HAS_INT128
+__extension__ typedef __int128 wide_t;
+#else
+typedef int64_t wide_t;
+#endif
+
+// Number of x of each task of random operands.
+constexpr std::size_t kSampleSize = 65536;
+
+const char* GetName(saturated::simd_level level) {
+  switch (level) {
+    case saturated::simd_level::scalar:
+      return "scalar";
+    case saturated::simd_level::sse2:
+      return "sse2";
+    case saturated::simd_level::avx2:
+      return "avx2";
+    case saturated::simd_level::avx512bw:
+      return "avx512bw";
+    default:
+      return "";
+  }
+}
+
+template <typename T>
+const char* GetTypeName() {
+  return std::is_signed<T>::value
+      ? ((sizeof(T) == 1) ? "int8_t"
+         : (sizeof(T) == 2) ? "int16_t"
+         : "int32_t")
+      : ((sizeof(T) == 1) ? "uint8_t"
+         : (sizeof(T) == 2) ? "uint16_t"
+         : "uint32_t");
+}
+
+template <typename T>
+T Clamp(wide_t value) {
+  using Limits = std::numeric_limits<T>;
+  return (value > static_cast<wide_t>(Limits::max()))
+      ? Limits::max()
+      : ((value < static_cast<wide_t>(Limits::lowest()))
+         ? Limits::lowest()
+         : static_cast<T>(value));
+}
+
+// Each operation has a reference calculated in wide_t.
+struct AddOp {
+  static const char* GetName() {
+    return "add";
+  }
+
+  static constexpr bool kTernary = false;
+
+  static wide_t Reference(wide_t x, wide_t y, wide_t /* z */) {
+    return x + y;
+  }
+
+  template <typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::add(x, y);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::add(x, y, out, n);
+  }
+};
+
+struct SubOp {
+  static const char* GetName() {
+    return "sub";
+  }
+
+  static constexpr bool kTernary = false;
+
+  static wide_t Reference(wide_t x, wide_t y, wide_t /* z */) {
+    return x - y;
+  }
+
+  template <typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::sub(x, y);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::sub(x, y, out, n);
+  }
+};
+
+struct MulOp {
+  static const char* GetName() {
+    return "mul";
+  }
+
+  static constexpr bool kTernary = false;
+
+  static wide_t Reference(wide_t x, wide_t y, wide_t /* z */) {
+    return x * y;
+  }
+
+  template <typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::mul(x, y);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::mul(x, y, out, n);
+  }
+};
+
+// Division by 0 is saturated in direction of the sign of x.
+// Batch division divides all elements by y[0],
+// which is the same for all elements in tasks.
+struct DivOp {
+  static const char* GetName() {
+    return "div";
+  }
+
+  static constexpr bool kTernary = false;
+
+  static wide_t Reference(wide_t x, wide_t y, wide_t /* z */) {
+    return (y != 0)
+        ? (x / y)
+        : ((x > 0) ? wide_t(std::numeric_limits<int64_t>::max())
+                   : ((x < 0) ? wide_t(std::numeric_limits<int64_t>::lowest())
+                              : 0));
+  }
+
+  template <typename T>
+  static T Scalar(T x, T y, T /* z */) {
+    return saturated::div(x, y);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* y, const T* /* z */, T* out,
+                    std::size_t n) {
+    saturated::div(x, y[0], out, n);
+  }
+};
+
+struct MulAddOp {
+  static const char* GetName() {
+    return "mul_add";
+  }
+
+  static constexpr bool kTernary = true;
+
+  static wide_t Reference(wide_t x, wide_t y, wide_t z) {
+    return x * y + z;
+  }
+
+  template <typename T>
+  static T Scalar(T x, T y, T z) {
+    return saturated::mul_add(x, y, z);
+  }
+
+  template <typename T>
+  static void Batch(const T* x, const T* y, const T* z, T* out,
+                    std::size_t n) {
+    saturated::mul_add(x, y, z, out, n);
+  }
+};
+
+struct Options {
+  std::string filter;
+  unsigned int threads;
+  std::size_t samples;
+};
+
+// Values around boundaries, such as lowest, max, powers of 2
+// and the root of max.
+template <typename T>
+std::vector<T> GetBoundaryValues() {
+  using Limits = std::numeric_limits<T>;
+  std::vector<int64_t> candidates;
+  for (int64_t delta = -2; delta <= 2; ++delta) {
+    candidates.push_back(delta);
+    candidates.push_back(static_cast<int64_t>(Limits::lowest()) + delta);
+    candidates.push_back(static_cast<int64_t>(Limits::max()) + delta);
+  }
+  for (int bit = 1; bit <= Limits::digits; ++bit) {
+    const int64_t power = int64_t(1) << bit;
+    for (const int64_t value : {power - 1, power, power + 1}) {
+      candidates.push_back(value);
+      candidates.push_back(-value);
+    }
+  }
+  const int64_t root = static_cast<int64_t>(
+      std::sqrt(static_cast<double>(Limits::max())));
+  for (int64_t delta = -1; delta <= 1; ++delta) {
+    candidates.push_back(root + delta);
+    candidates.push_back(-(root + delta));
+  }
+  std::vector<T> values;
+  for (const int64_t candidate : candidates) {
+    if ((candidate >= static_cast<int64_t>(Limits::lowest()))
+        && (candidate <= static_cast<int64_t>(Limits::max()))) {
+      values.push_back(static_cast<T>(candidate));
+    }
+  }
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
+
+// Random values of T, half of which are chosen from boundary values.
+template <typename T>
+class BiasedValue {
+ public:
+  BiasedValue(uint64_t seed, const std::vector<T>* boundaries)
+      : engine_(seed), boundaries_(boundaries) {
+  }
+
+  T operator()() {
+    const uint64_t bits = engine_();
+    return ((bits & 1) != 0)
+        ? (*boundaries_)[(bits >> 1) % boundaries_->size()]
+        : static_cast<T>(bits >> 32);
+  }
+
+ private:
+  std::mt19937_64 engine_;
+  const std::vector<T>* boundaries_;
+};
+
+// Operands of a task, x of all values or random ones,
+// and y and z of the same value for all elements.
+template <typename T>
+struct Task {
+  Task()
+      : x(), y(), z() {
+  }
+
+  std::vector<T> x;
+  std::vector<T> y;
+  std::vector<T> z;
+};
+
+// Whether all operands are checked, otherwise random ones.
+template <typename Op, typename T>
+constexpr bool IsExhaustive() {
+  return Op::kTernary ? (sizeof(T) == 1) : (sizeof(T) <= 2);
+}
+
+template <typename T>
+std::size_t NumValues() {
+  return std::size_t(1) << (sizeof(T) * 8);
+}
+
+template <typename Op, typename T>
+std::size_t NumTasks(const Options& options) {
+  return !IsExhaustive<Op, T>()
+      ? options.samples
+      : (Op::kTernary ? NumValues<T>() * NumValues<T>() : NumValues<T>());
+}
+
+template <typename Op, typename T>
+void PrepareTask(std::size_t index, const std::vector<T>& boundaries,
+                 Task<T>* task) {
+  if (IsExhaustive<Op, T>()) {
+    const std::size_t n = NumValues<T>();
+    task->x.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      task->x[i] = static_cast<T>(
+          static_cast<int64_t>(std::numeric_limits<T>::lowest())
+          + static_cast<int64_t>(i));
+    }
+    const T y = task->x[index % n];
+    const T z = Op::kTernary ? task->x[index / n] : T(0);
+    task->y.assign(n, y);
+    task->z.assign(n, z);
+    return;
+  }
+  BiasedValue<T> random(index, &boundaries);
+  task->x.resize(kSampleSize);
+  for (auto& x : task->x) {
+    x = random();
+  }
+  task->y.assign(kSampleSize, random());
+  task->z.assign(kSampleSize, Op::kTernary ? random() : T(0));
+}
+
+// The first mismatch among threads and number of mismatches.
+class Failures {
+ public:
+  Failures()
+      : mutex_(), count_(0), first_() {
+  }
+
+  template <typename T>
+  void Add(T x, T y, T z, T expected, T actual) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_++ == 0) {
+      first_ = "x = " + std::to_string(+x) + ", y = " + std::to_string(+y)
+          + ", z = " + std::to_string(+z)
+          + ", expected = " + std::to_string(+expected)
+          + ", actual = " + std::to_string(+actual);
+    }
+  }
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  const std::string& first() const {
+    return first_;
+  }
+
+ private:
+  std::mutex mutex_;
+  uint64_t count_;
+  std::string first_;
+};
+
+// Check results of a task, where batch is false for scalar functions.
+template <typename Op, typename T>
+void CheckTask(const Task<T>& task, bool batch, std::vector<T>* out,
+               Failures* failures) {
+  const std::size_t n = task.x.size();
+  out->resize(n);
+  if (batch) {
+    Op::Batch(task.x.data(), task.y.data(), task.z.data(), out->data(), n);
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      (*out)[i] = Op::Scalar(task.x[i], task.y[i], task.z[i]);
+    }
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    const T expected = Clamp<T>(Op::Reference(task.x[i], task.y[i],
+                                              task.z[i]));
+    if ((*out)[i] != expected) {
+      failures->Add(task.x[i], task.y[i], task.z[i], expected, (*out)[i]);
+    }
+  }
+}
+
+// Tasks are taken by threads one by one.
+template <typename Op, typename T>
+bool Verify(const Options& options, const char* backend, bool batch) {
+  const std::size_t tasks = NumTasks<Op, T>(options);
+  const std::vector<T> boundaries = GetBoundaryValues<T>();
+  std::atomic<std::size_t> next(0);
+  Failures failures;
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < options.threads; ++i) {
+    threads.emplace_back([&]() {
+        Task<T> task;
+        std::vector<T> out;
+        for (std::size_t index = next++; index < tasks; index = next++) {
+          PrepareTask<Op>(index, boundaries, &task);
+          CheckTask<Op>(task, batch, &out, &failures);
+        }
+      });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const uint64_t checked = static_cast<uint64_t>(tasks)
+      * (IsExhaustive<Op, T>() ? NumValues<T>() : kSampleSize);
+  std::printf("%s,%s,%s,%s,%llu,%llu,%.3f\n",
+              Op::GetName(), GetTypeName<T>(), backend,
+              IsExhaustive<Op, T>() ? "exhaustive" : "sampled",
+              static_cast<unsigned long long>(checked),  // NOLINT(runtime/int)
+              static_cast<unsigned long long>(  // NOLINT(runtime/int)
+                  failures.count()),
+              elapsed.count());
+  std::fflush(stdout);
+  if (failures.count() != 0) {
+    std::fprintf(stderr, "%s/%s by %s: %s\n", Op::GetName(),
+                 GetTypeName<T>(), backend, failures.first().c_str());
+    return false;
+  }
+  return true;
+}
+
+// Types whose results are held by wide_t.
+template <typename T>
+constexpr bool HasReference() {
+  return sizeof(T) * 2 < sizeof(wide_t);
+}
+
+// Scalar functions and batch functions by each SIMD level.
+template <typename Op, typename T>
+bool Run(const Options& options) {
+  const std::string name = std::string(Op::GetName()) + "/" + GetTypeName<T>();
+  if (!HasReference<T>()
+      || (name.find(options.filter) == std::string::npos)) {
+    return true;
+  }
+  bool ok = Verify<Op, T>(options, "function", false);
+  for (const auto level : {saturated::simd_level::scalar,
+                           saturated::simd_level::sse2,
+                           saturated::simd_level::avx2,
+                           saturated::simd_level::avx512bw}) {
+    if (saturated::force_simd_level(level)) {
+      ok = Verify<Op, T>(options, GetName(level), true) && ok;
+    }
+  }
+  saturated::reset_simd_level();
+  return ok;
+}
+
+template <typename Op>
+bool RunForTypes(const Options& options) {
+  bool ok = Run<Op, int8_t>(options);
+  ok = Run<Op, uint8_t>(options) && ok;
+  ok = Run<Op, int16_t>(options) && ok;
+  ok = Run<Op, uint16_t>(options) && ok;
+  ok = Run<Op, int32_t>(options) && ok;
+  ok = Run<Op, uint32_t>(options) && ok;
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options{"", std::max(1U, std::thread::hardware_concurrency()),
+                  4096};
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg.compare(0, 9, "--filter=") == 0) {
+      options.filter = arg.substr(9);
+    } else if (arg.compare(0, 10, "--threads=") == 0) {
+      options.threads = static_cast<unsigned int>(
+          std::max(1L, std::strtol(arg.c_str() + 10, nullptr, 10)));
+    } else if (arg.compare(0, 10, "--samples=") == 0) {
+      options.samples = static_cast<std::size_t>(
+          std::strtoull(arg.c_str() + 10, nullptr, 10));
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [--filter=<name>] [--threads=<n>]"
+                   " [--samples=<n>]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  std::printf("op,type,backend,method,checked,mismatches,seconds\n");
+  bool ok = RunForTypes<AddOp>(options);
+  ok = RunForTypes<SubOp>(options) && ok;
+  ok = RunForTypes<MulOp>(options) && ok;
+  ok = RunForTypes<DivOp>(options) && ok;
+  ok = RunForTypes<MulAddOp>(options) && ok;
+  return ok ? 0 : 1;
+}